@@ -0,0 +1,447 @@
+#include "../LearnOpenGL/gl_loader.h"
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../LearnOpenGL/bench_stats.h"
+#include "../LearnOpenGL/gl_trace.h"
+
+using namespace std;
+
+// replays a trace written by gl_recorder on a hidden window, into an offscreen framebuffer
+//
+// GLReplay trace.gltrace [--paced] [--loops=N] [--warmup=N] [--output=replay.json]
+//   --paced   keep the recorded frame pacing instead of issuing frames back to back
+//   --loops   replay the frames (not the setup) this many times
+//   --warmup  untimed passes over the frames before that, 1 by default
+
+struct replay_options {
+	string trace_path;
+	string output_path = "replay.json";
+	bool paced = false;
+	int loops = 1;
+	int warmup = 1;
+};
+
+// a read past the end marks the reader failed and returns zeros, never touching memory after end
+struct trace_reader {
+	const uint8_t* at;
+	const uint8_t* end;
+	bool failed;
+
+	size_t remaining() const { return static_cast<size_t>(end - at); }
+
+	template <typename T>
+	T read() {
+		T value = {};
+		if (failed || remaining() < sizeof(T)) {
+			failed = true;
+			return value;
+		}
+		memcpy(&value, at, sizeof(T));
+		at += sizeof(T);
+		return value;
+	}
+
+	// the next size bytes in place, or nullptr when the trace ends before them
+	const uint8_t* skip(const size_t size) {
+		if (failed || remaining() < size) {
+			failed = true;
+			return nullptr;
+		}
+		const uint8_t* bytes = at;
+		at += size;
+		return bytes;
+	}
+
+	string read_payload() {
+		const auto size = read<uint32_t>();
+		const uint8_t* bytes = skip(size);
+		return bytes != nullptr ? string(reinterpret_cast<const char*>(bytes), size) : string();
+	}
+};
+
+// recorded object name -> replay object name, per object type
+struct replay_names {
+	unordered_map<uint32_t, GLuint> shaders;
+	unordered_map<uint32_t, GLuint> programs;
+	unordered_map<uint32_t, GLuint> buffers;
+	unordered_map<uint32_t, GLuint> arrays;
+};
+
+static GLuint remap(const unordered_map<uint32_t, GLuint>& names, const uint32_t name) {
+	const auto found = names.find(name);
+	return found != names.end() ? found->second : 0;
+}
+
+static void gen_names(trace_reader& reader, unordered_map<uint32_t, GLuint>& names, const bool issue,
+	void (GL_LOADER_APIENTRY* gen)(GLsizei, GLuint*)) {
+	const auto count = reader.read<uint32_t>();
+	if (count > reader.remaining() / sizeof(uint32_t)) {
+		reader.failed = true;
+		return;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		const auto recorded = reader.read<uint32_t>();
+		if (issue && !reader.failed) {
+			GLuint name = 0;
+			gen(1, &name);
+			names[recorded] = name;
+		}
+	}
+}
+
+// decodes one command and issues it unless issue is false; returns false on a malformed trace.
+// a frame marker stores its timestamp in frame_end_ns, which the caller initializes to -1
+static bool execute(trace_reader& reader, replay_names& names, const bool issue, int64_t* frame_end_ns) {
+	const auto opcode = reader.read<uint8_t>();
+
+	switch (opcode) {
+	case trace_frame_end:
+		*frame_end_ns = static_cast<int64_t>(reader.read<uint64_t>());
+		break;
+	case trace_clear_color: {
+		const auto r = reader.read<float>(), g = reader.read<float>(), b = reader.read<float>(), a = reader.read<float>();
+		if (issue && !reader.failed) glClearColor(r, g, b, a);
+		break;
+	}
+	case trace_clear: {
+		const auto mask = reader.read<uint32_t>();
+		if (issue && !reader.failed) glClear(mask);
+		break;
+	}
+	case trace_viewport: {
+		const auto x = reader.read<int32_t>(), y = reader.read<int32_t>();
+		const auto width = reader.read<int32_t>(), height = reader.read<int32_t>();
+		if (issue && !reader.failed) glViewport(x, y, width, height);
+		break;
+	}
+	case trace_enable: {
+		const auto cap = reader.read<uint32_t>();
+		if (issue && !reader.failed) glEnable(cap);
+		break;
+	}
+	case trace_disable: {
+		const auto cap = reader.read<uint32_t>();
+		if (issue && !reader.failed) glDisable(cap);
+		break;
+	}
+	case trace_create_shader: {
+		const auto type = reader.read<uint32_t>();
+		const auto shader = reader.read<uint32_t>();
+		if (issue && !reader.failed) names.shaders[shader] = glCreateShader(type);
+		break;
+	}
+	case trace_shader_source: {
+		const GLuint shader = remap(names.shaders, reader.read<uint32_t>());
+		const auto count = reader.read<uint32_t>();
+		// every source has at least its length, so a count that can't fit is a corrupt trace
+		if (count > reader.remaining() / sizeof(uint32_t)) {
+			reader.failed = true;
+			break;
+		}
+		vector<string> sources(count);
+		vector<const GLchar*> strings(count);
+		vector<GLint> lengths(count);
+		for (uint32_t i = 0; i < count; i++) {
+			sources[i] = reader.read_payload();
+			strings[i] = sources[i].data();
+			lengths[i] = static_cast<GLint>(sources[i].size());
+		}
+		if (issue && !reader.failed) glShaderSource(shader, count, strings.data(), lengths.data());
+		break;
+	}
+	case trace_compile_shader: {
+		const GLuint shader = remap(names.shaders, reader.read<uint32_t>());
+		if (issue && !reader.failed) glCompileShader(shader);
+		break;
+	}
+	case trace_delete_shader: {
+		const GLuint shader = remap(names.shaders, reader.read<uint32_t>());
+		if (issue && !reader.failed) glDeleteShader(shader);
+		break;
+	}
+	case trace_create_program: {
+		const auto program = reader.read<uint32_t>();
+		if (issue && !reader.failed) names.programs[program] = glCreateProgram();
+		break;
+	}
+	case trace_attach_shader: {
+		const GLuint program = remap(names.programs, reader.read<uint32_t>());
+		const GLuint shader = remap(names.shaders, reader.read<uint32_t>());
+		if (issue && !reader.failed) glAttachShader(program, shader);
+		break;
+	}
+	case trace_link_program: {
+		const GLuint program = remap(names.programs, reader.read<uint32_t>());
+		if (issue && !reader.failed) glLinkProgram(program);
+		break;
+	}
+	case trace_use_program: {
+		const GLuint program = remap(names.programs, reader.read<uint32_t>());
+		if (issue && !reader.failed) glUseProgram(program);
+		break;
+	}
+	case trace_gen_buffers:
+		gen_names(reader, names.buffers, issue, glGenBuffers);
+		break;
+	case trace_bind_buffer: {
+		const auto target = reader.read<uint32_t>();
+		const GLuint buffer = remap(names.buffers, reader.read<uint32_t>());
+		if (issue && !reader.failed) glBindBuffer(target, buffer);
+		break;
+	}
+	case trace_buffer_data: {
+		const auto target = reader.read<uint32_t>();
+		const auto usage = reader.read<uint32_t>();
+		const auto size = reader.read<uint64_t>();
+		const auto data_size = reader.read<uint32_t>();
+		const uint8_t* bytes = reader.skip(data_size);
+		const void* data = data_size > 0 ? bytes : nullptr;
+		if (issue && !reader.failed) glBufferData(target, static_cast<GLsizeiptr>(size), data, usage);
+		break;
+	}
+	case trace_gen_vertex_arrays:
+		gen_names(reader, names.arrays, issue, glGenVertexArrays);
+		break;
+	case trace_bind_vertex_array: {
+		const GLuint array = remap(names.arrays, reader.read<uint32_t>());
+		if (issue && !reader.failed) glBindVertexArray(array);
+		break;
+	}
+	case trace_vertex_attrib_pointer: {
+		const auto index = reader.read<uint32_t>();
+		const auto size = reader.read<int32_t>();
+		const auto type = reader.read<uint32_t>();
+		const auto normalized = reader.read<uint8_t>();
+		const auto stride = reader.read<int32_t>();
+		const auto offset = reader.read<uint64_t>();
+		if (issue && !reader.failed) glVertexAttribPointer(index, size, type, normalized, stride, reinterpret_cast<const void*>(offset));
+		break;
+	}
+	case trace_enable_vertex_attrib_array: {
+		const auto index = reader.read<uint32_t>();
+		if (issue && !reader.failed) glEnableVertexAttribArray(index);
+		break;
+	}
+	case trace_draw_arrays: {
+		const auto mode = reader.read<uint32_t>();
+		const auto first = reader.read<int32_t>();
+		const auto count = reader.read<int32_t>();
+		if (issue && !reader.failed) glDrawArrays(mode, first, count);
+		break;
+	}
+	case trace_draw_elements: {
+		const auto mode = reader.read<uint32_t>();
+		const auto count = reader.read<int32_t>();
+		const auto type = reader.read<uint32_t>();
+		const auto offset = reader.read<uint64_t>();
+		if (issue && !reader.failed) glDrawElements(mode, count, type, reinterpret_cast<const void*>(offset));
+		break;
+	}
+	default:
+		printf("Unknown trace opcode %u\n", opcode);
+		return false;
+	}
+
+	if (reader.failed) {
+		printf("Trace ends inside a command with opcode %u\n", opcode);
+		return false;
+	}
+	return true;
+}
+
+struct trace_frame {
+	size_t begin;
+	size_t end;
+	int64_t end_ns;
+};
+
+// splits the trace into the setup section and frames without issuing anything
+static bool index_frames(const vector<uint8_t>& trace, vector<trace_frame>& frames) {
+	replay_names names;
+	trace_reader reader = { trace.data() + sizeof(gl_trace_header), trace.data() + trace.size(), false };
+	size_t begin = sizeof(gl_trace_header);
+
+	while (reader.at < reader.end) {
+		int64_t end_ns = -1;
+		if (!execute(reader, names, false, &end_ns)) {
+			return false;
+		}
+		if (end_ns >= 0) {
+			const size_t end = reader.at - trace.data();
+			frames.push_back({ begin, end, end_ns });
+			begin = end;
+		}
+	}
+	return !frames.empty();
+}
+
+static void replay_range(const vector<uint8_t>& trace, const trace_frame& frame, replay_names& names) {
+	trace_reader reader = { trace.data() + frame.begin, trace.data() + frame.end, false };
+	int64_t end_ns = -1;
+	while (reader.at < reader.end) {
+		if (!execute(reader, names, true, &end_ns)) {
+			return;
+		}
+	}
+}
+
+static replay_options parse_options(const int argc, char* argv[]) {
+	replay_options options;
+	for (int i = 1; i < argc; i++) {
+		const string arg = argv[i];
+		if (arg == "--paced") {
+			options.paced = true;
+		}
+		else if (arg.compare(0, 8, "--loops=") == 0) {
+			options.loops = max(1, atoi(arg.c_str() + 8));
+		}
+		else if (arg.compare(0, 9, "--warmup=") == 0) {
+			options.warmup = max(0, atoi(arg.c_str() + 9));
+		}
+		else if (arg.compare(0, 9, "--output=") == 0) {
+			options.output_path = arg.substr(9);
+		}
+		else {
+			options.trace_path = arg;
+		}
+	}
+	return options;
+}
+
+int main(int argc, char* argv[])
+{
+	const replay_options options = parse_options(argc, argv);
+	if (options.trace_path.empty()) {
+		printf("usage: GLReplay trace.gltrace [--paced] [--loops=N] [--warmup=N] [--output=replay.json]\n");
+		return -1;
+	}
+
+	ifstream file(options.trace_path, ios::in | ios::binary);
+	vector<uint8_t> trace((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	gl_trace_header header = {};
+	if (trace.size() < sizeof(header)) {
+		printf("Failed to read %s\n", options.trace_path.c_str());
+		return -1;
+	}
+	memcpy(&header, trace.data(), sizeof(header));
+	if (memcmp(header.magic, gl_trace_magic, sizeof(header.magic)) != 0 || header.version != gl_trace_version) {
+		printf("%s is not a version %u GL trace\n", options.trace_path.c_str(), gl_trace_version);
+		return -1;
+	}
+
+	// frame 0 is everything up to the first frame marker - the setup
+	vector<trace_frame> frames;
+	if (!index_frames(trace, frames) || frames.size() < 2) {
+		printf("Trace has no frames\n");
+		return -1;
+	}
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(header.width, header.height, "GLReplay", nullptr, nullptr);
+	if (window == nullptr) {
+		printf("Failed to create GL context\n");
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gl_loader_init(glfwGetProcAddress)) {
+		glfwTerminate();
+		return -1;
+	}
+
+	// a hidden window's back buffer may not be backed by pixels, so draw into our own target
+	GLuint color = 0, framebuffer = 0;
+	glGenRenderbuffers(1, &color);
+	glBindRenderbuffer(GL_RENDERBUFFER, color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, header.width, header.height);
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+
+	replay_names names;
+	const auto setup_start = chrono::steady_clock::now();
+	replay_range(trace, frames[0], names);
+	glFinish();
+	const double setup_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - setup_start).count();
+
+	const size_t frame_count = frames.size() - 1;
+	vector<GLuint> queries(frame_count * options.loops);
+	glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+
+	// untimed passes: first-draw shader variants get built, and llvmpipe reports garbage
+	// for a timer query that contains the first draw of a context
+	for (int loop = 0; loop < options.warmup; loop++) {
+		for (size_t f = 1; f < frames.size(); f++) {
+			replay_range(trace, frames[f], names);
+		}
+		glFinish();
+	}
+	vector<double> cpu_ms, gpu_ms;
+	cpu_ms.reserve(queries.size());
+
+	for (int loop = 0; loop < options.loops; loop++) {
+		const auto loop_start = chrono::steady_clock::now();
+
+		for (size_t f = 1; f < frames.size(); f++) {
+			if (options.paced) {
+				const auto due = loop_start + chrono::nanoseconds(frames[f - 1].end_ns - frames[0].end_ns);
+				this_thread::sleep_until(due);
+			}
+
+			const auto frame_start = chrono::steady_clock::now();
+			glBeginQuery(GL_TIME_ELAPSED, queries[loop * frame_count + f - 1]);
+			replay_range(trace, frames[f], names);
+			glEndQuery(GL_TIME_ELAPSED);
+			glFlush();
+			cpu_ms.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - frame_start).count());
+		}
+	}
+
+	for (const GLuint query : queries) {
+		GLuint64 elapsed_ns = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+		gpu_ms.push_back(elapsed_ns / 1e6);
+	}
+	glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+
+	string json = "{\n";
+	json += "  \"trace\": \"" + options.trace_path + "\",\n";
+	json += string("  \"mode\": \"") + (options.paced ? "paced" : "fast") + "\",\n";
+	json += "  \"frames\": " + to_string(frame_count) + ",\n";
+	json += "  \"loops\": " + to_string(options.loops) + ",\n";
+	json += "  \"setup_ms\": " + to_string(setup_ms) + ",\n";
+	json += "  \"cpu_ms\": " + stats_json(compute_stats(cpu_ms)) + ",\n";
+	json += "  \"gpu_ms\": " + stats_json(compute_stats(gpu_ms)) + ",\n";
+	json += "  \"per_frame\": [";
+	for (size_t i = 0; i < cpu_ms.size(); i++) {
+		char sample[64];
+		snprintf(sample, sizeof(sample), "%s[%.4f, %.4f]", i > 0 ? ", " : "", cpu_ms[i], gpu_ms[i]);
+		json += sample;
+	}
+	json += "]\n}\n";
+
+	ofstream output(options.output_path, ios::out | ios::trunc);
+	output << json;
+
+	const bench_stats cpu = compute_stats(cpu_ms), gpu = compute_stats(gpu_ms);
+	printf("%zu frames x %d: cpu %.3f ms (p95 %.3f), gpu %.3f ms (p95 %.3f), setup %.3f ms -> %s\n",
+		frame_count, options.loops, cpu.mean, cpu.p95, gpu.mean, gpu.p95, setup_ms, options.output_path.c_str());
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,477 @@
+#include "alloc_tracker.h"
+
+#include "log.h"
+
+using namespace std;
+
+#if TRACK_ALLOCATIONS
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <Windows.h>
+#include <DbgHelp.h>
+#if _DEBUG
+#include <crtdbg.h>
+#endif
+
+#include "profiler.h"
+
+static const int max_stack_depth = 16;
+// power of two, open addressing by stack hash
+static const uint32_t site_capacity = 16384;
+static const int zone_capacity = 64;
+
+struct alloc_site {
+	// 0 - free slot
+	uint32_t hash;
+	int depth;
+	void* stack[max_stack_depth];
+	const char* zone;
+	uint64_t allocations;
+	uint64_t bytes;
+	uint64_t steady_allocations;
+	uint64_t first_frame;
+	uint64_t last_frame;
+};
+
+struct zone_counter {
+	// the zone is nullptr for allocations outside every zone, so it can't mark a free slot
+	bool used;
+	const char* zone;
+	uint64_t allocations;
+	uint64_t steady_allocations;
+};
+
+// fixed tables, the hooks must not allocate themselves
+static alloc_site sites[site_capacity];
+static zone_counter zones[zone_capacity];
+static uint64_t untracked_sites = 0;
+static atomic_flag table_lock = ATOMIC_FLAG_INIT;
+
+static atomic<bool> active(false);
+static atomic<uint64_t> frame(0);
+static uint64_t warmup = 0;
+static atomic<uint64_t> allocations(0), frees(0), bytes(0), steady_allocations(0), steady_bytes(0);
+// set while inside a hook or the report, so nested allocations are not counted twice
+static thread_local bool inside = false;
+
+static bool same_stack(const alloc_site& site, void* const* stack, const int depth) {
+	return site.depth == depth && equal(stack, stack + depth, site.stack);
+}
+
+static void count_zone(const char* zone, const bool steady) {
+	for (zone_counter& counter : zones) {
+		if (!counter.used || counter.zone == zone) {
+			counter.used = true;
+			counter.zone = zone;
+			counter.allocations++;
+			counter.steady_allocations += steady ? 1 : 0;
+			return;
+		}
+	}
+}
+
+static void record_allocation(const size_t size) {
+	if (!active.load(memory_order_relaxed) || inside) {
+		return;
+	}
+	inside = true;
+
+	const uint64_t current_frame = frame.load(memory_order_relaxed);
+	const bool steady = current_frame >= warmup;
+	allocations.fetch_add(1, memory_order_relaxed);
+	bytes.fetch_add(size, memory_order_relaxed);
+	if (steady) {
+		steady_allocations.fetch_add(1, memory_order_relaxed);
+		steady_bytes.fetch_add(size, memory_order_relaxed);
+	}
+
+	void* stack[max_stack_depth];
+	DWORD hash = 0;
+	// skip this function and the hook that called it
+	const int depth = CaptureStackBackTrace(2, max_stack_depth, stack, &hash);
+	const char* zone = profiler_current_zone();
+	const uint32_t key = hash != 0 ? static_cast<uint32_t>(hash) : 1;
+
+	while (table_lock.test_and_set(memory_order_acquire)) {
+	}
+	count_zone(zone, steady);
+	uint32_t index = key & (site_capacity - 1);
+	uint32_t probes = 0;
+	while (sites[index].hash != 0 && !(sites[index].hash == key && same_stack(sites[index], stack, depth))
+		&& ++probes < site_capacity) {
+		index = (index + 1) & (site_capacity - 1);
+	}
+	if (probes == site_capacity) {
+		untracked_sites++;
+	}
+	else {
+		alloc_site& site = sites[index];
+		if (site.hash == 0) {
+			site.hash = key;
+			site.depth = depth;
+			copy(stack, stack + depth, site.stack);
+			site.first_frame = current_frame;
+		}
+		// latest zone, so a site that keeps allocating shows where it does it now
+		site.zone = zone;
+		site.allocations++;
+		site.bytes += size;
+		site.steady_allocations += steady ? 1 : 0;
+		site.last_frame = current_frame;
+	}
+	table_lock.clear(memory_order_release);
+
+	inside = false;
+}
+
+static void record_free() {
+	if (active.load(memory_order_relaxed) && !inside) {
+		frees.fetch_add(1, memory_order_relaxed);
+	}
+}
+
+static void* tracked_allocate(const size_t size) {
+	record_allocation(size);
+	// the malloc underneath is the same allocation, keep the CRT hook from counting it
+	const bool nested = inside;
+	inside = true;
+	void* pointer = malloc(size != 0 ? size : 1);
+	inside = nested;
+	return pointer;
+}
+
+static void tracked_free(void* pointer) {
+	if (pointer == nullptr) {
+		return;
+	}
+	record_free();
+	const bool nested = inside;
+	inside = true;
+	free(pointer);
+	inside = nested;
+}
+
+void* alloc_tracker_malloc(const size_t size) {
+	return tracked_allocate(size);
+}
+
+void alloc_tracker_free(void* pointer) {
+	tracked_free(pointer);
+}
+
+void* operator new(const size_t size) {
+	void* pointer = tracked_allocate(size);
+	if (pointer == nullptr) {
+		throw bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](const size_t size) {
+	void* pointer = tracked_allocate(size);
+	if (pointer == nullptr) {
+		throw bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(const size_t size, const nothrow_t&) noexcept {
+	return tracked_allocate(size);
+}
+
+void* operator new[](const size_t size, const nothrow_t&) noexcept {
+	return tracked_allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+	tracked_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	tracked_free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+	tracked_free(pointer);
+}
+
+void operator delete(void* pointer, const nothrow_t&) noexcept {
+	tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, const nothrow_t&) noexcept {
+	tracked_free(pointer);
+}
+
+#if __cpp_aligned_new
+// over-aligned types (C++17 /Zc:alignedNew) come through these, from the aligned CRT heap
+static void* tracked_allocate_aligned(const size_t size, const align_val_t alignment) {
+	record_allocation(size);
+	const bool nested = inside;
+	inside = true;
+	void* pointer = _aligned_malloc(size != 0 ? size : 1, static_cast<size_t>(alignment));
+	inside = nested;
+	return pointer;
+}
+
+static void tracked_free_aligned(void* pointer) {
+	if (pointer == nullptr) {
+		return;
+	}
+	record_free();
+	const bool nested = inside;
+	inside = true;
+	_aligned_free(pointer);
+	inside = nested;
+}
+
+void* operator new(const size_t size, const align_val_t alignment) {
+	void* pointer = tracked_allocate_aligned(size, alignment);
+	if (pointer == nullptr) {
+		throw bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](const size_t size, const align_val_t alignment) {
+	void* pointer = tracked_allocate_aligned(size, alignment);
+	if (pointer == nullptr) {
+		throw bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(const size_t size, const align_val_t alignment, const nothrow_t&) noexcept {
+	return tracked_allocate_aligned(size, alignment);
+}
+
+void* operator new[](const size_t size, const align_val_t alignment, const nothrow_t&) noexcept {
+	return tracked_allocate_aligned(size, alignment);
+}
+
+void operator delete(void* pointer, align_val_t) noexcept {
+	tracked_free_aligned(pointer);
+}
+
+void operator delete[](void* pointer, align_val_t) noexcept {
+	tracked_free_aligned(pointer);
+}
+
+void operator delete(void* pointer, size_t, align_val_t) noexcept {
+	tracked_free_aligned(pointer);
+}
+
+void operator delete[](void* pointer, size_t, align_val_t) noexcept {
+	tracked_free_aligned(pointer);
+}
+
+void operator delete(void* pointer, align_val_t, const nothrow_t&) noexcept {
+	tracked_free_aligned(pointer);
+}
+
+void operator delete[](void* pointer, align_val_t, const nothrow_t&) noexcept {
+	tracked_free_aligned(pointer);
+}
+#endif
+
+#if _DEBUG
+// the debug CRT reports every malloc/realloc/free, which catches C allocations the operators never see
+static int __cdecl crt_alloc_hook(const int type, void*, const size_t size, const int block_type, long,
+	const unsigned char*, int) {
+	if (block_type == _CRT_BLOCK) {
+		return TRUE;
+	}
+	if (type == _HOOK_ALLOC || type == _HOOK_REALLOC) {
+		record_allocation(size);
+	}
+	else if (type == _HOOK_FREE) {
+		record_free();
+	}
+	return TRUE;
+}
+#endif
+
+bool alloc_tracker_enable(const int warmup_frames) {
+	warmup = warmup_frames > 0 ? warmup_frames : 0;
+	frame = 0;
+	#if _DEBUG
+	_CrtSetAllocHook(crt_alloc_hook);
+	#endif
+	active = true;
+	return true;
+}
+
+void alloc_tracker_disable() {
+	active = false;
+	#if _DEBUG
+	_CrtSetAllocHook(nullptr);
+	#endif
+}
+
+void alloc_tracker_frame() {
+	frame.fetch_add(1, memory_order_relaxed);
+}
+
+alloc_counts alloc_tracker_counts() {
+	alloc_counts counts;
+	counts.allocations = allocations;
+	counts.frees = frees;
+	counts.bytes = bytes;
+	counts.steady_allocations = steady_allocations;
+	counts.steady_bytes = steady_bytes;
+	return counts;
+}
+
+// dbghelp is loaded on demand, only the report needs it
+typedef BOOL (WINAPI* sym_initialize_function)(HANDLE, PCSTR, BOOL);
+typedef BOOL (WINAPI* sym_from_address_function)(HANDLE, DWORD64, DWORD64*, SYMBOL_INFO*);
+typedef BOOL (WINAPI* sym_line_from_address_function)(HANDLE, DWORD64, DWORD*, IMAGEHLP_LINE64*);
+
+struct symbolizer {
+	sym_from_address_function from_address = nullptr;
+	sym_line_from_address_function line_from_address = nullptr;
+
+	symbolizer() {
+		HMODULE dbghelp = LoadLibraryA("dbghelp.dll");
+		if (dbghelp == nullptr) {
+			return;
+		}
+		const auto initialize = reinterpret_cast<sym_initialize_function>(GetProcAddress(dbghelp, "SymInitialize"));
+		if (initialize == nullptr || !initialize(GetCurrentProcess(), nullptr, TRUE)) {
+			return;
+		}
+		from_address = reinterpret_cast<sym_from_address_function>(GetProcAddress(dbghelp, "SymFromAddr"));
+		line_from_address = reinterpret_cast<sym_line_from_address_function>(GetProcAddress(dbghelp, "SymGetLineFromAddr64"));
+	}
+
+	string describe(void* address) const {
+		char text[512];
+		snprintf(text, sizeof(text), "0x%llx", static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(address)));
+		if (from_address == nullptr) {
+			return text;
+		}
+
+		char storage[sizeof(SYMBOL_INFO) + 256] = {};
+		SYMBOL_INFO* symbol = reinterpret_cast<SYMBOL_INFO*>(storage);
+		symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+		symbol->MaxNameLen = 255;
+		const DWORD64 address64 = reinterpret_cast<uintptr_t>(address);
+		if (!from_address(GetCurrentProcess(), address64, nullptr, symbol)) {
+			return text;
+		}
+
+		IMAGEHLP_LINE64 line = {};
+		line.SizeOfStruct = sizeof(line);
+		DWORD displacement = 0;
+		if (line_from_address != nullptr && line_from_address(GetCurrentProcess(), address64, &displacement, &line)) {
+			snprintf(text, sizeof(text), "%s (%s:%lu)", symbol->Name, line.FileName, static_cast<unsigned long>(line.LineNumber));
+		}
+		else {
+			snprintf(text, sizeof(text), "%s", symbol->Name);
+		}
+		return text;
+	}
+};
+
+string alloc_tracker_report(const int top_sites) {
+	const bool nested = inside;
+	inside = true;
+
+	const alloc_counts counts = alloc_tracker_counts();
+	char line[256];
+	snprintf(line, sizeof(line), "allocations %llu (%llu bytes), frees %llu\n"
+		"after %llu warmup frames: %llu allocations (%llu bytes) over %llu frames\n",
+		static_cast<unsigned long long>(counts.allocations), static_cast<unsigned long long>(counts.bytes),
+		static_cast<unsigned long long>(counts.frees), static_cast<unsigned long long>(warmup),
+		static_cast<unsigned long long>(counts.steady_allocations), static_cast<unsigned long long>(counts.steady_bytes),
+		static_cast<unsigned long long>(frame > warmup ? frame - warmup : 0));
+	string report = line;
+	#if !_DEBUG
+	report += "release build: only operator new and alloc_tracker_malloc are counted, malloc from libraries "
+		"and the driver needs the debug CRT\n";
+	#endif
+
+	report += "by zone:\n";
+	for (const zone_counter& counter : zones) {
+		if (!counter.used) {
+			break;
+		}
+		snprintf(line, sizeof(line), "  %s: %llu, %llu after warmup\n", counter.zone != nullptr ? counter.zone : "(no zone)",
+			static_cast<unsigned long long>(counter.allocations), static_cast<unsigned long long>(counter.steady_allocations));
+		report += line;
+	}
+
+	// steady state offenders first, they are the ones that fail the check
+	vector<const alloc_site*> ranked;
+	for (const alloc_site& site : sites) {
+		if (site.hash != 0) {
+			ranked.push_back(&site);
+		}
+	}
+	sort(ranked.begin(), ranked.end(), [](const alloc_site* a, const alloc_site* b) {
+		return a->steady_allocations != b->steady_allocations
+			? a->steady_allocations > b->steady_allocations : a->allocations > b->allocations;
+	});
+	if (untracked_sites > 0) {
+		report += "call site table full, " + to_string(untracked_sites) + " allocations not attributed\n";
+	}
+
+	report += "top call sites:\n";
+	const symbolizer symbols;
+	for (int i = 0; i < top_sites && i < static_cast<int>(ranked.size()); i++) {
+		const alloc_site& site = *ranked[i];
+		snprintf(line, sizeof(line), "  #%d %llu allocations, %llu bytes, %llu after warmup, frames %llu-%llu, zone %s\n",
+			i + 1, static_cast<unsigned long long>(site.allocations), static_cast<unsigned long long>(site.bytes),
+			static_cast<unsigned long long>(site.steady_allocations), static_cast<unsigned long long>(site.first_frame),
+			static_cast<unsigned long long>(site.last_frame), site.zone != nullptr ? site.zone : "(none)");
+		report += line;
+		for (int depth = 0; depth < site.depth; depth++) {
+			report += "      " + symbols.describe(site.stack[depth]) + "\n";
+		}
+	}
+
+	inside = nested;
+	return report;
+}
+
+#else
+
+#include <cstdlib>
+
+void* alloc_tracker_malloc(const size_t size) {
+	return malloc(size);
+}
+
+void alloc_tracker_free(void* pointer) {
+	free(pointer);
+}
+
+bool alloc_tracker_enable(int) {
+	log("Allocation tracking needs an instrumented build, rebuild with TrackAllocations=1");
+	return false;
+}
+
+void alloc_tracker_disable() {
+}
+
+void alloc_tracker_frame() {
+}
+
+alloc_counts alloc_tracker_counts() {
+	return alloc_counts();
+}
+
+string alloc_tracker_report(int) {
+	return string();
+}
+
+#endif
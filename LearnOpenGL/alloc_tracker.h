@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// instrumentation build (TRACK_ALLOCATIONS=1, msbuild /p:TrackAllocations=1) replaces the global
+// operator new/delete and counts alloc_tracker_malloc. only the debug CRT reports every other
+// malloc (libraries, the driver), a release tracking build doesn't see those. every allocation is
+// charged to its call stack, the innermost profiler zone and the frame number
+
+struct alloc_counts {
+	uint64_t allocations = 0;
+	uint64_t frees = 0;
+	uint64_t bytes = 0;
+	// from the end of the warmup frames on
+	uint64_t steady_allocations = 0;
+	uint64_t steady_bytes = 0;
+};
+
+// malloc/free for our own C style blocks (arenas, command lists), counted in every tracking build
+void* alloc_tracker_malloc(size_t size);
+void alloc_tracker_free(void* pointer);
+
+// false if the build has no hooks
+bool alloc_tracker_enable(int warmup_frames);
+void alloc_tracker_disable();
+// frame boundary of the main loop
+void alloc_tracker_frame();
+alloc_counts alloc_tracker_counts();
+// totals, allocations per zone and the call sites that allocated most, with symbolized stacks
+std::string alloc_tracker_report(int top_sites);
@@ -0,0 +1,191 @@
+#include "app_options.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "log.h"
+
+using namespace std;
+
+static bool match(const char* arg, const char* name, const char** value) {
+	const size_t length = strlen(name);
+	if (strncmp(arg, name, length) != 0) {
+		return false;
+	}
+	if (arg[length] == '=') {
+		*value = arg + length + 1;
+		return true;
+	}
+	if (arg[length] == '\0') {
+		*value = nullptr;
+		return true;
+	}
+	return false;
+}
+
+app_options parse_options(const int argc, char* argv[]) {
+	app_options options;
+
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* value = nullptr;
+
+		if (match(arg, "--startup-report", &value)) {
+			options.startup_report_path = value != nullptr ? value : "startup_report.json";
+		}
+		else if (match(arg, "--exit-after-first-frame", &value)) {
+			options.exit_after_first_frame = true;
+		}
+		else if (match(arg, "--glew-baseline", &value)) {
+			options.glew_baseline = true;
+		}
+		else if (match(arg, "--frames", &value) && value != nullptr) {
+			options.frame_limit = atoi(value);
+		}
+		else if (match(arg, "--seconds", &value) && value != nullptr) {
+			options.run_seconds = atof(value);
+		}
+		else if (match(arg, "--on-demand", &value)) {
+			options.on_demand = true;
+		}
+		else if (match(arg, "--render-graph", &value)) {
+			options.render_graph = value != nullptr && strcmp(value, "noalias") == 0 ? 2 : 1;
+		}
+		else if (match(arg, "--post-unfused", &value)) {
+			options.post_unfused = true;
+		}
+		else if (match(arg, "--post-bench", &value)) {
+			options.post_bench = true;
+		}
+		else if (match(arg, "--auto-exposure", &value)) {
+			options.auto_exposure = true;
+		}
+		else if (match(arg, "--exposure-bench", &value)) {
+			options.exposure_bench = true;
+		}
+		else if (match(arg, "--render-thread", &value)) {
+			options.render_thread = true;
+		}
+		else if (match(arg, "--pacing", &value)) {
+			// --pacing=limit:144, the rate is optional
+			const char* rate = value != nullptr ? strchr(value, ':') : nullptr;
+			if (value == nullptr || strcmp(value, "vsync") == 0) {
+				options.pacing = 3;
+			}
+			else if (strncmp(value, "limit", 5) == 0) {
+				options.pacing = 2;
+				options.pacing_fps = rate != nullptr ? atof(rate + 1) : 0.0;
+			}
+			else if (strcmp(value, "low-latency") == 0) {
+				options.pacing = 4;
+			}
+			else if (strcmp(value, "unpaced") == 0) {
+				options.pacing = 1;
+			}
+			else {
+				log(string("Unknown pacing mode: ") + value);
+			}
+		}
+		else if (match(arg, "--record", &value)) {
+			options.record_path = value != nullptr ? value : "frames.gltrace";
+		}
+		else if (match(arg, "--stats", &value)) {
+			options.render_stats_path = value != nullptr ? value : "render_stats.json";
+		}
+		else if (match(arg, "--gpu-memory", &value)) {
+			options.gpu_memory_report_seconds = value != nullptr ? atof(value) : 5.0;
+		}
+		else if (match(arg, "--gpu-budget", &value) && value != nullptr) {
+			options.gpu_budget = value;
+			if (options.gpu_memory_report_seconds < 0.0) {
+				options.gpu_memory_report_seconds = 0.0;
+			}
+		}
+		else if (match(arg, "--alloc-check", &value)) {
+			options.alloc_check_warmup = value != nullptr ? atoi(value) : 10;
+		}
+		else if (match(arg, "--software-compare", &value)) {
+			options.software_compare = true;
+		}
+		else if (match(arg, "--software-bench", &value)) {
+			options.software_bench_triangles = value != nullptr ? atoi(value) : 200000;
+		}
+		else if (match(arg, "--software", &value)) {
+			options.software_output_path = value != nullptr ? value : "software.ppm";
+		}
+		else if (match(arg, "--city", &value)) {
+			options.city_objects = value != nullptr ? atoi(value) : 10000;
+		}
+		else if (match(arg, "--occlusion-bench", &value)) {
+			options.occlusion_bench = true;
+		}
+		else if (match(arg, "--occlusion", &value)) {
+			options.occluders = value != nullptr ? atoi(value) : 48;
+		}
+		else if (match(arg, "--frustum-bench", &value)) {
+			options.frustum_bench_objects = value != nullptr ? atoi(value) : 1000000;
+		}
+		else if (match(arg, "--bvh-bench", &value)) {
+			options.bvh_bench_counts = value != nullptr ? value : "100000,1000000,10000000";
+		}
+		else if (match(arg, "--gpu-cull", &value)) {
+			options.gpu_cull = value != nullptr && strcmp(value, "hiz") == 0 ? 2 : 1;
+		}
+		else if (match(arg, "--command-lists", &value)) {
+			options.command_lists = value != nullptr && strcmp(value, "sorted") == 0 ? 2 : 1;
+		}
+		else if (match(arg, "--command-bench", &value)) {
+			options.command_bench_commands = value != nullptr ? atoi(value) : 100000;
+		}
+		else if (match(arg, "--sprite-bench", &value)) {
+			options.sprite_bench_sprites = value != nullptr ? atoi(value) : 1000000;
+		}
+		else if (match(arg, "--lights", &value)) {
+			options.city_lights = value != nullptr ? atoi(value) : 1000;
+		}
+		else if (match(arg, "--light-bench", &value)) {
+			options.light_bench_counts = value != nullptr ? value : "100,1000,10000";
+		}
+		else if (match(arg, "--deferred-bench", &value)) {
+			options.deferred_bench_lights = value != nullptr ? atoi(value) : 1000;
+		}
+		else if (match(arg, "--deferred", &value)) {
+			options.deferred = true;
+		}
+		else if (match(arg, "--shadows", &value)) {
+			options.shadow_map_size = value != nullptr ? atoi(value) : 1024;
+		}
+		else if (match(arg, "--shadow-bench", &value)) {
+			options.shadow_bench = true;
+			if (value != nullptr) {
+				options.shadow_map_size = atoi(value);
+			}
+		}
+		else if (match(arg, "--font", &value) && value != nullptr) {
+			options.font_path = value;
+		}
+		else if (match(arg, "--text-bench", &value)) {
+			options.text_bench_glyphs = value != nullptr ? atoi(value) : 100000;
+		}
+		else if (match(arg, "--bvh", &value)) {
+			options.city_bvh = true;
+		}
+		else if (match(arg, "--job-bench", &value)) {
+			options.job_bench_threads = value != nullptr ? atoi(value) : 64;
+		}
+		else if (match(arg, "--startup-bench", &value)) {
+			options.startup_bench_runs = value != nullptr ? atoi(value) : 10;
+		}
+		else if (match(arg, "--cold", &value)) {
+			options.startup_bench_cold = true;
+		}
+		else if (match(arg, "--bench-output", &value) && value != nullptr) {
+			options.bench_output_path = value;
+		}
+		else {
+			log(string("Unknown option: ") + arg);
+		}
+	}
+
+	return options;
+}
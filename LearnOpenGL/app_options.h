@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+
+// command line switches, see parse_options() for the spelling of each one
+struct app_options {
+	// write the startup report as JSON to this path (empty - only log it)
+	std::string startup_report_path;
+	// quit right after the first frame has been presented
+	bool exit_after_first_frame = false;
+	// also run glewInit() after the loader, as the startup report's glew_init phase
+	bool glew_baseline = false;
+	// quit after this many frames (0 - run until the window is closed)
+	int frame_limit = 0;
+	// quit after this many seconds of frames (0 - no limit)
+	double run_seconds = 0.0;
+
+	// wait for events and redraw only what input, resources or animation damaged
+	bool on_demand = false;
+	// draw through the render graph with bloom: 0 - off, 1 - on, 2 - on without aliasing transient targets
+	int render_graph = 0;
+	// the render graph's per-pixel post effects one pass each instead of fused into one
+	bool post_unfused = false;
+	// post-processing fused and unfused, with the GPU time of every pass
+	bool post_bench = false;
+	// the render graph's exposure from a GPU luminance histogram (GL 4.3)
+	bool auto_exposure = false;
+	// the luminance histogram and adaptation against the same math on the CPU, and their GPU time
+	bool exposure_bench = false;
+
+	// hand the GL context to a render thread fed with frame packets, so the main thread builds the
+	// next frame while the last one is drawn
+	bool render_thread = false;
+	// frame pacing: 0 - off, 1 - unpaced but measured, 2 - limited to pacing_fps, 3 - vsync,
+	// 4 - vsync with frames started as late as possible
+	int pacing = 0;
+	// the limit's rate (0 - display refresh rate)
+	double pacing_fps = 0.0;
+
+	// record the GL calls into this file for GLReplay
+	std::string record_path;
+
+	// count per frame work, show it on screen (F1 toggles) and write it to this file at exit
+	std::string render_stats_path;
+
+	// track GPU memory per category and log the totals every this many seconds (negative - off, 0 - only at exit)
+	double gpu_memory_report_seconds = -1.0;
+	// per category budgets in megabytes, "mesh:64,texture:256"
+	std::string gpu_budget;
+
+	// instrumented builds: fail the run if anything allocates after this many frames (negative - off)
+	int alloc_check_warmup = -1;
+
+	// render the scene with the software rasterizer into this image instead of opening a window
+	std::string software_output_path;
+	// render the first frame with both backends and log how far apart they are
+	bool software_compare = false;
+	// software rasterizer benchmark with this many triangles
+	int software_bench_triangles = 0;
+
+	// draw the city scene with this many objects instead of the quad (0 - off)
+	int city_objects = 0;
+	// cull the city with this many buildings as software occluders (0 - off)
+	int occluders = 0;
+	// draw the city path with and without occlusion culling and compare the times
+	bool occlusion_bench = false;
+	// frustum culling benchmark with this many objects
+	int frustum_bench_objects = 0;
+	// cull the city through a BVH instead of testing every object
+	bool city_bvh = false;
+	// cull and compact the city's draws with compute shaders: 0 - off, 1 - frustum, 2 - frustum and Hi-Z
+	int gpu_cull = 0;
+	// record the city's draws into command lists on the job system and replay them on the GL thread:
+	// 0 - off, 1 - in order, 2 - sorted near to far
+	int command_lists = 0;
+	// this many point lights in the city, shaded through clustered_lights (0 - off)
+	int city_lights = 0;
+	// clustered lighting benchmark at these light counts, "100,1000" (empty - off)
+	std::string light_bench_counts;
+	// shade the city through a G-buffer (deferred_shading.h) instead of in the draws
+	bool deferred = false;
+	// forward against deferred shading with this many lights (0 - off)
+	int deferred_bench_lights = 0;
+	// cascaded sun shadows with maps of this size (0 - off)
+	int shadow_map_size = 0;
+	// the shadow pass with and without cached cascades
+	bool shadow_bench = false;
+	// command list recording and replay benchmark with this many commands
+	int command_bench_commands = 0;
+	// sprite batch benchmark with this many sprites
+	int sprite_bench_sprites = 0;
+	// TrueType font for the on-screen text (empty - no text)
+	std::string font_path;
+	// SDF text benchmark with this many glyphs per frame
+	int text_bench_glyphs = 0;
+	// BVH benchmark at these object counts, "100000,1000000" (empty - off)
+	std::string bvh_bench_counts;
+
+	// job system benchmark on 1, 2, 4 ... up to this many threads (0 - off)
+	int job_bench_threads = 0;
+
+	// startup benchmark: relaunch the executable this many times and collect the reports
+	int startup_bench_runs = 0;
+	bool startup_bench_cold = false;
+
+	// where the benchmark modes write their JSON statistics (empty - mode specific default)
+	std::string bench_output_path;
+};
+
+app_options parse_options(int argc, char* argv[]);
@@ -0,0 +1,130 @@
+#include "auto_exposure.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gpu_resources.h"
+#include "log.h"
+#include "shader.h"
+
+using namespace std;
+
+// what the histogram covers, in stops: 1/1024 up to 64
+static const float min_log_luminance = -10.0f;
+static const float log_luminance_range = 16.0f;
+// the average luminance ends up here after the exposure, and the exposure stays within limits
+static const float key = 0.25f;
+static const float min_exposure = 1.0f / 16.0f;
+static const float max_exposure = 16.0f;
+// per second: about 80% of the way to the new average after one
+static const float adaptation_rate = 1.6f;
+// pixels a histogram work group covers across, 16x16 threads of 2x2 pixels
+static const int group_pixels = 32;
+
+static GLuint histogram_program = 0;
+static GLuint adapt_program = 0;
+static GLuint state_buffer = 0;
+static GLint min_log_location = -1;
+static GLint inverse_range_location = -1;
+static GLint pixel_count_location = -1;
+static GLint adaptation_location = -1;
+
+bool auto_exposure_supported() {
+	return gl_api_has_version(4, 3);
+}
+
+bool auto_exposure_init() {
+	if (!auto_exposure_supported()) {
+		log("Auto-exposure needs OpenGL 4.3");
+		return false;
+	}
+	histogram_program = load_compute_program("luminance_histogram.comp");
+	adapt_program = load_compute_program("exposure_adapt.comp");
+	if (histogram_program == 0 || adapt_program == 0) {
+		auto_exposure_release();
+		return false;
+	}
+	min_log_location = glGetUniformLocation(histogram_program, "min_log_luminance");
+	inverse_range_location = glGetUniformLocation(histogram_program, "inverse_log_luminance_range");
+	pixel_count_location = glGetUniformLocation(adapt_program, "pixel_count");
+	adaptation_location = glGetUniformLocation(adapt_program, "adaptation");
+	glUseProgram(adapt_program);
+	glUniform1f(glGetUniformLocation(adapt_program, "min_log_luminance"), min_log_luminance);
+	glUniform1f(glGetUniformLocation(adapt_program, "log_luminance_range"), log_luminance_range);
+	glUniform1f(glGetUniformLocation(adapt_program, "key"), key);
+	glUniform2f(glGetUniformLocation(adapt_program, "exposure_limits"), min_exposure, max_exposure);
+	glUseProgram(0);
+
+	// the adapted luminance, carried from frame to frame on the GPU
+	gpu_category_scope category(gpu_category::streaming);
+	glGenBuffers(1, &state_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, state_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	auto_exposure_reset();
+	return true;
+}
+
+void auto_exposure_release() {
+	glDeleteProgram(histogram_program);
+	glDeleteProgram(adapt_program);
+	glDeleteBuffers(1, &state_buffer);
+	histogram_program = adapt_program = state_buffer = 0;
+}
+
+void auto_exposure_reset() {
+	const float nothing_adapted = 0.0f;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, state_buffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(nothing_adapted), &nothing_adapted);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void auto_exposure_histogram(const GLuint hdr_texture, const int width, const int height, const GLuint histogram) {
+	static const GLuint empty_bins[auto_exposure_histogram_bytes / sizeof(GLuint)] = {};
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, histogram);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(empty_bins), empty_bins);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glUseProgram(histogram_program);
+	glUniform1f(min_log_location, min_log_luminance);
+	glUniform1f(inverse_range_location, 1.0f / log_luminance_range);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, hdr_texture);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, histogram);
+	glDispatchCompute((width + group_pixels - 1) / group_pixels, (height + group_pixels - 1) / group_pixels, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void auto_exposure_adapt(const GLuint histogram, const int width, const int height, const float seconds,
+	const GLuint result) {
+	glUseProgram(adapt_program);
+	glUniform1f(pixel_count_location, static_cast<float>(width) * height);
+	glUniform1f(adaptation_location, auto_exposure_adaptation(seconds));
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, histogram);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, state_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, result);
+	glDispatchCompute(1, 1, 1);
+	// the tonemapping reads result in a fragment shader
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+int auto_exposure_bin(const float luminance) {
+	if (luminance <= 0.0001f) {
+		return 0;
+	}
+	const float position = min(max((log2(luminance) - min_log_luminance) / log_luminance_range, 0.0f), 1.0f);
+	return static_cast<int>(position * 254.0f + 1.0f);
+}
+
+float auto_exposure_bin_luminance(const float bin) {
+	return exp2((bin - 1.0f) / 254.0f * log_luminance_range + min_log_luminance);
+}
+
+float auto_exposure_for(const float luminance) {
+	return luminance > 0.0f ? min(max(key / luminance, min_exposure), max_exposure) : 1.0f;
+}
+
+float auto_exposure_adaptation(const float seconds) {
+	return 1.0f - exp(-seconds * adaptation_rate);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "gl_api.h"
+
+// eye adaptation on the GPU (GL 4.3): a compute pass sorts the HDR scene's pixels into a 256 bin
+// histogram of log2 luminance, counted in shared memory and added to the global bins once per work
+// group, then a single 256 thread work group reduces the bins to the average luminance, adapts
+// towards it exponentially and writes the exposure to a storage buffer the tonemapping reads. the
+// CPU never reads anything back
+
+// histogram bins and the exposure the tonemapping reads, as storage buffer sizes
+const int auto_exposure_histogram_bytes = 256 * 4;
+const int auto_exposure_result_bytes = 16;
+// where the tonemapping finds the result: float average_luminance, float exposure
+const GLuint auto_exposure_binding = 0;
+
+bool auto_exposure_supported();
+bool auto_exposure_init();
+void auto_exposure_release();
+// forget the adapted luminance, the next frame snaps to its own average
+void auto_exposure_reset();
+// clears histogram and adds the texture's pixels
+void auto_exposure_histogram(GLuint hdr_texture, int width, int height, GLuint histogram);
+// the histogram of width x height pixels to the exposure in result; seconds since the last frame
+// (0 - snap to this frame's average)
+void auto_exposure_adapt(GLuint histogram, int width, int height, float seconds, GLuint result);
+
+// the histogram's binning on the CPU: bin of a luminance, and the luminance a bin stands for
+int auto_exposure_bin(float luminance);
+float auto_exposure_bin_luminance(float bin);
+// the exposure an adapted average luminance gets
+float auto_exposure_for(float luminance);
+// fraction of the way to the target luminance adaptation covers in seconds
+float auto_exposure_adaptation(float seconds);
@@ -0,0 +1,78 @@
+#include "bench_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "gl_api.h"
+#include "log.h"
+
+using namespace std;
+
+bench_stats compute_stats(vector<double> values) {
+	bench_stats stats;
+	if (values.empty()) {
+		return stats;
+	}
+	sort(values.begin(), values.end());
+
+	double sum = 0.0;
+	for (const double value : values) {
+		sum += value;
+	}
+	stats.mean = sum / values.size();
+
+	double variance = 0.0;
+	for (const double value : values) {
+		variance += (value - stats.mean) * (value - stats.mean);
+	}
+	stats.stddev = sqrt(variance / values.size());
+
+	const auto percentile = [&values](const double p) {
+		return values[min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5))];
+	};
+	stats.min = values.front();
+	stats.median = percentile(0.5);
+	stats.p95 = percentile(0.95);
+	stats.max = values.back();
+	return stats;
+}
+
+string stats_json(const bench_stats& stats) {
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"{\"min\": %.3f, \"mean\": %.3f, \"median\": %.3f, \"p95\": %.3f, \"max\": %.3f, \"stddev\": %.3f}",
+		stats.min, stats.mean, stats.median, stats.p95, stats.max, stats.stddev);
+	return buffer;
+}
+
+double elapsed_ms(const bench_clock::time_point since) {
+	return chrono::duration<double, milli>(bench_clock::now() - since).count();
+}
+
+void read_pixels(vector<uint8_t>& pixels, const int width, const int height) {
+	pixels.resize(static_cast<size_t>(width) * height * 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+int differing_pixels(const vector<uint8_t>& a, const vector<uint8_t>& b) {
+	int count = 0;
+	for (size_t i = 0; i < a.size(); i += 4) {
+		count += equal(&a[i], &a[i] + 4, &b[i]) ? 0 : 1;
+	}
+	return count;
+}
+
+bool write_bench_json(const string& path, const char* default_name, const string& json, const char* label) {
+	const string output_path = path.empty() ? default_name : path;
+	ofstream output(output_path, ios::out | ios::trunc);
+	output << json;
+	if (!output) {
+		log("Failed to write " + output_path);
+		return false;
+	}
+	log(string(label) + " written to " + output_path);
+	return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+// summary of a series of benchmark samples
+struct bench_stats {
+	double min = 0.0;
+	double mean = 0.0;
+	double median = 0.0;
+	double p95 = 0.0;
+	double max = 0.0;
+	double stddev = 0.0;
+};
+
+bench_stats compute_stats(std::vector<double> values);
+// {"min": .., "mean": .., "median": .., "p95": .., "max": .., "stddev": ..}
+std::string stats_json(const bench_stats& stats);
+
+double elapsed_ms(bench_clock::time_point since);
+// the bound read framebuffer as tightly packed RGBA8, bottom row first
+void read_pixels(std::vector<uint8_t>& pixels, int width, int height);
+// pixels whose RGBA isn't exactly the same in two read_pixels images of one size
+int differing_pixels(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b);
+// writes json to path, or to default_name when path is empty, and logs "<label> written to ..";
+// false (logged) if the file couldn't be written
+bool write_bench_json(const std::string& path, const char* default_name, const std::string& json, const char* label);
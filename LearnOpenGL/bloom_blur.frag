@@ -0,0 +1,21 @@
+#version 330 core
+
+in vec2 screen_uv;
+out vec4 color;
+
+uniform sampler2D source;
+// one texel along the blur's axis
+uniform vec2 texel_step;
+
+// 9 tap gaussian folded into 5 bilinear fetches
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main() {
+	vec3 sum = texture(source, screen_uv).rgb * weights[0];
+	for (int i = 1; i < 3; i++) {
+		sum += texture(source, screen_uv + texel_step * offsets[i]).rgb * weights[i];
+		sum += texture(source, screen_uv - texel_step * offsets[i]).rgb * weights[i];
+	}
+	color = vec4(sum, 1.0);
+}
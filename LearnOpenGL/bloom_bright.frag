@@ -0,0 +1,25 @@
+#version 330 core
+
+in vec2 screen_uv;
+out vec4 color;
+
+uniform sampler2D scene;
+uniform float threshold;
+// one texel of the scene
+uniform vec2 scene_texel;
+
+void main() {
+	// four bilinear fetches average the 4x4 scene texels under this quarter resolution texel
+	vec3 scene_color = vec3(0.0);
+	for (int i = 0; i < 4; i++) {
+		vec2 offset = vec2((i & 1) == 0 ? -1.0 : 1.0, (i & 2) == 0 ? -1.0 : 1.0);
+		scene_color += texture(scene, screen_uv + offset * scene_texel).rgb * 0.25;
+	}
+	// a soft knee, so the bloom fades in instead of switching on at the threshold
+	float brightness = max(scene_color.r, max(scene_color.g, scene_color.b));
+	float knee = threshold * 0.5;
+	float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+	soft = soft * soft / (4.0 * knee + 0.0001);
+	float weight = max(soft, brightness - threshold) / max(brightness, 0.0001);
+	color = vec4(scene_color * weight, 1.0);
+}
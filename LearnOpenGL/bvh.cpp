@@ -0,0 +1,354 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+static const int bin_count = 16;
+static const uint32_t max_leaf_size = 4;
+// nodes that cannot be split well still get split above this size, leaves are scanned linearly
+static const uint32_t max_unsplit_leaf_size = 16;
+// cost of visiting a node relative to testing one primitive box
+static const float traversal_cost = 1.0f;
+
+static bvh_box empty_box() {
+	return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+}
+
+static void grow(bvh_box& box, const vec3& point) {
+	box.min = { min(box.min.x, point.x), min(box.min.y, point.y), min(box.min.z, point.z) };
+	box.max = { max(box.max.x, point.x), max(box.max.y, point.y), max(box.max.z, point.z) };
+}
+
+static void grow(bvh_box& box, const bvh_box& other) {
+	grow(box, other.min);
+	grow(box, other.max);
+}
+
+// half the surface area, the constant factor cancels out in the heuristic
+static float half_area(const bvh_box& box) {
+	const vec3 size = box.max - box.min;
+	if (size.x < 0.0f) {
+		return 0.0f;
+	}
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+static float axis_value(const vec3& v, const int axis) {
+	return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+
+static bool is_leaf(const bvh_node& node) {
+	return (node.data & bvh_leaf_flag) != 0;
+}
+
+static uint32_t leaf_count(const bvh_node& node) {
+	return node.data & ~bvh_leaf_flag;
+}
+
+// index of the node after the subtree
+static uint32_t escape(const bvh_node& node, const uint32_t index) {
+	return is_leaf(node) ? index + 1 : node.data;
+}
+
+static void set_bounds(bvh_node& node, const bvh_box& box) {
+	node.min[0] = box.min.x;
+	node.min[1] = box.min.y;
+	node.min[2] = box.min.z;
+	node.max[0] = box.max.x;
+	node.max[1] = box.max.y;
+	node.max[2] = box.max.z;
+}
+
+static bvh_box node_box(const bvh_node& node) {
+	return { { node.min[0], node.min[1], node.min[2] }, { node.max[0], node.max[1], node.max[2] } };
+}
+
+// objects are sorted in place as whole items, so every pass of the build reads memory in order
+struct build_item {
+	bvh_box box;
+	vec3 centroid;
+	uint32_t index;
+};
+
+struct bin {
+	bvh_box bounds;
+	uint32_t count;
+};
+
+static void build_node(vector<bvh_node>& nodes, build_item* items, const uint32_t begin, const uint32_t end) {
+	bvh_box bounds = empty_box(), centroid_bounds = empty_box();
+	for (uint32_t i = begin; i < end; i++) {
+		grow(bounds, items[i].box);
+		grow(centroid_bounds, items[i].centroid);
+	}
+
+	const uint32_t index = static_cast<uint32_t>(nodes.size());
+	nodes.push_back(bvh_node());
+	set_bounds(nodes[index], bounds);
+	nodes[index].first = begin;
+
+	const uint32_t count = end - begin;
+	if (count <= max_leaf_size) {
+		nodes[index].data = bvh_leaf_flag | count;
+		return;
+	}
+
+	// binned surface area heuristic over the centroids: bin_count - 1 candidate planes per axis,
+	// all three axes binned in the same pass
+	float low[3], scale[3];
+	bin bins[3][bin_count];
+	for (int axis = 0; axis < 3; axis++) {
+		low[axis] = axis_value(centroid_bounds.min, axis);
+		const float extent = axis_value(centroid_bounds.max, axis) - low[axis];
+		scale[axis] = extent > 0.0f ? bin_count / extent : 0.0f;
+		for (bin& b : bins[axis]) {
+			b.bounds = empty_box();
+			b.count = 0;
+		}
+	}
+	for (uint32_t i = begin; i < end; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			const int b = min(bin_count - 1, static_cast<int>((axis_value(items[i].centroid, axis) - low[axis]) * scale[axis]));
+			grow(bins[axis][b].bounds, items[i].box);
+			bins[axis][b].count++;
+		}
+	}
+
+	int best_axis = -1, best_split = 0;
+	float best_cost = FLT_MAX;
+	for (int axis = 0; axis < 3; axis++) {
+		if (scale[axis] == 0.0f) {
+			continue;
+		}
+		// right to left sweep first, then the left side is accumulated while the costs are compared
+		float right_area[bin_count];
+		uint32_t right_count[bin_count];
+		bvh_box right = empty_box();
+		uint32_t right_total = 0;
+		for (int b = bin_count - 1; b > 0; b--) {
+			grow(right, bins[axis][b].bounds);
+			right_total += bins[axis][b].count;
+			right_area[b] = half_area(right);
+			right_count[b] = right_total;
+		}
+		bvh_box left = empty_box();
+		uint32_t left_total = 0;
+		for (int split = 1; split < bin_count; split++) {
+			grow(left, bins[axis][split - 1].bounds);
+			left_total += bins[axis][split - 1].count;
+			if (left_total == 0 || right_count[split] == 0) {
+				continue;
+			}
+			const float cost = half_area(left) * left_total + right_area[split] * right_count[split];
+			if (cost < best_cost) {
+				best_cost = cost;
+				best_axis = axis;
+				best_split = split;
+			}
+		}
+	}
+
+	uint32_t middle = begin;
+	if (best_axis >= 0) {
+		const float split_cost = traversal_cost + best_cost / half_area(bounds);
+		if (split_cost >= count && count <= max_unsplit_leaf_size) {
+			nodes[index].data = bvh_leaf_flag | count;
+			return;
+		}
+		const float axis_low = low[best_axis], axis_scale = scale[best_axis];
+		middle = static_cast<uint32_t>(partition(items + begin, items + end, [&](const build_item& item) {
+			return min(bin_count - 1, static_cast<int>((axis_value(item.centroid, best_axis) - axis_low) * axis_scale)) < best_split;
+		}) - items);
+	}
+	// every centroid in the same spot (or rounding emptied a side): split the range in half
+	if (middle == begin || middle == end) {
+		middle = begin + count / 2;
+	}
+
+	build_node(nodes, items, begin, middle);
+	build_node(nodes, items, middle, end);
+	nodes[index].data = static_cast<uint32_t>(nodes.size());
+}
+
+void bvh_build(bvh& tree, const bvh_box* boxes, const size_t count) {
+	tree.nodes.clear();
+	tree.primitives.resize(count);
+	tree.boxes.resize(count);
+	if (count == 0) {
+		return;
+	}
+	tree.nodes.reserve(count * 2 / max_leaf_size + 1);
+
+	vector<build_item> items(count);
+	for (size_t i = 0; i < count; i++) {
+		items[i] = { boxes[i], (boxes[i].min + boxes[i].max) * 0.5f, static_cast<uint32_t>(i) };
+	}
+	build_node(tree.nodes, items.data(), 0, static_cast<uint32_t>(count));
+
+	for (size_t i = 0; i < count; i++) {
+		tree.primitives[i] = items[i].index;
+		tree.boxes[i] = items[i].box;
+	}
+}
+
+void bvh_refit(bvh& tree, const bvh_box* boxes) {
+	for (size_t i = 0; i < tree.primitives.size(); i++) {
+		tree.boxes[i] = boxes[tree.primitives[i]];
+	}
+	// depth first order puts children after their parent, so walking backwards refits them first
+	for (uint32_t i = static_cast<uint32_t>(tree.nodes.size()); i-- > 0;) {
+		bvh_node& node = tree.nodes[i];
+		bvh_box bounds = empty_box();
+		if (is_leaf(node)) {
+			for (uint32_t k = node.first; k < node.first + leaf_count(node); k++) {
+				grow(bounds, tree.boxes[k]);
+			}
+		}
+		else {
+			const uint32_t left = i + 1;
+			const uint32_t right = escape(tree.nodes[left], left);
+			bounds = node_box(tree.nodes[left]);
+			grow(bounds, node_box(tree.nodes[right]));
+		}
+		set_bounds(node, bounds);
+	}
+}
+
+float bvh_sah_cost(const bvh& tree) {
+	if (tree.nodes.empty()) {
+		return 0.0f;
+	}
+	const float root_area = half_area(node_box(tree.nodes[0]));
+	if (root_area <= 0.0f) {
+		return static_cast<float>(tree.primitives.size());
+	}
+	double cost = 0.0;
+	for (const bvh_node& node : tree.nodes) {
+		const float area = half_area(node_box(node)) / root_area;
+		cost += is_leaf(node) ? area * leaf_count(node) : area * traversal_cost;
+	}
+	return static_cast<float>(cost);
+}
+
+enum class box_side {
+	outside,
+	intersects,
+	inside
+};
+
+// same test as frustum_cull() with cull_volume::box, plus whether the box is entirely inside
+static box_side classify(const frustum& view, const float* box_min, const float* box_max) {
+	const float cx = (box_min[0] + box_max[0]) * 0.5f, ex = (box_max[0] - box_min[0]) * 0.5f;
+	const float cy = (box_min[1] + box_max[1]) * 0.5f, ey = (box_max[1] - box_min[1]) * 0.5f;
+	const float cz = (box_min[2] + box_max[2]) * 0.5f, ez = (box_max[2] - box_min[2]) * 0.5f;
+	box_side side = box_side::inside;
+	for (const float* p : view.planes) {
+		const float distance = p[0] * cx + p[1] * cy + p[2] * cz + p[3];
+		const float reach = fabs(p[0]) * ex + fabs(p[1]) * ey + fabs(p[2]) * ez;
+		if (distance + reach < 0.0f) {
+			return box_side::outside;
+		}
+		if (distance - reach < 0.0f) {
+			side = box_side::intersects;
+		}
+	}
+	return side;
+}
+
+size_t bvh_cull_frustum(const bvh& tree, const frustum& view, uint32_t* output) {
+	const bvh_node* nodes = tree.nodes.data();
+	const uint32_t node_count = static_cast<uint32_t>(tree.nodes.size());
+	size_t count = 0;
+	uint32_t i = 0;
+	while (i < node_count) {
+		const bvh_node& node = nodes[i];
+		const uint32_t next = escape(node, i);
+		const box_side side = classify(view, node.min, node.max);
+		if (side == box_side::inside) {
+			// the subtree's last node is its last leaf, where its primitive range ends
+			const bvh_node& last = nodes[next - 1];
+			const uint32_t end = last.first + leaf_count(last);
+			memcpy(output + count, tree.primitives.data() + node.first, (end - node.first) * sizeof(uint32_t));
+			count += end - node.first;
+		}
+		else if (side == box_side::intersects && is_leaf(node)) {
+			for (uint32_t k = node.first; k < node.first + leaf_count(node); k++) {
+				const bvh_box& box = tree.boxes[k];
+				if (classify(view, &box.min.x, &box.max.x) != box_side::outside) {
+					output[count++] = tree.primitives[k];
+				}
+			}
+		}
+		else if (side == box_side::intersects) {
+			i++;
+			continue;
+		}
+		i = next;
+	}
+	return count;
+}
+
+// slab test against the segment's parameter range
+static bool ray_hits(const float* box_min, const float* box_max, const vec3& origin, const vec3& inverse, const float max_t) {
+	const float tx0 = (box_min[0] - origin.x) * inverse.x, tx1 = (box_max[0] - origin.x) * inverse.x;
+	const float ty0 = (box_min[1] - origin.y) * inverse.y, ty1 = (box_max[1] - origin.y) * inverse.y;
+	const float tz0 = (box_min[2] - origin.z) * inverse.z, tz1 = (box_max[2] - origin.z) * inverse.z;
+	const float t_enter = max(max(min(tx0, tx1), min(ty0, ty1)), max(min(tz0, tz1), 0.0f));
+	const float t_exit = min(min(max(tx0, tx1), max(ty0, ty1)), min(max(tz0, tz1), max_t));
+	return t_enter <= t_exit;
+}
+
+size_t bvh_query_ray(const bvh& tree, const vec3& origin, const vec3& direction, const float max_t, uint32_t* output) {
+	const vec3 inverse = { 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+	const uint32_t node_count = static_cast<uint32_t>(tree.nodes.size());
+	size_t count = 0;
+	uint32_t i = 0;
+	while (i < node_count) {
+		const bvh_node& node = tree.nodes[i];
+		if (!ray_hits(node.min, node.max, origin, inverse, max_t)) {
+			i = escape(node, i);
+			continue;
+		}
+		if (is_leaf(node)) {
+			for (uint32_t k = node.first; k < node.first + leaf_count(node); k++) {
+				if (ray_hits(&tree.boxes[k].min.x, &tree.boxes[k].max.x, origin, inverse, max_t)) {
+					output[count++] = tree.primitives[k];
+				}
+			}
+		}
+		i++;
+	}
+	return count;
+}
+
+static bool overlaps(const float* box_min, const float* box_max, const bvh_box& box) {
+	return box_min[0] <= box.max.x && box_max[0] >= box.min.x
+		&& box_min[1] <= box.max.y && box_max[1] >= box.min.y
+		&& box_min[2] <= box.max.z && box_max[2] >= box.min.z;
+}
+
+size_t bvh_query_box(const bvh& tree, const bvh_box& box, uint32_t* output) {
+	const uint32_t node_count = static_cast<uint32_t>(tree.nodes.size());
+	size_t count = 0;
+	uint32_t i = 0;
+	while (i < node_count) {
+		const bvh_node& node = tree.nodes[i];
+		if (!overlaps(node.min, node.max, box)) {
+			i = escape(node, i);
+			continue;
+		}
+		if (is_leaf(node)) {
+			for (uint32_t k = node.first; k < node.first + leaf_count(node); k++) {
+				if (overlaps(&tree.boxes[k].min.x, &tree.boxes[k].max.x, box)) {
+					output[count++] = tree.primitives[k];
+				}
+			}
+		}
+		i++;
+	}
+	return count;
+}
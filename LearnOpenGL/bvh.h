@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frustum_cull.h"
+#include "math3d.h"
+
+// bounding volume hierarchy over object boxes. built top down with a binned surface area
+// heuristic and stored flat in depth first order: a node's first child is the next node and every
+// node knows where its subtree ends, so queries walk the array front to back without a stack, and
+// a subtree's primitives are one contiguous range of bvh::primitives
+
+struct bvh_box {
+	vec3 min;
+	vec3 max;
+};
+
+struct bvh_node {
+	float min[3];
+	// first entry of the subtree's range in bvh::primitives
+	uint32_t first;
+	float max[3];
+	// leaf: bvh_leaf_flag | primitive count; inner node: index of the node after the subtree
+	uint32_t data;
+};
+
+const uint32_t bvh_leaf_flag = 0x80000000u;
+
+struct bvh {
+	std::vector<bvh_node> nodes;
+	// object indices in leaf order
+	std::vector<uint32_t> primitives;
+	// object boxes in leaf order, copied so leaves test them without chasing the indices
+	std::vector<bvh_box> boxes;
+};
+
+void bvh_build(bvh& tree, const bvh_box* boxes, size_t count);
+// boxes moved but the tree keeps its topology: node bounds are recomputed bottom up. cheap, but
+// the tree gets worse as objects travel; compare bvh_sah_cost() with the cost after the build to
+// decide when to rebuild
+void bvh_refit(bvh& tree, const bvh_box* boxes);
+// expected cost of a random query, in units of one box test
+float bvh_sah_cost(const bvh& tree);
+
+// object indices in leaf order, not sorted; output needs room for every object. subtrees entirely
+// inside the frustum are copied out without testing their objects
+size_t bvh_cull_frustum(const bvh& tree, const frustum& view, uint32_t* output);
+// objects whose boxes the segment origin + t * direction, 0 <= t <= max_t passes through
+size_t bvh_query_ray(const bvh& tree, const vec3& origin, const vec3& direction, float max_t, uint32_t* output);
+// objects whose boxes overlap the box
+size_t bvh_query_box(const bvh& tree, const bvh_box& box, uint32_t* output);
@@ -0,0 +1,156 @@
+#include "bvh_benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "bench_stats.h"
+#include "bvh.h"
+#include "frustum_cull.h"
+#include "log.h"
+
+using namespace std;
+
+static const float world_size = 2000.0f;
+static const int refit_steps = 10;
+static const int view_count = 20;
+static const int query_count = 10000;
+
+static string run_count(const size_t object_count, bool& mismatch) {
+	mt19937 random(1234);
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	vector<bvh_box> boxes(object_count);
+	vector<vec3> velocities(object_count);
+	for (size_t i = 0; i < object_count; i++) {
+		const vec3 center = { (unit(random) - 0.5f) * world_size, (unit(random) - 0.5f) * world_size, (unit(random) - 0.5f) * world_size };
+		const vec3 half_size = { 0.5f + unit(random) * 4.5f, 0.5f + unit(random) * 4.5f, 0.5f + unit(random) * 4.5f };
+		boxes[i] = { center - half_size, center + half_size };
+		velocities[i] = { unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f };
+	}
+
+	bvh tree;
+	bench_clock::time_point start = bench_clock::now();
+	bvh_build(tree, boxes.data(), object_count);
+	const double build_ms = elapsed_ms(start);
+	const float built_cost = bvh_sah_cost(tree);
+
+	// every object drifts a few units per step, the tree keeps its shape
+	vector<double> refit_ms;
+	for (int step = 0; step < refit_steps; step++) {
+		for (size_t i = 0; i < object_count; i++) {
+			const vec3 offset = velocities[i] * 4.0f;
+			boxes[i] = { boxes[i].min + offset, boxes[i].max + offset };
+		}
+		start = bench_clock::now();
+		bvh_refit(tree, boxes.data());
+		refit_ms.push_back(elapsed_ms(start));
+	}
+	const float refitted_cost = bvh_sah_cost(tree);
+	bvh rebuilt;
+	bvh_build(rebuilt, boxes.data(), object_count);
+	const float rebuilt_cost = bvh_sah_cost(rebuilt);
+
+	// frustum queries against the flat SoA culling of the same boxes
+	cull_objects flat;
+	flat.reserve(object_count);
+	for (const bvh_box& box : boxes) {
+		flat.add((box.min + box.max) * 0.5f, (box.max - box.min) * 0.5f);
+	}
+	// no job system here, the flat culling stays on this thread like the tree's
+	vector<uint32_t> tree_visible(object_count), flat_visible(object_count);
+	vector<double> tree_ms, flat_ms;
+	double visible_fraction = 0.0;
+	const mat4 projection = perspective(1.0f, 16.0f / 9.0f, 0.5f, world_size * 0.5f);
+	for (int view_index = 0; view_index < view_count; view_index++) {
+		const float angle = view_index * 0.3f;
+		const frustum view = frustum_from_matrix(projection
+			* look_at({ 0.0f, 0.0f, 0.0f }, { sin(angle), 0.2f, cos(angle) }, { 0.0f, 1.0f, 0.0f }));
+
+		start = bench_clock::now();
+		const size_t tree_count = bvh_cull_frustum(tree, view, tree_visible.data());
+		tree_ms.push_back(elapsed_ms(start));
+		start = bench_clock::now();
+		const size_t flat_count = frustum_cull(view, flat, cull_volume::box, flat_visible.data());
+		flat_ms.push_back(elapsed_ms(start));
+
+		visible_fraction += static_cast<double>(flat_count) / object_count / view_count;
+		sort(tree_visible.begin(), tree_visible.begin() + tree_count);
+		if (tree_count != flat_count || !equal(flat_visible.begin(), flat_visible.begin() + flat_count, tree_visible.begin())) {
+			mismatch = true;
+		}
+	}
+
+	// segments across the whole volume and small boxes anywhere in it
+	vector<uint32_t> hits(object_count);
+	size_t ray_hits = 0, box_hits = 0;
+	start = bench_clock::now();
+	for (int query = 0; query < query_count; query++) {
+		const vec3 origin = { (unit(random) - 0.5f) * world_size, (unit(random) - 0.5f) * world_size, -world_size * 0.5f };
+		const vec3 direction = normalize({ unit(random) - 0.5f, unit(random) - 0.5f, 1.0f });
+		ray_hits += bvh_query_ray(tree, origin, direction, world_size, hits.data());
+	}
+	const double ray_ms = elapsed_ms(start);
+	start = bench_clock::now();
+	for (int query = 0; query < query_count; query++) {
+		const vec3 center = { (unit(random) - 0.5f) * world_size, (unit(random) - 0.5f) * world_size, (unit(random) - 0.5f) * world_size };
+		const vec3 half_size = { 10.0f, 10.0f, 10.0f };
+		box_hits += bvh_query_box(tree, { center - half_size, center + half_size }, hits.data());
+	}
+	const double box_ms = elapsed_ms(start);
+
+	const bench_stats refit_stats = compute_stats(refit_ms);
+	const bench_stats tree_stats = compute_stats(tree_ms);
+	const bench_stats flat_stats = compute_stats(flat_ms);
+	char line[256];
+	snprintf(line, sizeof(line), "%9zu objects: build %.1f ms, refit %.2f ms, frustum %.3f ms (flat %.3f ms), "
+		"%.0f rays/s, %.0f box queries/s", object_count, build_ms, refit_stats.median, tree_stats.median,
+		flat_stats.median, query_count / ray_ms * 1000.0, query_count / box_ms * 1000.0);
+	log(line);
+
+	string json = "    {\"objects\": " + to_string(object_count);
+	json += ", \"nodes\": " + to_string(tree.nodes.size());
+	snprintf(line, sizeof(line), ", \"build_ms\": %.3f, \"sah_cost\": {\"built\": %.3f, \"refitted\": %.3f, \"rebuilt\": %.3f}",
+		build_ms, built_cost, refitted_cost, rebuilt_cost);
+	json += line;
+	json += ", \"refit_ms\": " + stats_json(refit_stats);
+	json += ", \"frustum_ms\": " + stats_json(tree_stats);
+	json += ", \"flat_frustum_ms\": " + stats_json(flat_stats);
+	snprintf(line, sizeof(line), ", \"visible_fraction\": %.4f, \"rays_per_second\": %.0f, \"hits_per_ray\": %.2f"
+		", \"box_queries_per_second\": %.0f, \"hits_per_box\": %.2f}", visible_fraction, query_count / ray_ms * 1000.0,
+		static_cast<double>(ray_hits) / query_count, query_count / box_ms * 1000.0, static_cast<double>(box_hits) / query_count);
+	json += line;
+	return json;
+}
+
+int run_bvh_benchmark(const app_options& options) {
+	vector<size_t> counts;
+	for (const char* cursor = options.bvh_bench_counts.c_str(); *cursor != '\0';) {
+		char* end = nullptr;
+		const unsigned long long count = strtoull(cursor, &end, 10);
+		if (end == cursor) {
+			log("Malformed --bvh-bench, expected a comma separated list of object counts");
+			return 1;
+		}
+		counts.push_back(static_cast<size_t>(count));
+		cursor = *end == ',' ? end + 1 : end;
+	}
+
+	bool mismatch = false;
+	string json = "{\n  \"runs\": [\n";
+	for (size_t i = 0; i < counts.size(); i++) {
+		json += run_count(counts[i], mismatch);
+		json += i + 1 < counts.size() ? ",\n" : "\n";
+	}
+	json += "  ],\n";
+	json += string("  \"frustum_results_match\": ") + (mismatch ? "false" : "true") + "\n}\n";
+	if (mismatch) {
+		log("BVH and flat frustum culling disagree on the visible objects");
+	}
+
+	if (!write_bench_json(options.bench_output_path, "bvh_bench.json", json, "BVH benchmark")) {
+		return 1;
+	}
+	return mismatch ? 1 : 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "app_options.h"
+
+// for each object count in options.bvh_bench_counts: builds a BVH over random boxes, refits it
+// while the boxes move, and times frustum (against flat culling), ray and box queries; JSON output
+int run_bvh_benchmark(const app_options& options);
@@ -0,0 +1,11 @@
+#version 330 core
+
+in vec3 world_normal;
+in vec3 surface_albedo;
+out vec4 color;
+
+void main() {
+	vec3 light = normalize(vec3(0.4, 1.0, 0.3));
+	float diffuse = max(dot(normalize(world_normal), light), 0.0);
+	color = vec4(surface_albedo * (0.3 + 0.7 * diffuse), 1.0);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+
+uniform mat4 view_projection;
+uniform mat4 model;
+// rgb and roughness
+uniform vec4 albedo;
+
+out vec3 world_normal;
+out vec3 surface_albedo;
+out vec3 world_position;
+out float surface_roughness;
+
+void main() {
+	vec4 world = model * vec4(position, 1.0);
+	gl_Position = view_projection * world;
+	world_position = world.xyz;
+	// boxes are only scaled along the axes, the normals keep their direction
+	world_normal = normal;
+	surface_albedo = albedo.rgb;
+	surface_roughness = albedo.a;
+}
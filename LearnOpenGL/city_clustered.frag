@@ -0,0 +1,16 @@
+#version 330 core
+
+// city.frag with point lights on top: the fragment finds its froxel from its screen position and
+// depth and only loops over the lights binned into it; the lighting is city_lighting.glsl
+
+in vec3 world_normal;
+in vec3 surface_albedo;
+in vec3 world_position;
+in float surface_roughness;
+out vec4 color;
+
+void main() {
+	vec3 normal = normalize(world_normal);
+	float depth = view_depth(gl_FragCoord.z);
+	color = vec4(city_lighting(surface_albedo, world_position, normal, surface_roughness, depth), 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+
+// the G-buffer of deferred_shading: no lighting here, deferred_light.frag does it for every pixel once
+
+in vec3 world_normal;
+in vec3 surface_albedo;
+in float surface_roughness;
+layout (location = 0) out vec4 albedo_roughness;
+layout (location = 1) out vec2 encoded_normal;
+
+// the unit sphere folded onto the octahedron, the lower half unfolded around it, into [0, 1]
+vec2 octahedral_encode(vec3 n) {
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 folded = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return folded * 0.5 + 0.5;
+}
+
+void main() {
+	albedo_roughness = vec4(surface_albedo, surface_roughness);
+	encoded_normal = octahedral_encode(normalize(world_normal));
+}
@@ -0,0 +1,27 @@
+#version 430 core
+
+// city objects drawn from GPU written indirect commands: the box comes from the mesh attributes,
+// center and size from the object buffer as instanced attributes (base_instance picks the object)
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+// w - 1 for buildings
+layout (location = 2) in vec4 center;
+layout (location = 3) in vec4 half_size;
+
+uniform mat4 view_projection;
+
+out vec3 world_normal;
+out vec3 surface_albedo;
+out vec3 world_position;
+out float surface_roughness;
+
+void main() {
+	vec4 world = vec4(center.xyz + position * half_size.xyz, 1.0);
+	gl_Position = view_projection * world;
+	world_position = world.xyz;
+	world_normal = normal;
+	// the albedos city_scene.cpp gives city.vert
+	surface_albedo = center.w > 0.5 ? vec3(0.7, 0.68, 0.62) : vec3(0.8, 0.35, 0.2);
+	surface_roughness = center.w > 0.5 ? 0.8 : 0.35;
+}
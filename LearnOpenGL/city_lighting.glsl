@@ -0,0 +1,79 @@
+// the city's lighting, shared by city_clustered.frag (forward) and deferred_light.frag: spliced in
+// after their #version line by load_program_with. the sun with its cascaded shadow, then the point
+// lights binned into the fragment's froxel (clustered_lights.h)
+
+// two texels per light: position and radius, color
+uniform samplerBuffer light_data;
+// per froxel: first entry in light_indices and how many
+uniform usamplerBuffer light_clusters;
+uniform usamplerBuffer light_indices;
+uniform vec2 tile_size;
+uniform ivec3 cluster_grid;
+uniform vec2 depth_range;
+uniform vec2 slice_scale_bias;
+uniform vec3 eye_position;
+
+// shadow_maps: the sun's cascades, clip to texture space, where each ends in view depth and the
+// world size of its texels
+layout (std140) uniform shadow_cascades {
+	mat4 shadow_matrices[4];
+	vec4 cascade_far;
+	vec4 cascade_texel;
+};
+uniform sampler2DArrayShadow shadow_map;
+uniform bool shadowed;
+
+// 0 in the sun's shadow, 1 in the sun
+float sun_shadow(vec3 position, vec3 normal, float depth) {
+	if (!shadowed) {
+		return 1.0;
+	}
+	int cascade = 0;
+	while (cascade < 4 && depth > cascade_far[cascade]) {
+		cascade++;
+	}
+	if (cascade == 4) {
+		return 1.0;
+	}
+	// off the surface by a texel and a half, against acne on faces the light grazes
+	vec4 shadow_position = shadow_matrices[cascade] * vec4(position + normal * (cascade_texel[cascade] * 1.5), 1.0);
+	return texture(shadow_map, vec4(shadow_position.xy, float(cascade), shadow_position.z));
+}
+
+// view depth back from the depth buffer value
+float view_depth(float depth_value) {
+	float near_plane = depth_range.x, far_plane = depth_range.y;
+	return 2.0 * near_plane * far_plane / (far_plane + near_plane - (2.0 * depth_value - 1.0) * (far_plane - near_plane));
+}
+
+// lit color of a surface at the fragment's pixel, depth in view space
+vec3 city_lighting(vec3 albedo, vec3 position, vec3 normal, float roughness, float depth) {
+	vec3 sun = normalize(vec3(0.4, 1.0, 0.3));
+	vec3 lit = vec3(0.15 + 0.35 * max(dot(normal, sun), 0.0) * sun_shadow(position, normal, depth));
+	vec3 to_eye = normalize(eye_position - position);
+	// blinn-phong highlight, tighter and brighter the smoother the surface
+	float shininess = exp2(10.0 * (1.0 - roughness) + 1.0);
+	float specular_scale = 1.0 - roughness;
+	vec3 highlight = vec3(0.0);
+
+	int slice = clamp(int(log(depth) * slice_scale_bias.x + slice_scale_bias.y), 0, cluster_grid.z - 1);
+	ivec2 tile = min(ivec2(gl_FragCoord.xy / tile_size), cluster_grid.xy - 1);
+	uvec2 cluster = texelFetch(light_clusters, (slice * cluster_grid.y + tile.y) * cluster_grid.x + tile.x).xy;
+
+	for (uint i = 0u; i < cluster.y; i++) {
+		int light = int(texelFetch(light_indices, int(cluster.x + i)).x);
+		vec4 position_radius = texelFetch(light_data, light * 2);
+		vec3 to_light = position_radius.xyz - position;
+		float distance = length(to_light);
+		if (distance < position_radius.w) {
+			float falloff = 1.0 - distance / position_radius.w;
+			vec3 direction = to_light / distance;
+			float diffuse = max(dot(normal, direction), 0.0);
+			float specular = diffuse > 0.0 ? specular_scale * pow(max(dot(normal, normalize(direction + to_eye)), 0.0), shininess) : 0.0;
+			vec3 light_color = texelFetch(light_data, light * 2 + 1).rgb * (falloff * falloff);
+			lit += light_color * diffuse;
+			highlight += light_color * specular;
+		}
+	}
+	return albedo * lit + highlight;
+}
@@ -0,0 +1,625 @@
+#include "city_scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include "bvh.h"
+#include "deferred_shading.h"
+#include "frame_arena.h"
+#include "frustum_cull.h"
+#include "gpu_cull.h"
+#include "gpu_resources.h"
+#include "job_system.h"
+#include "log.h"
+#include "occlusion.h"
+#include "shader.h"
+#include "shadow_maps.h"
+
+using namespace std;
+
+static const int blocks_per_side = 16;
+static const float block_size = 40.0f;
+static const float street_width = 12.0f;
+static const float city_extent = blocks_per_side * (block_size + street_width);
+
+static vector<city_object> objects;
+// the same bounds for frustum culling, flat and as a hierarchy
+static cull_objects bounds;
+static bvh tree;
+
+// a box program and its uniforms, -1 for the ones it doesn't have
+struct box_program {
+	GLuint id = 0;
+	GLint view_projection = -1;
+	GLint model = -1;
+	GLint albedo = -1;
+	GLint eye = -1;
+};
+
+// forward shading, with point lights after city_init_lights
+static box_program forward_shading;
+// --deferred: the G-buffer fill of deferred_shading
+static box_program gbuffer;
+static box_program* active = &forward_shading;
+static GLuint vao = 0;
+static GLuint vbo = 0;
+static GLuint ibo = 0;
+// color and roughness
+static const float building_albedo[4] = { 0.7f, 0.68f, 0.62f, 0.8f };
+static const float prop_albedo[4] = { 0.8f, 0.35f, 0.2f, 0.35f };
+static const float ground_albedo[4] = { 0.35f, 0.37f, 0.35f, 0.95f };
+
+// --lights: the forward programs shade with clustered_lights
+static bool lit = false;
+static int lit_width = 0;
+static int lit_height = 0;
+// each light drives along x (axis 0) or z (axis 1) from where it was at 0 seconds
+struct light_motion {
+	vec3 start;
+	int axis;
+	float speed;
+};
+static vector<light_motion> light_motions;
+static point_lights moving_lights;
+
+// --shadows: every object's box in world space, positions only, for the shadow maps' depth pass
+static bool shadowed = false;
+static GLuint caster_vao = 0;
+static GLuint caster_vbo = 0;
+static GLuint caster_ibo = 0;
+static vector<uint32_t> casters;
+// around every object and the ground
+static vec3 scene_min = { 0.0f, 0.0f, 0.0f };
+static vec3 scene_max = { 0.0f, 0.0f, 0.0f };
+
+// GPU culled path
+static box_program instanced;
+static GLuint instanced_vao = 0;
+static bool hiz = false;
+static GLuint framebuffer = 0;
+static GLuint color_renderbuffer = 0;
+static GLuint depth_texture = 0;
+static int target_width = 0;
+static int target_height = 0;
+
+const vec3 city_box_corners[8] = {
+	{ -1, -1, -1 }, { 1, -1, -1 }, { -1, 1, -1 }, { 1, 1, -1 },
+	{ -1, -1, 1 }, { 1, -1, 1 }, { -1, 1, 1 }, { 1, 1, 1 }
+};
+
+const uint32_t city_box_indices[36] = {
+	0, 4, 6, 0, 6, 2,  // -x
+	1, 3, 7, 1, 7, 5,  // +x
+	0, 1, 5, 0, 5, 4,  // -y
+	2, 6, 7, 2, 7, 3,  // +y
+	0, 2, 3, 0, 3, 1,  // -z
+	4, 5, 7, 4, 7, 6   // +z
+};
+
+void city_generate(const int object_count, const unsigned seed) {
+	mt19937 random(seed);
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	objects.clear();
+	objects.reserve(object_count);
+
+	const float pitch = block_size + street_width;
+	const float origin = -city_extent * 0.5f + street_width + block_size * 0.5f;
+	for (int z = 0; z < blocks_per_side && static_cast<int>(objects.size()) < object_count; z++) {
+		for (int x = 0; x < blocks_per_side && static_cast<int>(objects.size()) < object_count; x++) {
+			const float height = 8.0f + unit(random) * 40.0f;
+			const float half_width = block_size * (0.35f + unit(random) * 0.15f);
+			objects.push_back({ { origin + x * pitch, height, origin + z * pitch }, { half_width, height, half_width }, true });
+		}
+	}
+
+	while (static_cast<int>(objects.size()) < object_count) {
+		const float size = 0.4f + unit(random) * 1.2f;
+		const vec3 center = { (unit(random) - 0.5f) * city_extent, size, (unit(random) - 0.5f) * city_extent };
+		objects.push_back({ center, { size, size, size }, false });
+	}
+
+	bounds.clear();
+	bounds.reserve(objects.size());
+	vector<bvh_box> boxes;
+	boxes.reserve(objects.size());
+	scene_min = { -city_extent, -1.0f, -city_extent };
+	scene_max = { city_extent, 0.0f, city_extent };
+	for (const city_object& object : objects) {
+		bounds.add(object.center, object.half_size);
+		boxes.push_back({ object.center - object.half_size, object.center + object.half_size });
+		scene_max.y = max(scene_max.y, object.center.y + object.half_size.y);
+	}
+	bvh_build(tree, boxes.data(), boxes.size());
+	shadow_maps_invalidate();
+}
+
+const vector<city_object>& city_objects() {
+	return objects;
+}
+
+// down the street between the two middle block columns, turning around at the ends
+vec3 city_eye(const double seconds) {
+	const double phase = fmod(seconds, city_loop_seconds) / city_loop_seconds;
+	const double along = phase < 0.5 ? phase * 2.0 : 2.0 - phase * 2.0;
+	const float street_x = -city_extent * 0.5f + (blocks_per_side / 2) * (block_size + street_width) + street_width * 0.5f;
+	return { street_x, 2.5f, static_cast<float>((along - 0.5) * city_extent * 0.9) };
+}
+
+void city_generate_lights(const int count, const unsigned seed) {
+	mt19937 random(seed);
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const float pitch = block_size + street_width;
+	light_motions.clear();
+	light_motions.reserve(count);
+	moving_lights.clear();
+	moving_lights.reserve(count);
+	for (int i = 0; i < count; i++) {
+		// in the middle of a street, anywhere along it
+		const float street = -city_extent * 0.5f + static_cast<int>(unit(random) * blocks_per_side) * pitch + street_width * 0.5f;
+		const float along = (unit(random) - 0.5f) * city_extent;
+		const float across = street + (unit(random) - 0.5f) * street_width * 0.6f;
+		const int axis = i % 2;
+		const vec3 start = { axis == 0 ? along : across, 1.0f + unit(random) * 6.0f, axis == 0 ? across : along };
+		light_motions.push_back({ start, axis, (unit(random) - 0.5f) * 20.0f });
+		// saturated colors, one channel dimmed
+		vec3 color = { 0.4f + unit(random) * 0.6f, 0.4f + unit(random) * 0.6f, 0.4f + unit(random) * 0.6f };
+		(i % 3 == 0 ? color.x : i % 3 == 1 ? color.y : color.z) *= 0.2f;
+		moving_lights.add(start, 6.0f + unit(random) * 14.0f, color * 1.5f);
+	}
+}
+
+size_t city_light_count() {
+	return moving_lights.size();
+}
+
+void city_bin_lights(const double seconds, const mat4& view, const mat4& projection, light_grid& grid) {
+	const float time = static_cast<float>(fmod(seconds, 1000.0));
+	for (size_t i = 0; i < light_motions.size(); i++) {
+		const light_motion& motion = light_motions[i];
+		const float start = motion.axis == 0 ? motion.start.x : motion.start.z;
+		// off one end of the city and back in at the other
+		float along = fmod(start + city_extent * 0.5f + motion.speed * time, city_extent);
+		along += along < 0.0f ? city_extent : 0.0f;
+		(motion.axis == 0 ? moving_lights.x : moving_lights.z)[i] = along - city_extent * 0.5f;
+	}
+	clustered_lights_bin(moving_lights, view, projection, grid);
+}
+
+mat4 city_view(const double seconds) {
+	const double phase = fmod(seconds, city_loop_seconds) / city_loop_seconds;
+	const vec3 eye = city_eye(seconds);
+	const float direction = phase < 0.5 ? 1.0f : -1.0f;
+	// look a bit to the sides now and then so the view is not always straight down the street
+	const float sway = static_cast<float>(sin(seconds * 0.7)) * 0.6f;
+	return look_at(eye, { eye.x + sway * 10.0f, eye.y, eye.z + direction * 10.0f }, { 0.0f, 1.0f, 0.0f });
+}
+
+mat4 city_projection(const float aspect) {
+	return perspective(1.0f, aspect, 0.5f, city_extent * 1.5f);
+}
+
+size_t city_cull_frustum(const mat4& view_projection, const bool use_bvh, uint32_t* visible) {
+	const frustum view = frustum_from_matrix(view_projection);
+	if (use_bvh) {
+		return bvh_cull_frustum(tree, view, visible);
+	}
+	return frustum_cull(view, bounds, cull_volume::box, visible);
+}
+
+size_t city_cull_occluded(const mat4& view_projection, const vec3& eye, const int occluder_count,
+	const uint32_t* candidates, const size_t candidate_count, uint32_t* visible) {
+	occlusion_begin(view_projection);
+
+	frame_vector<pair<float, uint32_t>> occluders;
+	for (size_t i = 0; i < objects.size(); i++) {
+		if (objects[i].occluder) {
+			const vec3 offset = objects[i].center - eye;
+			occluders.push_back({ dot(offset, offset), static_cast<uint32_t>(i) });
+		}
+	}
+	const size_t nearest = min(occluders.size(), static_cast<size_t>(max(occluder_count, 0)));
+	partial_sort(occluders.begin(), occluders.begin() + nearest, occluders.end());
+	// front to back, so the near ones reject the tiles the far ones would have touched
+	for (size_t i = 0; i < nearest; i++) {
+		const city_object& object = objects[occluders[i].second];
+		occlusion_add_mesh(&city_box_corners[0].x, 8, city_box_indices, 36, box_transform(object.center, object.half_size));
+	}
+
+	const size_t total = candidates != nullptr ? candidate_count : objects.size();
+	size_t count = 0;
+	for (size_t i = 0; i < total; i++) {
+		const uint32_t index = candidates != nullptr ? candidates[i] : static_cast<uint32_t>(i);
+		if (occlusion_box_visible(objects[index].center, objects[index].half_size)) {
+			visible[count++] = index;
+		}
+	}
+	return count;
+}
+
+// snippet_path: GLSL the fragment shader builds on, may be null
+static bool load_box_program(box_program& loaded, const char* vertex_path, const char* fragment_path,
+	const char* snippet_path) {
+	const GLuint id = load_program_with(vertex_path, fragment_path, snippet_path);
+	if (id == 0) {
+		return false;
+	}
+	glDeleteProgram(loaded.id);
+	loaded.id = id;
+	loaded.view_projection = glGetUniformLocation(id, "view_projection");
+	loaded.model = glGetUniformLocation(id, "model");
+	loaded.albedo = glGetUniformLocation(id, "albedo");
+	loaded.eye = glGetUniformLocation(id, "eye_position");
+	return true;
+}
+
+bool city_init_gl() {
+	if (!load_box_program(forward_shading, "city.vert", "city.frag", nullptr)) {
+		return false;
+	}
+	active = &forward_shading;
+
+	// flat shaded box: every face gets its own four corners with the face normal
+	vector<GLfloat> vertices;
+	vector<GLuint> indices;
+	for (int face = 0; face < 6; face++) {
+		const uint32_t* triangles = city_box_indices + face * 6;
+		const vec3& a = city_box_corners[triangles[0]];
+		const vec3 normal = normalize(cross(city_box_corners[triangles[1]] - a, city_box_corners[triangles[2]] - a));
+		const GLuint base = static_cast<GLuint>(vertices.size() / 6);
+		const uint32_t quad[4] = { triangles[0], triangles[1], triangles[2], triangles[5] };
+		for (const uint32_t corner : quad) {
+			const vec3& p = city_box_corners[corner];
+			vertices.insert(vertices.end(), { p.x, p.y, p.z, normal.x, normal.y, normal.z });
+		}
+		indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+	}
+
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &vbo);
+	glGenBuffers(1, &ibo);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), static_cast<GLvoid*>(nullptr));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), reinterpret_cast<GLvoid*>(3 * sizeof(GLfloat)));
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+	return true;
+}
+
+bool city_init_lights(const int width, const int height) {
+	if (!clustered_lights_init()
+		|| !load_box_program(forward_shading, "city.vert", "city_clustered.frag", "city_lighting.glsl")) {
+		clustered_lights_release();
+		return false;
+	}
+	lit_width = width;
+	lit_height = height;
+	clustered_lights_setup_program(forward_shading.id, width, height, city_projection(static_cast<float>(width) / height));
+	shadow_maps_setup_program(forward_shading.id);
+	lit = true;
+	return true;
+}
+
+bool city_init_deferred() {
+	if (!lit || !load_box_program(gbuffer, "city.vert", "city_gbuffer.frag", nullptr)) {
+		return false;
+	}
+	if (!deferred_init(lit_width, lit_height, city_projection(static_cast<float>(lit_width) / lit_height))) {
+		glDeleteProgram(gbuffer.id);
+		gbuffer = box_program();
+		return false;
+	}
+	return true;
+}
+
+bool city_init_shadows(const int size) {
+	// the far half of the cascades cached, one of them redrawn every 8 frames
+	if (!shadow_maps_init(size, shadow_cascades / 2, 8)) {
+		return false;
+	}
+	shadow_maps_set_light(normalize(vec3{ 0.4f, 1.0f, 0.3f }));
+
+	vector<GLfloat> positions;
+	vector<GLuint> indices;
+	positions.reserve(objects.size() * 8 * 3);
+	indices.reserve(objects.size() * 36);
+	for (const city_object& object : objects) {
+		const GLuint base = static_cast<GLuint>(positions.size() / 3);
+		for (const vec3& corner : city_box_corners) {
+			positions.insert(positions.end(), { object.center.x + corner.x * object.half_size.x,
+				object.center.y + corner.y * object.half_size.y, object.center.z + corner.z * object.half_size.z });
+		}
+		for (const uint32_t index : city_box_indices) {
+			indices.push_back(base + index);
+		}
+	}
+	glGenVertexArrays(1, &caster_vao);
+	glGenBuffers(1, &caster_vbo);
+	glGenBuffers(1, &caster_ibo);
+	glBindVertexArray(caster_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, caster_vbo);
+	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(GLfloat), positions.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, caster_ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), static_cast<GLvoid*>(nullptr));
+	glEnableVertexAttribArray(0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	casters.resize(objects.size());
+	shadowed = true;
+	return true;
+}
+
+void city_fit_shadows(const mat4& view, const mat4& projection, shadow_frame& frame) {
+	shadow_maps_fit(view, projection, scene_min, scene_max, frame);
+	for (int i = 0; i < shadow_cascades; i++) {
+		if (!frame.render[i]) {
+			continue;
+		}
+		const size_t count = city_cull_frustum(frame.light_view_projection[i], false, casters.data());
+		// the culling keeps the objects in order, neighbours in the list are one range of indices
+		vector<uint32_t>& ranges = frame.ranges[i];
+		ranges.reserve(objects.size());
+		for (size_t first = 0; first < count;) {
+			size_t last = first;
+			while (last + 1 < count && casters[last + 1] == casters[last] + 1) {
+				last++;
+			}
+			ranges.push_back(casters[first] * 36);
+			ranges.push_back(static_cast<uint32_t>(last - first + 1) * 36);
+			first = last + 1;
+		}
+		frame.casters[i] = count;
+	}
+}
+
+void city_render_shadows(const shadow_frame& frame) {
+	shadow_maps_render(frame, caster_vao);
+}
+
+void city_release_shadows() {
+	shadow_maps_release();
+	glDeleteBuffers(1, &caster_vbo);
+	glDeleteBuffers(1, &caster_ibo);
+	glDeleteVertexArrays(1, &caster_vao);
+	caster_vbo = caster_ibo = caster_vao = 0;
+	shadowed = false;
+}
+
+void city_use_deferred(const bool deferred) {
+	active = deferred && gbuffer.id != 0 ? &gbuffer : &forward_shading;
+}
+
+void city_release_lights() {
+	clustered_lights_release();
+	lit = false;
+}
+
+// clears and draws the ground, which is never culled; leaves the program and the box bound
+static void begin_frame(const mat4& view_projection) {
+	if (active == &gbuffer) {
+		deferred_begin();
+	}
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.55f, 0.65f, 0.75f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	if (lit) {
+		clustered_lights_bind();
+	}
+	if (shadowed) {
+		shadow_maps_bind();
+	}
+	glUseProgram(active->id);
+	glUniformMatrix4fv(active->view_projection, 1, GL_FALSE, view_projection.m);
+	if (active->eye >= 0) {
+		glUniform3fv(active->eye, 1, &clustered_lights_eye().x);
+	}
+	glBindVertexArray(vao);
+
+	glUniformMatrix4fv(active->model, 1, GL_FALSE, box_transform({ 0.0f, -0.5f, 0.0f }, { city_extent, 0.5f, city_extent }).m);
+	glUniform4fv(active->albedo, 1, ground_albedo);
+	glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
+}
+
+// deferred: the G-buffer is lit into the target begin_frame() found bound
+static void end_frame(const mat4& view_projection) {
+	glBindVertexArray(0);
+	glDisable(GL_DEPTH_TEST);
+	if (active == &gbuffer) {
+		deferred_end(view_projection);
+	}
+}
+
+void city_draw(const mat4& view_projection, const uint32_t* visible, const size_t count) {
+	begin_frame(view_projection);
+
+	const size_t total = visible != nullptr ? count : objects.size();
+	for (size_t i = 0; i < total; i++) {
+		const city_object& object = objects[visible != nullptr ? visible[i] : i];
+		glUniformMatrix4fv(active->model, 1, GL_FALSE, box_transform(object.center, object.half_size).m);
+		glUniform4fv(active->albedo, 1, object.occluder ? building_albedo : prop_albedo);
+		glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
+	}
+	end_frame(view_projection);
+}
+
+struct record_context {
+	mat4 view_projection;
+	const uint32_t* visible;
+	size_t count;
+	command_list* lists;
+	size_t list_count;
+};
+
+static void record_lists(void* context, const int begin, const int end) {
+	const record_context& record = *static_cast<const record_context*>(context);
+	for (int list = begin; list < end; list++) {
+		command_list& commands = record.lists[list];
+		commands.clear();
+		commands.bind_program(active->id);
+		commands.bind_vertex_array(vao);
+		const size_t first = record.count * list / record.list_count;
+		const size_t last = record.count * (list + 1) / record.list_count;
+		for (size_t i = first; i < last; i++) {
+			const city_object& object = objects[record.visible != nullptr ? record.visible[i] : i];
+			commands.uniform_mat4(active->model, box_transform(object.center, object.half_size).m);
+			commands.uniform_vec4(active->albedo, object.occluder ? building_albedo : prop_albedo);
+			// distance along the view direction; a positive float's bits sort like the float
+			const float depth = max(transform(record.view_projection, object.center).w, 0.0f);
+			uint32_t key = 0;
+			memcpy(&key, &depth, sizeof(key));
+			commands.draw_indexed(key, command_primitive::triangles, 36, 0);
+		}
+	}
+}
+
+void city_record(const mat4& view_projection, const uint32_t* visible, const size_t count, command_list* lists,
+	const size_t list_count) {
+	record_context record = { view_projection, visible, visible != nullptr ? count : objects.size(), lists, list_count };
+	parallel_for(0, static_cast<int>(list_count), 1, record_lists, &record);
+}
+
+void city_draw_lists(const mat4& view_projection, const command_list* lists, const size_t list_count, const bool sort) {
+	begin_frame(view_projection);
+	command_lists_submit(lists, list_count, sort);
+	end_frame(view_projection);
+}
+
+bool city_init_gpu_cull(const int width, const int height, const bool use_hiz) {
+	// center with the building flag in w, half size
+	vector<float> bounds;
+	bounds.reserve(objects.size() * 8);
+	for (const city_object& object : objects) {
+		bounds.insert(bounds.end(), { object.center.x, object.center.y, object.center.z, object.occluder ? 1.0f : 0.0f,
+			object.half_size.x, object.half_size.y, object.half_size.z, 0.0f });
+	}
+	gpu_cull_mesh box;
+	box.index_count = 36;
+	if (!gpu_cull_init(bounds.data(), static_cast<uint32_t>(objects.size()), box)) {
+		return false;
+	}
+	if (!load_box_program(instanced, "city_instanced.vert", lit ? "city_clustered.frag" : "city.frag",
+		lit ? "city_lighting.glsl" : nullptr)) {
+		city_release_gpu_cull();
+		return false;
+	}
+	if (lit) {
+		clustered_lights_setup_program(instanced.id, lit_width, lit_height,
+			city_projection(static_cast<float>(lit_width) / lit_height));
+		shadow_maps_setup_program(instanced.id);
+	}
+
+	glGenVertexArrays(1, &instanced_vao);
+	glBindVertexArray(instanced_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), static_cast<GLvoid*>(nullptr));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), reinterpret_cast<GLvoid*>(3 * sizeof(GLfloat)));
+	glEnableVertexAttribArray(1);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	// per object, indexed by the commands' base instance
+	glBindBuffer(GL_ARRAY_BUFFER, gpu_cull_object_buffer());
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), static_cast<GLvoid*>(nullptr));
+	glVertexAttribDivisor(2, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), reinterpret_cast<GLvoid*>(4 * sizeof(GLfloat)));
+	glVertexAttribDivisor(3, 1);
+	glEnableVertexAttribArray(3);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	hiz = use_hiz;
+	if (hiz) {
+		// the default framebuffer's depth cannot be sampled, so the frame is rendered here and blitted
+		gpu_category_scope category(gpu_category::render_target);
+		target_width = width;
+		target_height = height;
+		glGenRenderbuffers(1, &color_renderbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glGenTextures(1, &depth_texture);
+		glBindTexture(GL_TEXTURE_2D, depth_texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+		// no mipmaps: the default minification filter would leave the texture incomplete
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_renderbuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_texture, 0);
+		const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (!complete) {
+			log("Hi-Z render target is incomplete");
+			city_release_gpu_cull();
+			return false;
+		}
+	}
+	return true;
+}
+
+void city_draw_gpu_culled(const mat4& view_projection) {
+	gpu_cull_dispatch(view_projection, hiz);
+
+	// the frame ends up where the caller had it going, e.g. a render graph target
+	GLint target = 0;
+	if (hiz) {
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	}
+	begin_frame(view_projection);
+	glUseProgram(instanced.id);
+	glUniformMatrix4fv(instanced.view_projection, 1, GL_FALSE, view_projection.m);
+	if (instanced.eye >= 0) {
+		glUniform3fv(instanced.eye, 1, &clustered_lights_eye().x);
+	}
+	glBindVertexArray(instanced_vao);
+	gpu_cull_draw();
+	glBindVertexArray(0);
+	glDisable(GL_DEPTH_TEST);
+
+	if (hiz) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		gpu_cull_build_hiz(depth_texture, target_width, target_height, view_projection);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+		glBlitFramebuffer(0, 0, target_width, target_height, 0, 0, target_width, target_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, target);
+	}
+}
+
+void city_release_gpu_cull() {
+	gpu_cull_shutdown();
+	glDeleteVertexArrays(1, &instanced_vao);
+	glDeleteProgram(instanced.id);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &color_renderbuffer);
+	glDeleteTextures(1, &depth_texture);
+	instanced = box_program();
+	instanced_vao = framebuffer = color_renderbuffer = depth_texture = 0;
+	hiz = false;
+}
+
+void city_release_gl() {
+	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &ibo);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteProgram(forward_shading.id);
+	if (gbuffer.id != 0) {
+		deferred_release();
+	}
+	glDeleteProgram(gbuffer.id);
+	forward_shading = gbuffer = box_program();
+	active = &forward_shading;
+	vbo = ibo = vao = 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "clustered_lights.h"
+#include "command_list.h"
+#include "gl_api.h"
+#include "math3d.h"
+#include "shadow_maps.h"
+
+// benchmark scene: a grid of city blocks with one building each and small props scattered over
+// the whole area, seen from a camera driving down a street. it is drawn the naive way, one
+// glDrawElements per object, so every object that reaches city_draw() costs submission time
+
+struct city_object {
+	vec3 center;
+	vec3 half_size;
+	// buildings - big enough to hide what is behind them
+	bool occluder;
+};
+
+void city_generate(int object_count, unsigned seed);
+const std::vector<city_object>& city_objects();
+
+// the camera path repeats every city_loop_seconds
+const double city_loop_seconds = 40.0;
+vec3 city_eye(double seconds);
+mat4 city_view(double seconds);
+mat4 city_projection(float aspect);
+
+// unit box (-1..1) as 12 outward facing, counter-clockwise triangles
+extern const vec3 city_box_corners[8];
+extern const uint32_t city_box_indices[36];
+
+// indices of the objects inside the view frustum, from the flat SoA culling (frustum_cull.h) or,
+// with use_bvh, from the scene's BVH (bvh.h); visible has room for every object, returns how many
+// were written
+size_t city_cull_frustum(const mat4& view_projection, bool use_bvh, uint32_t* visible);
+// rasterizes the occluder_count buildings nearest to the eye into the occlusion buffer (see
+// occlusion.h, initialized by the caller) and writes the candidates that are not hidden behind them
+// to visible, which may be the candidate list itself; candidates nullptr - every object
+size_t city_cull_occluded(const mat4& view_projection, const vec3& eye, int occluder_count,
+	const uint32_t* candidates, size_t candidate_count, uint32_t* visible);
+
+bool city_init_gl();
+// visible - indices into city_objects(); nullptr draws everything
+void city_draw(const mat4& view_projection, const uint32_t* visible, size_t count);
+void city_release_gl();
+
+// records what city_draw() submits per object into the lists, the objects split evenly between
+// them, on the job system's threads (job_system.h); any thread, the lists are cleared first.
+// sort keys put near objects first
+void city_record(const mat4& view_projection, const uint32_t* visible, size_t count, command_list* lists, size_t list_count);
+// city_draw() with the objects replayed from recorded lists, in order or sorted by key
+void city_draw_lists(const mat4& view_projection, const command_list* lists, size_t list_count, bool sort);
+
+// point lights driving up and down the streets at different heights and speeds
+void city_generate_lights(int count, unsigned seed);
+size_t city_light_count();
+// the lights where they are at seconds, binned for the camera; any thread
+void city_bin_lights(double seconds, const mat4& view, const mat4& projection, light_grid& grid);
+// after city_init_gl and before city_init_gpu_cull: both paths shade with the grid last given to
+// clustered_lights_upload() from then on, drawn at width x height
+bool city_init_lights(int width, int height);
+void city_release_lights();
+// deferred_shading's G-buffer fill and lighting pass in place of the forward shading, for city_draw
+// and the command lists recorded from then on; after city_init_lights, not for city_draw_gpu_culled
+bool city_init_deferred();
+void city_use_deferred(bool deferred);
+// cascaded shadow maps of size x size from the sun (shadow_maps.h), which the lit programs sample;
+// after city_init_gl and before city_init_lights, city_init_gpu_cull and city_init_deferred
+bool city_init_shadows(int size);
+// cascades for the camera with their casters; any thread, one at a time
+void city_fit_shadows(const mat4& view, const mat4& projection, shadow_frame& frame);
+void city_render_shadows(const shadow_frame& frame);
+void city_release_shadows();
+
+// GL 4.3 path, see gpu_cull.h: culling and draw compaction on the GPU, one indirect multi draw.
+// with hiz the frame goes to an offscreen target whose depth feeds the next frame's Hi-Z test
+bool city_init_gpu_cull(int width, int height, bool hiz);
+void city_draw_gpu_culled(const mat4& view_projection);
+void city_release_gpu_cull();
@@ -0,0 +1,464 @@
+#include "clustered_lights.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <intrin.h>
+
+#include "cpu_features.h"
+#include "gpu_resources.h"
+#include "job_system.h"
+#include "profiler.h"
+
+using namespace std;
+
+static const int tiles_per_slice = cluster_tiles_x * cluster_tiles_y;
+// texture units of the three buffers, unit 0 stays free for the programs' own textures
+static const GLint light_data_unit = 1;
+static const GLint clusters_unit = 2;
+static const GLint indices_unit = 3;
+
+static bool use_avx2 = cpu_has_avx2();
+
+// the view space box of every froxel, recomputed when the projection changes
+struct froxel_bounds {
+	float p0 = 0.0f, p5 = 0.0f, near_plane = 0.0f, far_plane = 0.0f;
+	float min_x[cluster_count], max_x[cluster_count];
+	float min_y[cluster_count], max_y[cluster_count];
+	float slice_near[cluster_slices], slice_far[cluster_slices];
+};
+
+static froxel_bounds froxels;
+
+static GLuint buffers[3] = {};
+static GLuint textures[3] = {};
+static vec3 uploaded_eye = { 0.0f, 0.0f, 0.0f };
+
+// room for at least count with some to spare, so a frame with a few more lights in view than any
+// before doesn't allocate
+template <typename T>
+static void reserve_ahead(vector<T>& values, const size_t count) {
+	if (values.capacity() < count) {
+		values.reserve(count * 2);
+	}
+}
+
+// takes the lowest set bit out of bits, which must have one
+static int pop_lowest_bit(uint32_t& bits) {
+	unsigned long index = 0;
+	_BitScanForward(&index, bits);
+	bits &= bits - 1;
+	return static_cast<int>(index);
+}
+
+void point_lights::clear() {
+	for (vector<float>* column : { &x, &y, &z, &radius, &red, &green, &blue }) {
+		column->clear();
+	}
+}
+
+void point_lights::reserve(const size_t count) {
+	for (vector<float>* column : { &x, &y, &z, &radius, &red, &green, &blue }) {
+		column->reserve(count);
+	}
+}
+
+void point_lights::add(const vec3& position, const float light_radius, const vec3& color) {
+	x.push_back(position.x);
+	y.push_back(position.y);
+	z.push_back(position.z);
+	radius.push_back(light_radius);
+	red.push_back(color.x);
+	green.push_back(color.y);
+	blue.push_back(color.z);
+}
+
+void clustered_lights_use_simd(const bool simd) {
+	use_avx2 = simd && cpu_has_avx2();
+}
+
+// slices split the depth range exponentially, so near froxels aren't long thin needles
+static float slice_depth(const float near_plane, const float far_plane, const int slice) {
+	return near_plane * pow(far_plane / near_plane, static_cast<float>(slice) / cluster_slices);
+}
+
+static int slice_of(const float depth) {
+	const float slice = log(depth / froxels.near_plane) / log(froxels.far_plane / froxels.near_plane) * cluster_slices;
+	return min(cluster_slices - 1, max(0, static_cast<int>(slice)));
+}
+
+static void update_froxels(const mat4& projection) {
+	const float p0 = projection.m[0], p5 = projection.m[5];
+	const float near_plane = projection.m[14] / (projection.m[10] - 1.0f);
+	const float far_plane = projection.m[14] / (projection.m[10] + 1.0f);
+	if (p0 == froxels.p0 && p5 == froxels.p5 && near_plane == froxels.near_plane && far_plane == froxels.far_plane) {
+		return;
+	}
+	froxels.p0 = p0;
+	froxels.p5 = p5;
+	froxels.near_plane = near_plane;
+	froxels.far_plane = far_plane;
+	for (int slice = 0; slice < cluster_slices; slice++) {
+		const float depth_near = slice_depth(near_plane, far_plane, slice);
+		const float depth_far = slice_depth(near_plane, far_plane, slice + 1);
+		froxels.slice_near[slice] = depth_near;
+		froxels.slice_far[slice] = depth_far;
+		for (int tile_y = 0; tile_y < cluster_tiles_y; tile_y++) {
+			for (int tile_x = 0; tile_x < cluster_tiles_x; tile_x++) {
+				// the tile's edges in NDC, at both ends of the slice
+				const float x0 = -1.0f + 2.0f * tile_x / cluster_tiles_x, x1 = -1.0f + 2.0f * (tile_x + 1) / cluster_tiles_x;
+				const float y0 = -1.0f + 2.0f * tile_y / cluster_tiles_y, y1 = -1.0f + 2.0f * (tile_y + 1) / cluster_tiles_y;
+				const int cluster = (slice * cluster_tiles_y + tile_y) * cluster_tiles_x + tile_x;
+				froxels.min_x[cluster] = min(x0 * depth_near, x0 * depth_far) / p0;
+				froxels.max_x[cluster] = max(x1 * depth_near, x1 * depth_far) / p0;
+				froxels.min_y[cluster] = min(y0 * depth_near, y0 * depth_far) / p5;
+				froxels.max_y[cluster] = max(y1 * depth_near, y1 * depth_far) / p5;
+			}
+		}
+	}
+}
+
+// view space in x, y and depth (-z), and the frustum test against the side planes and the depth range
+struct light_view {
+	const mat4* view;
+	float side_x, side_y;
+	float inv_length_x, inv_length_y;
+};
+
+static void keep_light(const point_lights& lights, const size_t source, const float x, const float y, const float depth,
+	light_grid& grid) {
+	const float radius = lights.radius[source];
+	grid.view_x.push_back(x);
+	grid.view_y.push_back(y);
+	grid.view_z.push_back(depth);
+	grid.view_radius.push_back(radius);
+	grid.first_slice.push_back(slice_of(max(depth - radius, froxels.near_plane)));
+	grid.last_slice.push_back(slice_of(min(depth + radius, froxels.far_plane)));
+	grid.lights.insert(grid.lights.end(), { lights.x[source], lights.y[source], lights.z[source], radius,
+		lights.red[source], lights.green[source], lights.blue[source], 0.0f });
+}
+
+static bool light_visible(const light_view& camera, const float x, const float y, const float depth, const float radius) {
+	return depth + radius > froxels.near_plane && depth - radius < froxels.far_plane
+		&& (camera.side_x * x - depth) * camera.inv_length_x <= radius
+		&& (-camera.side_x * x - depth) * camera.inv_length_x <= radius
+		&& (camera.side_y * y - depth) * camera.inv_length_y <= radius
+		&& (-camera.side_y * y - depth) * camera.inv_length_y <= radius;
+}
+
+static void cull_lights_scalar(const point_lights& lights, const light_view& camera, const size_t begin, light_grid& grid) {
+	const float* m = camera.view->m;
+	for (size_t i = begin; i < lights.size(); i++) {
+		const float x = m[0] * lights.x[i] + m[4] * lights.y[i] + m[8] * lights.z[i] + m[12];
+		const float y = m[1] * lights.x[i] + m[5] * lights.y[i] + m[9] * lights.z[i] + m[13];
+		const float depth = -(m[2] * lights.x[i] + m[6] * lights.y[i] + m[10] * lights.z[i] + m[14]);
+		if (light_visible(camera, x, y, depth, lights.radius[i])) {
+			keep_light(lights, i, x, y, depth, grid);
+		}
+	}
+}
+
+static void cull_lights_avx2(const point_lights& lights, const light_view& camera, light_grid& grid) {
+	const float* m = camera.view->m;
+	__m256 row[3][4];
+	for (int r = 0; r < 3; r++) {
+		for (int column = 0; column < 4; column++) {
+			row[r][column] = _mm256_set1_ps(m[column * 4 + r]);
+		}
+	}
+	const __m256 near_plane = _mm256_set1_ps(froxels.near_plane), far_plane = _mm256_set1_ps(froxels.far_plane);
+	const __m256 side_x = _mm256_set1_ps(camera.side_x), side_y = _mm256_set1_ps(camera.side_y);
+	const __m256 inv_length_x = _mm256_set1_ps(camera.inv_length_x), inv_length_y = _mm256_set1_ps(camera.inv_length_y);
+	const __m256 sign_bit = _mm256_set1_ps(-0.0f);
+
+	size_t i = 0;
+	for (; i + 8 <= lights.size(); i += 8) {
+		const __m256 wx = _mm256_loadu_ps(&lights.x[i]), wy = _mm256_loadu_ps(&lights.y[i]), wz = _mm256_loadu_ps(&lights.z[i]);
+		const __m256 radius = _mm256_loadu_ps(&lights.radius[i]);
+		__m256 view[3];
+		for (int r = 0; r < 3; r++) {
+			view[r] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(row[r][0], wx), _mm256_mul_ps(row[r][1], wy)),
+				_mm256_add_ps(_mm256_mul_ps(row[r][2], wz), row[r][3]));
+		}
+		const __m256 depth = _mm256_xor_ps(view[2], sign_bit);
+		// the side planes in pairs: |side * x| - depth covers both the left and the right one
+		const __m256 reach_x = _mm256_mul_ps(_mm256_sub_ps(_mm256_andnot_ps(sign_bit, _mm256_mul_ps(side_x, view[0])), depth), inv_length_x);
+		const __m256 reach_y = _mm256_mul_ps(_mm256_sub_ps(_mm256_andnot_ps(sign_bit, _mm256_mul_ps(side_y, view[1])), depth), inv_length_y);
+		__m256 inside = _mm256_cmp_ps(_mm256_add_ps(depth, radius), near_plane, _CMP_GT_OQ);
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_sub_ps(depth, radius), far_plane, _CMP_LT_OQ));
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(reach_x, radius, _CMP_LE_OQ));
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(reach_y, radius, _CMP_LE_OQ));
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+		if (mask == 0) {
+			continue;
+		}
+		float x[8], y[8], z[8];
+		_mm256_storeu_ps(x, view[0]);
+		_mm256_storeu_ps(y, view[1]);
+		_mm256_storeu_ps(z, depth);
+		while (mask != 0) {
+			const int lane = pop_lowest_bit(mask);
+			keep_light(lights, i + lane, x[lane], y[lane], z[lane], grid);
+		}
+	}
+	cull_lights_scalar(lights, camera, i, grid);
+}
+
+// squared distance from the sphere's center to the froxel box, without the depth part that is the
+// same for the whole slice; bits of the tiles in [first, last] of the row that the sphere reaches
+static uint32_t row_hits_scalar(const int row_start, const int first, const int last, const float x, const float y,
+	const float reach_squared) {
+	uint32_t hits = 0;
+	for (int tile = first; tile <= last; tile++) {
+		const int cluster = row_start + tile;
+		const float dx = max(max(froxels.min_x[cluster] - x, x - froxels.max_x[cluster]), 0.0f);
+		const float dy = max(max(froxels.min_y[cluster] - y, y - froxels.max_y[cluster]), 0.0f);
+		hits |= dx * dx + dy * dy <= reach_squared ? 1u << tile : 0u;
+	}
+	return hits;
+}
+
+static uint32_t row_hits_avx2(const int row_start, const int first, const int last, const float x, const float y,
+	const float reach_squared) {
+	const __m256 center_x = _mm256_set1_ps(x), center_y = _mm256_set1_ps(y), reach = _mm256_set1_ps(reach_squared);
+	const __m256 zero = _mm256_setzero_ps();
+	uint32_t hits = 0;
+	for (int block = first & ~7; block <= last; block += 8) {
+		const int cluster = row_start + block;
+		const __m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(&froxels.min_x[cluster]), center_x),
+			_mm256_sub_ps(center_x, _mm256_loadu_ps(&froxels.max_x[cluster]))), zero);
+		const __m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(&froxels.min_y[cluster]), center_y),
+			_mm256_sub_ps(center_y, _mm256_loadu_ps(&froxels.max_y[cluster]))), zero);
+		const __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		hits |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(distance, reach, _CMP_LE_OQ))) << block;
+	}
+	// the blocks run past the range at both ends
+	return hits & ((2u << last) - 1) & ~((1u << first) - 1);
+}
+
+static int tile_of(const float ndc, const int tiles) {
+	return min(tiles - 1, max(0, static_cast<int>(floor((ndc + 1.0f) * 0.5f * tiles))));
+}
+
+// one slice: every candidate light against the froxels its screen bounds cover, then the hits
+// sorted by froxel into the slice's part of the grid
+static void bin_slices(void* context, const int begin, const int end) {
+	light_grid& grid = *static_cast<light_grid*>(context);
+	static_assert(cluster_tiles_x % 8 == 0 && cluster_tiles_x <= 32, "rows are tested 8 tiles at a time into a 32 bit mask");
+	for (int slice = begin; slice < end; slice++) {
+		vector<uint32_t>& pairs = grid.slice_pairs[slice];
+		pairs.clear();
+		// a tile and a light per hit, most lights hit a few tiles; far slices start out empty and
+		// fill up as the camera turns
+		reserve_ahead(pairs, max<size_t>((grid.slice_offsets[slice + 1] - grid.slice_offsets[slice]) * 8, 1024));
+		const float slice_near = froxels.slice_near[slice], slice_far = froxels.slice_far[slice];
+		for (uint32_t candidate = grid.slice_offsets[slice]; candidate < grid.slice_offsets[slice + 1]; candidate++) {
+			const uint32_t light = grid.slice_lights[candidate];
+			const float x = grid.view_x[light], y = grid.view_y[light], depth = grid.view_z[light];
+			const float radius = grid.view_radius[light];
+			const float dz = max(max(slice_near - depth, depth - slice_far), 0.0f);
+			const float reach_squared = radius * radius - dz * dz;
+			if (reach_squared < 0.0f) {
+				continue;
+			}
+			// NDC bounds of the sphere's box clipped to the slice: the nearest depth spreads a side the
+			// most when it is away from the center line, the farthest when it is across it
+			const float depth_near = max(depth - radius, slice_near), depth_far = min(depth + radius, slice_far);
+			const float left = x - radius, right = x + radius, bottom = y - radius, top = y + radius;
+			const int first_x = tile_of(froxels.p0 * left / (left >= 0.0f ? depth_far : depth_near), cluster_tiles_x);
+			const int last_x = tile_of(froxels.p0 * right / (right >= 0.0f ? depth_near : depth_far), cluster_tiles_x);
+			const int first_y = tile_of(froxels.p5 * bottom / (bottom >= 0.0f ? depth_far : depth_near), cluster_tiles_y);
+			const int last_y = tile_of(froxels.p5 * top / (top >= 0.0f ? depth_near : depth_far), cluster_tiles_y);
+			for (int tile_y = first_y; tile_y <= last_y; tile_y++) {
+				const int row_start = (slice * cluster_tiles_y + tile_y) * cluster_tiles_x;
+				uint32_t hits = use_avx2 ? row_hits_avx2(row_start, first_x, last_x, x, y, reach_squared)
+					: row_hits_scalar(row_start, first_x, last_x, x, y, reach_squared);
+				while (hits != 0) {
+					const int tile_x = pop_lowest_bit(hits);
+					pairs.push_back(static_cast<uint32_t>(tile_y * cluster_tiles_x + tile_x));
+					pairs.push_back(light);
+				}
+			}
+		}
+
+		// counting sort by froxel; offsets are local to the slice until the slices are put together
+		uint32_t* clusters = &grid.clusters[slice * tiles_per_slice * 2];
+		for (int tile = 0; tile < tiles_per_slice; tile++) {
+			clusters[tile * 2 + 1] = 0;
+		}
+		for (size_t pair = 0; pair < pairs.size(); pair += 2) {
+			clusters[pairs[pair] * 2 + 1]++;
+		}
+		uint32_t offset = 0;
+		for (int tile = 0; tile < tiles_per_slice; tile++) {
+			clusters[tile * 2] = offset;
+			offset += clusters[tile * 2 + 1];
+		}
+		vector<uint32_t>& indices = grid.slice_indices[slice];
+		reserve_ahead(indices, max<size_t>(offset, 512));
+		indices.resize(offset);
+		for (size_t pair = 0; pair < pairs.size(); pair += 2) {
+			// the count is reused as a cursor and comes back to what it was
+			uint32_t& count = clusters[pairs[pair] * 2 + 1];
+			indices[clusters[pairs[pair] * 2] + --count] = pairs[pair + 1];
+		}
+		for (size_t pair = 0; pair < pairs.size(); pair += 2) {
+			clusters[pairs[pair] * 2 + 1]++;
+		}
+	}
+}
+
+void clustered_lights_bin(const point_lights& lights, const mat4& view, const mat4& projection, light_grid& grid) {
+	const double start = profiler_now_ms();
+	update_froxels(projection);
+	grid.lights.clear();
+	grid.view_x.clear();
+	grid.view_y.clear();
+	grid.view_z.clear();
+	grid.view_radius.clear();
+	grid.first_slice.clear();
+	grid.last_slice.clear();
+	for (vector<float>* column : { &grid.view_x, &grid.view_y, &grid.view_z, &grid.view_radius }) {
+		column->reserve(lights.size());
+	}
+	grid.first_slice.reserve(lights.size());
+	grid.last_slice.reserve(lights.size());
+	grid.lights.reserve(lights.size() * 8);
+
+	light_view camera;
+	camera.view = &view;
+	camera.side_x = froxels.p0;
+	camera.side_y = froxels.p5;
+	camera.inv_length_x = 1.0f / sqrt(froxels.p0 * froxels.p0 + 1.0f);
+	camera.inv_length_y = 1.0f / sqrt(froxels.p5 * froxels.p5 + 1.0f);
+	if (use_avx2) {
+		cull_lights_avx2(lights, camera, grid);
+	}
+	else {
+		cull_lights_scalar(lights, camera, 0, grid);
+	}
+	grid.light_count = grid.view_x.size();
+	// the view matrix is a rotation and a translation: eye = -transpose(rotation) * translation
+	const float* m = view.m;
+	grid.eye = {
+		-(m[0] * m[12] + m[1] * m[13] + m[2] * m[14]),
+		-(m[4] * m[12] + m[5] * m[13] + m[6] * m[14]),
+		-(m[8] * m[12] + m[9] * m[13] + m[10] * m[14])
+	};
+
+	// the lights each slice has to look at
+	grid.slice_offsets.assign(cluster_slices + 1, 0);
+	for (size_t light = 0; light < grid.light_count; light++) {
+		for (int slice = grid.first_slice[light]; slice <= grid.last_slice[light]; slice++) {
+			grid.slice_offsets[slice + 1]++;
+		}
+	}
+	for (int slice = 0; slice < cluster_slices; slice++) {
+		grid.slice_offsets[slice + 1] += grid.slice_offsets[slice];
+	}
+	reserve_ahead(grid.slice_lights, grid.slice_offsets[cluster_slices]);
+	grid.slice_lights.resize(grid.slice_offsets[cluster_slices]);
+	for (size_t light = 0; light < grid.light_count; light++) {
+		for (int slice = grid.first_slice[light]; slice <= grid.last_slice[light]; slice++) {
+			grid.slice_lights[grid.slice_offsets[slice]++] = static_cast<uint32_t>(light);
+		}
+	}
+	// the fill moved every offset to the next slice's start
+	for (int slice = cluster_slices; slice > 0; slice--) {
+		grid.slice_offsets[slice] = grid.slice_offsets[slice - 1];
+	}
+	grid.slice_offsets[0] = 0;
+
+	grid.clusters.resize(cluster_count * 2);
+	grid.slice_pairs.resize(cluster_slices);
+	grid.slice_indices.resize(cluster_slices);
+	parallel_for(0, cluster_slices, 1, bin_slices, &grid);
+
+	grid.indices.clear();
+	grid.max_per_cluster = 0;
+	size_t total = 0;
+	for (const vector<uint32_t>& indices : grid.slice_indices) {
+		total += indices.size();
+	}
+	reserve_ahead(grid.indices, total);
+	for (int slice = 0; slice < cluster_slices; slice++) {
+		const uint32_t base = static_cast<uint32_t>(grid.indices.size());
+		uint32_t* clusters = &grid.clusters[slice * tiles_per_slice * 2];
+		for (int tile = 0; tile < tiles_per_slice; tile++) {
+			clusters[tile * 2] += base;
+			grid.max_per_cluster = max<size_t>(grid.max_per_cluster, clusters[tile * 2 + 1]);
+		}
+		grid.indices.insert(grid.indices.end(), grid.slice_indices[slice].begin(), grid.slice_indices[slice].end());
+	}
+	grid.bin_ms = profiler_now_ms() - start;
+}
+
+bool clustered_lights_init() {
+	static const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+	glGenBuffers(3, buffers);
+	glGenTextures(3, textures);
+	gpu_category_scope category(gpu_category::streaming);
+	for (int i = 0; i < 3; i++) {
+		glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+		glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+	}
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	return true;
+}
+
+void clustered_lights_release() {
+	glDeleteTextures(3, textures);
+	glDeleteBuffers(3, buffers);
+	memset(textures, 0, sizeof(textures));
+	memset(buffers, 0, sizeof(buffers));
+}
+
+void clustered_lights_setup_program(const GLuint program, const int width, const int height, const mat4& projection) {
+	const float near_plane = projection.m[14] / (projection.m[10] - 1.0f);
+	const float far_plane = projection.m[14] / (projection.m[10] + 1.0f);
+	const float slice_scale = cluster_slices / log(far_plane / near_plane);
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "light_data"), light_data_unit);
+	glUniform1i(glGetUniformLocation(program, "light_clusters"), clusters_unit);
+	glUniform1i(glGetUniformLocation(program, "light_indices"), indices_unit);
+	glUniform2f(glGetUniformLocation(program, "tile_size"), static_cast<GLfloat>(width) / cluster_tiles_x,
+		static_cast<GLfloat>(height) / cluster_tiles_y);
+	glUniform3i(glGetUniformLocation(program, "cluster_grid"), cluster_tiles_x, cluster_tiles_y, cluster_slices);
+	glUniform2f(glGetUniformLocation(program, "depth_range"), near_plane, far_plane);
+	// slice = log(depth) * scale + bias
+	glUniform2f(glGetUniformLocation(program, "slice_scale_bias"), slice_scale, -log(near_plane) * slice_scale);
+}
+
+static void upload(const int buffer, const void* data, const size_t bytes) {
+	// a buffer texture needs a store even when there is nothing in it
+	glBindBuffer(GL_TEXTURE_BUFFER, buffers[buffer]);
+	glBufferData(GL_TEXTURE_BUFFER, max<size_t>(bytes, 16), nullptr, GL_STREAM_DRAW);
+	if (bytes > 0) {
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+	}
+}
+
+void clustered_lights_upload(const light_grid& grid) {
+	gpu_category_scope category(gpu_category::streaming);
+	upload(0, grid.lights.data(), grid.lights.size() * sizeof(float));
+	upload(1, grid.clusters.data(), grid.clusters.size() * sizeof(uint32_t));
+	upload(2, grid.indices.data(), grid.indices.size() * sizeof(uint32_t));
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	uploaded_eye = grid.eye;
+}
+
+const vec3& clustered_lights_eye() {
+	return uploaded_eye;
+}
+
+void clustered_lights_bind() {
+	const GLint units[3] = { light_data_unit, clusters_unit, indices_unit };
+	for (int i = 0; i < 3; i++) {
+		glActiveTexture(GL_TEXTURE0 + units[i]);
+		glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
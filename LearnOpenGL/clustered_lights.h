@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gl_api.h"
+#include "math3d.h"
+
+// clustered forward lighting: the view frustum is cut into a grid of froxels, screen tiles times
+// depth slices that grow exponentially, and every point light is binned on the CPU into the froxels
+// its sphere touches. the grid goes to the GPU as texture buffers and a fragment only loops over the
+// lights of its own froxel (city_clustered.frag)
+
+const int cluster_tiles_x = 16;
+const int cluster_tiles_y = 9;
+const int cluster_slices = 24;
+const int cluster_count = cluster_tiles_x * cluster_tiles_y * cluster_slices;
+
+// structure of arrays, so the binning can take 8 lights at a time
+struct point_lights {
+	std::vector<float> x, y, z;
+	std::vector<float> radius;
+	std::vector<float> red, green, blue;
+
+	void clear();
+	void reserve(size_t count);
+	void add(const vec3& position, float radius, const vec3& color);
+	size_t size() const { return x.size(); }
+};
+
+// what the binning produces for one frame; the vectors keep their capacity between frames
+struct light_grid {
+	// the lights inside the frustum, two RGBA32F texels each: world position and radius, color
+	std::vector<float> lights;
+	size_t light_count = 0;
+	// per froxel, slice major then row then column: first entry in indices and how many there are
+	std::vector<uint32_t> clusters;
+	// into lights, grouped by froxel
+	std::vector<uint32_t> indices;
+	size_t max_per_cluster = 0;
+	// camera position in world space, for the specular highlights
+	vec3 eye = { 0.0f, 0.0f, 0.0f };
+	double bin_ms = 0.0;
+
+	// the lights inside the frustum in view space, and the slices each one reaches
+	std::vector<float> view_x, view_y, view_z, view_radius;
+	std::vector<int> first_slice, last_slice;
+	// candidates of every slice, then each slice's froxel lists before they are put together
+	std::vector<uint32_t> slice_offsets;
+	std::vector<uint32_t> slice_lights;
+	std::vector<std::vector<uint32_t>> slice_indices;
+	std::vector<std::vector<uint32_t>> slice_pairs;
+};
+
+// bins the lights for a camera, the slices spread over the job system's threads when it runs;
+// projection comes from perspective() and its near and far planes bound the slices
+void clustered_lights_bin(const point_lights& lights, const mat4& view, const mat4& projection, light_grid& grid);
+// AVX2 for the frustum test and the froxel tests when the CPU has it; false - scalar only
+void clustered_lights_use_simd(bool simd);
+
+bool clustered_lights_init();
+void clustered_lights_release();
+// sampler units and grid constants of a program that shades with the grid, drawn at width x height
+// with projection; leaves the program bound
+void clustered_lights_setup_program(GLuint program, int width, int height, const mat4& projection);
+// copies a binned grid into the texture buffers
+void clustered_lights_upload(const light_grid& grid);
+// eye of the last uploaded grid, for the programs' eye_position uniform
+const vec3& clustered_lights_eye();
+// binds the texture buffers to the units the programs sample them from
+void clustered_lights_bind();
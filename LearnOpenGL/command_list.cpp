@@ -0,0 +1,300 @@
+#include "command_list.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+
+#include "alloc_tracker.h"
+#include "frame_arena.h"
+#include "gl_api.h"
+#include "log.h"
+
+using namespace std;
+
+static const size_t block_size = 64 * 1024;
+
+struct command_list::block {
+	block* next;
+	size_t size;
+	size_t used;
+
+	unsigned char* data() { return reinterpret_cast<unsigned char*>(this + 1); }
+};
+
+struct uniform_value {
+	int32_t location;
+	// 3, 4 or 16 floats
+	int32_t components;
+};
+
+// followed by uniform_count uniform_values and then their floats back to back
+struct draw_command {
+	uint64_t sort_key;
+	const draw_command* next;
+	uint32_t program;
+	uint32_t vertex_array;
+	command_primitive primitive;
+	uint32_t index_count;
+	uint32_t first_index;
+	// position in its list, keeps sorting stable
+	uint32_t sequence;
+	uint32_t uniform_count;
+	uint32_t float_count;
+};
+
+command_list::~command_list() {
+	while (blocks != nullptr) {
+		block* next = blocks->next;
+		alloc_tracker_free(blocks);
+		blocks = next;
+	}
+}
+
+void command_list::clear() {
+	for (block* b = blocks; b != nullptr; b = b->next) {
+		b->used = 0;
+	}
+	current = blocks;
+	first = last = nullptr;
+	commands = draws = 0;
+	dropped_uniforms = 0;
+	program = vertex_array = 0;
+	bound_uniforms = 0;
+}
+
+void* command_list::allocate(size_t bytes) {
+	bytes = (bytes + 7) & ~static_cast<size_t>(7);
+	for (block* b = current; b != nullptr; b = b->next) {
+		if (b->used + bytes <= b->size) {
+			void* pointer = b->data() + b->used;
+			b->used += bytes;
+			current = b;
+			return pointer;
+		}
+	}
+
+	const size_t size = max(block_size, bytes);
+	block* added = static_cast<block*>(alloc_tracker_malloc(sizeof(block) + size));
+	if (added == nullptr) {
+		throw bad_alloc();
+	}
+	added->size = size;
+	added->used = bytes;
+	if (current == nullptr) {
+		added->next = blocks;
+		blocks = added;
+	}
+	else {
+		added->next = current->next;
+		current->next = added;
+	}
+	current = added;
+	return added->data();
+}
+
+void command_list::bind_program(const uint32_t bound_program) {
+	// locations belong to a program, the next one starts over
+	if (bound_program != program) {
+		bound_uniforms = 0;
+	}
+	program = bound_program;
+	commands++;
+}
+
+void command_list::bind_vertex_array(const uint32_t bound_vertex_array) {
+	vertex_array = bound_vertex_array;
+	commands++;
+}
+
+void command_list::uniform(const int32_t location, const int components, const float* value) {
+	// a second value for the same location replaces the first for the draws after it
+	int slot = 0;
+	while (slot < bound_uniforms && bound_locations[slot] != location) {
+		slot++;
+	}
+	assert(slot < max_uniforms && "more distinct uniforms than a command list keeps per program");
+	if (slot == max_uniforms) {
+		dropped_uniforms++;
+		return;
+	}
+	if (slot == bound_uniforms) {
+		bound_uniforms++;
+	}
+	bound_locations[slot] = location;
+	bound_components[slot] = components;
+	memcpy(bound_values[slot], value, components * sizeof(float));
+	commands++;
+}
+
+void command_list::uniform_vec3(const int32_t location, const float* value) {
+	uniform(location, 3, value);
+}
+
+void command_list::uniform_vec4(const int32_t location, const float* value) {
+	uniform(location, 4, value);
+}
+
+void command_list::uniform_mat4(const int32_t location, const float* value) {
+	uniform(location, 16, value);
+}
+
+void command_list::draw_indexed(const uint64_t sort_key, const command_primitive primitive, const uint32_t index_count,
+	const uint32_t first_index) {
+	uint32_t float_count = 0;
+	for (int i = 0; i < bound_uniforms; i++) {
+		float_count += bound_components[i];
+	}
+
+	draw_command* draw = static_cast<draw_command*>(allocate(sizeof(draw_command)
+		+ bound_uniforms * sizeof(uniform_value) + float_count * sizeof(float)));
+	draw->sort_key = sort_key;
+	draw->next = nullptr;
+	draw->program = program;
+	draw->vertex_array = vertex_array;
+	draw->primitive = primitive;
+	draw->index_count = index_count;
+	draw->first_index = first_index;
+	draw->sequence = static_cast<uint32_t>(draws);
+	draw->uniform_count = bound_uniforms;
+	draw->float_count = float_count;
+
+	uniform_value* uniforms = reinterpret_cast<uniform_value*>(draw + 1);
+	float* values = reinterpret_cast<float*>(uniforms + bound_uniforms);
+	for (int i = 0; i < bound_uniforms; i++) {
+		uniforms[i].location = bound_locations[i];
+		uniforms[i].components = bound_components[i];
+		memcpy(values, bound_values[i], bound_components[i] * sizeof(float));
+		values += bound_components[i];
+	}
+
+	if (last != nullptr) {
+		last->next = draw;
+	}
+	else {
+		first = draw;
+	}
+	last = draw;
+	commands++;
+	draws++;
+}
+
+struct submit_state {
+	bool bound = false;
+	GLuint program = 0;
+	GLuint vertex_array = 0;
+	// values last given to the bound program, so the ones every draw carries only go out on a change
+	int uniforms = 0;
+	int32_t locations[command_list::max_uniforms];
+	float values[command_list::max_uniforms][16];
+	size_t calls = 0;
+};
+
+static bool uniform_changed(submit_state& state, const int32_t location, const int components, const float* value) {
+	int slot = 0;
+	while (slot < state.uniforms && state.locations[slot] != location) {
+		slot++;
+	}
+	if (slot < state.uniforms && memcmp(state.values[slot], value, components * sizeof(float)) == 0) {
+		return false;
+	}
+	if (slot == state.uniforms) {
+		if (slot == command_list::max_uniforms) {
+			return true;
+		}
+		state.uniforms++;
+		state.locations[slot] = location;
+	}
+	memcpy(state.values[slot], value, components * sizeof(float));
+	return true;
+}
+
+static GLenum gl_primitive(const command_primitive primitive) {
+	switch (primitive) {
+	case command_primitive::lines: return GL_LINES;
+	case command_primitive::points: return GL_POINTS;
+	default: return GL_TRIANGLES;
+	}
+}
+
+static void submit_draw(const draw_command& draw, submit_state& state) {
+	if (!state.bound || draw.program != state.program) {
+		glUseProgram(draw.program);
+		state.program = draw.program;
+		state.uniforms = 0;
+		state.calls++;
+	}
+	if (!state.bound || draw.vertex_array != state.vertex_array) {
+		glBindVertexArray(draw.vertex_array);
+		state.vertex_array = draw.vertex_array;
+		state.calls++;
+	}
+	state.bound = true;
+
+	const uniform_value* uniforms = reinterpret_cast<const uniform_value*>(&draw + 1);
+	const float* values = reinterpret_cast<const float*>(uniforms + draw.uniform_count);
+	for (uint32_t i = 0; i < draw.uniform_count; i++) {
+		const float* value = values;
+		values += uniforms[i].components;
+		if (!uniform_changed(state, uniforms[i].location, uniforms[i].components, value)) {
+			continue;
+		}
+		switch (uniforms[i].components) {
+		case 3: glUniform3fv(uniforms[i].location, 1, value); break;
+		case 4: glUniform4fv(uniforms[i].location, 1, value); break;
+		default: glUniformMatrix4fv(uniforms[i].location, 1, GL_FALSE, value); break;
+		}
+		state.calls++;
+	}
+
+	glDrawElements(gl_primitive(draw.primitive), draw.index_count, GL_UNSIGNED_INT,
+		reinterpret_cast<const GLvoid*>(static_cast<uintptr_t>(draw.first_index) * sizeof(GLuint)));
+	state.calls++;
+}
+
+struct sort_entry {
+	uint64_t key;
+	// list index above, sequence below
+	uint64_t order;
+	const draw_command* draw;
+};
+
+size_t command_lists_submit(const command_list* lists, const size_t count, const bool sort) {
+	static bool reported = false;
+	for (size_t list = 0; list < count && !reported; list++) {
+		if (lists[list].dropped_uniform_count() > 0) {
+			log("Command list dropped " + to_string(lists[list].dropped_uniform_count())
+				+ " uniforms past the limit of " + to_string(command_list::max_uniforms) + " per program");
+			reported = true;
+		}
+	}
+
+	submit_state state;
+	if (!sort) {
+		for (size_t list = 0; list < count; list++) {
+			for (const draw_command* draw = lists[list].first_draw(); draw != nullptr; draw = draw->next) {
+				submit_draw(*draw, state);
+			}
+		}
+		return state.calls;
+	}
+
+	size_t total = 0;
+	for (size_t list = 0; list < count; list++) {
+		total += lists[list].draw_count();
+	}
+	frame_vector<sort_entry> entries;
+	entries.reserve(total);
+	for (size_t list = 0; list < count; list++) {
+		for (const draw_command* draw = lists[list].first_draw(); draw != nullptr; draw = draw->next) {
+			entries.push_back({ draw->sort_key, static_cast<uint64_t>(list) << 32 | draw->sequence, draw });
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](const sort_entry& a, const sort_entry& b) {
+		return a.key != b.key ? a.key < b.key : a.order < b.order;
+	});
+	for (const sort_entry& entry : entries) {
+		submit_draw(*entry.draw, state);
+	}
+	return state.calls;
+}
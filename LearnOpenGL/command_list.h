@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// draw commands recorded without touching GL, so any thread can record them: program and vertex
+// array binds and uniforms are state for the draws that follow, and every draw is stored with
+// the whole state it was recorded under - every uniform set since its program was bound, not just
+// the ones set since the draw before it. that lets the replay keep the recorded order or sort the
+// draws of many lists by key, dropping the binds and uniform values that change nothing. a list
+// bump allocates from blocks of its own that clear() keeps for the next frame, so a list recorded
+// by one thread at a time never locks or, once warm, allocates
+
+enum class command_primitive : uint32_t {
+	triangles,
+	lines,
+	points
+};
+
+struct draw_command;
+
+class command_list {
+public:
+	// uniforms one program can have set in a list, more are dropped and counted
+	static const int max_uniforms = 8;
+
+	command_list() = default;
+	command_list(const command_list&) = delete;
+	command_list& operator=(const command_list&) = delete;
+	~command_list();
+
+	// drops the commands, keeps the memory
+	void clear();
+
+	void bind_program(uint32_t program);
+	void bind_vertex_array(uint32_t vertex_array);
+	void uniform_vec3(int32_t location, const float* value);
+	void uniform_vec4(int32_t location, const float* value);
+	void uniform_mat4(int32_t location, const float* value);
+	// 32 bit indices from the bound vertex array's element buffer; sort_key only matters for sorted
+	// replays, lower draws first
+	void draw_indexed(uint64_t sort_key, command_primitive primitive, uint32_t index_count, uint32_t first_index);
+
+	// every call above counts, binds and uniforms too
+	size_t command_count() const { return commands; }
+	size_t draw_count() const { return draws; }
+	const draw_command* first_draw() const { return first; }
+	size_t dropped_uniform_count() const { return dropped_uniforms; }
+
+private:
+	struct block;
+
+	void uniform(int32_t location, int components, const float* value);
+	void* allocate(size_t bytes);
+
+	block* blocks = nullptr;
+	block* current = nullptr;
+	draw_command* first = nullptr;
+	draw_command* last = nullptr;
+	size_t commands = 0;
+	size_t draws = 0;
+	size_t dropped_uniforms = 0;
+
+	uint32_t program = 0;
+	uint32_t vertex_array = 0;
+	// uniforms set since the program was bound, every draw carries all of them
+	int bound_uniforms = 0;
+	int32_t bound_locations[max_uniforms];
+	int bound_components[max_uniforms];
+	float bound_values[max_uniforms][16];
+};
+
+// GL side, on the thread that owns the context: the draws of lists[0], then lists[1] ... or, with
+// sort, all of them ordered by key (ties keep the recorded order). binds and uniform values that
+// match the current state are skipped either way; returns the GL calls made
+size_t command_lists_submit(const command_list* lists, size_t count, bool sort);
@@ -0,0 +1,143 @@
+#include "command_list_benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bench_stats.h"
+#include "city_scene.h"
+#include "frame_arena.h"
+#include "job_system.h"
+#include "log.h"
+
+using namespace std;
+
+static const int warmup_frames = 3;
+static const int list_count = 64;
+// model matrix, albedo, draw
+static const int commands_per_object = 3;
+
+// path 0 draws straight from the objects, 1 replays the lists in order, 2 sorted
+static void draw_path(const int path, const mat4& view_projection, const command_list* lists) {
+	if (path == 0) {
+		city_draw(view_projection, nullptr, 0);
+	}
+	else {
+		city_draw_lists(view_projection, lists, list_count, path == 2);
+	}
+}
+
+int run_command_list_benchmark(const app_options& options, GLFWwindow* window, const int width, const int height) {
+	const int object_count = max(1, options.command_bench_commands / commands_per_object);
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 20;
+
+	city_generate(object_count, 1234);
+	if (!city_init_gl()) {
+		log("Failed to set up the command list benchmark");
+		return 1;
+	}
+	const mat4 view_projection = city_projection(static_cast<float>(width) / height) * city_view(0.0);
+	unique_ptr<command_list[]> lists(new command_list[list_count]);
+
+	string json = "{\n";
+	json += "  \"objects\": " + to_string(object_count) + ",\n";
+	json += "  \"lists\": " + to_string(list_count) + ",\n";
+	json += "  \"frames\": " + to_string(frames) + ",\n";
+	json += "  \"renderer\": \"" + string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) + "\",\n";
+	json += "  \"record\": [\n";
+
+	const int hardware_threads = max(1, static_cast<int>(thread::hardware_concurrency()));
+	vector<int> thread_counts;
+	for (int threads = 1; threads < hardware_threads; threads *= 2) {
+		thread_counts.push_back(threads);
+	}
+	thread_counts.push_back(hardware_threads);
+
+	size_t commands = 0;
+	char line[256];
+	for (size_t run = 0; run < thread_counts.size(); run++) {
+		job_system_init(thread_counts[run]);
+		vector<double> record_ms;
+		for (int frame = 0; frame < warmup_frames + frames; frame++) {
+			const bench_clock::time_point start = bench_clock::now();
+			city_record(view_projection, nullptr, 0, lists.get(), list_count);
+			if (frame >= warmup_frames) {
+				record_ms.push_back(elapsed_ms(start));
+			}
+		}
+		job_system_shutdown();
+
+		commands = 0;
+		for (int list = 0; list < list_count; list++) {
+			commands += lists[list].command_count();
+		}
+		const bench_stats stats = compute_stats(record_ms);
+		snprintf(line, sizeof(line), "Command lists: %zu commands recorded on %2d threads in %.3f ms, %.1f M commands/s",
+			commands, thread_counts[run], stats.median, commands / stats.median / 1000.0);
+		log(line);
+		json += "    {\"threads\": " + to_string(thread_counts[run]) + ", \"record_ms\": " + stats_json(stats);
+		snprintf(line, sizeof(line), ", \"commands_per_second\": %.0f}", commands / stats.median * 1000.0);
+		json += line;
+		json += run + 1 == thread_counts.size() ? "\n" : ",\n";
+	}
+	json += "  ],\n";
+	json += "  \"commands\": " + to_string(commands) + ",\n";
+
+	// every path has to produce the direct path's image; sorting only reorders opaque draws
+	vector<uint8_t> reference, replayed;
+	draw_path(0, view_projection, lists.get());
+	read_pixels(reference, width, height);
+	draw_path(1, view_projection, lists.get());
+	read_pixels(replayed, width, height);
+	const int in_order_difference = differing_pixels(reference, replayed);
+	draw_path(2, view_projection, lists.get());
+	read_pixels(replayed, width, height);
+	const int sorted_difference = differing_pixels(reference, replayed);
+	frame_arena_reset();
+
+	const char* path_names[] = { "direct", "replay_in_order", "replay_sorted" };
+	json += "  \"replay\": [\n";
+	for (int path = 0; path < 3; path++) {
+		vector<double> submit_ms, frame_ms;
+		for (int frame = 0; frame < warmup_frames + frames; frame++) {
+			glfwPollEvents();
+			const bench_clock::time_point start = bench_clock::now();
+			draw_path(path, view_projection, lists.get());
+			const double submitted = elapsed_ms(start);
+			// the driver queues the draws, wait for them so the second time is the frame's cost
+			glFinish();
+			if (frame >= warmup_frames) {
+				submit_ms.push_back(submitted);
+				frame_ms.push_back(elapsed_ms(start));
+			}
+			glfwSwapBuffers(window);
+			frame_arena_reset();
+		}
+
+		const bench_stats submit_stats = compute_stats(submit_ms);
+		const bench_stats frame_stats = compute_stats(frame_ms);
+		snprintf(line, sizeof(line), "Command lists: %-15s submit %.3f ms (%.1f ns per command), frame %.3f ms",
+			path_names[path], submit_stats.median, submit_stats.median * 1e6 / commands, frame_stats.median);
+		log(line);
+		json += string("    {\"path\": \"") + path_names[path] + "\", \"submit_ms\": " + stats_json(submit_stats);
+		json += ", \"frame_ms\": " + stats_json(frame_stats);
+		snprintf(line, sizeof(line), ", \"submit_ns_per_command\": %.2f}", submit_stats.median * 1e6 / commands);
+		json += line;
+		json += path == 2 ? "\n" : ",\n";
+	}
+	json += "  ],\n";
+	json += "  \"in_order_differing_pixels\": " + to_string(in_order_difference) + ",\n";
+	json += "  \"sorted_differing_pixels\": " + to_string(sorted_difference) + "\n";
+	json += "}\n";
+	city_release_gl();
+
+	snprintf(line, sizeof(line), "Command lists: %d pixels differ in order, %d sorted", in_order_difference, sorted_difference);
+	log(line);
+
+	if (!write_bench_json(options.bench_output_path, "command_list_bench.json", json, "Command list benchmark")) {
+		return 1;
+	}
+	return in_order_difference == 0 ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "app_options.h"
+#include "gl_api.h"
+
+// the city with enough objects for options.command_bench_commands commands: records them into
+// command lists on 1, 2, 4 ... hardware threads, then draws the frame directly, replayed in order
+// and replayed sorted, checks the images match and writes recording throughput and replay cost
+// as JSON
+int run_command_list_benchmark(const app_options& options, GLFWwindow* window, int width, int height);
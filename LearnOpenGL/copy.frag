@@ -0,0 +1,10 @@
+#version 330 core
+
+in vec2 screen_uv;
+out vec4 color;
+
+uniform sampler2D source;
+
+void main() {
+	color = texture(source, screen_uv);
+}
@@ -0,0 +1,27 @@
+#include "cpu_features.h"
+
+#include <intrin.h>
+
+static bool detect_avx2() {
+	int registers[4];
+	__cpuid(registers, 0);
+	if (registers[0] < 7) {
+		return false;
+	}
+
+	// the OS has to save the ymm registers (OSXSAVE + XCR0 bits 1 and 2) before AVX can be used at all
+	__cpuid(registers, 1);
+	const bool osxsave = (registers[2] & (1 << 27)) != 0;
+	const bool avx = (registers[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+
+	__cpuidex(registers, 7, 0);
+	return (registers[1] & (1 << 5)) != 0;
+}
+
+bool cpu_has_avx2() {
+	static const bool avx2 = detect_avx2();
+	return avx2;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// runtime instruction set checks; SIMD code paths keep a scalar fallback for CPUs without them
+bool cpu_has_avx2();
@@ -0,0 +1,214 @@
+#include "damage.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "gl_api.h"
+#include "gpu_resources.h"
+#include "log.h"
+
+using namespace std;
+
+// rectangles collected before they are squeezed into one bounding box
+static const size_t max_pending = 32;
+// two rectangles are merged when their bounding box is at most this much bigger than both together
+static const double merge_slack = 1.25;
+// past this share of the screen a partial redraw is not worth the scissoring
+static const double full_redraw_share = 0.7;
+
+static int screen_width = 0;
+static int screen_height = 0;
+static bool full = true;
+static vector<damage_rect> pending;
+
+static uint64_t frames = 0;
+static uint64_t partial_frames = 0;
+static uint64_t redrawn_pixels = 0;
+
+static GLuint canvas_framebuffer = 0;
+static GLuint canvas_color = 0;
+static GLuint canvas_depth = 0;
+
+static int64_t area(const damage_rect& rect) {
+	return static_cast<int64_t>(rect.width) * rect.height;
+}
+
+static damage_rect bounds(const damage_rect& a, const damage_rect& b) {
+	damage_rect result;
+	result.x = min(a.x, b.x);
+	result.y = min(a.y, b.y);
+	result.width = max(a.x + a.width, b.x + b.width) - result.x;
+	result.height = max(a.y + a.height, b.y + b.height) - result.y;
+	return result;
+}
+
+static bool overlap(const damage_rect& a, const damage_rect& b) {
+	return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+// merges the pair whose bounding box wastes the fewest pixels
+static void merge_closest() {
+	size_t best_a = 0, best_b = 1;
+	int64_t best_waste = INT64_MAX;
+	for (size_t a = 0; a < pending.size(); a++) {
+		for (size_t b = a + 1; b < pending.size(); b++) {
+			const int64_t waste = area(bounds(pending[a], pending[b])) - area(pending[a]) - area(pending[b]);
+			if (waste < best_waste) {
+				best_waste = waste;
+				best_a = a;
+				best_b = b;
+			}
+		}
+	}
+	pending[best_a] = bounds(pending[best_a], pending[best_b]);
+	pending.erase(pending.begin() + best_b);
+}
+
+void damage_init(const int width, const int height) {
+	screen_width = width;
+	screen_height = height;
+	pending.reserve(max_pending + 1);
+	damage_add_full();
+}
+
+void damage_add(const damage_rect& rect) {
+	if (full) {
+		return;
+	}
+	damage_rect clipped;
+	clipped.x = max(rect.x, 0);
+	clipped.y = max(rect.y, 0);
+	clipped.width = min(rect.x + rect.width, screen_width) - clipped.x;
+	clipped.height = min(rect.y + rect.height, screen_height) - clipped.y;
+	if (clipped.width <= 0 || clipped.height <= 0) {
+		return;
+	}
+
+	// swallow whatever the new rectangle overlaps or sits right next to, until nothing is left to merge
+	for (size_t i = 0; i < pending.size();) {
+		const damage_rect merged = bounds(pending[i], clipped);
+		if (overlap(pending[i], clipped) || area(merged) <= (area(pending[i]) + area(clipped)) * merge_slack) {
+			clipped = merged;
+			pending.erase(pending.begin() + i);
+			i = 0;
+		}
+		else {
+			i++;
+		}
+	}
+	pending.push_back(clipped);
+	while (pending.size() > max_pending) {
+		merge_closest();
+	}
+}
+
+void damage_add_full() {
+	full = true;
+	pending.clear();
+}
+
+bool damage_pending() {
+	return full || !pending.empty();
+}
+
+bool damage_intersects(const damage_rect& rect) {
+	if (full) {
+		return true;
+	}
+	for (const damage_rect& damaged : pending) {
+		if (overlap(damaged, rect)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t damage_take(damage_rect* rects) {
+	if (!damage_pending()) {
+		return 0;
+	}
+	while (pending.size() > max_damage_rects) {
+		merge_closest();
+	}
+
+	int64_t damaged_pixels = 0;
+	for (const damage_rect& rect : pending) {
+		damaged_pixels += area(rect);
+	}
+	const int64_t screen_pixels = static_cast<int64_t>(screen_width) * screen_height;
+	size_t count = 0;
+	if (full || damaged_pixels >= screen_pixels * full_redraw_share) {
+		rects[0].x = rects[0].y = 0;
+		rects[0].width = screen_width;
+		rects[0].height = screen_height;
+		damaged_pixels = screen_pixels;
+		count = 1;
+	}
+	else {
+		copy(pending.begin(), pending.end(), rects);
+		count = pending.size();
+		partial_frames++;
+	}
+	frames++;
+	redrawn_pixels += damaged_pixels;
+
+	full = false;
+	pending.clear();
+	return count;
+}
+
+bool damage_is_full(const damage_rect& rect) {
+	return rect.x <= 0 && rect.y <= 0 && rect.width >= screen_width && rect.height >= screen_height;
+}
+
+bool damage_canvas_init(const int width, const int height) {
+	gpu_category_scope category(gpu_category::render_target);
+	glGenRenderbuffers(1, &canvas_color);
+	glBindRenderbuffer(GL_RENDERBUFFER, canvas_color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glGenRenderbuffers(1, &canvas_depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, canvas_depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &canvas_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, canvas_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, canvas_color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, canvas_depth);
+	const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (!complete) {
+		log("Damage canvas framebuffer incomplete");
+		damage_canvas_release();
+	}
+	return complete;
+}
+
+void damage_canvas_release() {
+	glDeleteFramebuffers(1, &canvas_framebuffer);
+	glDeleteRenderbuffers(1, &canvas_color);
+	glDeleteRenderbuffers(1, &canvas_depth);
+	canvas_framebuffer = canvas_color = canvas_depth = 0;
+}
+
+void damage_canvas_bind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, canvas_framebuffer);
+}
+
+void damage_canvas_present() {
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, canvas_framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, screen_width, screen_height, 0, 0, screen_width, screen_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+string damage_report() {
+	const double screen_pixels = static_cast<double>(screen_width) * screen_height;
+	char line[160];
+	snprintf(line, sizeof(line), "Damage: %llu frames drawn, %llu partially, %.1f%% of their pixels redrawn",
+		static_cast<unsigned long long>(frames), static_cast<unsigned long long>(partial_frames),
+		frames > 0 ? 100.0 * redrawn_pixels / (screen_pixels * frames) : 0.0);
+	return line;
+}
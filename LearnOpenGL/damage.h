@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// a screen rectangle in pixels, bottom left origin like glScissor
+struct damage_rect {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+// rectangles a frame redraws at most, more are merged
+const size_t max_damage_rects = 4;
+
+// on-demand rendering: a frame is drawn only when something damaged part of the screen, and only
+// that part is redrawn. everything is damaged to begin with. main thread only
+void damage_init(int width, int height);
+void damage_add(const damage_rect& rect);
+void damage_add_full();
+bool damage_pending();
+bool damage_intersects(const damage_rect& rect);
+// everything damaged since the last call as at most max_damage_rects rectangles; a single
+// rectangle covering the screen when most of it is damaged, 0 when nothing is
+size_t damage_take(damage_rect* rects);
+bool damage_is_full(const damage_rect& rect);
+
+// the back buffer is undefined after a swap, so partial frames are drawn into this color and depth
+// target, which keeps the last frame, and copied to the back buffer whole
+bool damage_canvas_init(int width, int height);
+void damage_canvas_release();
+void damage_canvas_bind();
+void damage_canvas_present();
+
+// frames drawn, how many of them partially and the share of the pixels they redrew
+std::string damage_report();
@@ -0,0 +1,161 @@
+#include "deferred_benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_stats.h"
+#include "city_scene.h"
+#include "clustered_lights.h"
+#include "deferred_shading.h"
+#include "job_system.h"
+#include "log.h"
+#include "profiler.h"
+
+using namespace std;
+
+static const int warmup_frames = 3;
+static const int default_objects = 10000;
+// the default framebuffer: RGBA8 color and a 32 bit depth and stencil buffer
+static const int forward_bytes_per_pixel = 8;
+// channel difference the packed normal and the R11F_G11F_B10F target may account for
+static const int tolerance = 8;
+
+struct shading_times {
+	vector<double> gpu_ms;
+	// upload and draw until glFinish returns
+	vector<double> draw_ms;
+};
+
+// the camera a bit further down the path every frame
+static double frame_seconds(const int frame) {
+	return 2.0 + frame * 0.37;
+}
+
+static void draw_frame(const double seconds, const int width, const int height, vector<uint32_t>& visible, light_grid& grid) {
+	const mat4 projection = city_projection(static_cast<float>(width) / height);
+	const mat4 view = city_view(seconds);
+	const mat4 view_projection = projection * view;
+	const size_t visible_count = city_cull_frustum(view_projection, false, visible.data());
+	city_bin_lights(seconds, view, projection, grid);
+	clustered_lights_upload(grid);
+	city_draw(view_projection, visible.data(), visible_count);
+}
+
+static void run_frames(GLFWwindow* window, const int frames, const int width, const int height, shading_times& times) {
+	vector<uint32_t> visible(city_objects().size());
+	light_grid grid;
+	GLuint query = 0;
+	glGenQueries(1, &query);
+	for (int frame = 0; frame < warmup_frames + frames; frame++) {
+		glfwPollEvents();
+		const double start = profiler_now_ms();
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		draw_frame(frame_seconds(frame), width, height, visible, grid);
+		glEndQuery(GL_TIME_ELAPSED);
+		glFinish();
+		const double draw_ms = profiler_now_ms() - start;
+		GLuint64 gpu_ns = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpu_ns);
+		if (frame >= warmup_frames) {
+			times.gpu_ms.push_back(gpu_ns / 1e6);
+			times.draw_ms.push_back(draw_ms);
+		}
+		glfwSwapBuffers(window);
+	}
+	glDeleteQueries(1, &query);
+}
+
+// the first frame of the path as it ends up in the back buffer
+static void read_frame(const int width, const int height, vector<uint8_t>& pixels) {
+	vector<uint32_t> visible(city_objects().size());
+	light_grid grid;
+	draw_frame(frame_seconds(0), width, height, visible, grid);
+	read_pixels(pixels, width, height);
+}
+
+int run_deferred_benchmark(const app_options& options, GLFWwindow* window, const int width, const int height) {
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 20;
+	city_generate(options.city_objects > 0 ? options.city_objects : default_objects, 1234);
+	city_generate_lights(options.deferred_bench_lights, 4321);
+	job_system_init(0);
+	if (!city_init_gl() || !city_init_lights(width, height) || !city_init_deferred()) {
+		log("Failed to set up the deferred shading benchmark");
+		city_release_lights();
+		city_release_gl();
+		job_system_shutdown();
+		return 1;
+	}
+	glViewport(0, 0, width, height);
+
+	vector<uint8_t> forward_pixels, deferred_pixels;
+	shading_times forward, deferred;
+	city_use_deferred(false);
+	read_frame(width, height, forward_pixels);
+	run_frames(window, frames, width, height, forward);
+	city_use_deferred(true);
+	read_frame(width, height, deferred_pixels);
+	run_frames(window, frames, width, height, deferred);
+	city_use_deferred(false);
+
+	size_t differing = 0;
+	int max_difference = 0;
+	for (size_t i = 0; i < forward_pixels.size(); i += 4) {
+		int pixel_difference = 0;
+		for (size_t channel = 0; channel < 3; channel++) {
+			pixel_difference = max(pixel_difference, abs(forward_pixels[i + channel] - deferred_pixels[i + channel]));
+		}
+		max_difference = max(max_difference, pixel_difference);
+		differing += pixel_difference > tolerance ? 1 : 0;
+	}
+	const bool match = differing * 1000 <= forward_pixels.size() / 4;
+
+	const bench_stats forward_gpu = compute_stats(forward.gpu_ms);
+	const bench_stats forward_draw = compute_stats(forward.draw_ms);
+	const bench_stats deferred_gpu = compute_stats(deferred.gpu_ms);
+	const bench_stats deferred_draw = compute_stats(deferred.draw_ms);
+	// the window's buffers are still there when the frame is shaded deferred
+	const int deferred_total_bytes = forward_bytes_per_pixel + deferred_bytes_per_pixel();
+	const double pixels = static_cast<double>(width) * height;
+
+	char line[320];
+	snprintf(line, sizeof(line), "Deferred: %d lights, forward GPU %.2f ms, draw to finish %.2f ms; deferred GPU %.2f ms, "
+		"draw to finish %.2f ms", options.deferred_bench_lights, forward_gpu.median, forward_draw.median,
+		deferred_gpu.median, deferred_draw.median);
+	log(line);
+	snprintf(line, sizeof(line), "Deferred: %d bytes per pixel forward, %d deferred (G-buffer and HDR target %d, %d unpacked), "
+		"%.2f MB of targets at %dx%d; %zu pixels differ by more than %d (max %d)%s", forward_bytes_per_pixel,
+		deferred_total_bytes, deferred_bytes_per_pixel(), deferred_unpacked_bytes_per_pixel(),
+		deferred_bytes_per_pixel() * pixels / 1048576.0, width, height, differing, tolerance, max_difference,
+		match ? "" : ", the images DIFFER");
+	log(line);
+
+	string json = "{\n";
+	json += "  \"objects\": " + to_string(city_objects().size()) + ",\n";
+	json += "  \"lights\": " + to_string(options.deferred_bench_lights) + ",\n";
+	json += "  \"width\": " + to_string(width) + ",\n";
+	json += "  \"height\": " + to_string(height) + ",\n";
+	json += "  \"renderer\": \"" + string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) + "\",\n";
+	json += "  \"forward_bytes_per_pixel\": " + to_string(forward_bytes_per_pixel) + ",\n";
+	json += "  \"deferred_bytes_per_pixel\": " + to_string(deferred_total_bytes) + ",\n";
+	json += "  \"gbuffer_bytes_per_pixel\": " + to_string(deferred_bytes_per_pixel()) + ",\n";
+	json += "  \"unpacked_gbuffer_bytes_per_pixel\": " + to_string(deferred_unpacked_bytes_per_pixel()) + ",\n";
+	json += "  \"forward_gpu_ms\": " + stats_json(forward_gpu) + ",\n";
+	json += "  \"forward_draw_ms\": " + stats_json(forward_draw) + ",\n";
+	json += "  \"deferred_gpu_ms\": " + stats_json(deferred_gpu) + ",\n";
+	json += "  \"deferred_draw_ms\": " + stats_json(deferred_draw) + ",\n";
+	json += "  \"differing_pixels\": " + to_string(differing) + ",\n";
+	json += "  \"max_channel_difference\": " + to_string(max_difference) + ",\n";
+	json += string("  \"images_match\": ") + (match ? "true" : "false") + "\n";
+	json += "}\n";
+
+	city_release_lights();
+	city_release_gl();
+	job_system_shutdown();
+
+	if (!write_bench_json(options.bench_output_path, "deferred_bench.json", json, "Deferred shading benchmark")) {
+		return 1;
+	}
+	return match ? 0 : 1;
+}
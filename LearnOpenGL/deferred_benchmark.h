@@ -0,0 +1,9 @@
+#pragma once
+
+#include "app_options.h"
+#include "gl_api.h"
+
+// the city with options.deferred_bench_lights moving point lights shaded forward and deferred: GPU
+// time and time to glFinish of both, the bytes per pixel of their targets, and how far the two
+// images of the same frame are apart; writes JSON
+int run_deferred_benchmark(const app_options& options, GLFWwindow* window, int width, int height);
@@ -0,0 +1,40 @@
+#version 330 core
+
+// city_lighting.glsl, as city_clustered.frag uses it, for every pixel of the G-buffer with the
+// position reconstructed from the depth
+
+out vec4 color;
+
+uniform sampler2D albedo_roughness;
+uniform sampler2D encoded_normal;
+uniform sampler2D scene_depth;
+uniform mat4 inverse_view_projection;
+
+vec3 octahedral_decode(vec2 encoded) {
+	vec2 f = encoded * 2.0 - 1.0;
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+	float unfold = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -unfold : unfold;
+	n.y += n.y >= 0.0 ? -unfold : unfold;
+	return normalize(n);
+}
+
+void main() {
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 surface = texelFetch(albedo_roughness, pixel, 0);
+	float depth_value = texelFetch(scene_depth, pixel, 0).r;
+	// nothing was drawn, the clear color is the sky
+	if (depth_value == 1.0) {
+		color = vec4(surface.rgb, 1.0);
+		return;
+	}
+	// tile_size * cluster_grid.xy is the size of the target
+	vec4 world = inverse_view_projection * vec4(gl_FragCoord.xy / (tile_size * vec2(cluster_grid.xy)) * 2.0 - 1.0,
+		depth_value * 2.0 - 1.0, 1.0);
+	vec3 world_position = world.xyz / world.w;
+	vec3 normal = octahedral_decode(texelFetch(encoded_normal, pixel, 0).rg);
+	float roughness = surface.a;
+
+	float depth = view_depth(depth_value);
+	color = vec4(city_lighting(surface.rgb, world_position, normal, roughness, depth), 1.0);
+}
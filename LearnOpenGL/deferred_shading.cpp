@@ -0,0 +1,168 @@
+#include "deferred_shading.h"
+
+#include "clustered_lights.h"
+#include "gl_api.h"
+#include "gpu_resources.h"
+#include "log.h"
+#include "shader.h"
+#include "shadow_maps.h"
+
+using namespace std;
+
+// the G-buffer's texture units, 1 to 3 are clustered_lights'
+static const GLint albedo_unit = 0;
+static const GLint normal_unit = 4;
+static const GLint depth_unit = 5;
+
+enum deferred_texture {
+	albedo_roughness,
+	encoded_normal,
+	scene_depth,
+	hdr_color,
+	texture_count
+};
+
+struct texture_format {
+	GLenum internal_format;
+	GLenum format;
+	GLenum type;
+	int bytes;
+};
+
+static const texture_format formats[texture_count] = {
+	{ GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+	{ GL_RG16, GL_RG, GL_UNSIGNED_SHORT, 4 },
+	{ GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4 },
+	{ GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, 4 }
+};
+
+static GLuint textures[texture_count] = {};
+static GLuint gbuffer_framebuffer = 0;
+static GLuint hdr_framebuffer = 0;
+static GLuint empty_vao = 0;
+static GLuint light_program = 0;
+static GLint inverse_view_projection_location = -1;
+static GLint eye_location = -1;
+static int target_width = 0;
+static int target_height = 0;
+// where deferred_end() puts the frame
+static GLint saved_framebuffer = 0;
+
+static bool complete_framebuffer(const char* name) {
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+		return true;
+	}
+	log(string("Deferred ") + name + " framebuffer is incomplete");
+	return false;
+}
+
+bool deferred_init(const int width, const int height, const mat4& projection) {
+	light_program = load_program_with("fullscreen.vert", "deferred_light.frag", "city_lighting.glsl");
+	if (light_program == 0) {
+		return false;
+	}
+	clustered_lights_setup_program(light_program, width, height, projection);
+	glUniform1i(glGetUniformLocation(light_program, "albedo_roughness"), albedo_unit);
+	glUniform1i(glGetUniformLocation(light_program, "encoded_normal"), normal_unit);
+	glUniform1i(glGetUniformLocation(light_program, "scene_depth"), depth_unit);
+	shadow_maps_setup_program(light_program);
+	glUseProgram(0);
+	inverse_view_projection_location = glGetUniformLocation(light_program, "inverse_view_projection");
+	eye_location = glGetUniformLocation(light_program, "eye_position");
+
+	gpu_category_scope category(gpu_category::render_target);
+	target_width = width;
+	target_height = height;
+	glGenTextures(texture_count, textures);
+	for (int i = 0; i < texture_count; i++) {
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, formats[i].internal_format, width, height, 0, formats[i].format, formats[i].type, nullptr);
+		// read with texelFetch, but without mipmaps the default filter would leave them incomplete
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &gbuffer_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, gbuffer_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[albedo_roughness], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[encoded_normal], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[scene_depth], 0);
+	static const GLenum draw_buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, draw_buffers);
+	bool complete = complete_framebuffer("G-buffer");
+
+	glGenFramebuffers(1, &hdr_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, hdr_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[hdr_color], 0);
+	complete = complete_framebuffer("HDR") && complete;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// core profile draws need a vertex array, even without attributes
+	glGenVertexArrays(1, &empty_vao);
+	if (!complete) {
+		deferred_release();
+		return false;
+	}
+	return true;
+}
+
+void deferred_release() {
+	glDeleteProgram(light_program);
+	glDeleteFramebuffers(1, &gbuffer_framebuffer);
+	glDeleteFramebuffers(1, &hdr_framebuffer);
+	glDeleteTextures(texture_count, textures);
+	glDeleteVertexArrays(1, &empty_vao);
+	for (GLuint& texture : textures) {
+		texture = 0;
+	}
+	light_program = gbuffer_framebuffer = hdr_framebuffer = empty_vao = 0;
+}
+
+void deferred_begin() {
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &saved_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, gbuffer_framebuffer);
+}
+
+void deferred_end(const mat4& view_projection) {
+	glBindFramebuffer(GL_FRAMEBUFFER, hdr_framebuffer);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glActiveTexture(GL_TEXTURE0 + albedo_unit);
+	glBindTexture(GL_TEXTURE_2D, textures[albedo_roughness]);
+	glActiveTexture(GL_TEXTURE0 + normal_unit);
+	glBindTexture(GL_TEXTURE_2D, textures[encoded_normal]);
+	glActiveTexture(GL_TEXTURE0 + depth_unit);
+	glBindTexture(GL_TEXTURE_2D, textures[scene_depth]);
+	clustered_lights_bind();
+
+	glUseProgram(light_program);
+	glUniformMatrix4fv(inverse_view_projection_location, 1, GL_FALSE, inverse(view_projection).m);
+	glUniform3fv(eye_location, 1, &clustered_lights_eye().x);
+	glBindVertexArray(empty_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	for (const GLint unit : { depth_unit, normal_unit, albedo_unit }) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	// a blit converts the float target to whatever the caller's framebuffer holds
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, hdr_framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, saved_framebuffer);
+	glBlitFramebuffer(0, 0, target_width, target_height, 0, 0, target_width, target_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, saved_framebuffer);
+}
+
+int deferred_bytes_per_pixel() {
+	int bytes = 0;
+	for (const texture_format& format : formats) {
+		bytes += format.bytes;
+	}
+	return bytes;
+}
+
+int deferred_unpacked_bytes_per_pixel() {
+	return 16 + 8 + 4 + 4 + 4 + 8;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "math3d.h"
+
+// deferred shading of the city: the boxes only write a compact G-buffer (albedo and roughness RGBA8,
+// octahedral normal RG16 and depth, the position comes back from the depth), then one fullscreen pass
+// lights every pixel with the froxel lists of clustered_lights into an R11F_G11F_B10F target, which
+// ends up in the framebuffer that was bound at deferred_begin(). needs clustered_lights set up;
+// the G-buffer is width x height and projection is the one the city is drawn with
+bool deferred_init(int width, int height, const mat4& projection);
+void deferred_release();
+// the city draws that follow go into the G-buffer
+void deferred_begin();
+// lights the G-buffer for the camera it was drawn with and copies the result back
+void deferred_end(const mat4& view_projection);
+
+// G-buffer and HDR target
+int deferred_bytes_per_pixel();
+// the same targets without packing: RGBA32F position, RGBA16F normal, RGBA8 albedo, R32F roughness,
+// depth and RGBA16F HDR
+int deferred_unpacked_bytes_per_pixel();
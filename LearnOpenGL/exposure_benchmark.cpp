@@ -0,0 +1,205 @@
+#include "exposure_benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "auto_exposure.h"
+#include "bench_stats.h"
+#include "log.h"
+
+using namespace std;
+
+static const int warmup_frames = 3;
+static const int bins = auto_exposure_histogram_bytes / 4;
+// pixels the GPU may put into a neighbouring bin, its log2 rounds differently at the edges
+static const double max_moved_fraction = 0.001;
+// relative error of the average and the adapted luminance
+static const double max_relative_error = 0.01;
+static const float frame_seconds = 1.0f / 60.0f;
+
+// luminances spread over stops first to last, a few black pixels; CPU histogram and average bin
+struct test_image {
+	vector<float> pixels;
+	vector<uint32_t> histogram;
+	float average_luminance;
+};
+
+static float luminance_of(const float* pixel) {
+	return 0.2126f * pixel[0] + 0.7152f * pixel[1] + 0.0722f * pixel[2];
+}
+
+static test_image make_image(const int width, const int height, const float first_stop, const float last_stop,
+	const unsigned seed) {
+	test_image image;
+	image.pixels.resize(static_cast<size_t>(width) * height * 4);
+	image.histogram.assign(bins, 0);
+	mt19937 random(seed);
+	uniform_real_distribution<float> stop(first_stop, last_stop);
+	uniform_real_distribution<float> tint(0.5f, 1.5f);
+	double weighted = 0.0;
+	size_t counted = 0;
+	for (size_t i = 0; i < image.pixels.size(); i += 4) {
+		float* pixel = &image.pixels[i];
+		const bool black = random() % 64 == 0;
+		const float level = black ? 0.0f : exp2(stop(random));
+		pixel[0] = level * tint(random);
+		pixel[1] = level;
+		pixel[2] = level * tint(random);
+		pixel[3] = 1.0f;
+		const int bin = auto_exposure_bin(luminance_of(pixel));
+		image.histogram[bin]++;
+		weighted += bin;
+		counted += bin > 0 ? 1 : 0;
+	}
+	image.average_luminance = auto_exposure_bin_luminance(static_cast<float>(weighted / counted));
+	return image;
+}
+
+static GLuint upload(const test_image& image, const int width, const int height) {
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, image.pixels.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+static GLuint storage_buffer(const int bytes) {
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return buffer;
+}
+
+// for the checks only, the frames never read anything back
+static void read_buffer(const GLuint buffer, const int bytes, void* data) {
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, data);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+static double relative_error(const double value, const double expected) {
+	return abs(value - expected) / max(abs(expected), 1e-6);
+}
+
+int run_exposure_benchmark(const app_options& options, GLFWwindow* window, const int width, const int height) {
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 60;
+	if (!auto_exposure_init()) {
+		log("Failed to set up the auto-exposure benchmark");
+		return 1;
+	}
+	// a dim interior and a sunlit street, a few stops apart
+	const test_image dark = make_image(width, height, -6.0f, -1.0f, 1234);
+	const test_image bright = make_image(width, height, -1.0f, 4.0f, 4321);
+	const GLuint dark_texture = upload(dark, width, height);
+	const GLuint bright_texture = upload(bright, width, height);
+	const GLuint histogram = storage_buffer(auto_exposure_histogram_bytes);
+	const GLuint result = storage_buffer(auto_exposure_result_bytes);
+
+	// one frame snapped to the dark image: bins and average
+	auto_exposure_reset();
+	auto_exposure_histogram(dark_texture, width, height, histogram);
+	auto_exposure_adapt(histogram, width, height, 0.0f, result);
+	vector<uint32_t> gpu_histogram(bins);
+	float gpu_result[2] = {};
+	read_buffer(histogram, auto_exposure_histogram_bytes, gpu_histogram.data());
+	read_buffer(result, sizeof(gpu_result), gpu_result);
+	uint64_t moved = 0, total = 0;
+	for (int bin = 0; bin < bins; bin++) {
+		moved += abs(static_cast<int64_t>(gpu_histogram[bin]) - static_cast<int64_t>(dark.histogram[bin]));
+		total += gpu_histogram[bin];
+	}
+	// every pixel counted once, the ones in the wrong bin show up twice in the difference
+	const double moved_fraction = moved / 2.0 / (static_cast<double>(width) * height);
+	const bool histogram_match = total == static_cast<uint64_t>(width) * height && moved_fraction <= max_moved_fraction;
+	const double average_error = relative_error(gpu_result[0], dark.average_luminance);
+	const double exposure_error = relative_error(gpu_result[1], auto_exposure_for(dark.average_luminance));
+
+	// the bright image from then on, one 60 Hz frame at a time, against the exponential
+	double adapted = dark.average_luminance;
+	double max_adaptation_error = 0.0;
+	vector<double> adapted_curve;
+	for (int frame = 0; frame < frames; frame++) {
+		auto_exposure_histogram(bright_texture, width, height, histogram);
+		auto_exposure_adapt(histogram, width, height, frame_seconds, result);
+		read_buffer(result, sizeof(gpu_result), gpu_result);
+		adapted += (bright.average_luminance - adapted) * auto_exposure_adaptation(frame_seconds);
+		max_adaptation_error = max(max_adaptation_error, relative_error(gpu_result[0], adapted));
+		adapted_curve.push_back(gpu_result[0]);
+	}
+
+	// GPU time of the two dispatches, nothing read back
+	vector<double> histogram_ms, adapt_ms;
+	GLuint queries[2] = {};
+	glGenQueries(2, queries);
+	for (int frame = 0; frame < warmup_frames + frames; frame++) {
+		glfwPollEvents();
+		glBeginQuery(GL_TIME_ELAPSED, queries[0]);
+		auto_exposure_histogram(frame % 2 == 0 ? dark_texture : bright_texture, width, height, histogram);
+		glEndQuery(GL_TIME_ELAPSED);
+		glBeginQuery(GL_TIME_ELAPSED, queries[1]);
+		auto_exposure_adapt(histogram, width, height, frame_seconds, result);
+		glEndQuery(GL_TIME_ELAPSED);
+		GLuint64 histogram_ns = 0, adapt_ns = 0;
+		glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &histogram_ns);
+		glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &adapt_ns);
+		if (frame >= warmup_frames) {
+			histogram_ms.push_back(histogram_ns / 1e6);
+			adapt_ms.push_back(adapt_ns / 1e6);
+		}
+		glfwSwapBuffers(window);
+	}
+	glDeleteQueries(2, queries);
+
+	const bool match = histogram_match && average_error <= max_relative_error && exposure_error <= max_relative_error
+		&& max_adaptation_error <= max_relative_error;
+	const bench_stats histogram_stats = compute_stats(histogram_ms);
+	const bench_stats adapt_stats = compute_stats(adapt_ms);
+	char line[320];
+	snprintf(line, sizeof(line), "Auto-exposure: %dx%d histogram %.3f ms, adaptation %.3f ms GPU; %.4f%% of pixels in another "
+		"bin than on the CPU, adapted luminance %.4f (CPU %.4f), off by at most %.4f%%%s", width, height,
+		histogram_stats.median, adapt_stats.median, moved_fraction * 100.0, adapted_curve.back(), adapted,
+		max_adaptation_error * 100.0, match ? "" : ", the results DIFFER");
+	log(line);
+
+	string json = "{\n";
+	json += "  \"width\": " + to_string(width) + ",\n";
+	json += "  \"height\": " + to_string(height) + ",\n";
+	json += "  \"frames\": " + to_string(frames) + ",\n";
+	json += "  \"renderer\": \"" + string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) + "\",\n";
+	json += "  \"histogram_gpu_ms\": " + stats_json(histogram_stats) + ",\n";
+	json += "  \"adapt_gpu_ms\": " + stats_json(adapt_stats) + ",\n";
+	snprintf(line, sizeof(line), "  \"moved_pixel_fraction\": %.6f,\n  \"average_relative_error\": %.6f,\n"
+		"  \"exposure_relative_error\": %.6f,\n  \"max_adaptation_relative_error\": %.6f,\n", moved_fraction, average_error,
+		exposure_error, max_adaptation_error);
+	json += line;
+	snprintf(line, sizeof(line), "  \"dark_luminance\": %.6f,\n  \"bright_luminance\": %.6f,\n", dark.average_luminance,
+		bright.average_luminance);
+	json += line;
+	json += "  \"adapted_luminance\": [";
+	for (size_t i = 0; i < adapted_curve.size(); i++) {
+		snprintf(line, sizeof(line), "%s%.5f", i > 0 ? ", " : "", adapted_curve[i]);
+		json += line;
+	}
+	json += "],\n";
+	json += string("  \"results_match\": ") + (match ? "true" : "false") + "\n";
+	json += "}\n";
+
+	glDeleteBuffers(1, &histogram);
+	glDeleteBuffers(1, &result);
+	glDeleteTextures(1, &dark_texture);
+	glDeleteTextures(1, &bright_texture);
+	auto_exposure_release();
+
+	if (!write_bench_json(options.bench_output_path, "exposure_bench.json", json, "Auto-exposure benchmark")) {
+		return 1;
+	}
+	return match ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "app_options.h"
+#include "gl_api.h"
+
+// auto_exposure on a width x height HDR image with a known spread of luminances: the GPU histogram
+// and average against the same binning on the CPU, the adaptation from a dark image to a bright one
+// against the exponential it should follow, and the GPU time of both dispatches; writes JSON
+int run_exposure_benchmark(const app_options& options, GLFWwindow* window, int width, int height);
@@ -0,0 +1,167 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include "alloc_tracker.h"
+
+using namespace std;
+
+static const size_t block_size = 64 * 1024;
+static const unsigned char poison_byte = 0xdd;
+
+struct arena_block {
+	arena_block* next;
+	size_t size;
+	size_t used;
+
+	unsigned char* data() { return reinterpret_cast<unsigned char*>(this + 1); }
+};
+
+struct thread_arena {
+	arena_block* first = nullptr;
+	arena_block* current = nullptr;
+
+	thread_arena();
+	~thread_arena();
+};
+
+// every thread's arena, so the frame boundary can rewind them all
+static mutex arenas_mutex;
+static vector<thread_arena*> arenas;
+static thread_local thread_arena arena;
+
+static atomic<uint64_t> heap_allocations(0);
+static uint64_t heap_allocations_at_reset = 0;
+static frame_arena_stats last;
+
+#if _DEBUG
+static bool poison = true;
+#else
+static bool poison = false;
+#endif
+
+thread_arena::thread_arena() {
+	lock_guard<mutex> lock(arenas_mutex);
+	arenas.push_back(this);
+}
+
+thread_arena::~thread_arena() {
+	lock_guard<mutex> lock(arenas_mutex);
+	arenas.erase(find(arenas.begin(), arenas.end(), this));
+	while (first != nullptr) {
+		arena_block* next = first->next;
+		alloc_tracker_free(first);
+		first = next;
+	}
+}
+
+static arena_block* new_block(const size_t size) {
+	arena_block* block = static_cast<arena_block*>(alloc_tracker_malloc(sizeof(arena_block) + size));
+	if (block == nullptr) {
+		throw bad_alloc();
+	}
+	block->next = nullptr;
+	block->size = size;
+	block->used = 0;
+	heap_allocations.fetch_add(1, memory_order_relaxed);
+	return block;
+}
+
+// offset into the block that gives an aligned address
+static size_t aligned_offset(arena_block* block, const size_t alignment) {
+	const uintptr_t address = reinterpret_cast<uintptr_t>(block->data()) + block->used;
+	return ((address + alignment - 1) & ~(alignment - 1)) - reinterpret_cast<uintptr_t>(block->data());
+}
+
+void* frame_arena_allocate(const size_t bytes, const size_t alignment) {
+	arena_block* block = arena.current;
+	while (block != nullptr) {
+		const size_t offset = aligned_offset(block, alignment);
+		if (offset + bytes <= block->size) {
+			block->used = offset + bytes;
+			arena.current = block;
+			return block->data() + offset;
+		}
+		// blocks further down the chain are empty until the next reset
+		block = block->next;
+	}
+
+	// out of room: add a block after the current one, big requests get a block of their own
+	arena_block* added = new_block(max(block_size, bytes + alignment));
+	if (arena.current == nullptr) {
+		arena.first = added;
+	}
+	else {
+		added->next = arena.current->next;
+		arena.current->next = added;
+	}
+	arena.current = added;
+
+	const size_t offset = aligned_offset(added, alignment);
+	added->used = offset + bytes;
+	return added->data() + offset;
+}
+
+void frame_arena_release(void* pointer, const size_t bytes) {
+	if (poison && pointer != nullptr) {
+		memset(pointer, poison_byte, bytes);
+	}
+}
+
+void frame_arena_reset() {
+	frame_arena_stats stats;
+
+	{
+		lock_guard<mutex> lock(arenas_mutex);
+		for (thread_arena* thread : arenas) {
+			for (arena_block* block = thread->first; block != nullptr; block = block->next) {
+				stats.bytes_used += block->used;
+				stats.bytes_reserved += block->size;
+				if (poison) {
+					memset(block->data(), poison_byte, block->used);
+				}
+				block->used = 0;
+			}
+			thread->current = thread->first;
+		}
+	}
+
+	stats.high_water = max(last.high_water, stats.bytes_used);
+	stats.heap_allocations = heap_allocations.load(memory_order_relaxed);
+	stats.frame_heap_allocations = stats.heap_allocations - heap_allocations_at_reset;
+	heap_allocations_at_reset = stats.heap_allocations;
+	last = stats;
+}
+
+const frame_arena_stats& frame_arena_last() {
+	return last;
+}
+
+void frame_arena_set_poison(const bool enabled) {
+	poison = enabled;
+}
+
+const char* frame_format(const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	va_list measure;
+	va_copy(measure, args);
+	const int length = vsnprintf(nullptr, 0, format, measure);
+	va_end(measure);
+
+	char* text = static_cast<char*>(frame_arena_allocate(length > 0 ? length + 1 : 1, 1));
+	if (length > 0) {
+		vsnprintf(text, length + 1, format, args);
+	}
+	else {
+		text[0] = '\0';
+	}
+	va_end(args);
+	return text;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// bump allocator for data that lives until the end of the current frame: draw lists, sort keys,
+// uniform staging. every thread gets its own chain of blocks, the blocks are kept across frames,
+// so once the chains have grown to the frame's working set no frame touches the global heap
+
+struct frame_arena_stats {
+	// all threads, the frame that was just reset
+	size_t bytes_used = 0;
+	size_t bytes_reserved = 0;
+	size_t high_water = 0;
+	// blocks taken from the global heap since startup / during that frame
+	uint64_t heap_allocations = 0;
+	uint64_t frame_heap_allocations = 0;
+};
+
+void* frame_arena_allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+// marks the frame boundary - everything allocated before is gone; other threads must not be
+// allocating while this runs
+void frame_arena_reset();
+const frame_arena_stats& frame_arena_last();
+
+// fill released memory with 0xdd so use after the frame shows up quickly, on by default in debug builds
+void frame_arena_set_poison(bool poison);
+
+// memory only comes back at the frame boundary, this just poisons the range
+void frame_arena_release(void* pointer, size_t bytes);
+
+// printf into the arena, valid until the next frame_arena_reset()
+const char* frame_format(const char* format, ...);
+
+template <typename T>
+struct frame_allocator {
+	typedef T value_type;
+
+	frame_allocator() = default;
+	template <typename U>
+	frame_allocator(const frame_allocator<U>&) {}
+
+	T* allocate(const size_t count) {
+		return static_cast<T*>(frame_arena_allocate(count * sizeof(T), alignof(T)));
+	}
+	void deallocate(T* pointer, const size_t count) {
+		frame_arena_release(pointer, count * sizeof(T));
+	}
+};
+
+template <typename T, typename U>
+bool operator==(const frame_allocator<T>&, const frame_allocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const frame_allocator<T>&, const frame_allocator<U>&) { return false; }
+
+template <typename T>
+using frame_vector = std::vector<T, frame_allocator<T>>;
+typedef std::basic_string<char, std::char_traits<char>, frame_allocator<char>> frame_string;
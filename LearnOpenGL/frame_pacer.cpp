@@ -0,0 +1,258 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <Windows.h>
+#include <timeapi.h>
+
+#include "bench_stats.h"
+#include "gl_api.h"
+#include "profiler.h"
+
+using namespace std;
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x2
+#endif
+
+// presents kept for the report, the rest are not recorded
+static const size_t max_samples = 1 << 16;
+// frames whose work predicts the next one's in the low latency mode
+static const int work_history = 16;
+// slack left before the refresh in the low latency mode, widened by missed refreshes
+static const double min_margin_ms = 1.0;
+static const double max_margin_ms = 4.0;
+// a present this many periods after the previous one missed at least one refresh
+static const double late_factor = 1.5;
+// bounds of the spin before a deadline
+static const double min_spin_ms = 0.2;
+static const double max_spin_ms = 4.0;
+
+static pacing_mode mode = pacing_mode::unpaced;
+// the rate frames are paced to (0 - unpaced)
+static double period_ms = 0.0;
+static double refresh_ms = 0.0;
+static HANDLE timer = nullptr;
+static bool timer_period_raised = false;
+// sleeps end this long before a deadline and the rest is spun; grows when a sleep overshoots
+static double spin_ms = 1.0;
+static double next_start_ms = 0.0;
+
+// written by the swapping thread, read by frame_pacer_wait()
+static atomic<double> last_present_ms(0.0);
+// how long before the refresh a low latency frame starts
+static atomic<double> lead_ms(0.0);
+
+// the swapping thread's
+static double work_ms[work_history] = {};
+static int work_index = 0;
+static double margin_ms = min_margin_ms;
+static double previous_present_ms = 0.0;
+static vector<double> intervals;
+static vector<double> latencies;
+static size_t late_frames = 0;
+
+// the main thread's
+static double spun_ms = 0.0;
+static double stats_start_ms = 0.0;
+static double stats_start_cpu_ms = 0.0;
+
+static const char* mode_name(const pacing_mode paced) {
+	switch (paced) {
+	case pacing_mode::limit: return "limit";
+	case pacing_mode::vsync: return "vsync";
+	case pacing_mode::low_latency: return "low latency";
+	default: return "unpaced";
+	}
+}
+
+// sleeps most of the way and spins the last spin_ms, the scheduler can't wake us more precisely
+static void wait_until(const double deadline_ms) {
+	for (;;) {
+		const double before = profiler_now_ms();
+		const double remaining = deadline_ms - before;
+		if (remaining <= spin_ms) {
+			break;
+		}
+
+		double requested = 1.0;
+		LARGE_INTEGER due;
+		// relative, in 100 ns ticks
+		due.QuadPart = -static_cast<LONGLONG>((remaining - spin_ms) * 10000.0);
+		if (timer != nullptr && SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE)) {
+			requested = remaining - spin_ms;
+			WaitForSingleObject(timer, INFINITE);
+		}
+		else {
+			Sleep(1);
+		}
+
+		const double overshoot = profiler_now_ms() - before - requested;
+		if (overshoot > spin_ms) {
+			spin_ms = min(max_spin_ms, overshoot * 1.25);
+		}
+	}
+	// sleeps that were on time let the spin shrink back slowly
+	spin_ms = max(min_spin_ms, spin_ms * 0.99);
+
+	const double spin_start = profiler_now_ms();
+	while (profiler_now_ms() < deadline_ms) {
+		this_thread::yield();
+	}
+	spun_ms += profiler_now_ms() - spin_start;
+}
+
+void frame_pacer_init(const pacing_mode paced, const double target_fps) {
+	mode = paced;
+	// the primary monitor's rate, the window isn't moved anywhere else
+	const GLFWvidmode* video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+	const int refresh_rate = video_mode != nullptr && video_mode->refreshRate > 0 ? video_mode->refreshRate : 60;
+	refresh_ms = 1000.0 / refresh_rate;
+
+	switch (mode) {
+	case pacing_mode::limit:
+		period_ms = 1000.0 / (target_fps > 0.0 ? target_fps : refresh_rate);
+		break;
+	case pacing_mode::vsync:
+	case pacing_mode::low_latency:
+		period_ms = refresh_ms;
+		break;
+	default:
+		period_ms = 0.0;
+		break;
+	}
+	glfwSwapInterval(mode == pacing_mode::vsync || mode == pacing_mode::low_latency ? 1 : 0);
+
+	if (mode == pacing_mode::limit || mode == pacing_mode::low_latency) {
+		// high resolution timers (Windows 10 1803 and later) wake within a fraction of a millisecond,
+		// before that Sleep() is only precise to 1 ms once the timer resolution is raised
+		timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (timer == nullptr) {
+			timer_period_raised = timeBeginPeriod(1) == TIMERR_NOERROR;
+		}
+		spin_ms = timer != nullptr ? 0.5 : 2.0;
+	}
+
+	intervals.reserve(max_samples);
+	latencies.reserve(max_samples);
+	next_start_ms = 0.0;
+	last_present_ms.store(0.0);
+	lead_ms.store(0.0);
+	fill(work_ms, work_ms + work_history, 0.0);
+	margin_ms = min_margin_ms;
+	frame_pacer_reset_stats();
+}
+
+void frame_pacer_shutdown() {
+	if (timer != nullptr) {
+		CloseHandle(timer);
+		timer = nullptr;
+	}
+	if (timer_period_raised) {
+		timeEndPeriod(1);
+		timer_period_raised = false;
+	}
+}
+
+double frame_pacer_wait() {
+	const double now = profiler_now_ms();
+	if (mode == pacing_mode::limit) {
+		next_start_ms += period_ms;
+		// more than a frame behind, e.g. after a hitch: start over instead of rushing to catch up
+		if (next_start_ms < now - period_ms) {
+			next_start_ms = now;
+		}
+		wait_until(next_start_ms);
+	}
+	else if (mode == pacing_mode::low_latency) {
+		const double last_present = last_present_ms.load(memory_order_acquire);
+		if (last_present > 0.0) {
+			// start so the work ends just before the next refresh the frame can still make
+			const double lead = lead_ms.load(memory_order_relaxed);
+			double present = last_present + refresh_ms;
+			while (present - lead < now) {
+				present += refresh_ms;
+			}
+			wait_until(present - lead);
+		}
+	}
+	return profiler_now_ms();
+}
+
+void frame_pacer_presented(const double input_ms, const double swap_start_ms) {
+	const double now = profiler_now_ms();
+
+	const double interval = previous_present_ms > 0.0 ? now - previous_present_ms : 0.0;
+	const bool late = period_ms > 0.0 && interval > late_factor * period_ms;
+	previous_present_ms = now;
+	if (interval > 0.0 && intervals.size() < max_samples) {
+		intervals.push_back(interval);
+		latencies.push_back(now - input_ms);
+		late_frames += late ? 1 : 0;
+	}
+
+	// the slowest recent frame, one slow frame in a while shouldn't make the next miss its refresh;
+	// a missed refresh anyway means the wakeups are later than the margin allows for
+	work_ms[work_index] = swap_start_ms - input_ms;
+	work_index = (work_index + 1) % work_history;
+	margin_ms = late ? min(max_margin_ms, margin_ms + 0.5) : max(min_margin_ms, margin_ms * 0.995);
+	lead_ms.store(*max_element(work_ms, work_ms + work_history) + margin_ms, memory_order_relaxed);
+	last_present_ms.store(now, memory_order_release);
+}
+
+void frame_pacer_reset_stats() {
+	intervals.clear();
+	latencies.clear();
+	late_frames = 0;
+	previous_present_ms = 0.0;
+	spun_ms = 0.0;
+	stats_start_ms = profiler_now_ms();
+	stats_start_cpu_ms = profiler_process_cpu_ms();
+}
+
+string frame_pacer_report() {
+	char line[256];
+	if (period_ms > 0.0) {
+		snprintf(line, sizeof(line), "Frame pacing: %s, %.2f ms period", mode_name(mode), period_ms);
+	}
+	else {
+		snprintf(line, sizeof(line), "Frame pacing: %s", mode_name(mode));
+	}
+	string report = line;
+	if (intervals.empty()) {
+		return report + ", no frames presented";
+	}
+
+	const bench_stats interval_stats = compute_stats(intervals);
+	// unpaced frames have no target, their jitter is around the mean
+	const double target = period_ms > 0.0 ? period_ms : interval_stats.mean;
+	vector<double> jitter(intervals.size());
+	transform(intervals.begin(), intervals.end(), jitter.begin(), [target](const double interval) {
+		return abs(interval - target);
+	});
+	const bench_stats jitter_stats = compute_stats(jitter);
+	const bench_stats latency_stats = compute_stats(latencies);
+
+	snprintf(line, sizeof(line), "\n  present interval %.2f ms median, %.2f ms p95, %.2f ms max; %zu of %zu frames late",
+		interval_stats.median, interval_stats.p95, interval_stats.max, late_frames, intervals.size());
+	report += line;
+	snprintf(line, sizeof(line), "\n  jitter %.3f ms median, %.3f ms p95, %.3f ms max",
+		jitter_stats.median, jitter_stats.p95, jitter_stats.max);
+	report += line;
+	snprintf(line, sizeof(line), "\n  input to present latency %.2f ms median, %.2f ms p95",
+		latency_stats.median, latency_stats.p95);
+	report += line;
+
+	const double wall_ms = profiler_now_ms() - stats_start_ms;
+	const double cpu_ms = profiler_process_cpu_ms();
+	if (cpu_ms >= 0.0 && stats_start_cpu_ms >= 0.0 && wall_ms > 0.0) {
+		snprintf(line, sizeof(line), "\n  CPU %.1f%% of a core, %.1f%% spent spinning to deadlines",
+			100.0 * (cpu_ms - stats_start_cpu_ms) / wall_ms, 100.0 * spun_ms / wall_ms);
+		report += line;
+	}
+	return report;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+enum class pacing_mode {
+	// swap interval 0, frames as fast as they go; only measured
+	unpaced,
+	// swap interval 0, frames started at a fixed rate by sleeping and then spinning to the deadline
+	limit,
+	// swap interval 1, presents that miss a refresh are counted as late
+	vsync,
+	// swap interval 1, each frame starts as late as the last frames' work allows, so input is
+	// sampled just before it is needed
+	low_latency
+};
+
+// sets the swap interval, so the window's context must be current. target_fps is the limit
+// mode's rate, 0 takes the display's refresh rate
+void frame_pacer_init(pacing_mode mode, double target_fps);
+void frame_pacer_shutdown();
+
+// main thread, before input is polled: blocks until the next frame should start and returns the
+// time input is sampled at (profiler_now_ms() clock)
+double frame_pacer_wait();
+// on the thread that swaps, right after glfwSwapBuffers returned. input_ms is what
+// frame_pacer_wait() returned for this frame, swap_start_ms when the swap was called
+void frame_pacer_presented(double input_ms, double swap_start_ms);
+// drops the samples so far, e.g. the startup frames; the swapping thread must be idle
+void frame_pacer_reset_stats();
+
+// present interval, jitter against the target, late frames, CPU use and input to present latency
+std::string frame_pacer_report();
@@ -0,0 +1,207 @@
+#include "frustum_cull.h"
+
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+#include "cpu_features.h"
+#include "job_system.h"
+
+using namespace std;
+
+// objects per job, a multiple of 8; smaller inputs are culled on the calling thread
+static const size_t chunk_size = 32768;
+
+// for each 8 bit visibility mask: the lanes to keep, packed to the front, and how many there are
+struct compaction_table {
+	uint32_t lanes[256][8];
+	int count[256];
+
+	compaction_table() {
+		for (int mask = 0; mask < 256; mask++) {
+			int kept = 0;
+			for (int lane = 0; lane < 8; lane++) {
+				if (mask & (1 << lane)) {
+					lanes[mask][kept++] = lane;
+				}
+			}
+			count[mask] = kept;
+			for (int lane = kept; lane < 8; lane++) {
+				lanes[mask][lane] = 0;
+			}
+		}
+	}
+};
+
+static const compaction_table compaction;
+static bool use_avx2 = cpu_has_avx2();
+// visible indices found per chunk, before they are moved together
+static vector<size_t> chunk_counts;
+
+struct cull_context {
+	const frustum* view;
+	const cull_objects* objects;
+	cull_volume volume;
+	uint32_t* visible;
+};
+
+void cull_objects::clear() {
+	for (vector<float>* column : { &center_x, &center_y, &center_z, &radius, &extent_x, &extent_y, &extent_z }) {
+		column->clear();
+	}
+}
+
+void cull_objects::reserve(const size_t count) {
+	for (vector<float>* column : { &center_x, &center_y, &center_z, &radius, &extent_x, &extent_y, &extent_z }) {
+		column->reserve(count);
+	}
+}
+
+void cull_objects::add(const vec3& center, const vec3& half_size) {
+	center_x.push_back(center.x);
+	center_y.push_back(center.y);
+	center_z.push_back(center.z);
+	radius.push_back(length(half_size));
+	extent_x.push_back(half_size.x);
+	extent_y.push_back(half_size.y);
+	extent_z.push_back(half_size.z);
+}
+
+// Gribb and Hartmann: each plane is the last row of the matrix plus or minus one of the others
+frustum frustum_from_matrix(const mat4& view_projection) {
+	const float* m = view_projection.m;
+	frustum result;
+	for (int plane = 0; plane < 6; plane++) {
+		const int row = plane / 2;
+		const float sign = plane % 2 == 0 ? 1.0f : -1.0f;
+		float* p = result.planes[plane];
+		for (int column = 0; column < 4; column++) {
+			p[column] = m[column * 4 + 3] + sign * m[column * 4 + row];
+		}
+		const float inv_length = 1.0f / sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+		for (int i = 0; i < 4; i++) {
+			p[i] *= inv_length;
+		}
+	}
+	return result;
+}
+
+void frustum_cull_use_simd(const bool simd) {
+	use_avx2 = simd && cpu_has_avx2();
+}
+
+static bool inside_scalar(const frustum& view, const cull_objects& objects, const cull_volume volume, const size_t i) {
+	for (const float* p : view.planes) {
+		const float distance = p[0] * objects.center_x[i] + p[1] * objects.center_y[i] + p[2] * objects.center_z[i] + p[3];
+		const float reach = volume == cull_volume::sphere ? objects.radius[i]
+			: fabs(p[0]) * objects.extent_x[i] + fabs(p[1]) * objects.extent_y[i] + fabs(p[2]) * objects.extent_z[i];
+		if (distance + reach < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static size_t cull_range_avx2(const frustum& view, const cull_objects& objects, const cull_volume volume,
+	const size_t begin, const size_t end, uint32_t* visible) {
+	__m256 a[6], b[6], c[6], d[6], abs_a[6], abs_b[6], abs_c[6];
+	const __m256 sign_bit = _mm256_set1_ps(-0.0f);
+	for (int plane = 0; plane < 6; plane++) {
+		a[plane] = _mm256_set1_ps(view.planes[plane][0]);
+		b[plane] = _mm256_set1_ps(view.planes[plane][1]);
+		c[plane] = _mm256_set1_ps(view.planes[plane][2]);
+		d[plane] = _mm256_set1_ps(view.planes[plane][3]);
+		abs_a[plane] = _mm256_andnot_ps(sign_bit, a[plane]);
+		abs_b[plane] = _mm256_andnot_ps(sign_bit, b[plane]);
+		abs_c[plane] = _mm256_andnot_ps(sign_bit, c[plane]);
+	}
+	const bool spheres = volume == cull_volume::sphere;
+
+	size_t count = 0;
+	__m256i lane_index = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(begin)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	const __m256i lane_step = _mm256_set1_epi32(8);
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		const __m256 x = _mm256_loadu_ps(&objects.center_x[i]);
+		const __m256 y = _mm256_loadu_ps(&objects.center_y[i]);
+		const __m256 z = _mm256_loadu_ps(&objects.center_z[i]);
+		__m256 radius, ex, ey, ez;
+		if (spheres) {
+			radius = _mm256_loadu_ps(&objects.radius[i]);
+		}
+		else {
+			ex = _mm256_loadu_ps(&objects.extent_x[i]);
+			ey = _mm256_loadu_ps(&objects.extent_y[i]);
+			ez = _mm256_loadu_ps(&objects.extent_z[i]);
+		}
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int plane = 0; plane < 6; plane++) {
+			const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a[plane], x), _mm256_mul_ps(b[plane], y)),
+				_mm256_add_ps(_mm256_mul_ps(c[plane], z), d[plane]));
+			const __m256 reach = spheres ? radius : _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(abs_a[plane], ex),
+				_mm256_mul_ps(abs_b[plane], ey)), _mm256_mul_ps(abs_c[plane], ez));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+
+		// all 8 lanes are stored, only the kept ones count; writing at count <= i - begin stays
+		// inside this range's part of the output
+		const int mask = _mm256_movemask_ps(inside);
+		const __m256i order = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(compaction.lanes[mask]));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(visible + count), _mm256_permutevar8x32_epi32(lane_index, order));
+		count += compaction.count[mask];
+		lane_index = _mm256_add_epi32(lane_index, lane_step);
+	}
+	for (; i < end; i++) {
+		if (inside_scalar(view, objects, volume, i)) {
+			visible[count++] = static_cast<uint32_t>(i);
+		}
+	}
+	return count;
+}
+
+static size_t cull_range(const frustum& view, const cull_objects& objects, const cull_volume volume,
+	const size_t begin, const size_t end, uint32_t* visible) {
+	if (use_avx2) {
+		return cull_range_avx2(view, objects, volume, begin, end, visible);
+	}
+	size_t count = 0;
+	for (size_t i = begin; i < end; i++) {
+		if (inside_scalar(view, objects, volume, i)) {
+			visible[count++] = static_cast<uint32_t>(i);
+		}
+	}
+	return count;
+}
+
+// each chunk writes to its own stretch of the output, starting at its first object's index
+static void cull_chunks(void* context_pointer, const int first_chunk, const int end_chunk) {
+	const cull_context& context = *static_cast<const cull_context*>(context_pointer);
+	for (int chunk = first_chunk; chunk < end_chunk; chunk++) {
+		const size_t begin = chunk * chunk_size;
+		const size_t end = min(begin + chunk_size, context.objects->size());
+		chunk_counts[chunk] = cull_range(*context.view, *context.objects, context.volume, begin, end, context.visible + begin);
+	}
+}
+
+size_t frustum_cull(const frustum& view, const cull_objects& objects, const cull_volume volume, uint32_t* visible) {
+	const size_t object_count = objects.size();
+	const int chunks = static_cast<int>((object_count + chunk_size - 1) / chunk_size);
+	if (job_system_threads() == 1 || chunks <= 1) {
+		return cull_range(view, objects, volume, 0, object_count, visible);
+	}
+
+	if (chunk_counts.size() < static_cast<size_t>(chunks)) {
+		chunk_counts.resize(chunks);
+	}
+	cull_context context = { &view, &objects, volume, visible };
+	parallel_for(0, chunks, 1, cull_chunks, &context);
+
+	// close the gaps between the chunks' results; the first one is already in place
+	size_t count = chunk_counts[0];
+	for (int chunk = 1; chunk < chunks; chunk++) {
+		memmove(visible + count, visible + chunk * chunk_size, chunk_counts[chunk] * sizeof(uint32_t));
+		count += chunk_counts[chunk];
+	}
+	return count;
+}
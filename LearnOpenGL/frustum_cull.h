@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "math3d.h"
+
+// view frustum culling over bounds kept as structure of arrays, so one AVX2 iteration tests eight
+// objects against a plane. visible objects come out as a compact, ascending index list; big
+// object counts are split into chunks that run on the job system when it is up (job_system.h)
+
+struct cull_objects {
+	std::vector<float> center_x, center_y, center_z;
+	// bounding sphere
+	std::vector<float> radius;
+	// axis aligned box half size
+	std::vector<float> extent_x, extent_y, extent_z;
+
+	void clear();
+	void reserve(size_t count);
+	// box of this center and half size, with the sphere around it
+	void add(const vec3& center, const vec3& half_size);
+	size_t size() const { return center_x.size(); }
+};
+
+enum class cull_volume {
+	sphere,
+	box
+};
+
+struct frustum {
+	// a x + b y + c z + d >= 0 inside, normalized; left, right, bottom, top, near, far
+	float planes[6][4];
+};
+
+frustum frustum_from_matrix(const mat4& view_projection);
+
+// simd false forces the scalar path, for comparisons
+void frustum_cull_use_simd(bool simd);
+
+// visible needs room for objects.size() indices; returns how many were written
+size_t frustum_cull(const frustum& view, const cull_objects& objects, cull_volume volume, uint32_t* visible);
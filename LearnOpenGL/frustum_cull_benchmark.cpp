@@ -0,0 +1,125 @@
+#include "frustum_cull_benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bench_stats.h"
+#include "cpu_features.h"
+#include "frustum_cull.h"
+#include "job_system.h"
+#include "log.h"
+
+using namespace std;
+
+static const int warmup_frames = 3;
+static const float world_size = 2000.0f;
+
+struct cull_run {
+	const char* name;
+	bool simd;
+	int threads;
+};
+
+int run_frustum_cull_benchmark(const app_options& options) {
+	const int object_count = options.frustum_bench_objects;
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 50;
+
+	mt19937 random(1234);
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	cull_objects objects;
+	objects.reserve(object_count);
+	for (int i = 0; i < object_count; i++) {
+		const vec3 center = { (unit(random) - 0.5f) * world_size, (unit(random) - 0.5f) * world_size, (unit(random) - 0.5f) * world_size };
+		const vec3 half_size = { 0.5f + unit(random) * 4.5f, 0.5f + unit(random) * 4.5f, 0.5f + unit(random) * 4.5f };
+		objects.add(center, half_size);
+	}
+
+	// the camera turns around in the middle of the volume, frame i of every run sees the same view
+	const mat4 projection = perspective(1.0f, 16.0f / 9.0f, 0.5f, world_size * 0.5f);
+	vector<frustum> views;
+	for (int frame = 0; frame < warmup_frames + frames; frame++) {
+		const float angle = frame * 0.1f;
+		const mat4 view = look_at({ 0.0f, 0.0f, 0.0f }, { sin(angle), 0.2f, cos(angle) }, { 0.0f, 1.0f, 0.0f });
+		views.push_back(frustum_from_matrix(projection * view));
+	}
+
+	vector<cull_run> runs = { { "scalar", false, 1 } };
+	if (cpu_has_avx2()) {
+		const int hardware_threads = max(1, static_cast<int>(thread::hardware_concurrency()));
+		for (int threads = 1; threads < hardware_threads; threads *= 2) {
+			runs.push_back({ "avx2", true, threads });
+		}
+		runs.push_back({ "avx2", true, hardware_threads });
+	}
+
+	vector<uint32_t> visible(object_count), reference(object_count);
+	string json = "{\n";
+	json += "  \"objects\": " + to_string(object_count) + ",\n";
+	json += "  \"frames\": " + to_string(frames) + ",\n";
+	json += "  \"runs\": [\n";
+
+	size_t reference_count = 0;
+	bool mismatch = false;
+	const cull_volume volumes[] = { cull_volume::sphere, cull_volume::box };
+	for (const cull_volume volume : volumes) {
+		const char* volume_name = volume == cull_volume::sphere ? "sphere" : "box";
+		for (size_t run = 0; run < runs.size(); run++) {
+			job_system_init(runs[run].threads);
+			frustum_cull_use_simd(runs[run].simd);
+
+			vector<double> cull_ms;
+			double visible_fraction = 0.0;
+			for (int frame = 0; frame < warmup_frames + frames; frame++) {
+				const bench_clock::time_point start = bench_clock::now();
+				const size_t count = frustum_cull(views[frame], objects, volume, visible.data());
+				const double ms = elapsed_ms(start);
+				if (frame < warmup_frames) {
+					continue;
+				}
+				cull_ms.push_back(ms);
+				visible_fraction += static_cast<double>(count) / object_count / frames;
+
+				// the first frame of the scalar run is the reference for every other run
+				if (frame == warmup_frames) {
+					if (run == 0) {
+						copy(visible.begin(), visible.begin() + count, reference.begin());
+						reference_count = count;
+					}
+					else if (count != reference_count || !equal(reference.begin(), reference.begin() + count, visible.begin())) {
+						mismatch = true;
+					}
+				}
+			}
+			job_system_shutdown();
+
+			const bench_stats stats = compute_stats(cull_ms);
+			char line[200];
+			snprintf(line, sizeof(line), "%-6s %-6s %2d threads: %7.3f ms, %6.1f M objects/s, %.1f%% visible",
+				volume_name, runs[run].name, runs[run].threads, stats.median, object_count / stats.median / 1000.0,
+				visible_fraction * 100.0);
+			log(line);
+
+			json += string("    {\"volume\": \"") + volume_name + "\", \"path\": \"" + runs[run].name + "\"";
+			json += ", \"threads\": " + to_string(runs[run].threads);
+			json += ", \"cull_ms\": " + stats_json(stats);
+			snprintf(line, sizeof(line), ", \"objects_per_second\": %.0f, \"visible_fraction\": %.4f}",
+				object_count / stats.median * 1000.0, visible_fraction);
+			json += line;
+			json += volume == cull_volume::box && run + 1 == runs.size() ? "\n" : ",\n";
+		}
+	}
+	frustum_cull_use_simd(true);
+	json += "  ],\n";
+	json += string("  \"results_match\": ") + (mismatch ? "false" : "true") + "\n}\n";
+	if (mismatch) {
+		log("Frustum culling paths disagree on the visible objects");
+	}
+
+	if (!write_bench_json(options.bench_output_path, "frustum_bench.json", json, "Frustum culling benchmark")) {
+		return 1;
+	}
+	return mismatch ? 1 : 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "app_options.h"
+
+// culls options.frustum_bench_objects random boxes and spheres against a turning camera, scalar
+// and AVX2 on one thread and AVX2 on 2, 4 ... hardware threads, and writes the times as JSON
+int run_frustum_cull_benchmark(const app_options& options);
@@ -0,0 +1,68 @@
+#include "gl_api.h"
+
+#include <string>
+
+#include "log.h"
+#include "profiler.h"
+
+using namespace std;
+
+#if USE_GLEW
+#define GL_API_ENTRY GLAPIENTRY
+#else
+#define GL_API_ENTRY GL_LOADER_APIENTRY
+#endif
+
+bool gl_api_init() {
+	#if USE_GLEW
+	profile_scope zone("glew_init");
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK) {
+		log("Failed to initialize GLEW");
+		return false;
+	}
+	#else
+	profile_scope zone("gl_loader_init");
+	if (!gl_loader_init(glfwGetProcAddress)) {
+		log("Failed to load OpenGL functions");
+		return false;
+	}
+	startup_note("gl_functions_loaded", gl_loader_function_count());
+	#endif
+	return true;
+}
+
+bool gl_api_has_version(const int major, const int minor) {
+	#if USE_GLEW
+	GLint context_major = 0, context_minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &context_major);
+	glGetIntegerv(GL_MINOR_VERSION, &context_minor);
+	return context_major > major || (context_major == major && context_minor >= minor);
+	#else
+	return gl_loader_has_version(major, minor);
+	#endif
+}
+
+bool gl_api_has_extension(const char* name) {
+	#if USE_GLEW
+	return glewIsSupported(name) == GL_TRUE;
+	#else
+	return gl_loader_has_extension(name);
+	#endif
+}
+
+static void GL_API_ENTRY debug_message(GLenum source, GLenum type, GLuint id, const GLenum severity, GLsizei length,
+	const GLchar* message, const void* user_param) {
+	if (severity != GL_DEBUG_SEVERITY_NOTIFICATION) {
+		log(string("GL: ") + message);
+	}
+}
+
+void gl_api_enable_debug_output() {
+	if (!gl_api_has_extension("GL_KHR_debug")) {
+		return;
+	}
+	glEnable(GL_DEBUG_OUTPUT);
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(debug_message, nullptr);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// GL entry points come from the generated minimal loader (tools/gen_gl_loader.py);
+// build with msbuild /p:UseGlew=1 to use the vendored GLEW instead for comparison
+#if USE_GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+#else
+#include "gl_loader.h"
+#define GLFW_INCLUDE_NONE
+#endif
+#include <GLFW/glfw3.h>
+
+// needs a current context
+bool gl_api_init();
+bool gl_api_has_version(int major, int minor);
+bool gl_api_has_extension(const char* name);
+// routes KHR_debug messages to log() when the driver supports it
+void gl_api_enable_debug_output();
@@ -0,0 +1,358 @@
+// generated by tools/gen_gl_loader.py from gl_loader.manifest - do not edit
+#include "gl_loader.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "log.h"
+
+using namespace std;
+
+static gl_loader_get_proc loader_get_proc = nullptr;
+
+PFNGLACTIVETEXTUREPROC gl_loader_glActiveTexture = nullptr;
+PFNGLATTACHSHADERPROC gl_loader_glAttachShader = nullptr;
+PFNGLBEGINQUERYPROC gl_loader_glBeginQuery = nullptr;
+PFNGLBINDBUFFERPROC gl_loader_glBindBuffer = nullptr;
+PFNGLBINDBUFFERBASEPROC gl_loader_glBindBufferBase = nullptr;
+PFNGLBINDBUFFERRANGEPROC gl_loader_glBindBufferRange = nullptr;
+PFNGLBINDFRAMEBUFFERPROC gl_loader_glBindFramebuffer = nullptr;
+PFNGLBINDRENDERBUFFERPROC gl_loader_glBindRenderbuffer = nullptr;
+PFNGLBINDTEXTUREPROC gl_loader_glBindTexture = nullptr;
+PFNGLBINDVERTEXARRAYPROC gl_loader_glBindVertexArray = nullptr;
+PFNGLBLENDFUNCPROC gl_loader_glBlendFunc = nullptr;
+PFNGLBLITFRAMEBUFFERPROC gl_loader_glBlitFramebuffer = nullptr;
+PFNGLBUFFERDATAPROC gl_loader_glBufferData = nullptr;
+PFNGLBUFFERSUBDATAPROC gl_loader_glBufferSubData = nullptr;
+PFNGLCHECKFRAMEBUFFERSTATUSPROC gl_loader_glCheckFramebufferStatus = nullptr;
+PFNGLCLEARPROC gl_loader_glClear = nullptr;
+PFNGLCLEARCOLORPROC gl_loader_glClearColor = nullptr;
+PFNGLCLIENTWAITSYNCPROC gl_loader_glClientWaitSync = nullptr;
+PFNGLCOMPILESHADERPROC gl_loader_glCompileShader = nullptr;
+PFNGLCREATEPROGRAMPROC gl_loader_glCreateProgram = nullptr;
+PFNGLCREATESHADERPROC gl_loader_glCreateShader = nullptr;
+PFNGLDELETEBUFFERSPROC gl_loader_glDeleteBuffers = nullptr;
+PFNGLDELETEFRAMEBUFFERSPROC gl_loader_glDeleteFramebuffers = nullptr;
+PFNGLDELETEPROGRAMPROC gl_loader_glDeleteProgram = nullptr;
+PFNGLDELETEQUERIESPROC gl_loader_glDeleteQueries = nullptr;
+PFNGLDELETERENDERBUFFERSPROC gl_loader_glDeleteRenderbuffers = nullptr;
+PFNGLDELETESHADERPROC gl_loader_glDeleteShader = nullptr;
+PFNGLDELETESYNCPROC gl_loader_glDeleteSync = nullptr;
+PFNGLDELETETEXTURESPROC gl_loader_glDeleteTextures = nullptr;
+PFNGLDELETEVERTEXARRAYSPROC gl_loader_glDeleteVertexArrays = nullptr;
+PFNGLDISABLEPROC gl_loader_glDisable = nullptr;
+PFNGLDRAWARRAYSPROC gl_loader_glDrawArrays = nullptr;
+PFNGLDRAWARRAYSINSTANCEDPROC gl_loader_glDrawArraysInstanced = nullptr;
+PFNGLDRAWBUFFERPROC gl_loader_glDrawBuffer = nullptr;
+PFNGLDRAWBUFFERSPROC gl_loader_glDrawBuffers = nullptr;
+PFNGLDRAWELEMENTSPROC gl_loader_glDrawElements = nullptr;
+PFNGLDRAWELEMENTSINSTANCEDPROC gl_loader_glDrawElementsInstanced = nullptr;
+PFNGLENABLEPROC gl_loader_glEnable = nullptr;
+PFNGLENABLEVERTEXATTRIBARRAYPROC gl_loader_glEnableVertexAttribArray = nullptr;
+PFNGLENDQUERYPROC gl_loader_glEndQuery = nullptr;
+PFNGLFENCESYNCPROC gl_loader_glFenceSync = nullptr;
+PFNGLFINISHPROC gl_loader_glFinish = nullptr;
+PFNGLFLUSHPROC gl_loader_glFlush = nullptr;
+PFNGLFRAMEBUFFERRENDERBUFFERPROC gl_loader_glFramebufferRenderbuffer = nullptr;
+PFNGLFRAMEBUFFERTEXTURE2DPROC gl_loader_glFramebufferTexture2D = nullptr;
+PFNGLFRAMEBUFFERTEXTURELAYERPROC gl_loader_glFramebufferTextureLayer = nullptr;
+PFNGLGENBUFFERSPROC gl_loader_glGenBuffers = nullptr;
+PFNGLGENFRAMEBUFFERSPROC gl_loader_glGenFramebuffers = nullptr;
+PFNGLGENQUERIESPROC gl_loader_glGenQueries = nullptr;
+PFNGLGENRENDERBUFFERSPROC gl_loader_glGenRenderbuffers = nullptr;
+PFNGLGENTEXTURESPROC gl_loader_glGenTextures = nullptr;
+PFNGLGENVERTEXARRAYSPROC gl_loader_glGenVertexArrays = nullptr;
+PFNGLGENERATEMIPMAPPROC gl_loader_glGenerateMipmap = nullptr;
+PFNGLGETBUFFERSUBDATAPROC gl_loader_glGetBufferSubData = nullptr;
+PFNGLGETINTEGERVPROC gl_loader_glGetIntegerv = nullptr;
+PFNGLGETPROGRAMINFOLOGPROC gl_loader_glGetProgramInfoLog = nullptr;
+PFNGLGETPROGRAMIVPROC gl_loader_glGetProgramiv = nullptr;
+PFNGLGETQUERYOBJECTUI64VPROC gl_loader_glGetQueryObjectui64v = nullptr;
+PFNGLGETSHADERINFOLOGPROC gl_loader_glGetShaderInfoLog = nullptr;
+PFNGLGETSHADERIVPROC gl_loader_glGetShaderiv = nullptr;
+PFNGLGETSTRINGPROC gl_loader_glGetString = nullptr;
+PFNGLGETSTRINGIPROC gl_loader_glGetStringi = nullptr;
+PFNGLGETUNIFORMBLOCKINDEXPROC gl_loader_glGetUniformBlockIndex = nullptr;
+PFNGLGETUNIFORMLOCATIONPROC gl_loader_glGetUniformLocation = nullptr;
+PFNGLLINKPROGRAMPROC gl_loader_glLinkProgram = nullptr;
+PFNGLMAPBUFFERRANGEPROC gl_loader_glMapBufferRange = nullptr;
+PFNGLPIXELSTOREIPROC gl_loader_glPixelStorei = nullptr;
+PFNGLPOLYGONOFFSETPROC gl_loader_glPolygonOffset = nullptr;
+PFNGLREADBUFFERPROC gl_loader_glReadBuffer = nullptr;
+PFNGLREADPIXELSPROC gl_loader_glReadPixels = nullptr;
+PFNGLRENDERBUFFERSTORAGEPROC gl_loader_glRenderbufferStorage = nullptr;
+PFNGLSCISSORPROC gl_loader_glScissor = nullptr;
+PFNGLSHADERSOURCEPROC gl_loader_glShaderSource = nullptr;
+PFNGLTEXBUFFERPROC gl_loader_glTexBuffer = nullptr;
+PFNGLTEXIMAGE2DPROC gl_loader_glTexImage2D = nullptr;
+PFNGLTEXIMAGE3DPROC gl_loader_glTexImage3D = nullptr;
+PFNGLTEXPARAMETERIPROC gl_loader_glTexParameteri = nullptr;
+PFNGLTEXSUBIMAGE2DPROC gl_loader_glTexSubImage2D = nullptr;
+PFNGLTEXSUBIMAGE3DPROC gl_loader_glTexSubImage3D = nullptr;
+PFNGLUNIFORM1FPROC gl_loader_glUniform1f = nullptr;
+PFNGLUNIFORM1IPROC gl_loader_glUniform1i = nullptr;
+PFNGLUNIFORM1UIPROC gl_loader_glUniform1ui = nullptr;
+PFNGLUNIFORM2FPROC gl_loader_glUniform2f = nullptr;
+PFNGLUNIFORM2IPROC gl_loader_glUniform2i = nullptr;
+PFNGLUNIFORM3FVPROC gl_loader_glUniform3fv = nullptr;
+PFNGLUNIFORM3IPROC gl_loader_glUniform3i = nullptr;
+PFNGLUNIFORM4FVPROC gl_loader_glUniform4fv = nullptr;
+PFNGLUNIFORMBLOCKBINDINGPROC gl_loader_glUniformBlockBinding = nullptr;
+PFNGLUNIFORMMATRIX4FVPROC gl_loader_glUniformMatrix4fv = nullptr;
+PFNGLUNMAPBUFFERPROC gl_loader_glUnmapBuffer = nullptr;
+PFNGLUSEPROGRAMPROC gl_loader_glUseProgram = nullptr;
+PFNGLVERTEXATTRIBDIVISORPROC gl_loader_glVertexAttribDivisor = nullptr;
+PFNGLVERTEXATTRIBIPOINTERPROC gl_loader_glVertexAttribIPointer = nullptr;
+PFNGLVERTEXATTRIBPOINTERPROC gl_loader_glVertexAttribPointer = nullptr;
+PFNGLVIEWPORTPROC gl_loader_glViewport = nullptr;
+
+struct lazy_alternative {
+	const char* requirement;
+	const char* name;
+};
+
+struct lazy_function {
+	const char* name;
+	lazy_alternative alternatives[3];
+	void (*assign)(gl_loader_proc proc);
+	int state; // 0 - not tried, 1 - resolved, -1 - unavailable
+};
+
+static lazy_function lazy_functions[] = {
+	{ "glBindImageTexture", { { "GL_VERSION_4_2", "glBindImageTexture" }, { "GL_ARB_shader_image_load_store", "glBindImageTexture" } }, [](const gl_loader_proc proc) { gl_loader_glBindImageTexture = reinterpret_cast<PFNGLBINDIMAGETEXTUREPROC>(proc); }, 0 },
+	{ "glBufferStorage", { { "GL_VERSION_4_4", "glBufferStorage" }, { "GL_ARB_buffer_storage", "glBufferStorage" } }, [](const gl_loader_proc proc) { gl_loader_glBufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(proc); }, 0 },
+	{ "glDebugMessageCallback", { { "GL_VERSION_4_3", "glDebugMessageCallback" }, { "GL_KHR_debug", "glDebugMessageCallback" }, { "GL_ARB_debug_output", "glDebugMessageCallbackARB" } }, [](const gl_loader_proc proc) { gl_loader_glDebugMessageCallback = reinterpret_cast<PFNGLDEBUGMESSAGECALLBACKPROC>(proc); }, 0 },
+	{ "glDispatchCompute", { { "GL_VERSION_4_3", "glDispatchCompute" }, { "GL_ARB_compute_shader", "glDispatchCompute" } }, [](const gl_loader_proc proc) { gl_loader_glDispatchCompute = reinterpret_cast<PFNGLDISPATCHCOMPUTEPROC>(proc); }, 0 },
+	{ "glMemoryBarrier", { { "GL_VERSION_4_2", "glMemoryBarrier" }, { "GL_ARB_shader_image_load_store", "glMemoryBarrier" } }, [](const gl_loader_proc proc) { gl_loader_glMemoryBarrier = reinterpret_cast<PFNGLMEMORYBARRIERPROC>(proc); }, 0 },
+	{ "glMultiDrawElementsIndirect", { { "GL_VERSION_4_3", "glMultiDrawElementsIndirect" }, { "GL_ARB_multi_draw_indirect", "glMultiDrawElementsIndirect" } }, [](const gl_loader_proc proc) { gl_loader_glMultiDrawElementsIndirect = reinterpret_cast<PFNGLMULTIDRAWELEMENTSINDIRECTPROC>(proc); }, 0 },
+	{ "glMultiDrawElementsIndirectCount", { { "GL_VERSION_4_6", "glMultiDrawElementsIndirectCount" }, { "GL_ARB_indirect_parameters", "glMultiDrawElementsIndirectCountARB" } }, [](const gl_loader_proc proc) { gl_loader_glMultiDrawElementsIndirectCount = reinterpret_cast<PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC>(proc); }, 0 },
+};
+
+static bool requirement_met(const char* requirement) {
+	int major = 0, minor = 0;
+	if (sscanf(requirement, "GL_VERSION_%d_%d", &major, &minor) == 2) {
+		return gl_loader_has_version(major, minor);
+	}
+	return gl_loader_has_extension(requirement);
+}
+
+static bool resolve_lazy(const int index) {
+	lazy_function& function = lazy_functions[index];
+	if (function.state == 0) {
+		function.state = -1;
+		for (const lazy_alternative& alternative : function.alternatives) {
+			if (alternative.name == nullptr || !requirement_met(alternative.requirement)) {
+				continue;
+			}
+			const gl_loader_proc proc = loader_get_proc(alternative.name);
+			if (proc != nullptr) {
+				function.assign(proc);
+				function.state = 1;
+				break;
+			}
+		}
+		if (function.state < 0) {
+			log(string("GL function not available: ") + function.name);
+		}
+	}
+	return function.state > 0;
+}
+
+static void GL_LOADER_APIENTRY lazy_glBindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format) {
+	if (resolve_lazy(0)) {
+		gl_loader_glBindImageTexture(unit, texture, level, layered, layer, access, format);
+	}
+}
+
+static void GL_LOADER_APIENTRY lazy_glBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags) {
+	if (resolve_lazy(1)) {
+		gl_loader_glBufferStorage(target, size, data, flags);
+	}
+}
+
+static void GL_LOADER_APIENTRY lazy_glDebugMessageCallback(GLDEBUGPROC callback, const void *userParam) {
+	if (resolve_lazy(2)) {
+		gl_loader_glDebugMessageCallback(callback, userParam);
+	}
+}
+
+static void GL_LOADER_APIENTRY lazy_glDispatchCompute(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z) {
+	if (resolve_lazy(3)) {
+		gl_loader_glDispatchCompute(num_groups_x, num_groups_y, num_groups_z);
+	}
+}
+
+static void GL_LOADER_APIENTRY lazy_glMemoryBarrier(GLbitfield barriers) {
+	if (resolve_lazy(4)) {
+		gl_loader_glMemoryBarrier(barriers);
+	}
+}
+
+static void GL_LOADER_APIENTRY lazy_glMultiDrawElementsIndirect(GLenum mode, GLenum type, const void *indirect, GLsizei primcount, GLsizei stride) {
+	if (resolve_lazy(5)) {
+		gl_loader_glMultiDrawElementsIndirect(mode, type, indirect, primcount, stride);
+	}
+}
+
+static void GL_LOADER_APIENTRY lazy_glMultiDrawElementsIndirectCount(GLenum mode, GLenum type, const GLvoid *indirect, GLintptr drawcount, GLsizei maxdrawcount, GLsizei stride) {
+	if (resolve_lazy(6)) {
+		gl_loader_glMultiDrawElementsIndirectCount(mode, type, indirect, drawcount, maxdrawcount, stride);
+	}
+}
+
+PFNGLBINDIMAGETEXTUREPROC gl_loader_glBindImageTexture = lazy_glBindImageTexture;
+PFNGLBUFFERSTORAGEPROC gl_loader_glBufferStorage = lazy_glBufferStorage;
+PFNGLDEBUGMESSAGECALLBACKPROC gl_loader_glDebugMessageCallback = lazy_glDebugMessageCallback;
+PFNGLDISPATCHCOMPUTEPROC gl_loader_glDispatchCompute = lazy_glDispatchCompute;
+PFNGLMEMORYBARRIERPROC gl_loader_glMemoryBarrier = lazy_glMemoryBarrier;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC gl_loader_glMultiDrawElementsIndirect = lazy_glMultiDrawElementsIndirect;
+PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC gl_loader_glMultiDrawElementsIndirectCount = lazy_glMultiDrawElementsIndirectCount;
+
+bool gl_loader_init(const gl_loader_get_proc get_proc) {
+	loader_get_proc = get_proc;
+	int missing = 0;
+
+	const auto load = [&](const char* name) {
+		const gl_loader_proc proc = get_proc(name);
+		if (proc == nullptr) {
+			log(string("Failed to load ") + name);
+			missing++;
+		}
+		return proc;
+	};
+
+	gl_loader_glActiveTexture = reinterpret_cast<PFNGLACTIVETEXTUREPROC>(load("glActiveTexture"));
+	gl_loader_glAttachShader = reinterpret_cast<PFNGLATTACHSHADERPROC>(load("glAttachShader"));
+	gl_loader_glBeginQuery = reinterpret_cast<PFNGLBEGINQUERYPROC>(load("glBeginQuery"));
+	gl_loader_glBindBuffer = reinterpret_cast<PFNGLBINDBUFFERPROC>(load("glBindBuffer"));
+	gl_loader_glBindBufferBase = reinterpret_cast<PFNGLBINDBUFFERBASEPROC>(load("glBindBufferBase"));
+	gl_loader_glBindBufferRange = reinterpret_cast<PFNGLBINDBUFFERRANGEPROC>(load("glBindBufferRange"));
+	gl_loader_glBindFramebuffer = reinterpret_cast<PFNGLBINDFRAMEBUFFERPROC>(load("glBindFramebuffer"));
+	gl_loader_glBindRenderbuffer = reinterpret_cast<PFNGLBINDRENDERBUFFERPROC>(load("glBindRenderbuffer"));
+	gl_loader_glBindTexture = reinterpret_cast<PFNGLBINDTEXTUREPROC>(load("glBindTexture"));
+	gl_loader_glBindVertexArray = reinterpret_cast<PFNGLBINDVERTEXARRAYPROC>(load("glBindVertexArray"));
+	gl_loader_glBlendFunc = reinterpret_cast<PFNGLBLENDFUNCPROC>(load("glBlendFunc"));
+	gl_loader_glBlitFramebuffer = reinterpret_cast<PFNGLBLITFRAMEBUFFERPROC>(load("glBlitFramebuffer"));
+	gl_loader_glBufferData = reinterpret_cast<PFNGLBUFFERDATAPROC>(load("glBufferData"));
+	gl_loader_glBufferSubData = reinterpret_cast<PFNGLBUFFERSUBDATAPROC>(load("glBufferSubData"));
+	gl_loader_glCheckFramebufferStatus = reinterpret_cast<PFNGLCHECKFRAMEBUFFERSTATUSPROC>(load("glCheckFramebufferStatus"));
+	gl_loader_glClear = reinterpret_cast<PFNGLCLEARPROC>(load("glClear"));
+	gl_loader_glClearColor = reinterpret_cast<PFNGLCLEARCOLORPROC>(load("glClearColor"));
+	gl_loader_glClientWaitSync = reinterpret_cast<PFNGLCLIENTWAITSYNCPROC>(load("glClientWaitSync"));
+	gl_loader_glCompileShader = reinterpret_cast<PFNGLCOMPILESHADERPROC>(load("glCompileShader"));
+	gl_loader_glCreateProgram = reinterpret_cast<PFNGLCREATEPROGRAMPROC>(load("glCreateProgram"));
+	gl_loader_glCreateShader = reinterpret_cast<PFNGLCREATESHADERPROC>(load("glCreateShader"));
+	gl_loader_glDeleteBuffers = reinterpret_cast<PFNGLDELETEBUFFERSPROC>(load("glDeleteBuffers"));
+	gl_loader_glDeleteFramebuffers = reinterpret_cast<PFNGLDELETEFRAMEBUFFERSPROC>(load("glDeleteFramebuffers"));
+	gl_loader_glDeleteProgram = reinterpret_cast<PFNGLDELETEPROGRAMPROC>(load("glDeleteProgram"));
+	gl_loader_glDeleteQueries = reinterpret_cast<PFNGLDELETEQUERIESPROC>(load("glDeleteQueries"));
+	gl_loader_glDeleteRenderbuffers = reinterpret_cast<PFNGLDELETERENDERBUFFERSPROC>(load("glDeleteRenderbuffers"));
+	gl_loader_glDeleteShader = reinterpret_cast<PFNGLDELETESHADERPROC>(load("glDeleteShader"));
+	gl_loader_glDeleteSync = reinterpret_cast<PFNGLDELETESYNCPROC>(load("glDeleteSync"));
+	gl_loader_glDeleteTextures = reinterpret_cast<PFNGLDELETETEXTURESPROC>(load("glDeleteTextures"));
+	gl_loader_glDeleteVertexArrays = reinterpret_cast<PFNGLDELETEVERTEXARRAYSPROC>(load("glDeleteVertexArrays"));
+	gl_loader_glDisable = reinterpret_cast<PFNGLDISABLEPROC>(load("glDisable"));
+	gl_loader_glDrawArrays = reinterpret_cast<PFNGLDRAWARRAYSPROC>(load("glDrawArrays"));
+	gl_loader_glDrawArraysInstanced = reinterpret_cast<PFNGLDRAWARRAYSINSTANCEDPROC>(load("glDrawArraysInstanced"));
+	gl_loader_glDrawBuffer = reinterpret_cast<PFNGLDRAWBUFFERPROC>(load("glDrawBuffer"));
+	gl_loader_glDrawBuffers = reinterpret_cast<PFNGLDRAWBUFFERSPROC>(load("glDrawBuffers"));
+	gl_loader_glDrawElements = reinterpret_cast<PFNGLDRAWELEMENTSPROC>(load("glDrawElements"));
+	gl_loader_glDrawElementsInstanced = reinterpret_cast<PFNGLDRAWELEMENTSINSTANCEDPROC>(load("glDrawElementsInstanced"));
+	gl_loader_glEnable = reinterpret_cast<PFNGLENABLEPROC>(load("glEnable"));
+	gl_loader_glEnableVertexAttribArray = reinterpret_cast<PFNGLENABLEVERTEXATTRIBARRAYPROC>(load("glEnableVertexAttribArray"));
+	gl_loader_glEndQuery = reinterpret_cast<PFNGLENDQUERYPROC>(load("glEndQuery"));
+	gl_loader_glFenceSync = reinterpret_cast<PFNGLFENCESYNCPROC>(load("glFenceSync"));
+	gl_loader_glFinish = reinterpret_cast<PFNGLFINISHPROC>(load("glFinish"));
+	gl_loader_glFlush = reinterpret_cast<PFNGLFLUSHPROC>(load("glFlush"));
+	gl_loader_glFramebufferRenderbuffer = reinterpret_cast<PFNGLFRAMEBUFFERRENDERBUFFERPROC>(load("glFramebufferRenderbuffer"));
+	gl_loader_glFramebufferTexture2D = reinterpret_cast<PFNGLFRAMEBUFFERTEXTURE2DPROC>(load("glFramebufferTexture2D"));
+	gl_loader_glFramebufferTextureLayer = reinterpret_cast<PFNGLFRAMEBUFFERTEXTURELAYERPROC>(load("glFramebufferTextureLayer"));
+	gl_loader_glGenBuffers = reinterpret_cast<PFNGLGENBUFFERSPROC>(load("glGenBuffers"));
+	gl_loader_glGenFramebuffers = reinterpret_cast<PFNGLGENFRAMEBUFFERSPROC>(load("glGenFramebuffers"));
+	gl_loader_glGenQueries = reinterpret_cast<PFNGLGENQUERIESPROC>(load("glGenQueries"));
+	gl_loader_glGenRenderbuffers = reinterpret_cast<PFNGLGENRENDERBUFFERSPROC>(load("glGenRenderbuffers"));
+	gl_loader_glGenTextures = reinterpret_cast<PFNGLGENTEXTURESPROC>(load("glGenTextures"));
+	gl_loader_glGenVertexArrays = reinterpret_cast<PFNGLGENVERTEXARRAYSPROC>(load("glGenVertexArrays"));
+	gl_loader_glGenerateMipmap = reinterpret_cast<PFNGLGENERATEMIPMAPPROC>(load("glGenerateMipmap"));
+	gl_loader_glGetBufferSubData = reinterpret_cast<PFNGLGETBUFFERSUBDATAPROC>(load("glGetBufferSubData"));
+	gl_loader_glGetIntegerv = reinterpret_cast<PFNGLGETINTEGERVPROC>(load("glGetIntegerv"));
+	gl_loader_glGetProgramInfoLog = reinterpret_cast<PFNGLGETPROGRAMINFOLOGPROC>(load("glGetProgramInfoLog"));
+	gl_loader_glGetProgramiv = reinterpret_cast<PFNGLGETPROGRAMIVPROC>(load("glGetProgramiv"));
+	gl_loader_glGetQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VPROC>(load("glGetQueryObjectui64v"));
+	gl_loader_glGetShaderInfoLog = reinterpret_cast<PFNGLGETSHADERINFOLOGPROC>(load("glGetShaderInfoLog"));
+	gl_loader_glGetShaderiv = reinterpret_cast<PFNGLGETSHADERIVPROC>(load("glGetShaderiv"));
+	gl_loader_glGetString = reinterpret_cast<PFNGLGETSTRINGPROC>(load("glGetString"));
+	gl_loader_glGetStringi = reinterpret_cast<PFNGLGETSTRINGIPROC>(load("glGetStringi"));
+	gl_loader_glGetUniformBlockIndex = reinterpret_cast<PFNGLGETUNIFORMBLOCKINDEXPROC>(load("glGetUniformBlockIndex"));
+	gl_loader_glGetUniformLocation = reinterpret_cast<PFNGLGETUNIFORMLOCATIONPROC>(load("glGetUniformLocation"));
+	gl_loader_glLinkProgram = reinterpret_cast<PFNGLLINKPROGRAMPROC>(load("glLinkProgram"));
+	gl_loader_glMapBufferRange = reinterpret_cast<PFNGLMAPBUFFERRANGEPROC>(load("glMapBufferRange"));
+	gl_loader_glPixelStorei = reinterpret_cast<PFNGLPIXELSTOREIPROC>(load("glPixelStorei"));
+	gl_loader_glPolygonOffset = reinterpret_cast<PFNGLPOLYGONOFFSETPROC>(load("glPolygonOffset"));
+	gl_loader_glReadBuffer = reinterpret_cast<PFNGLREADBUFFERPROC>(load("glReadBuffer"));
+	gl_loader_glReadPixels = reinterpret_cast<PFNGLREADPIXELSPROC>(load("glReadPixels"));
+	gl_loader_glRenderbufferStorage = reinterpret_cast<PFNGLRENDERBUFFERSTORAGEPROC>(load("glRenderbufferStorage"));
+	gl_loader_glScissor = reinterpret_cast<PFNGLSCISSORPROC>(load("glScissor"));
+	gl_loader_glShaderSource = reinterpret_cast<PFNGLSHADERSOURCEPROC>(load("glShaderSource"));
+	gl_loader_glTexBuffer = reinterpret_cast<PFNGLTEXBUFFERPROC>(load("glTexBuffer"));
+	gl_loader_glTexImage2D = reinterpret_cast<PFNGLTEXIMAGE2DPROC>(load("glTexImage2D"));
+	gl_loader_glTexImage3D = reinterpret_cast<PFNGLTEXIMAGE3DPROC>(load("glTexImage3D"));
+	gl_loader_glTexParameteri = reinterpret_cast<PFNGLTEXPARAMETERIPROC>(load("glTexParameteri"));
+	gl_loader_glTexSubImage2D = reinterpret_cast<PFNGLTEXSUBIMAGE2DPROC>(load("glTexSubImage2D"));
+	gl_loader_glTexSubImage3D = reinterpret_cast<PFNGLTEXSUBIMAGE3DPROC>(load("glTexSubImage3D"));
+	gl_loader_glUniform1f = reinterpret_cast<PFNGLUNIFORM1FPROC>(load("glUniform1f"));
+	gl_loader_glUniform1i = reinterpret_cast<PFNGLUNIFORM1IPROC>(load("glUniform1i"));
+	gl_loader_glUniform1ui = reinterpret_cast<PFNGLUNIFORM1UIPROC>(load("glUniform1ui"));
+	gl_loader_glUniform2f = reinterpret_cast<PFNGLUNIFORM2FPROC>(load("glUniform2f"));
+	gl_loader_glUniform2i = reinterpret_cast<PFNGLUNIFORM2IPROC>(load("glUniform2i"));
+	gl_loader_glUniform3fv = reinterpret_cast<PFNGLUNIFORM3FVPROC>(load("glUniform3fv"));
+	gl_loader_glUniform3i = reinterpret_cast<PFNGLUNIFORM3IPROC>(load("glUniform3i"));
+	gl_loader_glUniform4fv = reinterpret_cast<PFNGLUNIFORM4FVPROC>(load("glUniform4fv"));
+	gl_loader_glUniformBlockBinding = reinterpret_cast<PFNGLUNIFORMBLOCKBINDINGPROC>(load("glUniformBlockBinding"));
+	gl_loader_glUniformMatrix4fv = reinterpret_cast<PFNGLUNIFORMMATRIX4FVPROC>(load("glUniformMatrix4fv"));
+	gl_loader_glUnmapBuffer = reinterpret_cast<PFNGLUNMAPBUFFERPROC>(load("glUnmapBuffer"));
+	gl_loader_glUseProgram = reinterpret_cast<PFNGLUSEPROGRAMPROC>(load("glUseProgram"));
+	gl_loader_glVertexAttribDivisor = reinterpret_cast<PFNGLVERTEXATTRIBDIVISORPROC>(load("glVertexAttribDivisor"));
+	gl_loader_glVertexAttribIPointer = reinterpret_cast<PFNGLVERTEXATTRIBIPOINTERPROC>(load("glVertexAttribIPointer"));
+	gl_loader_glVertexAttribPointer = reinterpret_cast<PFNGLVERTEXATTRIBPOINTERPROC>(load("glVertexAttribPointer"));
+	gl_loader_glViewport = reinterpret_cast<PFNGLVIEWPORTPROC>(load("glViewport"));
+
+	return missing == 0;
+}
+
+int gl_loader_function_count() {
+	return 102;
+}
+
+bool gl_loader_load(const char* name) {
+	for (int i = 0; i < 7; i++) {
+		if (strcmp(lazy_functions[i].name, name) == 0) {
+			return resolve_lazy(i);
+		}
+	}
+	return false;
+}
+
+bool gl_loader_has_version(const int major, const int minor) {
+	static int version = -1;
+	if (version < 0) {
+		GLint context_major = 0, context_minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &context_major);
+		glGetIntegerv(GL_MINOR_VERSION, &context_minor);
+		version = context_major * 10 + context_minor;
+	}
+	return version >= major * 10 + minor;
+}
+
+bool gl_loader_has_extension(const char* name) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++) {
+		const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+		if (extension != nullptr && strcmp(reinterpret_cast<const char*>(extension), name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,592 @@
+// generated by tools/gen_gl_loader.py from gl_loader.manifest - do not edit
+// 102 functions (7 resolved on first use), 123 constants
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__gl_h_) || defined(__GL_H__) || defined(__glew_h__)
+#error gl_loader.h replaces gl.h and glew.h, include only one of them
+#endif
+#define __gl_h_
+#define __GL_H__
+
+#ifdef _WIN32
+#define GL_LOADER_APIENTRY __stdcall
+#else
+#define GL_LOADER_APIENTRY
+#endif
+
+typedef unsigned int GLenum;
+typedef unsigned int GLbitfield;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+typedef unsigned char GLboolean;
+typedef signed char GLbyte;
+typedef short GLshort;
+typedef unsigned char GLubyte;
+typedef unsigned short GLushort;
+typedef float GLfloat;
+typedef float GLclampf;
+typedef double GLdouble;
+typedef double GLclampd;
+typedef void GLvoid;
+typedef char GLchar;
+typedef unsigned short GLhalf;
+typedef int64_t GLint64;
+typedef uint64_t GLuint64;
+typedef ptrdiff_t GLintptr;
+typedef ptrdiff_t GLsizeiptr;
+typedef struct __GLsync* GLsync;
+typedef void (GL_LOADER_APIENTRY* GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_BLEND 0x0BE2
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#define GL_BYTE 0x1400
+#define GL_CLAMP_TO_EDGE 0x812F
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_COLOR_ATTACHMENT1 0x8CE1
+#define GL_COLOR_BUFFER_BIT 0x00004000
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_COMPARE_REF_TO_TEXTURE 0x884E
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_DEPTH24_STENCIL8 0x88F0
+#define GL_DEPTH_ATTACHMENT 0x8D00
+#define GL_DEPTH_BUFFER_BIT 0x00000100
+#define GL_DEPTH_COMPONENT 0x1902
+#define GL_DEPTH_COMPONENT32F 0x8CAC
+#define GL_DEPTH_STENCIL 0x84F9
+#define GL_DEPTH_STENCIL_ATTACHMENT 0x821A
+#define GL_DEPTH_TEST 0x0B71
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#define GL_DRAW_FRAMEBUFFER_BINDING 0x8CA6
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_DYNAMIC_COPY 0x88EA
+#define GL_DYNAMIC_DRAW 0x88E8
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_EXTENSIONS 0x1F03
+#define GL_FALSE 0
+#define GL_FLOAT 0x1406
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_HALF_FLOAT 0x140B
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+#define GL_LEQUAL 0x0203
+#define GL_LINEAR 0x2601
+#define GL_LINEAR_MIPMAP_LINEAR 0x2703
+#define GL_LINES 0x0001
+#define GL_LINK_STATUS 0x8B82
+#define GL_MAJOR_VERSION 0x821B
+#define GL_MAP_COHERENT_BIT 0x00000080
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#define GL_MAP_PERSISTENT_BIT 0x00000040
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MINOR_VERSION 0x821C
+#define GL_NEAREST 0x2600
+#define GL_NEAREST_MIPMAP_NEAREST 0x2700
+#define GL_NONE 0
+#define GL_NUM_EXTENSIONS 0x821D
+#define GL_ONE_MINUS_SRC_ALPHA 0x0303
+#define GL_PACK_ALIGNMENT 0x0D05
+#define GL_PARAMETER_BUFFER 0x80EE
+#define GL_POINTS 0x0000
+#define GL_POLYGON_OFFSET_FILL 0x8037
+#define GL_QUERY_RESULT 0x8866
+#define GL_R11F_G11F_B10F 0x8C3A
+#define GL_R16F 0x822D
+#define GL_R32F 0x822E
+#define GL_R32UI 0x8236
+#define GL_R8 0x8229
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#define GL_RED 0x1903
+#define GL_RENDERBUFFER 0x8D41
+#define GL_RENDERER 0x1F01
+#define GL_RG 0x8227
+#define GL_RG16 0x822C
+#define GL_RG16F 0x822F
+#define GL_RG32F 0x8230
+#define GL_RG32UI 0x823C
+#define GL_RG8 0x822B
+#define GL_RGB 0x1907
+#define GL_RGB16F 0x881B
+#define GL_RGB32F 0x8815
+#define GL_RGBA 0x1908
+#define GL_RGBA16F 0x881A
+#define GL_RGBA32F 0x8814
+#define GL_RGBA8 0x8058
+#define GL_SCISSOR_TEST 0x0C11
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x2000
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHORT 0x1402
+#define GL_SRC_ALPHA 0x0302
+#define GL_STATIC_DRAW 0x88E4
+#define GL_STREAM_DRAW 0x88E0
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_TEXTURE0 0x84C0
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#define GL_TEXTURE_3D 0x806F
+#define GL_TEXTURE_BUFFER 0x8C2A
+#define GL_TEXTURE_COMPARE_FUNC 0x884D
+#define GL_TEXTURE_COMPARE_MODE 0x884C
+#define GL_TEXTURE_CUBE_MAP 0x8513
+#define GL_TEXTURE_CUBE_MAP_NEGATIVE_Z 0x851A
+#define GL_TEXTURE_CUBE_MAP_POSITIVE_X 0x8515
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_TRIANGLES 0x0004
+#define GL_TRIANGLE_FAN 0x0006
+#define GL_TRIANGLE_STRIP 0x0005
+#define GL_TRUE 1
+#define GL_UNIFORM_BUFFER 0x8A11
+#define GL_UNPACK_ALIGNMENT 0x0CF5
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_UNSIGNED_INT 0x1405
+#define GL_UNSIGNED_INT_10F_11F_11F_REV 0x8C3B
+#define GL_UNSIGNED_INT_24_8 0x84FA
+#define GL_UNSIGNED_INT_2_10_10_10_REV 0x8368
+#define GL_UNSIGNED_SHORT 0x1403
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_VIEWPORT 0x0BA2
+#define GL_WRITE_ONLY 0x88B9
+
+typedef void (GL_LOADER_APIENTRY* PFNGLACTIVETEXTUREPROC)(GLenum texture);
+typedef void (GL_LOADER_APIENTRY* PFNGLATTACHSHADERPROC)(GLuint program, GLuint shader);
+typedef void (GL_LOADER_APIENTRY* PFNGLBEGINQUERYPROC)(GLenum target, GLuint id);
+typedef void (GL_LOADER_APIENTRY* PFNGLBINDBUFFERPROC)(GLenum target, GLuint buffer);
+typedef void (GL_LOADER_APIENTRY* PFNGLBINDBUFFERBASEPROC)(GLenum target, GLuint index, GLuint buffer);
+typedef void (GL_LOADER_APIENTRY* PFNGLBINDBUFFERRANGEPROC)(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+typedef void (GL_LOADER_APIENTRY* PFNGLBINDFRAMEBUFFERPROC)(GLenum target, GLuint framebuffer);
+typedef void (GL_LOADER_APIENTRY* PFNGLBINDRENDERBUFFERPROC)(GLenum target, GLuint renderbuffer);
+typedef void (GL_LOADER_APIENTRY* PFNGLBINDTEXTUREPROC)(GLenum target, GLuint texture);
+typedef void (GL_LOADER_APIENTRY* PFNGLBINDVERTEXARRAYPROC)(GLuint array);
+typedef void (GL_LOADER_APIENTRY* PFNGLBLENDFUNCPROC)(GLenum sfactor, GLenum dfactor);
+typedef void (GL_LOADER_APIENTRY* PFNGLBLITFRAMEBUFFERPROC)(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
+typedef void (GL_LOADER_APIENTRY* PFNGLBUFFERDATAPROC)(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+typedef void (GL_LOADER_APIENTRY* PFNGLBUFFERSUBDATAPROC)(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+typedef GLenum (GL_LOADER_APIENTRY* PFNGLCHECKFRAMEBUFFERSTATUSPROC)(GLenum target);
+typedef void (GL_LOADER_APIENTRY* PFNGLCLEARPROC)(GLbitfield mask);
+typedef void (GL_LOADER_APIENTRY* PFNGLCLEARCOLORPROC)(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
+typedef GLenum (GL_LOADER_APIENTRY* PFNGLCLIENTWAITSYNCPROC)(GLsync GLsync,GLbitfield flags,GLuint64 timeout);
+typedef void (GL_LOADER_APIENTRY* PFNGLCOMPILESHADERPROC)(GLuint shader);
+typedef GLuint (GL_LOADER_APIENTRY* PFNGLCREATEPROGRAMPROC)(void);
+typedef GLuint (GL_LOADER_APIENTRY* PFNGLCREATESHADERPROC)(GLenum type);
+typedef void (GL_LOADER_APIENTRY* PFNGLDELETEBUFFERSPROC)(GLsizei n, const GLuint* buffers);
+typedef void (GL_LOADER_APIENTRY* PFNGLDELETEFRAMEBUFFERSPROC)(GLsizei n, const GLuint* framebuffers);
+typedef void (GL_LOADER_APIENTRY* PFNGLDELETEPROGRAMPROC)(GLuint program);
+typedef void (GL_LOADER_APIENTRY* PFNGLDELETEQUERIESPROC)(GLsizei n, const GLuint* ids);
+typedef void (GL_LOADER_APIENTRY* PFNGLDELETERENDERBUFFERSPROC)(GLsizei n, const GLuint* renderbuffers);
+typedef void (GL_LOADER_APIENTRY* PFNGLDELETESHADERPROC)(GLuint shader);
+typedef void (GL_LOADER_APIENTRY* PFNGLDELETESYNCPROC)(GLsync GLsync);
+typedef void (GL_LOADER_APIENTRY* PFNGLDELETETEXTURESPROC)(GLsizei n, const GLuint *textures);
+typedef void (GL_LOADER_APIENTRY* PFNGLDELETEVERTEXARRAYSPROC)(GLsizei n, const GLuint* arrays);
+typedef void (GL_LOADER_APIENTRY* PFNGLDISABLEPROC)(GLenum cap);
+typedef void (GL_LOADER_APIENTRY* PFNGLDRAWARRAYSPROC)(GLenum mode, GLint first, GLsizei count);
+typedef void (GL_LOADER_APIENTRY* PFNGLDRAWARRAYSINSTANCEDPROC)(GLenum mode, GLint first, GLsizei count, GLsizei primcount);
+typedef void (GL_LOADER_APIENTRY* PFNGLDRAWBUFFERPROC)(GLenum mode);
+typedef void (GL_LOADER_APIENTRY* PFNGLDRAWBUFFERSPROC)(GLsizei n, const GLenum* bufs);
+typedef void (GL_LOADER_APIENTRY* PFNGLDRAWELEMENTSPROC)(GLenum mode, GLsizei count, GLenum type, const void *indices);
+typedef void (GL_LOADER_APIENTRY* PFNGLDRAWELEMENTSINSTANCEDPROC)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei primcount);
+typedef void (GL_LOADER_APIENTRY* PFNGLENABLEPROC)(GLenum cap);
+typedef void (GL_LOADER_APIENTRY* PFNGLENABLEVERTEXATTRIBARRAYPROC)(GLuint index);
+typedef void (GL_LOADER_APIENTRY* PFNGLENDQUERYPROC)(GLenum target);
+typedef GLsync (GL_LOADER_APIENTRY* PFNGLFENCESYNCPROC)(GLenum condition,GLbitfield flags);
+typedef void (GL_LOADER_APIENTRY* PFNGLFINISHPROC)(void);
+typedef void (GL_LOADER_APIENTRY* PFNGLFLUSHPROC)(void);
+typedef void (GL_LOADER_APIENTRY* PFNGLFRAMEBUFFERRENDERBUFFERPROC)(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
+typedef void (GL_LOADER_APIENTRY* PFNGLFRAMEBUFFERTEXTURE2DPROC)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+typedef void (GL_LOADER_APIENTRY* PFNGLFRAMEBUFFERTEXTURELAYERPROC)(GLenum target,GLenum attachment, GLuint texture,GLint level,GLint layer);
+typedef void (GL_LOADER_APIENTRY* PFNGLGENBUFFERSPROC)(GLsizei n, GLuint* buffers);
+typedef void (GL_LOADER_APIENTRY* PFNGLGENFRAMEBUFFERSPROC)(GLsizei n, GLuint* framebuffers);
+typedef void (GL_LOADER_APIENTRY* PFNGLGENQUERIESPROC)(GLsizei n, GLuint* ids);
+typedef void (GL_LOADER_APIENTRY* PFNGLGENRENDERBUFFERSPROC)(GLsizei n, GLuint* renderbuffers);
+typedef void (GL_LOADER_APIENTRY* PFNGLGENTEXTURESPROC)(GLsizei n, GLuint *textures);
+typedef void (GL_LOADER_APIENTRY* PFNGLGENVERTEXARRAYSPROC)(GLsizei n, GLuint* arrays);
+typedef void (GL_LOADER_APIENTRY* PFNGLGENERATEMIPMAPPROC)(GLenum target);
+typedef void (GL_LOADER_APIENTRY* PFNGLGETBUFFERSUBDATAPROC)(GLenum target, GLintptr offset, GLsizeiptr size, void* data);
+typedef void (GL_LOADER_APIENTRY* PFNGLGETINTEGERVPROC)(GLenum pname, GLint *params);
+typedef void (GL_LOADER_APIENTRY* PFNGLGETPROGRAMINFOLOGPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+typedef void (GL_LOADER_APIENTRY* PFNGLGETPROGRAMIVPROC)(GLuint program, GLenum pname, GLint* param);
+typedef void (GL_LOADER_APIENTRY* PFNGLGETQUERYOBJECTUI64VPROC)(GLuint id, GLenum pname, GLuint64* params);
+typedef void (GL_LOADER_APIENTRY* PFNGLGETSHADERINFOLOGPROC)(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+typedef void (GL_LOADER_APIENTRY* PFNGLGETSHADERIVPROC)(GLuint shader, GLenum pname, GLint* param);
+typedef const GLubyte * (GL_LOADER_APIENTRY* PFNGLGETSTRINGPROC)(GLenum name);
+typedef const GLubyte* (GL_LOADER_APIENTRY* PFNGLGETSTRINGIPROC)(GLenum name, GLuint index);
+typedef GLuint (GL_LOADER_APIENTRY* PFNGLGETUNIFORMBLOCKINDEXPROC)(GLuint program, const GLchar* uniformBlockName);
+typedef GLint (GL_LOADER_APIENTRY* PFNGLGETUNIFORMLOCATIONPROC)(GLuint program, const GLchar* name);
+typedef void (GL_LOADER_APIENTRY* PFNGLLINKPROGRAMPROC)(GLuint program);
+typedef void * (GL_LOADER_APIENTRY* PFNGLMAPBUFFERRANGEPROC)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef void (GL_LOADER_APIENTRY* PFNGLPIXELSTOREIPROC)(GLenum pname, GLint param);
+typedef void (GL_LOADER_APIENTRY* PFNGLPOLYGONOFFSETPROC)(GLfloat factor, GLfloat units);
+typedef void (GL_LOADER_APIENTRY* PFNGLREADBUFFERPROC)(GLenum mode);
+typedef void (GL_LOADER_APIENTRY* PFNGLREADPIXELSPROC)(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels);
+typedef void (GL_LOADER_APIENTRY* PFNGLRENDERBUFFERSTORAGEPROC)(GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (GL_LOADER_APIENTRY* PFNGLSCISSORPROC)(GLint x, GLint y, GLsizei width, GLsizei height);
+typedef void (GL_LOADER_APIENTRY* PFNGLSHADERSOURCEPROC)(GLuint shader, GLsizei count, const GLchar *const* string, const GLint* length);
+typedef void (GL_LOADER_APIENTRY* PFNGLTEXBUFFERPROC)(GLenum target, GLenum internalFormat, GLuint buffer);
+typedef void (GL_LOADER_APIENTRY* PFNGLTEXIMAGE2DPROC)(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels);
+typedef void (GL_LOADER_APIENTRY* PFNGLTEXIMAGE3DPROC)(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels);
+typedef void (GL_LOADER_APIENTRY* PFNGLTEXPARAMETERIPROC)(GLenum target, GLenum pname, GLint param);
+typedef void (GL_LOADER_APIENTRY* PFNGLTEXSUBIMAGE2DPROC)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels);
+typedef void (GL_LOADER_APIENTRY* PFNGLTEXSUBIMAGE3DPROC)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels);
+typedef void (GL_LOADER_APIENTRY* PFNGLUNIFORM1FPROC)(GLint location, GLfloat v0);
+typedef void (GL_LOADER_APIENTRY* PFNGLUNIFORM1IPROC)(GLint location, GLint v0);
+typedef void (GL_LOADER_APIENTRY* PFNGLUNIFORM1UIPROC)(GLint location, GLuint v0);
+typedef void (GL_LOADER_APIENTRY* PFNGLUNIFORM2FPROC)(GLint location, GLfloat v0, GLfloat v1);
+typedef void (GL_LOADER_APIENTRY* PFNGLUNIFORM2IPROC)(GLint location, GLint v0, GLint v1);
+typedef void (GL_LOADER_APIENTRY* PFNGLUNIFORM3FVPROC)(GLint location, GLsizei count, const GLfloat* value);
+typedef void (GL_LOADER_APIENTRY* PFNGLUNIFORM3IPROC)(GLint location, GLint v0, GLint v1, GLint v2);
+typedef void (GL_LOADER_APIENTRY* PFNGLUNIFORM4FVPROC)(GLint location, GLsizei count, const GLfloat* value);
+typedef void (GL_LOADER_APIENTRY* PFNGLUNIFORMBLOCKBINDINGPROC)(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+typedef void (GL_LOADER_APIENTRY* PFNGLUNIFORMMATRIX4FVPROC)(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+typedef GLboolean (GL_LOADER_APIENTRY* PFNGLUNMAPBUFFERPROC)(GLenum target);
+typedef void (GL_LOADER_APIENTRY* PFNGLUSEPROGRAMPROC)(GLuint program);
+typedef void (GL_LOADER_APIENTRY* PFNGLVERTEXATTRIBDIVISORPROC)(GLuint index, GLuint divisor);
+typedef void (GL_LOADER_APIENTRY* PFNGLVERTEXATTRIBIPOINTERPROC)(GLuint index, GLint size, GLenum type, GLsizei stride, const void*pointer);
+typedef void (GL_LOADER_APIENTRY* PFNGLVERTEXATTRIBPOINTERPROC)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+typedef void (GL_LOADER_APIENTRY* PFNGLVIEWPORTPROC)(GLint x, GLint y, GLsizei width, GLsizei height);
+typedef void (GL_LOADER_APIENTRY* PFNGLBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+typedef void (GL_LOADER_APIENTRY* PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void (GL_LOADER_APIENTRY* PFNGLDEBUGMESSAGECALLBACKPROC)(GLDEBUGPROC callback, const void *userParam);
+typedef void (GL_LOADER_APIENTRY* PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+typedef void (GL_LOADER_APIENTRY* PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void (GL_LOADER_APIENTRY* PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect, GLsizei primcount, GLsizei stride);
+typedef void (GL_LOADER_APIENTRY* PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC)(GLenum mode, GLenum type, const GLvoid *indirect, GLintptr drawcount, GLsizei maxdrawcount, GLsizei stride);
+
+extern PFNGLACTIVETEXTUREPROC gl_loader_glActiveTexture;
+extern PFNGLATTACHSHADERPROC gl_loader_glAttachShader;
+extern PFNGLBEGINQUERYPROC gl_loader_glBeginQuery;
+extern PFNGLBINDBUFFERPROC gl_loader_glBindBuffer;
+extern PFNGLBINDBUFFERBASEPROC gl_loader_glBindBufferBase;
+extern PFNGLBINDBUFFERRANGEPROC gl_loader_glBindBufferRange;
+extern PFNGLBINDFRAMEBUFFERPROC gl_loader_glBindFramebuffer;
+extern PFNGLBINDRENDERBUFFERPROC gl_loader_glBindRenderbuffer;
+extern PFNGLBINDTEXTUREPROC gl_loader_glBindTexture;
+extern PFNGLBINDVERTEXARRAYPROC gl_loader_glBindVertexArray;
+extern PFNGLBLENDFUNCPROC gl_loader_glBlendFunc;
+extern PFNGLBLITFRAMEBUFFERPROC gl_loader_glBlitFramebuffer;
+extern PFNGLBUFFERDATAPROC gl_loader_glBufferData;
+extern PFNGLBUFFERSUBDATAPROC gl_loader_glBufferSubData;
+extern PFNGLCHECKFRAMEBUFFERSTATUSPROC gl_loader_glCheckFramebufferStatus;
+extern PFNGLCLEARPROC gl_loader_glClear;
+extern PFNGLCLEARCOLORPROC gl_loader_glClearColor;
+extern PFNGLCLIENTWAITSYNCPROC gl_loader_glClientWaitSync;
+extern PFNGLCOMPILESHADERPROC gl_loader_glCompileShader;
+extern PFNGLCREATEPROGRAMPROC gl_loader_glCreateProgram;
+extern PFNGLCREATESHADERPROC gl_loader_glCreateShader;
+extern PFNGLDELETEBUFFERSPROC gl_loader_glDeleteBuffers;
+extern PFNGLDELETEFRAMEBUFFERSPROC gl_loader_glDeleteFramebuffers;
+extern PFNGLDELETEPROGRAMPROC gl_loader_glDeleteProgram;
+extern PFNGLDELETEQUERIESPROC gl_loader_glDeleteQueries;
+extern PFNGLDELETERENDERBUFFERSPROC gl_loader_glDeleteRenderbuffers;
+extern PFNGLDELETESHADERPROC gl_loader_glDeleteShader;
+extern PFNGLDELETESYNCPROC gl_loader_glDeleteSync;
+extern PFNGLDELETETEXTURESPROC gl_loader_glDeleteTextures;
+extern PFNGLDELETEVERTEXARRAYSPROC gl_loader_glDeleteVertexArrays;
+extern PFNGLDISABLEPROC gl_loader_glDisable;
+extern PFNGLDRAWARRAYSPROC gl_loader_glDrawArrays;
+extern PFNGLDRAWARRAYSINSTANCEDPROC gl_loader_glDrawArraysInstanced;
+extern PFNGLDRAWBUFFERPROC gl_loader_glDrawBuffer;
+extern PFNGLDRAWBUFFERSPROC gl_loader_glDrawBuffers;
+extern PFNGLDRAWELEMENTSPROC gl_loader_glDrawElements;
+extern PFNGLDRAWELEMENTSINSTANCEDPROC gl_loader_glDrawElementsInstanced;
+extern PFNGLENABLEPROC gl_loader_glEnable;
+extern PFNGLENABLEVERTEXATTRIBARRAYPROC gl_loader_glEnableVertexAttribArray;
+extern PFNGLENDQUERYPROC gl_loader_glEndQuery;
+extern PFNGLFENCESYNCPROC gl_loader_glFenceSync;
+extern PFNGLFINISHPROC gl_loader_glFinish;
+extern PFNGLFLUSHPROC gl_loader_glFlush;
+extern PFNGLFRAMEBUFFERRENDERBUFFERPROC gl_loader_glFramebufferRenderbuffer;
+extern PFNGLFRAMEBUFFERTEXTURE2DPROC gl_loader_glFramebufferTexture2D;
+extern PFNGLFRAMEBUFFERTEXTURELAYERPROC gl_loader_glFramebufferTextureLayer;
+extern PFNGLGENBUFFERSPROC gl_loader_glGenBuffers;
+extern PFNGLGENFRAMEBUFFERSPROC gl_loader_glGenFramebuffers;
+extern PFNGLGENQUERIESPROC gl_loader_glGenQueries;
+extern PFNGLGENRENDERBUFFERSPROC gl_loader_glGenRenderbuffers;
+extern PFNGLGENTEXTURESPROC gl_loader_glGenTextures;
+extern PFNGLGENVERTEXARRAYSPROC gl_loader_glGenVertexArrays;
+extern PFNGLGENERATEMIPMAPPROC gl_loader_glGenerateMipmap;
+extern PFNGLGETBUFFERSUBDATAPROC gl_loader_glGetBufferSubData;
+extern PFNGLGETINTEGERVPROC gl_loader_glGetIntegerv;
+extern PFNGLGETPROGRAMINFOLOGPROC gl_loader_glGetProgramInfoLog;
+extern PFNGLGETPROGRAMIVPROC gl_loader_glGetProgramiv;
+extern PFNGLGETQUERYOBJECTUI64VPROC gl_loader_glGetQueryObjectui64v;
+extern PFNGLGETSHADERINFOLOGPROC gl_loader_glGetShaderInfoLog;
+extern PFNGLGETSHADERIVPROC gl_loader_glGetShaderiv;
+extern PFNGLGETSTRINGPROC gl_loader_glGetString;
+extern PFNGLGETSTRINGIPROC gl_loader_glGetStringi;
+extern PFNGLGETUNIFORMBLOCKINDEXPROC gl_loader_glGetUniformBlockIndex;
+extern PFNGLGETUNIFORMLOCATIONPROC gl_loader_glGetUniformLocation;
+extern PFNGLLINKPROGRAMPROC gl_loader_glLinkProgram;
+extern PFNGLMAPBUFFERRANGEPROC gl_loader_glMapBufferRange;
+extern PFNGLPIXELSTOREIPROC gl_loader_glPixelStorei;
+extern PFNGLPOLYGONOFFSETPROC gl_loader_glPolygonOffset;
+extern PFNGLREADBUFFERPROC gl_loader_glReadBuffer;
+extern PFNGLREADPIXELSPROC gl_loader_glReadPixels;
+extern PFNGLRENDERBUFFERSTORAGEPROC gl_loader_glRenderbufferStorage;
+extern PFNGLSCISSORPROC gl_loader_glScissor;
+extern PFNGLSHADERSOURCEPROC gl_loader_glShaderSource;
+extern PFNGLTEXBUFFERPROC gl_loader_glTexBuffer;
+extern PFNGLTEXIMAGE2DPROC gl_loader_glTexImage2D;
+extern PFNGLTEXIMAGE3DPROC gl_loader_glTexImage3D;
+extern PFNGLTEXPARAMETERIPROC gl_loader_glTexParameteri;
+extern PFNGLTEXSUBIMAGE2DPROC gl_loader_glTexSubImage2D;
+extern PFNGLTEXSUBIMAGE3DPROC gl_loader_glTexSubImage3D;
+extern PFNGLUNIFORM1FPROC gl_loader_glUniform1f;
+extern PFNGLUNIFORM1IPROC gl_loader_glUniform1i;
+extern PFNGLUNIFORM1UIPROC gl_loader_glUniform1ui;
+extern PFNGLUNIFORM2FPROC gl_loader_glUniform2f;
+extern PFNGLUNIFORM2IPROC gl_loader_glUniform2i;
+extern PFNGLUNIFORM3FVPROC gl_loader_glUniform3fv;
+extern PFNGLUNIFORM3IPROC gl_loader_glUniform3i;
+extern PFNGLUNIFORM4FVPROC gl_loader_glUniform4fv;
+extern PFNGLUNIFORMBLOCKBINDINGPROC gl_loader_glUniformBlockBinding;
+extern PFNGLUNIFORMMATRIX4FVPROC gl_loader_glUniformMatrix4fv;
+extern PFNGLUNMAPBUFFERPROC gl_loader_glUnmapBuffer;
+extern PFNGLUSEPROGRAMPROC gl_loader_glUseProgram;
+extern PFNGLVERTEXATTRIBDIVISORPROC gl_loader_glVertexAttribDivisor;
+extern PFNGLVERTEXATTRIBIPOINTERPROC gl_loader_glVertexAttribIPointer;
+extern PFNGLVERTEXATTRIBPOINTERPROC gl_loader_glVertexAttribPointer;
+extern PFNGLVIEWPORTPROC gl_loader_glViewport;
+extern PFNGLBINDIMAGETEXTUREPROC gl_loader_glBindImageTexture;
+extern PFNGLBUFFERSTORAGEPROC gl_loader_glBufferStorage;
+extern PFNGLDEBUGMESSAGECALLBACKPROC gl_loader_glDebugMessageCallback;
+extern PFNGLDISPATCHCOMPUTEPROC gl_loader_glDispatchCompute;
+extern PFNGLMEMORYBARRIERPROC gl_loader_glMemoryBarrier;
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC gl_loader_glMultiDrawElementsIndirect;
+extern PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC gl_loader_glMultiDrawElementsIndirectCount;
+
+#define glActiveTexture gl_loader_glActiveTexture
+#define glAttachShader gl_loader_glAttachShader
+#define glBeginQuery gl_loader_glBeginQuery
+#define glBindBuffer gl_loader_glBindBuffer
+#define glBindBufferBase gl_loader_glBindBufferBase
+#define glBindBufferRange gl_loader_glBindBufferRange
+#define glBindFramebuffer gl_loader_glBindFramebuffer
+#define glBindRenderbuffer gl_loader_glBindRenderbuffer
+#define glBindTexture gl_loader_glBindTexture
+#define glBindVertexArray gl_loader_glBindVertexArray
+#define glBlendFunc gl_loader_glBlendFunc
+#define glBlitFramebuffer gl_loader_glBlitFramebuffer
+#define glBufferData gl_loader_glBufferData
+#define glBufferSubData gl_loader_glBufferSubData
+#define glCheckFramebufferStatus gl_loader_glCheckFramebufferStatus
+#define glClear gl_loader_glClear
+#define glClearColor gl_loader_glClearColor
+#define glClientWaitSync gl_loader_glClientWaitSync
+#define glCompileShader gl_loader_glCompileShader
+#define glCreateProgram gl_loader_glCreateProgram
+#define glCreateShader gl_loader_glCreateShader
+#define glDeleteBuffers gl_loader_glDeleteBuffers
+#define glDeleteFramebuffers gl_loader_glDeleteFramebuffers
+#define glDeleteProgram gl_loader_glDeleteProgram
+#define glDeleteQueries gl_loader_glDeleteQueries
+#define glDeleteRenderbuffers gl_loader_glDeleteRenderbuffers
+#define glDeleteShader gl_loader_glDeleteShader
+#define glDeleteSync gl_loader_glDeleteSync
+#define glDeleteTextures gl_loader_glDeleteTextures
+#define glDeleteVertexArrays gl_loader_glDeleteVertexArrays
+#define glDisable gl_loader_glDisable
+#define glDrawArrays gl_loader_glDrawArrays
+#define glDrawArraysInstanced gl_loader_glDrawArraysInstanced
+#define glDrawBuffer gl_loader_glDrawBuffer
+#define glDrawBuffers gl_loader_glDrawBuffers
+#define glDrawElements gl_loader_glDrawElements
+#define glDrawElementsInstanced gl_loader_glDrawElementsInstanced
+#define glEnable gl_loader_glEnable
+#define glEnableVertexAttribArray gl_loader_glEnableVertexAttribArray
+#define glEndQuery gl_loader_glEndQuery
+#define glFenceSync gl_loader_glFenceSync
+#define glFinish gl_loader_glFinish
+#define glFlush gl_loader_glFlush
+#define glFramebufferRenderbuffer gl_loader_glFramebufferRenderbuffer
+#define glFramebufferTexture2D gl_loader_glFramebufferTexture2D
+#define glFramebufferTextureLayer gl_loader_glFramebufferTextureLayer
+#define glGenBuffers gl_loader_glGenBuffers
+#define glGenFramebuffers gl_loader_glGenFramebuffers
+#define glGenQueries gl_loader_glGenQueries
+#define glGenRenderbuffers gl_loader_glGenRenderbuffers
+#define glGenTextures gl_loader_glGenTextures
+#define glGenVertexArrays gl_loader_glGenVertexArrays
+#define glGenerateMipmap gl_loader_glGenerateMipmap
+#define glGetBufferSubData gl_loader_glGetBufferSubData
+#define glGetIntegerv gl_loader_glGetIntegerv
+#define glGetProgramInfoLog gl_loader_glGetProgramInfoLog
+#define glGetProgramiv gl_loader_glGetProgramiv
+#define glGetQueryObjectui64v gl_loader_glGetQueryObjectui64v
+#define glGetShaderInfoLog gl_loader_glGetShaderInfoLog
+#define glGetShaderiv gl_loader_glGetShaderiv
+#define glGetString gl_loader_glGetString
+#define glGetStringi gl_loader_glGetStringi
+#define glGetUniformBlockIndex gl_loader_glGetUniformBlockIndex
+#define glGetUniformLocation gl_loader_glGetUniformLocation
+#define glLinkProgram gl_loader_glLinkProgram
+#define glMapBufferRange gl_loader_glMapBufferRange
+#define glPixelStorei gl_loader_glPixelStorei
+#define glPolygonOffset gl_loader_glPolygonOffset
+#define glReadBuffer gl_loader_glReadBuffer
+#define glReadPixels gl_loader_glReadPixels
+#define glRenderbufferStorage gl_loader_glRenderbufferStorage
+#define glScissor gl_loader_glScissor
+#define glShaderSource gl_loader_glShaderSource
+#define glTexBuffer gl_loader_glTexBuffer
+#define glTexImage2D gl_loader_glTexImage2D
+#define glTexImage3D gl_loader_glTexImage3D
+#define glTexParameteri gl_loader_glTexParameteri
+#define glTexSubImage2D gl_loader_glTexSubImage2D
+#define glTexSubImage3D gl_loader_glTexSubImage3D
+#define glUniform1f gl_loader_glUniform1f
+#define glUniform1i gl_loader_glUniform1i
+#define glUniform1ui gl_loader_glUniform1ui
+#define glUniform2f gl_loader_glUniform2f
+#define glUniform2i gl_loader_glUniform2i
+#define glUniform3fv gl_loader_glUniform3fv
+#define glUniform3i gl_loader_glUniform3i
+#define glUniform4fv gl_loader_glUniform4fv
+#define glUniformBlockBinding gl_loader_glUniformBlockBinding
+#define glUniformMatrix4fv gl_loader_glUniformMatrix4fv
+#define glUnmapBuffer gl_loader_glUnmapBuffer
+#define glUseProgram gl_loader_glUseProgram
+#define glVertexAttribDivisor gl_loader_glVertexAttribDivisor
+#define glVertexAttribIPointer gl_loader_glVertexAttribIPointer
+#define glVertexAttribPointer gl_loader_glVertexAttribPointer
+#define glViewport gl_loader_glViewport
+#define glBindImageTexture gl_loader_glBindImageTexture
+#define glBufferStorage gl_loader_glBufferStorage
+#define glDebugMessageCallback gl_loader_glDebugMessageCallback
+#define glDispatchCompute gl_loader_glDispatchCompute
+#define glMemoryBarrier gl_loader_glMemoryBarrier
+#define glMultiDrawElementsIndirect gl_loader_glMultiDrawElementsIndirect
+#define glMultiDrawElementsIndirectCount gl_loader_glMultiDrawElementsIndirectCount
+
+// X(return type, name, (parameters), (arguments)) for every function, for code that wraps them all
+#define GL_LOADER_FUNCTIONS(X) \
+	X(void, glActiveTexture, (GLenum texture), (texture)) \
+	X(void, glAttachShader, (GLuint program, GLuint shader), (program, shader)) \
+	X(void, glBeginQuery, (GLenum target, GLuint id), (target, id)) \
+	X(void, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer)) \
+	X(void, glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer)) \
+	X(void, glBindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size)) \
+	X(void, glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer)) \
+	X(void, glBindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer)) \
+	X(void, glBindTexture, (GLenum target, GLuint texture), (target, texture)) \
+	X(void, glBindVertexArray, (GLuint array), (array)) \
+	X(void, glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor)) \
+	X(void, glBlitFramebuffer, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter), (srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter)) \
+	X(void, glBufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage)) \
+	X(void, glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data)) \
+	X(GLenum, glCheckFramebufferStatus, (GLenum target), (target)) \
+	X(void, glClear, (GLbitfield mask), (mask)) \
+	X(void, glClearColor, (GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha), (red, green, blue, alpha)) \
+	X(GLenum, glClientWaitSync, (GLsync GLsync,GLbitfield flags,GLuint64 timeout), (GLsync, flags, timeout)) \
+	X(void, glCompileShader, (GLuint shader), (shader)) \
+	X(GLuint, glCreateProgram, (void), ()) \
+	X(GLuint, glCreateShader, (GLenum type), (type)) \
+	X(void, glDeleteBuffers, (GLsizei n, const GLuint* buffers), (n, buffers)) \
+	X(void, glDeleteFramebuffers, (GLsizei n, const GLuint* framebuffers), (n, framebuffers)) \
+	X(void, glDeleteProgram, (GLuint program), (program)) \
+	X(void, glDeleteQueries, (GLsizei n, const GLuint* ids), (n, ids)) \
+	X(void, glDeleteRenderbuffers, (GLsizei n, const GLuint* renderbuffers), (n, renderbuffers)) \
+	X(void, glDeleteShader, (GLuint shader), (shader)) \
+	X(void, glDeleteSync, (GLsync GLsync), (GLsync)) \
+	X(void, glDeleteTextures, (GLsizei n, const GLuint *textures), (n, textures)) \
+	X(void, glDeleteVertexArrays, (GLsizei n, const GLuint* arrays), (n, arrays)) \
+	X(void, glDisable, (GLenum cap), (cap)) \
+	X(void, glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+	X(void, glDrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei primcount), (mode, first, count, primcount)) \
+	X(void, glDrawBuffer, (GLenum mode), (mode)) \
+	X(void, glDrawBuffers, (GLsizei n, const GLenum* bufs), (n, bufs)) \
+	X(void, glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices), (mode, count, type, indices)) \
+	X(void, glDrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei primcount), (mode, count, type, indices, primcount)) \
+	X(void, glEnable, (GLenum cap), (cap)) \
+	X(void, glEnableVertexAttribArray, (GLuint index), (index)) \
+	X(void, glEndQuery, (GLenum target), (target)) \
+	X(GLsync, glFenceSync, (GLenum condition,GLbitfield flags), (condition, flags)) \
+	X(void, glFinish, (void), ()) \
+	X(void, glFlush, (void), ()) \
+	X(void, glFramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer)) \
+	X(void, glFramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level)) \
+	X(void, glFramebufferTextureLayer, (GLenum target,GLenum attachment, GLuint texture,GLint level,GLint layer), (target, attachment, texture, level, layer)) \
+	X(void, glGenBuffers, (GLsizei n, GLuint* buffers), (n, buffers)) \
+	X(void, glGenFramebuffers, (GLsizei n, GLuint* framebuffers), (n, framebuffers)) \
+	X(void, glGenQueries, (GLsizei n, GLuint* ids), (n, ids)) \
+	X(void, glGenRenderbuffers, (GLsizei n, GLuint* renderbuffers), (n, renderbuffers)) \
+	X(void, glGenTextures, (GLsizei n, GLuint *textures), (n, textures)) \
+	X(void, glGenVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays)) \
+	X(void, glGenerateMipmap, (GLenum target), (target)) \
+	X(void, glGetBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, void* data), (target, offset, size, data)) \
+	X(void, glGetIntegerv, (GLenum pname, GLint *params), (pname, params)) \
+	X(void, glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (program, bufSize, length, infoLog)) \
+	X(void, glGetProgramiv, (GLuint program, GLenum pname, GLint* param), (program, pname, param)) \
+	X(void, glGetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64* params), (id, pname, params)) \
+	X(void, glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (shader, bufSize, length, infoLog)) \
+	X(void, glGetShaderiv, (GLuint shader, GLenum pname, GLint* param), (shader, pname, param)) \
+	X(const GLubyte *, glGetString, (GLenum name), (name)) \
+	X(const GLubyte*, glGetStringi, (GLenum name, GLuint index), (name, index)) \
+	X(GLuint, glGetUniformBlockIndex, (GLuint program, const GLchar* uniformBlockName), (program, uniformBlockName)) \
+	X(GLint, glGetUniformLocation, (GLuint program, const GLchar* name), (program, name)) \
+	X(void, glLinkProgram, (GLuint program), (program)) \
+	X(void *, glMapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access)) \
+	X(void, glPixelStorei, (GLenum pname, GLint param), (pname, param)) \
+	X(void, glPolygonOffset, (GLfloat factor, GLfloat units), (factor, units)) \
+	X(void, glReadBuffer, (GLenum mode), (mode)) \
+	X(void, glReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels), (x, y, width, height, format, type, pixels)) \
+	X(void, glRenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height)) \
+	X(void, glScissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height)) \
+	X(void, glShaderSource, (GLuint shader, GLsizei count, const GLchar *const* string, const GLint* length), (shader, count, string, length)) \
+	X(void, glTexBuffer, (GLenum target, GLenum internalFormat, GLuint buffer), (target, internalFormat, buffer)) \
+	X(void, glTexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalformat, width, height, border, format, type, pixels)) \
+	X(void, glTexImage3D, (GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalFormat, width, height, depth, border, format, type, pixels)) \
+	X(void, glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param)) \
+	X(void, glTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels)) \
+	X(void, glTexSubImage3D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels)) \
+	X(void, glUniform1f, (GLint location, GLfloat v0), (location, v0)) \
+	X(void, glUniform1i, (GLint location, GLint v0), (location, v0)) \
+	X(void, glUniform1ui, (GLint location, GLuint v0), (location, v0)) \
+	X(void, glUniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1)) \
+	X(void, glUniform2i, (GLint location, GLint v0, GLint v1), (location, v0, v1)) \
+	X(void, glUniform3fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value)) \
+	X(void, glUniform3i, (GLint location, GLint v0, GLint v1, GLint v2), (location, v0, v1, v2)) \
+	X(void, glUniform4fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value)) \
+	X(void, glUniformBlockBinding, (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding), (program, uniformBlockIndex, uniformBlockBinding)) \
+	X(void, glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value)) \
+	X(GLboolean, glUnmapBuffer, (GLenum target), (target)) \
+	X(void, glUseProgram, (GLuint program), (program)) \
+	X(void, glVertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor)) \
+	X(void, glVertexAttribIPointer, (GLuint index, GLint size, GLenum type, GLsizei stride, const void*pointer), (index, size, type, stride, pointer)) \
+	X(void, glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer), (index, size, type, normalized, stride, pointer)) \
+	X(void, glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height)) \
+	X(void, glBindImageTexture, (GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format), (unit, texture, level, layered, layer, access, format)) \
+	X(void, glBufferStorage, (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags), (target, size, data, flags)) \
+	X(void, glDebugMessageCallback, (GLDEBUGPROC callback, const void *userParam), (callback, userParam)) \
+	X(void, glDispatchCompute, (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z), (num_groups_x, num_groups_y, num_groups_z)) \
+	X(void, glMemoryBarrier, (GLbitfield barriers), (barriers)) \
+	X(void, glMultiDrawElementsIndirect, (GLenum mode, GLenum type, const void *indirect, GLsizei primcount, GLsizei stride), (mode, type, indirect, primcount, stride)) \
+	X(void, glMultiDrawElementsIndirectCount, (GLenum mode, GLenum type, const GLvoid *indirect, GLintptr drawcount, GLsizei maxdrawcount, GLsizei stride), (mode, type, indirect, drawcount, maxdrawcount, stride))
+
+typedef void (*gl_loader_proc)();
+typedef gl_loader_proc (*gl_loader_get_proc)(const char* name);
+
+// resolves every function that is not lazy; false if one of them is missing
+bool gl_loader_init(gl_loader_get_proc get_proc);
+int gl_loader_function_count();
+// resolves a lazy function now; false if the driver does not provide it
+bool gl_loader_load(const char* name);
+bool gl_loader_has_version(int major, int minor);
+bool gl_loader_has_extension(const char* name);
+
@@ -0,0 +1,278 @@
+#include "gl_recorder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "gl_api.h"
+#include "gl_trace.h"
+#include "log.h"
+
+using namespace std;
+
+#if USE_GLEW
+
+bool gl_recorder_start(const string& path, int width, int height) {
+	log("GL recording needs the generated loader, rebuild without UseGlew");
+	return false;
+}
+
+void gl_recorder_frame() {
+}
+
+bool gl_recorder_stop() {
+	return true;
+}
+
+bool gl_recorder_active() {
+	return false;
+}
+
+#else
+
+static FILE* trace_file = nullptr;
+static string trace_path;
+static vector<uint8_t> pending;
+static chrono::steady_clock::time_point trace_start;
+
+static void flush_pending() {
+	if (!pending.empty()) {
+		fwrite(pending.data(), 1, pending.size(), trace_file);
+		pending.clear();
+	}
+}
+
+static void write_bytes(const void* data, const size_t size) {
+	const auto* bytes = static_cast<const uint8_t*>(data);
+	pending.insert(pending.end(), bytes, bytes + size);
+	if (pending.size() > (1 << 20)) {
+		flush_pending();
+	}
+}
+
+template <typename T>
+static void write(const T value) {
+	write_bytes(&value, sizeof(T));
+}
+
+static void write_payload(const void* data, const size_t size) {
+	write(static_cast<uint32_t>(size));
+	write_bytes(data, size);
+}
+
+static void write_names(const GLsizei n, const GLuint* names) {
+	write(static_cast<uint32_t>(n));
+	write_bytes(names, n * sizeof(GLuint));
+}
+
+// every hook calls the function the loader had before gl_recorder_start(), then records the call
+#define RECORD(name, params, args, body) \
+	static decltype(gl_loader_##name) real_##name = nullptr; \
+	static void GL_LOADER_APIENTRY record_##name params { \
+		real_##name args; \
+		body \
+	}
+
+RECORD(glClearColor, (GLfloat r, GLfloat g, GLfloat b, GLfloat a), (r, g, b, a), {
+	write(trace_clear_color); write(r); write(g); write(b); write(a);
+})
+RECORD(glClear, (GLbitfield mask), (mask), {
+	write(trace_clear); write<uint32_t>(mask);
+})
+RECORD(glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), {
+	write(trace_viewport); write<int32_t>(x); write<int32_t>(y); write<int32_t>(width); write<int32_t>(height);
+})
+RECORD(glEnable, (GLenum cap), (cap), {
+	write(trace_enable); write<uint32_t>(cap);
+})
+RECORD(glDisable, (GLenum cap), (cap), {
+	write(trace_disable); write<uint32_t>(cap);
+})
+
+static decltype(gl_loader_glCreateShader) real_glCreateShader = nullptr;
+static GLuint GL_LOADER_APIENTRY record_glCreateShader(const GLenum type) {
+	const GLuint shader = real_glCreateShader(type);
+	write(trace_create_shader); write<uint32_t>(type); write<uint32_t>(shader);
+	return shader;
+}
+
+RECORD(glShaderSource, (GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths),
+	(shader, count, strings, lengths), {
+	write(trace_shader_source); write<uint32_t>(shader); write<uint32_t>(count);
+	for (GLsizei i = 0; i < count; i++) {
+		const bool terminated = lengths == nullptr || lengths[i] < 0;
+		write_payload(strings[i], terminated ? strlen(strings[i]) : lengths[i]);
+	}
+})
+RECORD(glCompileShader, (GLuint shader), (shader), {
+	write(trace_compile_shader); write<uint32_t>(shader);
+})
+RECORD(glDeleteShader, (GLuint shader), (shader), {
+	write(trace_delete_shader); write<uint32_t>(shader);
+})
+
+static decltype(gl_loader_glCreateProgram) real_glCreateProgram = nullptr;
+static GLuint GL_LOADER_APIENTRY record_glCreateProgram() {
+	const GLuint program = real_glCreateProgram();
+	write(trace_create_program); write<uint32_t>(program);
+	return program;
+}
+
+RECORD(glAttachShader, (GLuint program, GLuint shader), (program, shader), {
+	write(trace_attach_shader); write<uint32_t>(program); write<uint32_t>(shader);
+})
+RECORD(glLinkProgram, (GLuint program), (program), {
+	write(trace_link_program); write<uint32_t>(program);
+})
+RECORD(glUseProgram, (GLuint program), (program), {
+	write(trace_use_program); write<uint32_t>(program);
+})
+RECORD(glGenBuffers, (GLsizei n, GLuint* buffers), (n, buffers), {
+	write(trace_gen_buffers); write_names(n, buffers);
+})
+RECORD(glBindBuffer, (GLenum target, GLuint buffer), (target, buffer), {
+	write(trace_bind_buffer); write<uint32_t>(target); write<uint32_t>(buffer);
+})
+RECORD(glBufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage), {
+	write(trace_buffer_data); write<uint32_t>(target); write<uint32_t>(usage); write<uint64_t>(size);
+	write_payload(data, data != nullptr ? size : 0);
+})
+RECORD(glGenVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays), {
+	write(trace_gen_vertex_arrays); write_names(n, arrays);
+})
+RECORD(glBindVertexArray, (GLuint array), (array), {
+	write(trace_bind_vertex_array); write<uint32_t>(array);
+})
+RECORD(glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer),
+	(index, size, type, normalized, stride, pointer), {
+	write(trace_vertex_attrib_pointer); write<uint32_t>(index); write<int32_t>(size); write<uint32_t>(type);
+	write<uint8_t>(normalized); write<int32_t>(stride); write<uint64_t>(reinterpret_cast<uintptr_t>(pointer));
+})
+RECORD(glEnableVertexAttribArray, (GLuint index), (index), {
+	write(trace_enable_vertex_attrib_array); write<uint32_t>(index);
+})
+RECORD(glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count), {
+	write(trace_draw_arrays); write<uint32_t>(mode); write<int32_t>(first); write<int32_t>(count);
+})
+RECORD(glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices), {
+	write(trace_draw_elements); write<uint32_t>(mode); write<int32_t>(count); write<uint32_t>(type);
+	write<uint64_t>(reinterpret_cast<uintptr_t>(indices));
+})
+
+// calls that change nothing a replay draws: queries, timers, fences and debug output
+static bool replay_neutral(const char* name) {
+	static const char* const neutral[] = {
+		"glBeginQuery", "glCheckFramebufferStatus", "glClientWaitSync", "glDebugMessageCallback", "glDeleteQueries",
+		"glDeleteSync", "glEndQuery", "glFenceSync", "glFinish", "glFlush", "glGenQueries", "glQueryCounter",
+	};
+	if (strncmp(name, "glGet", 5) == 0 || strncmp(name, "glIs", 4) == 0) {
+		return true;
+	}
+	for (const char* neutral_name : neutral) {
+		if (strcmp(name, neutral_name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// the first call the trace misses, the trace is thrown away at the end
+static const char* unrecorded = nullptr;
+
+static void note_unrecorded(const char* name) {
+	if (unrecorded == nullptr) {
+		unrecorded = name;
+		log(string("GL recording can't capture ") + name + ", the trace would replay wrong");
+	}
+}
+
+// every loader function the hooks above don't serialize goes through one of these, so an option
+// that draws with more than the recorder knows is caught by the calls it makes
+#define PASS(ret, name, params, args) \
+	static decltype(gl_loader_##name) original_##name = nullptr; \
+	static decltype(gl_loader_##name) installed_##name = nullptr; \
+	static ret GL_LOADER_APIENTRY pass_##name params { \
+		note_unrecorded(#name); \
+		return original_##name args; \
+	}
+
+GL_LOADER_FUNCTIONS(PASS)
+
+#define INSTALL_PASS(ret, name, params, args) \
+	original_##name = gl_loader_##name; \
+	if (gl_loader_##name != nullptr && !replay_neutral(#name)) { \
+		gl_loader_##name = pass_##name; \
+	} \
+	installed_##name = gl_loader_##name;
+// a function resolved while recording (a lazy one) replaced what was installed and went unseen
+#define REMOVE_PASS(ret, name, params, args) \
+	if (gl_loader_##name == installed_##name) { \
+		gl_loader_##name = original_##name; \
+	} \
+	else if (!replay_neutral(#name)) { \
+		note_unrecorded(#name); \
+	}
+#define HOOK(name) real_##name = original_##name; gl_loader_##name = record_##name; installed_##name = record_##name
+
+bool gl_recorder_start(const string& path, const int width, const int height) {
+	trace_path = path;
+	trace_file = fopen(path.c_str(), "wb");
+	if (trace_file == nullptr) {
+		log("Failed to open GL trace " + path);
+		return false;
+	}
+
+	gl_trace_header header;
+	memcpy(header.magic, gl_trace_magic, sizeof(header.magic));
+	header.version = gl_trace_version;
+	header.width = width;
+	header.height = height;
+	fwrite(&header, sizeof(header), 1, trace_file);
+
+	unrecorded = nullptr;
+	GL_LOADER_FUNCTIONS(INSTALL_PASS)
+	HOOK(glClearColor); HOOK(glClear); HOOK(glViewport); HOOK(glEnable); HOOK(glDisable);
+	HOOK(glCreateShader); HOOK(glShaderSource); HOOK(glCompileShader); HOOK(glDeleteShader);
+	HOOK(glCreateProgram); HOOK(glAttachShader); HOOK(glLinkProgram); HOOK(glUseProgram);
+	HOOK(glGenBuffers); HOOK(glBindBuffer); HOOK(glBufferData);
+	HOOK(glGenVertexArrays); HOOK(glBindVertexArray); HOOK(glVertexAttribPointer); HOOK(glEnableVertexAttribArray);
+	HOOK(glDrawArrays); HOOK(glDrawElements);
+
+	trace_start = chrono::steady_clock::now();
+	log("Recording GL calls to " + path);
+	return true;
+}
+
+void gl_recorder_frame() {
+	if (trace_file == nullptr) {
+		return;
+	}
+	write(trace_frame_end);
+	write<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - trace_start).count());
+}
+
+bool gl_recorder_stop() {
+	if (trace_file == nullptr) {
+		return true;
+	}
+
+	GL_LOADER_FUNCTIONS(REMOVE_PASS)
+
+	flush_pending();
+	fclose(trace_file);
+	trace_file = nullptr;
+	if (unrecorded != nullptr) {
+		remove(trace_path.c_str());
+		log("GL recording discarded, " + string(unrecorded) + " is not in the trace format");
+		return false;
+	}
+	log("GL recording stopped");
+	return true;
+}
+
+bool gl_recorder_active() {
+	return trace_file != nullptr;
+}
+
+#endif
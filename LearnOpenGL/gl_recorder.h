@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+// records the GL calls the application makes into a gl_trace.h file for GLReplay;
+// works by swapping the gl_loader function pointers, so it is not available with USE_GLEW. only the
+// calls the plain quad makes are recorded; any other loader function that changes what is drawn is
+// passed through and noted, and the trace is discarded when one was called
+bool gl_recorder_start(const std::string& path, int width, int height);
+// frame boundary, call after glfwSwapBuffers
+void gl_recorder_frame();
+// false if the trace was discarded
+bool gl_recorder_stop();
+bool gl_recorder_active();
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+// binary GL trace written by gl_recorder and read by GLReplay
+//
+// file:    gl_trace_header, then commands until the end of the file
+// command: uint8 opcode followed by its arguments, little endian, no padding;
+//          object names are the ones the recording context returned and get remapped on replay,
+//          payloads (buffer data, shader sources) are uint32 size + bytes
+
+const char gl_trace_magic[4] = { 'G', 'L', 'T', 'R' };
+const uint32_t gl_trace_version = 1;
+
+struct gl_trace_header {
+	char magic[4];
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+};
+
+enum gl_trace_opcode : uint8_t {
+	// uint64 ns since gl_recorder_start(); everything before the first one is setup
+	trace_frame_end = 1,
+
+	trace_clear_color,              // float r, g, b, a
+	trace_clear,                    // uint32 mask
+	trace_viewport,                 // int32 x, y, width, height
+	trace_enable,                   // uint32 cap
+	trace_disable,                  // uint32 cap
+
+	trace_create_shader,            // uint32 type, uint32 shader
+	trace_shader_source,            // uint32 shader, uint32 count, count * payload
+	trace_compile_shader,           // uint32 shader
+	trace_delete_shader,            // uint32 shader
+	trace_create_program,           // uint32 program
+	trace_attach_shader,            // uint32 program, uint32 shader
+	trace_link_program,             // uint32 program
+	trace_use_program,              // uint32 program
+
+	trace_gen_buffers,              // uint32 n, n * uint32 buffer
+	trace_bind_buffer,              // uint32 target, uint32 buffer
+	trace_buffer_data,              // uint32 target, uint32 usage, uint64 size, payload (size 0 - no data)
+	trace_gen_vertex_arrays,        // uint32 n, n * uint32 array
+	trace_bind_vertex_array,        // uint32 array
+	trace_vertex_attrib_pointer,    // uint32 index, int32 size, uint32 type, uint8 normalized, int32 stride, uint64 offset
+	trace_enable_vertex_attrib_array, // uint32 index
+
+	trace_draw_arrays,              // uint32 mode, int32 first, int32 count
+	trace_draw_elements,            // uint32 mode, int32 count, uint32 type, uint64 offset
+};
@@ -0,0 +1,25 @@
+#include "glew_baseline.h"
+
+#include "log.h"
+#include "profiler.h"
+
+// GLEW's own header, not gl_api.h: in a loader build the two declare the same GL names
+#if !USE_GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+#endif
+
+bool glew_baseline_init() {
+	#if USE_GLEW
+	log("GLEW baseline: this build already loads GL through GLEW");
+	return false;
+	#else
+	profile_scope zone("glew_init");
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK) {
+		log("GLEW baseline: glewInit failed");
+		return false;
+	}
+	return true;
+	#endif
+}
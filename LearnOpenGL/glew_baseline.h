@@ -0,0 +1,6 @@
+#pragma once
+
+// glewInit() in a loader build, timed as the glew_init phase of the startup report so the two can
+// be compared in one process; needs a current context. it runs after gl_loader_init, when the
+// driver has already answered the loader's lookups, so GLEW's number is if anything flattering
+bool glew_baseline_init();
@@ -0,0 +1,313 @@
+#include "glyph_atlas.h"
+
+#include <algorithm>
+
+#include "gpu_resources.h"
+
+using namespace std;
+
+// cleared texels around every bitmap, so filtering at its edge never reads a neighbour or
+// whatever an evicted glyph left behind
+static const int padding = 1;
+// shelf heights are rounded up to this so glyphs of similar heights share shelves
+static const int shelf_granularity = 4;
+
+glyph_atlas::~glyph_atlas() {
+	release();
+}
+
+bool glyph_atlas::init(const int size, const uint32_t max_keys) {
+	release();
+	atlas_size = size;
+	gpu_category_scope category(gpu_category::texture);
+	const vector<uint8_t> cleared(static_cast<size_t>(size) * size, 0);
+	glGenTextures(1, &atlas_texture);
+	glBindTexture(GL_TEXTURE_2D, atlas_texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, size, size, 0, GL_RED, GL_UNSIGNED_BYTE, cleared.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	key_slots.assign(max_keys, -1);
+	return true;
+}
+
+void glyph_atlas::release() {
+	if (atlas_texture != 0) {
+		glDeleteTextures(1, &atlas_texture);
+		atlas_texture = 0;
+	}
+	next_shelf_y = 0;
+	shelves.clear();
+	slots.clear();
+	free_slots.clear();
+	key_slots.clear();
+	newest = oldest = -1;
+	resident_count = 0;
+	counters = glyph_atlas_stats();
+}
+
+int glyph_atlas::find(const uint32_t key) {
+	const int index = key < key_slots.size() ? key_slots[key] : -1;
+	if (index >= 0) {
+		slots[index].used_frame = frame;
+		if (index != newest) {
+			unlink(index);
+			link_newest(index);
+		}
+	}
+	return index;
+}
+
+int glyph_atlas::insert(const uint32_t key, const int width, const int height, const uint8_t* pixels) {
+	const int outer_width = width + 2 * padding, outer_height = height + 2 * padding;
+	if (key >= key_slots.size() || outer_width > atlas_size || outer_height > atlas_size) {
+		counters.full++;
+		return -1;
+	}
+	atlas_rect outer;
+	int shelf_index = -1;
+	bool placed = allocate(outer_width, outer_height, outer, shelf_index);
+	if (!placed && fits_after_eviction(outer_width, outer_height)) {
+		while (!placed && oldest >= 0 && slots[oldest].used_frame != frame) {
+			evict(oldest);
+			placed = allocate(outer_width, outer_height, outer, shelf_index);
+		}
+	}
+	if (!placed) {
+		counters.full++;
+		return -1;
+	}
+
+	upload.assign(static_cast<size_t>(outer_width) * outer_height, 0);
+	for (int row = 0; row < height; row++) {
+		copy(pixels + row * width, pixels + (row + 1) * width, &upload[(row + padding) * outer_width + padding]);
+	}
+	glBindTexture(GL_TEXTURE_2D, atlas_texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, outer.x, outer.y, outer_width, outer_height, GL_RED, GL_UNSIGNED_BYTE, upload.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	int index = 0;
+	if (free_slots.empty()) {
+		index = static_cast<int>(slots.size());
+		slots.emplace_back();
+	}
+	else {
+		index = free_slots.back();
+		free_slots.pop_back();
+	}
+	slot& inserted = slots[index];
+	inserted.key = key;
+	inserted.rect.x = outer.x + padding;
+	inserted.rect.y = outer.y + padding;
+	inserted.rect.width = width;
+	inserted.rect.height = height;
+	inserted.shelf = shelf_index;
+	inserted.used_frame = frame;
+	link_newest(index);
+	key_slots[key] = index;
+	resident_count++;
+	counters.inserted++;
+	return index;
+}
+
+bool glyph_atlas::allocate(const int width, const int height, atlas_rect& rect, int& shelf_index) {
+	// the lowest shelf the bitmap fits on; one much taller than the bitmap only when nothing lives there
+	const int shelf_height = (height + shelf_granularity - 1) / shelf_granularity * shelf_granularity;
+	const int tallest_shared = height + height / 2 + shelf_granularity;
+	int best = -1;
+	for (size_t i = 0; i < shelves.size(); i++) {
+		const shelf& candidate = shelves[i];
+		if (candidate.height < height || (!empty(candidate) && candidate.height > tallest_shared)
+			|| (best >= 0 && shelves[best].height <= candidate.height)) {
+			continue;
+		}
+		for (const span& free : candidate.free) {
+			if (free.width >= width) {
+				best = static_cast<int>(i);
+				break;
+			}
+		}
+	}
+
+	if (best >= 0 && empty(shelves[best]) && shelves[best].height > tallest_shared) {
+		// cut down to the bitmap, the rows left over stay an empty shelf of their own
+		shelf& cut = shelves[best];
+		const shelf rest = { cut.y + shelf_height, cut.height - shelf_height, cut.free };
+		cut.height = shelf_height;
+		shelves.insert(shelves.begin() + best + 1, rest);
+		shift_shelves(best + 1, 1);
+	}
+
+	if (best < 0) {
+		if (next_shelf_y + shelf_height > atlas_size) {
+			return false;
+		}
+		shelf added;
+		added.y = next_shelf_y;
+		added.height = shelf_height;
+		const span rest = { 0, atlas_size };
+		added.free.push_back(rest);
+		shelves.push_back(added);
+		next_shelf_y += shelf_height;
+		best = static_cast<int>(shelves.size()) - 1;
+	}
+
+	shelf& chosen = shelves[best];
+	for (size_t i = 0; i < chosen.free.size(); i++) {
+		span& free = chosen.free[i];
+		if (free.width >= width) {
+			rect.x = free.x;
+			rect.y = chosen.y;
+			rect.width = width;
+			rect.height = height;
+			free.x += width;
+			free.width -= width;
+			if (free.width == 0) {
+				chosen.free.erase(chosen.free.begin() + i);
+			}
+			shelf_index = best;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool glyph_atlas::fits_after_eviction(const int width, const int height) {
+	const int shelf_height = (height + shelf_granularity - 1) / shelf_granularity * shelf_granularity;
+	const int tallest_shared = height + height / 2 + shelf_granularity;
+	// rows of shelves that only hold evictable glyphs, which merge into one shelf once emptied
+	int run_height = 0;
+	for (size_t i = 0; i < shelves.size(); i++) {
+		pinned.clear();
+		for (size_t index = 0; index < slots.size(); index++) {
+			const slot& candidate = slots[index];
+			const bool resident = key_slots[candidate.key] == static_cast<int>(index);
+			if (resident && candidate.shelf == static_cast<int>(i) && candidate.used_frame == frame) {
+				const span held = { candidate.rect.x - padding, candidate.rect.width + 2 * padding };
+				pinned.push_back(held);
+			}
+		}
+		if (pinned.empty()) {
+			run_height += shelves[i].height;
+			if (run_height >= shelf_height) {
+				return true;
+			}
+			continue;
+		}
+		run_height = 0;
+
+		if (shelves[i].height < height || shelves[i].height > tallest_shared) {
+			continue;
+		}
+		sort(pinned.begin(), pinned.end(), [](const span& a, const span& b) { return a.x < b.x; });
+		int x = 0;
+		for (const span& held : pinned) {
+			if (held.x - x >= width) {
+				return true;
+			}
+			x = held.x + held.width;
+		}
+		if (atlas_size - x >= width) {
+			return true;
+		}
+	}
+	// the empty shelves at the top give their rows back too
+	return run_height + atlas_size - next_shelf_y >= shelf_height;
+}
+
+bool glyph_atlas::empty(const shelf& candidate) const {
+	return candidate.free.size() == 1 && candidate.free[0].width == atlas_size;
+}
+
+void glyph_atlas::shift_shelves(const int first, const int delta) {
+	for (slot& moved : slots) {
+		if (moved.shelf >= first) {
+			moved.shelf += delta;
+		}
+	}
+}
+
+void glyph_atlas::free_space(const atlas_rect& rect, const int shelf_index) {
+	vector<span>& free = shelves[shelf_index].free;
+	const span freed = { rect.x, rect.width };
+	auto at = free.insert(lower_bound(free.begin(), free.end(), freed,
+		[](const span& a, const span& b) { return a.x < b.x; }), freed);
+	// merged with the neighbours it touches
+	if (at + 1 != free.end() && at->x + at->width == (at + 1)->x) {
+		at->width += (at + 1)->width;
+		free.erase(at + 1);
+	}
+	if (at != free.begin() && (at - 1)->x + (at - 1)->width == at->x) {
+		(at - 1)->width += at->width;
+		free.erase(at);
+	}
+}
+
+void glyph_atlas::unlink(const int index) {
+	const slot& unlinked = slots[index];
+	if (unlinked.newer >= 0) {
+		slots[unlinked.newer].older = unlinked.older;
+	}
+	else {
+		newest = unlinked.older;
+	}
+	if (unlinked.older >= 0) {
+		slots[unlinked.older].newer = unlinked.newer;
+	}
+	else {
+		oldest = unlinked.newer;
+	}
+}
+
+void glyph_atlas::link_newest(const int index) {
+	slots[index].newer = -1;
+	slots[index].older = newest;
+	if (newest >= 0) {
+		slots[newest].newer = index;
+	}
+	newest = index;
+	if (oldest < 0) {
+		oldest = index;
+	}
+}
+
+void glyph_atlas::evict(const int index) {
+	const slot& evicted = slots[index];
+	unlink(index);
+	atlas_rect outer = evicted.rect;
+	outer.x -= padding;
+	outer.y -= padding;
+	outer.width += 2 * padding;
+	outer.height += 2 * padding;
+	free_space(outer, evicted.shelf);
+	key_slots[evicted.key] = -1;
+	if (empty(shelves[evicted.shelf])) {
+		reclaim_shelf(evicted.shelf);
+	}
+	free_slots.push_back(index);
+	resident_count--;
+	counters.evicted++;
+}
+
+void glyph_atlas::reclaim_shelf(int shelf_index) {
+	// empty shelves never touch each other or the top, so there is at most one on either side
+	if (shelf_index + 1 < static_cast<int>(shelves.size()) && empty(shelves[shelf_index + 1])) {
+		shelves[shelf_index].height += shelves[shelf_index + 1].height;
+		shelves.erase(shelves.begin() + shelf_index + 1);
+		shift_shelves(shelf_index + 2, -1);
+	}
+	if (shelf_index > 0 && empty(shelves[shelf_index - 1])) {
+		shelves[shelf_index - 1].height += shelves[shelf_index].height;
+		shelves.erase(shelves.begin() + shelf_index);
+		shift_shelves(shelf_index + 1, -1);
+		shelf_index--;
+	}
+	if (shelf_index == static_cast<int>(shelves.size()) - 1) {
+		next_shelf_y = shelves[shelf_index].y;
+		shelves.pop_back();
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "gl_api.h"
+
+// one channel texture that glyph bitmaps are packed into on shelves: rows of one height that are
+// filled left to right, with the holes evicted glyphs leave reused. a shelf emptied by evictions
+// merges with the empty ones next to it, or gives its rows back at the top, and an empty shelf is
+// cut down to the height of the next bitmap placed on it. when a bitmap doesn't fit, the least
+// recently used glyphs are evicted until it does - unless even evicting all of them wouldn't make
+// room, then nothing is; glyphs used in the current frame stay
+
+struct atlas_rect {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+struct glyph_atlas_stats {
+	uint64_t inserted = 0;
+	uint64_t evicted = 0;
+	// inserts that failed even with everything evictable gone
+	uint64_t full = 0;
+};
+
+class glyph_atlas {
+public:
+	glyph_atlas() = default;
+	glyph_atlas(const glyph_atlas&) = delete;
+	glyph_atlas& operator=(const glyph_atlas&) = delete;
+	~glyph_atlas();
+
+	// keys are below max_keys, e.g. glyph indices
+	bool init(int size, uint32_t max_keys);
+	void release();
+
+	// the key's slot, or -1; a found key counts as used this frame
+	int find(uint32_t key);
+	// a slot for a width x height bitmap, used this frame; -1 when there is no room
+	int insert(uint32_t key, int width, int height, const uint8_t* pixels);
+	const atlas_rect& rect(int slot) const { return slots[slot].rect; }
+	// ends the frame, what it used becomes evictable
+	void next_frame() { frame++; }
+
+	GLuint texture() const { return atlas_texture; }
+	int size() const { return atlas_size; }
+	int resident() const { return resident_count; }
+	const glyph_atlas_stats& stats() const { return counters; }
+
+private:
+	struct span {
+		int x;
+		int width;
+	};
+	struct shelf {
+		int y;
+		int height;
+		// free parts, sorted by x
+		std::vector<span> free;
+	};
+	struct slot {
+		uint32_t key;
+		atlas_rect rect;
+		int shelf;
+		uint64_t used_frame;
+		// least recently used list, -1 at either end
+		int newer;
+		int older;
+	};
+
+	bool allocate(int width, int height, atlas_rect& rect, int& shelf_index);
+	// whether allocate() would succeed with every glyph not used this frame evicted
+	bool fits_after_eviction(int width, int height);
+	bool empty(const shelf& candidate) const;
+	// slots on shelves from first on move by delta, after shelves are inserted or erased before them
+	void shift_shelves(int first, int delta);
+	void free_space(const atlas_rect& rect, int shelf_index);
+	void reclaim_shelf(int shelf_index);
+	void unlink(int index);
+	void link_newest(int index);
+	void evict(int index);
+
+	GLuint atlas_texture = 0;
+	int atlas_size = 0;
+	int next_shelf_y = 0;
+	std::vector<shelf> shelves;
+	std::vector<slot> slots;
+	std::vector<int> free_slots;
+	std::vector<int> key_slots;
+	// a bitmap with its cleared border, as uploaded
+	std::vector<uint8_t> upload;
+	// fits_after_eviction(): the spans glyphs used this frame hold on one shelf
+	std::vector<span> pinned;
+	int newest = -1;
+	int oldest = -1;
+	int resident_count = 0;
+	uint64_t frame = 1;
+	glyph_atlas_stats counters;
+};
@@ -0,0 +1,226 @@
+#include "gpu_cull.h"
+
+#include <algorithm>
+
+#include "frustum_cull.h"
+#include "gpu_resources.h"
+#include "log.h"
+#include "shader.h"
+
+using namespace std;
+
+static const GLuint cull_group_size = 64;
+static const GLuint reduce_group_size = 8;
+static const int max_hiz_levels = 16;
+
+// sizeof(DrawElementsIndirectCommand)
+static const GLsizeiptr command_size = 5 * sizeof(GLuint);
+
+static GLuint cull_program = 0;
+static GLuint reduce_program = 0;
+static GLuint object_buffer = 0;
+static GLuint command_buffer = 0;
+static GLuint count_buffer = 0;
+static uint32_t object_count = 0;
+static gpu_cull_mesh mesh;
+static bool indirect_count = false;
+
+static GLint object_count_location = -1;
+static GLint planes_location = -1;
+static GLint mesh_index_count_location = -1;
+static GLint mesh_first_index_location = -1;
+static GLint mesh_base_vertex_location = -1;
+static GLint use_hiz_location = -1;
+static GLint hiz_levels_location = -1;
+static GLint depth_size_location = -1;
+static GLint hiz_view_projection_location = -1;
+static GLint source_level_location = -1;
+
+static GLuint hiz_texture = 0;
+static int hiz_levels = 0;
+static int depth_width = 0;
+static int depth_height = 0;
+static mat4 hiz_view_projection = {};
+static bool hiz_valid = false;
+
+bool gpu_cull_supported() {
+	return gl_api_has_version(4, 3);
+}
+
+bool gpu_cull_init(const float* bounds, const uint32_t count, const gpu_cull_mesh& draw_mesh) {
+	if (!gpu_cull_supported()) {
+		log("GPU culling needs OpenGL 4.3");
+		return false;
+	}
+	cull_program = load_compute_program("gpu_cull.comp");
+	reduce_program = load_compute_program("hiz_reduce.comp");
+	if (cull_program == 0 || reduce_program == 0) {
+		gpu_cull_shutdown();
+		return false;
+	}
+	object_count_location = glGetUniformLocation(cull_program, "object_count");
+	planes_location = glGetUniformLocation(cull_program, "planes");
+	mesh_index_count_location = glGetUniformLocation(cull_program, "mesh_index_count");
+	mesh_first_index_location = glGetUniformLocation(cull_program, "mesh_first_index");
+	mesh_base_vertex_location = glGetUniformLocation(cull_program, "mesh_base_vertex");
+	use_hiz_location = glGetUniformLocation(cull_program, "use_hiz");
+	hiz_levels_location = glGetUniformLocation(cull_program, "hiz_levels");
+	depth_size_location = glGetUniformLocation(cull_program, "depth_size");
+	hiz_view_projection_location = glGetUniformLocation(cull_program, "hiz_view_projection");
+	source_level_location = glGetUniformLocation(reduce_program, "source_level");
+
+	object_count = count;
+	mesh = draw_mesh;
+	#if USE_GLEW
+	// GLEW keeps the ARB entry point separate, only the core one is called
+	indirect_count = gl_api_has_version(4, 6);
+	#else
+	// core in 4.6, the ARB name before that; the loader resolves either one
+	indirect_count = gl_api_has_version(4, 6) || gl_api_has_extension("GL_ARB_indirect_parameters");
+	#endif
+
+	glGenBuffers(1, &object_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, object_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(count) * 8 * sizeof(float), bounds, GL_STATIC_DRAW);
+
+	// written by the GPU every frame, never touched by the CPU
+	glGenBuffers(1, &command_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, max<GLsizeiptr>(1, count) * command_size, nullptr, GL_DYNAMIC_COPY);
+	glGenBuffers(1, &count_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, count_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	log(string("GPU culling ready, draw count ") + (indirect_count ? "stays on the GPU" : "is read back every frame"));
+	return true;
+}
+
+void gpu_cull_shutdown() {
+	glDeleteBuffers(1, &object_buffer);
+	glDeleteBuffers(1, &command_buffer);
+	glDeleteBuffers(1, &count_buffer);
+	glDeleteTextures(1, &hiz_texture);
+	glDeleteProgram(cull_program);
+	glDeleteProgram(reduce_program);
+	object_buffer = command_buffer = count_buffer = hiz_texture = cull_program = reduce_program = 0;
+	hiz_levels = depth_width = depth_height = 0;
+	hiz_valid = false;
+}
+
+GLuint gpu_cull_object_buffer() {
+	return object_buffer;
+}
+
+bool gpu_cull_has_indirect_count() {
+	return indirect_count;
+}
+
+void gpu_cull_dispatch(const mat4& view_projection, const bool use_hiz) {
+	const GLuint zero = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, count_buffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glUseProgram(cull_program);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, object_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, command_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, count_buffer);
+
+	const frustum view = frustum_from_matrix(view_projection);
+	glUniform1ui(object_count_location, object_count);
+	glUniform4fv(planes_location, 6, &view.planes[0][0]);
+	glUniform1ui(mesh_index_count_location, mesh.index_count);
+	glUniform1ui(mesh_first_index_location, mesh.first_index);
+	glUniform1i(mesh_base_vertex_location, mesh.base_vertex);
+
+	const bool hiz = use_hiz && hiz_valid;
+	glUniform1i(use_hiz_location, hiz ? 1 : 0);
+	if (hiz) {
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, hiz_texture);
+		glUniform1i(hiz_levels_location, hiz_levels);
+		glUniform2i(depth_size_location, depth_width, depth_height);
+		glUniformMatrix4fv(hiz_view_projection_location, 1, GL_FALSE, hiz_view_projection.m);
+	}
+
+	glDispatchCompute((object_count + cull_group_size - 1) / cull_group_size, 1, 1);
+	// the commands and the count are read by the draw, the count maybe by glGetBufferSubData
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+	if (hiz) {
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
+
+uint32_t gpu_cull_read_draw_count() {
+	GLuint count = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, count_buffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(count), &count);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return count;
+}
+
+void gpu_cull_draw() {
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+	if (indirect_count) {
+		glBindBuffer(GL_PARAMETER_BUFFER, count_buffer);
+		glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, static_cast<GLsizei>(object_count), 0);
+		glBindBuffer(GL_PARAMETER_BUFFER, 0);
+	}
+	else {
+		const GLsizei count = static_cast<GLsizei>(gpu_cull_read_draw_count());
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, count, 0);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+static void create_hiz(const int width, const int height) {
+	glDeleteTextures(1, &hiz_texture);
+	gpu_category_scope category(gpu_category::render_target);
+	glGenTextures(1, &hiz_texture);
+	glBindTexture(GL_TEXTURE_2D, hiz_texture);
+
+	hiz_levels = 0;
+	int level_width = max(1, width / 2), level_height = max(1, height / 2);
+	for (;;) {
+		glTexImage2D(GL_TEXTURE_2D, hiz_levels, GL_R32F, level_width, level_height, 0, GL_RED, GL_FLOAT, nullptr);
+		hiz_levels++;
+		if ((level_width == 1 && level_height == 1) || hiz_levels == max_hiz_levels) {
+			break;
+		}
+		level_width = max(1, level_width / 2);
+		level_height = max(1, level_height / 2);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, hiz_levels - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	depth_width = width;
+	depth_height = height;
+}
+
+void gpu_cull_build_hiz(const GLuint depth_texture, const int width, const int height, const mat4& view_projection) {
+	if (hiz_texture == 0 || width != depth_width || height != depth_height) {
+		create_hiz(width, height);
+	}
+
+	glUseProgram(reduce_program);
+	glActiveTexture(GL_TEXTURE0);
+	int level_width = max(1, width / 2), level_height = max(1, height / 2);
+	for (int level = 0; level < hiz_levels; level++) {
+		// level 0 reduces the depth buffer itself, the others the level before them
+		glBindTexture(GL_TEXTURE_2D, level == 0 ? depth_texture : hiz_texture);
+		glUniform1i(source_level_location, level == 0 ? 0 : level - 1);
+		glBindImageTexture(0, hiz_texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute((level_width + reduce_group_size - 1) / reduce_group_size,
+			(level_height + reduce_group_size - 1) / reduce_group_size, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+		level_width = max(1, level_width / 2);
+		level_height = max(1, level_height / 2);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	hiz_view_projection = view_projection;
+	hiz_valid = true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include "gl_api.h"
+#include "math3d.h"
+
+// GPU driven culling (GL 4.3): object bounds live in a storage buffer, a compute shader tests them
+// against the frustum and, optionally, a max depth pyramid built from the previous frame's depth
+// buffer, and writes compacted DrawElementsIndirectCommand records plus their count. everything
+// stays on the GPU when glMultiDrawElementsIndirectCount (GL 4.6 / ARB_indirect_parameters) is
+// there; otherwise the count is read back before glMultiDrawElementsIndirect
+
+// every object is drawn with the same index range of the bound element buffer
+struct gpu_cull_mesh {
+	uint32_t index_count = 0;
+	uint32_t first_index = 0;
+	int32_t base_vertex = 0;
+};
+
+bool gpu_cull_supported();
+// bounds - two vec4 per object: center (w free for the caller's shaders) and half size
+bool gpu_cull_init(const float* bounds, uint32_t object_count, const gpu_cull_mesh& mesh);
+void gpu_cull_shutdown();
+// the bounds buffer, e.g. as instanced vertex attributes; object i is instance i of its draw
+GLuint gpu_cull_object_buffer();
+// true if draws need no count read back
+bool gpu_cull_has_indirect_count();
+
+// use_hiz false, or no pyramid built yet - frustum only
+void gpu_cull_dispatch(const mat4& view_projection, bool use_hiz);
+// the surviving objects, with the program and vertex array already bound
+void gpu_cull_draw();
+// reads the last count back, waiting for the GPU; for statistics only
+uint32_t gpu_cull_read_draw_count();
+
+// builds the pyramid for the next gpu_cull_dispatch() from a depth texture rendered with view_projection
+void gpu_cull_build_hiz(GLuint depth_texture, int width, int height, const mat4& view_projection);
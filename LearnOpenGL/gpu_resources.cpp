@@ -0,0 +1,398 @@
+#include "gpu_resources.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+#include "log.h"
+
+using namespace std;
+
+const int category_count = static_cast<int>(gpu_category::count);
+const int object_type_count = static_cast<int>(gpu_object_type::count);
+
+// indexed by GL name - names are small integers handed out sequentially by the driver
+static vector<gpu_resource> objects[object_type_count];
+static gpu_category_usage usage[category_count];
+static gpu_eviction_callback eviction_callbacks[category_count];
+
+static bool scope_active = false;
+static gpu_category scope_category = gpu_category::mesh;
+
+static double report_interval_seconds = 0.0;
+static chrono::steady_clock::time_point last_report = chrono::steady_clock::now();
+
+const char* gpu_category_name(const gpu_category category) {
+	switch (category) {
+	case gpu_category::mesh: return "mesh";
+	case gpu_category::texture: return "texture";
+	case gpu_category::render_target: return "render_target";
+	case gpu_category::streaming: return "streaming";
+	default: return "unknown";
+	}
+}
+
+static gpu_resource& slot(const gpu_object_type type, const GLuint name) {
+	vector<gpu_resource>& table = objects[static_cast<int>(type)];
+	if (name >= table.size()) {
+		table.resize(name + 1 + table.size() / 2);
+	}
+	return table[name];
+}
+
+static gpu_category_usage& usage_of(const gpu_category category) {
+	return usage[static_cast<int>(category)];
+}
+
+static gpu_category default_category(const gpu_object_type type, const GLenum format) {
+	if (scope_active) {
+		return scope_category;
+	}
+	switch (type) {
+	case gpu_object_type::texture: return gpu_category::texture;
+	case gpu_object_type::renderbuffer: return gpu_category::render_target;
+	default:
+		// buffers respecified every frame say so in their usage hint
+		return format == GL_STREAM_DRAW || format == GL_DYNAMIC_DRAW ? gpu_category::streaming : gpu_category::mesh;
+	}
+}
+
+static void add_bytes(gpu_category_usage& category, const int64_t delta) {
+	category.bytes += delta;
+	if (category.bytes > category.high_water) {
+		category.high_water = category.bytes;
+	}
+}
+
+static void move_to(gpu_resource& resource, const gpu_category category) {
+	if (resource.live && resource.category != category) {
+		usage_of(resource.category).bytes -= resource.bytes;
+		usage_of(resource.category).objects--;
+		add_bytes(usage_of(category), resource.bytes);
+		usage_of(category).objects++;
+	}
+	resource.category = category;
+}
+
+static void set_bytes(const gpu_object_type type, const GLuint name, const uint64_t bytes, const GLenum format) {
+	if (name == 0) {
+		return;
+	}
+	gpu_resource& resource = slot(type, name);
+	if (!resource.live) {
+		resource.live = true;
+		usage_of(resource.category).objects++;
+	}
+	// untagged objects follow the latest allocation, a buffer respecified with another usage hint moves
+	if (!resource.tagged) {
+		move_to(resource, default_category(type, format));
+	}
+	add_bytes(usage_of(resource.category), static_cast<int64_t>(bytes) - static_cast<int64_t>(resource.bytes));
+	resource.bytes = bytes;
+	resource.format = format;
+}
+
+static void release(const gpu_object_type type, const GLuint name) {
+	vector<gpu_resource>& table = objects[static_cast<int>(type)];
+	if (name == 0 || name >= table.size() || !table[name].live) {
+		return;
+	}
+	gpu_category_usage& category = usage_of(table[name].category);
+	category.bytes -= table[name].bytes;
+	category.objects--;
+	table[name] = gpu_resource();
+}
+
+void gpu_resources_tag(const gpu_object_type type, const GLuint name, const gpu_category category) {
+	gpu_resource& resource = slot(type, name);
+	move_to(resource, category);
+	resource.tagged = true;
+}
+
+const gpu_resource* gpu_resources_find(const gpu_object_type type, const GLuint name) {
+	const vector<gpu_resource>& table = objects[static_cast<int>(type)];
+	return name < table.size() && table[name].live ? &table[name] : nullptr;
+}
+
+const gpu_category_usage& gpu_resources_usage(const gpu_category category) {
+	return usage_of(category);
+}
+
+void gpu_resources_set_budget(const gpu_category category, const uint64_t bytes, const gpu_eviction_callback& on_over_budget) {
+	usage_of(category).budget = bytes;
+	eviction_callbacks[static_cast<int>(category)] = on_over_budget;
+}
+
+bool gpu_resources_set_budgets(const string& spec, const gpu_eviction_callback& on_over_budget) {
+	size_t begin = 0;
+	while (begin < spec.size()) {
+		size_t end = spec.find(',', begin);
+		if (end == string::npos) {
+			end = spec.size();
+		}
+		const string entry = spec.substr(begin, end - begin);
+		const size_t colon = entry.find(':');
+		if (colon == string::npos) {
+			return false;
+		}
+
+		const string name = entry.substr(0, colon);
+		int category = 0;
+		while (category < category_count && name != gpu_category_name(static_cast<gpu_category>(category))) {
+			category++;
+		}
+		if (category == category_count) {
+			return false;
+		}
+		const uint64_t megabytes = strtoull(entry.c_str() + colon + 1, nullptr, 10);
+		gpu_resources_set_budget(static_cast<gpu_category>(category), megabytes * 1048576, on_over_budget);
+		begin = end + 1;
+	}
+	return true;
+}
+
+void gpu_resources_report_interval(const double seconds) {
+	report_interval_seconds = seconds;
+}
+
+static string format_size(const uint64_t bytes) {
+	char buffer[32];
+	if (bytes < 1048576) {
+		snprintf(buffer, sizeof(buffer), "%.1f KB", bytes / 1024.0);
+	}
+	else {
+		snprintf(buffer, sizeof(buffer), "%.2f MB", bytes / 1048576.0);
+	}
+	return buffer;
+}
+
+string gpu_resources_report() {
+	string report = "GPU memory by category:";
+	uint64_t total = 0;
+	for (int i = 0; i < category_count; i++) {
+		const gpu_category_usage& category = usage[i];
+		total += category.bytes;
+		report += string("\n  ") + gpu_category_name(static_cast<gpu_category>(i)) + ": " + format_size(category.bytes)
+			+ " in " + to_string(category.objects) + " objects, peak " + format_size(category.high_water);
+		if (category.budget > 0) {
+			report += ", budget " + format_size(category.budget);
+		}
+	}
+	report += "\n  total: " + format_size(total);
+	return report;
+}
+
+void gpu_resources_frame() {
+	for (int i = 0; i < category_count; i++) {
+		const gpu_category_usage& category = usage[i];
+		if (category.budget > 0 && category.bytes > category.budget && eviction_callbacks[i]) {
+			eviction_callbacks[i](static_cast<gpu_category>(i), category.bytes - category.budget);
+		}
+	}
+
+	if (report_interval_seconds > 0.0) {
+		const auto now = chrono::steady_clock::now();
+		if (chrono::duration<double>(now - last_report).count() >= report_interval_seconds) {
+			last_report = now;
+			log(gpu_resources_report());
+		}
+	}
+}
+
+gpu_category_scope::gpu_category_scope(const gpu_category category)
+	: previous(scope_category), had_previous(scope_active) {
+	scope_active = true;
+	scope_category = category;
+}
+
+gpu_category_scope::~gpu_category_scope() {
+	scope_active = had_previous;
+	scope_category = previous;
+}
+
+#if USE_GLEW
+
+bool gpu_resources_enable() {
+	log("GPU memory accounting needs the generated loader, rebuild without UseGlew");
+	return false;
+}
+
+#else
+
+// what is bound where, so an allocation call can be attributed to an object name
+static unordered_map<GLenum, GLuint> bound_buffers;
+static unordered_map<GLuint, GLuint> vertex_array_elements;
+static GLuint bound_vertex_array = 0;
+static unordered_map<uint64_t, GLuint> bound_textures;
+static GLenum active_texture_unit = GL_TEXTURE0;
+static GLuint bound_renderbuffer = 0;
+// level 0 size per texture, for glGenerateMipmap
+static vector<uint64_t> texture_base_bytes;
+
+static GLuint buffer_bound_to(const GLenum target) {
+	// the element buffer binding is part of the vertex array object
+	if (target == GL_ELEMENT_ARRAY_BUFFER) {
+		const auto found = vertex_array_elements.find(bound_vertex_array);
+		return found != vertex_array_elements.end() ? found->second : 0;
+	}
+	const auto found = bound_buffers.find(target);
+	return found != bound_buffers.end() ? found->second : 0;
+}
+
+static uint64_t texture_key(const GLenum target) {
+	return static_cast<uint64_t>(active_texture_unit) << 32 | target;
+}
+
+static GLuint texture_bound_to(GLenum target) {
+	if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z) {
+		target = GL_TEXTURE_CUBE_MAP;
+	}
+	const auto found = bound_textures.find(texture_key(target));
+	return found != bound_textures.end() ? found->second : 0;
+}
+
+static uint64_t internal_format_bytes(const GLint internal_format) {
+	switch (internal_format) {
+	case GL_R8: case GL_RED: return 1;
+	case GL_RG8: case GL_R16F: return 2;
+	case GL_RGBA16F: case GL_RG32F: case GL_RGB16F: return 8;
+	case GL_RGBA32F: case GL_RGB32F: return 16;
+	// drivers pad three channel 8 bit formats to four bytes
+	default: return 4;
+	}
+}
+
+static void texture_level(const GLenum target, const GLint level, const uint64_t bytes, const GLint internal_format) {
+	const GLuint texture = texture_bound_to(target);
+	if (texture == 0) {
+		return;
+	}
+	const gpu_resource* resource = gpu_resources_find(gpu_object_type::texture, texture);
+	const bool first_image = level == 0 && (target == GL_TEXTURE_2D || target == GL_TEXTURE_2D_ARRAY
+		|| target == GL_TEXTURE_3D || target == GL_TEXTURE_CUBE_MAP_POSITIVE_X);
+	// re-specifying level 0 restarts the size, other levels and cube faces add to it
+	const uint64_t total = first_image || resource == nullptr ? bytes : resource->bytes + bytes;
+	set_bytes(gpu_object_type::texture, texture, total, internal_format);
+
+	if (level == 0) {
+		if (texture >= texture_base_bytes.size()) {
+			texture_base_bytes.resize(texture + 1 + texture_base_bytes.size() / 2);
+		}
+		texture_base_bytes[texture] = total;
+	}
+}
+
+#define TRACK(name, params, args, body) \
+	static decltype(gl_loader_##name) real_##name = nullptr; \
+	static void GL_LOADER_APIENTRY track_##name params { \
+		real_##name args; \
+		body \
+	}
+
+TRACK(glBindBuffer, (GLenum target, GLuint buffer), (target, buffer), {
+	if (target == GL_ELEMENT_ARRAY_BUFFER) {
+		vertex_array_elements[bound_vertex_array] = buffer;
+	}
+	else {
+		bound_buffers[target] = buffer;
+	}
+})
+// an indexed binding binds the target's generic binding point too
+TRACK(glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer), {
+	bound_buffers[target] = buffer;
+})
+TRACK(glBindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size),
+	(target, index, buffer, offset, size), {
+	bound_buffers[target] = buffer;
+})
+TRACK(glBindVertexArray, (GLuint array), (array), {
+	bound_vertex_array = array;
+})
+TRACK(glDeleteVertexArrays, (GLsizei n, const GLuint* arrays), (n, arrays), {
+	// the name can come back for a new array, which starts without an element buffer
+	for (GLsizei i = 0; i < n; i++) {
+		vertex_array_elements.erase(arrays[i]);
+		if (arrays[i] == bound_vertex_array) {
+			bound_vertex_array = 0;
+		}
+	}
+})
+TRACK(glBufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage), {
+	set_bytes(gpu_object_type::buffer, buffer_bound_to(target), size, usage);
+})
+TRACK(glBufferStorage, (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags), (target, size, data, flags), {
+	// storage the CPU maps for writing is refilled all the time
+	set_bytes(gpu_object_type::buffer, buffer_bound_to(target), size, flags & GL_MAP_WRITE_BIT ? GL_STREAM_DRAW : GL_STATIC_DRAW);
+})
+TRACK(glDeleteBuffers, (GLsizei n, const GLuint* buffers), (n, buffers), {
+	for (GLsizei i = 0; i < n; i++) {
+		release(gpu_object_type::buffer, buffers[i]);
+	}
+})
+TRACK(glActiveTexture, (GLenum unit), (unit), {
+	active_texture_unit = unit;
+})
+TRACK(glBindTexture, (GLenum target, GLuint texture), (target, texture), {
+	bound_textures[texture_key(target)] = texture;
+})
+TRACK(glTexImage2D, (GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border,
+	GLenum format, GLenum type, const void* pixels), (target, level, internal_format, width, height, border, format, type, pixels), {
+	texture_level(target, level, static_cast<uint64_t>(width) * height * internal_format_bytes(internal_format), internal_format);
+})
+TRACK(glTexImage3D, (GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLsizei depth,
+	GLint border, GLenum format, GLenum type, const void* pixels),
+	(target, level, internal_format, width, height, depth, border, format, type, pixels), {
+	texture_level(target, level, static_cast<uint64_t>(width) * height * depth * internal_format_bytes(internal_format), internal_format);
+})
+TRACK(glGenerateMipmap, (GLenum target), (target), {
+	const GLuint texture = texture_bound_to(target);
+	const gpu_resource* resource = gpu_resources_find(gpu_object_type::texture, texture);
+	if (resource != nullptr && texture < texture_base_bytes.size()) {
+		// a full mip chain adds a third of the base level
+		set_bytes(gpu_object_type::texture, texture, texture_base_bytes[texture] * 4 / 3, resource->format);
+	}
+})
+TRACK(glDeleteTextures, (GLsizei n, const GLuint* textures), (n, textures), {
+	for (GLsizei i = 0; i < n; i++) {
+		release(gpu_object_type::texture, textures[i]);
+	}
+})
+TRACK(glFramebufferTexture2D, (GLenum target, GLenum attachment, GLenum texture_target, GLuint texture, GLint level),
+	(target, attachment, texture_target, texture, level), {
+	const gpu_resource* resource = gpu_resources_find(gpu_object_type::texture, texture);
+	if (resource != nullptr && !resource->tagged) {
+		gpu_resources_tag(gpu_object_type::texture, texture, gpu_category::render_target);
+	}
+})
+TRACK(glBindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer), {
+	bound_renderbuffer = renderbuffer;
+})
+TRACK(glRenderbufferStorage, (GLenum target, GLenum internal_format, GLsizei width, GLsizei height),
+	(target, internal_format, width, height), {
+	set_bytes(gpu_object_type::renderbuffer, bound_renderbuffer,
+		static_cast<uint64_t>(width) * height * internal_format_bytes(internal_format), internal_format);
+})
+TRACK(glDeleteRenderbuffers, (GLsizei n, const GLuint* renderbuffers), (n, renderbuffers), {
+	for (GLsizei i = 0; i < n; i++) {
+		release(gpu_object_type::renderbuffer, renderbuffers[i]);
+	}
+})
+
+#define HOOK(name) real_##name = gl_loader_##name; gl_loader_##name = track_##name
+
+bool gpu_resources_enable() {
+	HOOK(glBindBuffer); HOOK(glBindBufferBase); HOOK(glBindBufferRange); HOOK(glBufferData); HOOK(glDeleteBuffers);
+	HOOK(glBindVertexArray); HOOK(glDeleteVertexArrays);
+	HOOK(glActiveTexture); HOOK(glBindTexture); HOOK(glTexImage2D); HOOK(glTexImage3D);
+	HOOK(glGenerateMipmap); HOOK(glDeleteTextures); HOOK(glFramebufferTexture2D);
+	HOOK(glBindRenderbuffer); HOOK(glRenderbufferStorage); HOOK(glDeleteRenderbuffers);
+	// lazy: resolved first, or resolving it on the first call would put the driver's function back
+	if ((gl_api_has_version(4, 4) || gl_api_has_extension("GL_ARB_buffer_storage")) && gl_loader_load("glBufferStorage")) {
+		HOOK(glBufferStorage);
+	}
+	return true;
+}
+
+#endif
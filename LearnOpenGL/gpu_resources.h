@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "gl_api.h"
+
+// registry of every GL buffer, texture and renderbuffer with its size, format and owner category;
+// sizes come from hooking the gl_loader allocation functions, so it needs the generated loader
+
+enum class gpu_category {
+	mesh,
+	texture,
+	render_target,
+	streaming,
+	count
+};
+
+enum class gpu_object_type {
+	buffer,
+	texture,
+	renderbuffer,
+	count
+};
+
+struct gpu_resource {
+	uint64_t bytes = 0;
+	// internal format for textures and renderbuffers, usage for buffers
+	GLenum format = 0;
+	gpu_category category = gpu_category::mesh;
+	bool live = false;
+	bool tagged = false;
+};
+
+struct gpu_category_usage {
+	uint64_t bytes = 0;
+	uint64_t high_water = 0;
+	uint64_t objects = 0;
+	uint64_t budget = 0;
+};
+
+// over_bytes - how far the category is above its budget; the callback is expected to free something
+typedef std::function<void(gpu_category category, uint64_t over_bytes)> gpu_eviction_callback;
+
+bool gpu_resources_enable();
+// category of an object, wins over the scope default
+void gpu_resources_tag(gpu_object_type type, GLuint name, gpu_category category);
+// O(1) by GL name, nullptr if the object is unknown or deleted
+const gpu_resource* gpu_resources_find(gpu_object_type type, GLuint name);
+const gpu_category_usage& gpu_resources_usage(gpu_category category);
+
+// 0 - no budget; the callback runs from gpu_resources_frame() while the category is over budget
+void gpu_resources_set_budget(gpu_category category, uint64_t bytes, const gpu_eviction_callback& on_over_budget);
+// "mesh:64,texture:256" - megabytes per category name, false on a malformed spec
+bool gpu_resources_set_budgets(const std::string& spec, const gpu_eviction_callback& on_over_budget);
+// log gpu_resources_report() every this many seconds (0 - never)
+void gpu_resources_report_interval(double seconds);
+// frame boundary: budget checks and the periodic report
+void gpu_resources_frame();
+std::string gpu_resources_report();
+const char* gpu_category_name(gpu_category category);
+
+// untagged objects sized while a scope is alive get its category
+class gpu_category_scope {
+public:
+	explicit gpu_category_scope(gpu_category category);
+	~gpu_category_scope();
+
+	gpu_category_scope(const gpu_category_scope&) = delete;
+	gpu_category_scope& operator=(const gpu_category_scope&) = delete;
+
+private:
+	gpu_category previous;
+	bool had_previous;
+};
@@ -0,0 +1,225 @@
+#include "job_benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bench_stats.h"
+#include "job_system.h"
+#include "log.h"
+
+using namespace std;
+
+static const int fine_jobs = 20000;
+static const double fine_us = 10.0;
+static const int coarse_jobs = 640;
+static const double coarse_us = 1000.0;
+static const int stage_count = 4;
+static const int for_items = 2000000;
+// work per parallel_for item
+static const int for_item_iterations = 16;
+
+// xorshift rounds per microsecond on this machine
+static double iterations_per_us = 0.0;
+
+static uint32_t spin(const int iterations, uint32_t value) {
+	for (int i = 0; i < iterations; i++) {
+		value ^= value << 13;
+		value ^= value >> 17;
+		value ^= value << 5;
+	}
+	return value;
+}
+
+static void calibrate() {
+	const int iterations = 4000000;
+	const bench_clock::time_point start = bench_clock::now();
+	volatile uint32_t sink = spin(iterations, 1);
+	(void)sink;
+	const double us = chrono::duration<double, micro>(bench_clock::now() - start).count();
+	iterations_per_us = iterations / max(us, 1.0);
+}
+
+struct work_job {
+	int iterations;
+	atomic<int>* done;
+	uint32_t result;
+};
+
+static void run_work(void* context) {
+	work_job* work = static_cast<work_job*>(context);
+	work->result = spin(work->iterations, 1);
+	work->done->fetch_add(1, memory_order_relaxed);
+}
+
+// stage s must only start once all of stage s - 1 is done
+struct stage_job {
+	int iterations;
+	int stage;
+	int stage_size;
+	atomic<int>* done;
+	atomic<bool>* out_of_order;
+	uint32_t result;
+};
+
+static void run_stage(void* context) {
+	stage_job* work = static_cast<stage_job*>(context);
+	if (work->stage > 0 && work->done[work->stage - 1].load(memory_order_relaxed) != work->stage_size) {
+		work->out_of_order->store(true);
+	}
+	work->result = spin(work->iterations, 1);
+	work->done[work->stage].fetch_add(1, memory_order_relaxed);
+}
+
+struct for_context {
+	vector<uint8_t>* hits;
+	atomic<uint32_t> checksum{ 0 };
+};
+
+static void run_items(void* context, const int begin, const int end) {
+	for_context* items = static_cast<for_context*>(context);
+	uint32_t sum = 0;
+	for (int i = begin; i < end; i++) {
+		sum += spin(for_item_iterations, i + 1);
+		(*items->hits)[i]++;
+	}
+	items->checksum.fetch_add(sum, memory_order_relaxed);
+}
+
+// one timed pass of a workload; false if a job was lost, ran twice or ran too early
+static bool run_jobs(const int count, const double job_us, double* ms) {
+	vector<work_job> jobs(count);
+	atomic<int> done{ 0 };
+	for (work_job& work : jobs) {
+		work.iterations = static_cast<int>(job_us * iterations_per_us);
+		work.done = &done;
+	}
+	const bench_clock::time_point start = bench_clock::now();
+	job_counter counter;
+	for (work_job& work : jobs) {
+		job_run(run_work, &work, &counter);
+	}
+	job_wait(&counter);
+	*ms = elapsed_ms(start);
+	return done.load() == count;
+}
+
+static bool run_stages(double* ms) {
+	const int stage_size = fine_jobs / stage_count;
+	vector<stage_job> jobs(fine_jobs);
+	atomic<int> done[stage_count];
+	atomic<bool> out_of_order{ false };
+	for (int s = 0; s < stage_count; s++) {
+		done[s] = 0;
+	}
+	for (int i = 0; i < fine_jobs; i++) {
+		jobs[i].iterations = static_cast<int>(fine_us * iterations_per_us);
+		jobs[i].stage = i / stage_size;
+		jobs[i].stage_size = stage_size;
+		jobs[i].done = done;
+		jobs[i].out_of_order = &out_of_order;
+	}
+	const bench_clock::time_point start = bench_clock::now();
+	job_counter counters[stage_count];
+	for (int i = 0; i < fine_jobs; i++) {
+		const int stage = jobs[i].stage;
+		if (stage == 0) {
+			job_run(run_stage, &jobs[i], &counters[0]);
+		}
+		else {
+			job_run_after(&counters[stage - 1], run_stage, &jobs[i], &counters[stage]);
+		}
+	}
+	job_wait(&counters[stage_count - 1]);
+	*ms = elapsed_ms(start);
+	for (int s = 0; s < stage_count - 1; s++) {
+		job_wait(&counters[s]);
+	}
+	return !out_of_order.load() && done[stage_count - 1].load() == stage_size;
+}
+
+static bool run_for(double* ms) {
+	vector<uint8_t> hits(for_items);
+	for_context items;
+	items.hits = &hits;
+	const bench_clock::time_point start = bench_clock::now();
+	parallel_for(0, for_items, 0, run_items, &items);
+	*ms = elapsed_ms(start);
+	return all_of(hits.begin(), hits.end(), [](const uint8_t hit) { return hit == 1; });
+}
+
+int run_job_benchmark(const app_options& options) {
+	const int runs = options.frame_limit > 0 ? options.frame_limit : 3;
+	calibrate();
+
+	vector<int> thread_counts;
+	for (int threads = 1; threads < options.job_bench_threads; threads *= 2) {
+		thread_counts.push_back(threads);
+	}
+	thread_counts.push_back(options.job_bench_threads);
+
+	const char* workloads[] = { "jobs_10us", "jobs_1ms", "stages_10us", "parallel_for" };
+	const int workload_count = sizeof(workloads) / sizeof(workloads[0]);
+	vector<double> single_thread_ms(workload_count, 0.0);
+
+	string json = "{\n";
+	json += "  \"hardware_threads\": " + to_string(thread::hardware_concurrency()) + ",\n";
+	json += "  \"runs\": " + to_string(runs) + ",\n";
+	json += "  \"results\": [\n";
+
+	bool failed = false;
+	for (size_t t = 0; t < thread_counts.size(); t++) {
+		const int threads = thread_counts[t];
+		job_system_init(threads);
+		for (int w = 0; w < workload_count; w++) {
+			vector<double> ms;
+			// the first pass warms up the threads and the caches
+			for (int run = 0; run <= runs; run++) {
+				double pass_ms = 0.0;
+				bool correct = false;
+				switch (w) {
+				case 0: correct = run_jobs(fine_jobs, fine_us, &pass_ms); break;
+				case 1: correct = run_jobs(coarse_jobs, coarse_us, &pass_ms); break;
+				case 2: correct = run_stages(&pass_ms); break;
+				default: correct = run_for(&pass_ms); break;
+				}
+				failed = failed || !correct;
+				if (run > 0) {
+					ms.push_back(pass_ms);
+				}
+			}
+
+			const bench_stats stats = compute_stats(ms);
+			if (threads == 1) {
+				single_thread_ms[w] = stats.median;
+			}
+			const double speedup = single_thread_ms[w] / stats.median;
+			const double efficiency = speedup / threads;
+			char line[200];
+			snprintf(line, sizeof(line), "%-12s %2d threads: %8.2f ms, speedup %5.2f, efficiency %5.1f%%",
+				workloads[w], threads, stats.median, speedup, efficiency * 100.0);
+			log(line);
+
+			json += string("    {\"workload\": \"") + workloads[w] + "\", \"threads\": " + to_string(threads);
+			json += ", \"ms\": " + stats_json(stats);
+			snprintf(line, sizeof(line), ", \"speedup\": %.3f, \"efficiency\": %.3f}", speedup, efficiency);
+			json += line;
+			json += t + 1 == thread_counts.size() && w + 1 == workload_count ? "\n" : ",\n";
+		}
+		job_system_shutdown();
+	}
+	json += "  ],\n";
+	json += string("  \"all_jobs_ran_once_in_order\": ") + (failed ? "false" : "true") + "\n}\n";
+	if (failed) {
+		log("Job system lost, repeated or reordered jobs");
+	}
+
+	if (!write_bench_json(options.bench_output_path, "job_bench.json", json, "Job system benchmark")) {
+		return 1;
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "app_options.h"
+
+// runs 10 us jobs, 1 ms jobs, chained stages of 10 us jobs and a fine grained parallel_for on 1, 2,
+// 4 ... options.job_bench_threads threads, checks every job ran once and in order, and writes the
+// times with the speedup and scaling efficiency over one thread as JSON
+int run_job_benchmark(const app_options& options);
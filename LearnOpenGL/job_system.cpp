@@ -0,0 +1,440 @@
+#include "job_system.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// jobs per thread, both the ring they are taken from and the deque; a power of two
+static const int job_capacity = 4096;
+// pieces a range is cut into per thread when parallel_for picks the grain itself
+static const int pieces_per_thread = 16;
+// yields an idle worker spends looking for work before it sleeps
+static const int idle_spins = 64;
+// states kept for threads that attach later, past the ones init starts with
+static const int attach_slots = 4;
+
+struct job {
+	job_function function = nullptr;
+	range_function range = nullptr;
+	void* context = nullptr;
+	int begin = 0;
+	int end = 0;
+	int grain = 0;
+	job_counter* counter = nullptr;
+	// next continuation waiting on the same counter
+	job* next = nullptr;
+	// queued or waiting on a counter, the ring has to skip it
+	atomic<bool> in_use{ false };
+};
+
+// Chase-Lev deque of a fixed size: the owner pushes and pops at the bottom, thieves take from the
+// top, and only the last item needs a CAS between the owner and a thief
+class job_deque {
+public:
+	bool push(job* item);
+	job* pop();
+	job* steal();
+	bool empty() const;
+
+private:
+	atomic<int64_t> top{ 0 };
+	// thieves hammer top, the owner bottom
+	char padding[64];
+	atomic<int64_t> bottom{ 0 };
+	atomic<job*> items[job_capacity];
+};
+
+bool job_deque::push(job* item) {
+	const int64_t b = bottom.load(memory_order_relaxed);
+	const int64_t t = top.load(memory_order_acquire);
+	if (b - t >= job_capacity) {
+		return false;
+	}
+	items[b & (job_capacity - 1)].store(item, memory_order_relaxed);
+	bottom.store(b + 1, memory_order_release);
+	return true;
+}
+
+job* job_deque::pop() {
+	const int64_t b = bottom.load(memory_order_relaxed) - 1;
+	bottom.store(b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t t = top.load(memory_order_relaxed);
+	if (t > b) {
+		bottom.store(b + 1, memory_order_relaxed);
+		return nullptr;
+	}
+	job* item = items[b & (job_capacity - 1)].load(memory_order_relaxed);
+	if (t == b) {
+		// the last item, a thief may be taking it right now
+		if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+			item = nullptr;
+		}
+		bottom.store(b + 1, memory_order_relaxed);
+	}
+	return item;
+}
+
+job* job_deque::steal() {
+	int64_t t = top.load(memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	const int64_t b = bottom.load(memory_order_acquire);
+	if (t >= b) {
+		return nullptr;
+	}
+	job* item = items[t & (job_capacity - 1)].load(memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+		return nullptr;
+	}
+	return item;
+}
+
+bool job_deque::empty() const {
+	return bottom.load(memory_order_relaxed) <= top.load(memory_order_relaxed);
+}
+
+struct thread_state {
+	job_deque deque;
+	job jobs[job_capacity];
+	unsigned next_job = 0;
+	uint32_t random = 1;
+	// an attach slot in use
+	atomic<bool> attached{ false };
+};
+
+// the threads init was asked for, then the attach slots
+static vector<unique_ptr<thread_state>> states;
+static int thread_count = 0;
+static vector<thread> workers;
+static thread_local int thread_index = -1;
+
+// jobs sitting in deques, idle workers sleep while it is zero
+static atomic<int> queued{ 0 };
+static atomic<int> sleeping{ 0 };
+static atomic<bool> stopping{ false };
+static mutex sleep_mutex;
+static condition_variable wake;
+
+static void execute(job* item);
+
+static void lock(job_counter* counter) {
+	while (counter->locked.exchange(true, memory_order_acquire)) {
+		while (counter->locked.load(memory_order_relaxed)) {
+			this_thread::yield();
+		}
+	}
+}
+
+static void unlock(job_counter* counter) {
+	counter->locked.store(false, memory_order_release);
+}
+
+static void push(thread_state& state, job* item) {
+	if (!state.deque.push(item)) {
+		// the deque is full, nobody will miss the parallelism
+		execute(item);
+		return;
+	}
+	queued.fetch_add(1);
+	if (sleeping.load() > 0) {
+		// taking the mutex orders the notify after a sleeper's check of queued
+		lock_guard<mutex> guard(sleep_mutex);
+		wake.notify_one();
+	}
+}
+
+static job* find_job(thread_state& state) {
+	job* item = state.deque.pop();
+	if (item != nullptr) {
+		return item;
+	}
+	const int count = static_cast<int>(states.size());
+	state.random ^= state.random << 13;
+	state.random ^= state.random >> 17;
+	state.random ^= state.random << 5;
+	const int first = static_cast<int>(state.random % count);
+	for (int i = 0; i < count; i++) {
+		const int victim = (first + i) % count;
+		if (victim != thread_index) {
+			item = states[victim]->deque.steal();
+			if (item != nullptr) {
+				return item;
+			}
+		}
+	}
+	return nullptr;
+}
+
+static bool run_one(thread_state& state) {
+	job* item = find_job(state);
+	if (item == nullptr) {
+		return false;
+	}
+	queued.fetch_sub(1);
+	execute(item);
+	return true;
+}
+
+static job* allocate(thread_state& state) {
+	for (;;) {
+		job* item = &state.jobs[state.next_job & (job_capacity - 1)];
+		if (!item->in_use.load(memory_order_acquire)) {
+			state.next_job++;
+			item->in_use.store(true, memory_order_relaxed);
+			item->next = nullptr;
+			return item;
+		}
+		// the ring went all the way around to a job that hasn't started, help until it does
+		if (!run_one(state)) {
+			this_thread::yield();
+		}
+	}
+}
+
+static void start_continuations(job* item) {
+	while (item != nullptr) {
+		job* next = item->next;
+		if (thread_index >= 0) {
+			push(*states[thread_index], item);
+		}
+		else {
+			execute(item);
+		}
+		item = next;
+	}
+}
+
+static void finish(job_counter* counter) {
+	int pending = counter->pending.load(memory_order_relaxed);
+	for (;;) {
+		// not the last job, the waiter can't return before the last one so a plain decrement is enough
+		while (pending > 1) {
+			if (counter->pending.compare_exchange_weak(pending, pending - 1, memory_order_acq_rel, memory_order_relaxed)) {
+				return;
+			}
+		}
+		// the last one reaches zero under the lock and job_wait takes the lock once before returning,
+		// so the counter isn't touched after its owner let it go
+		lock(counter);
+		pending = 1;
+		if (counter->pending.compare_exchange_strong(pending, 0, memory_order_acq_rel, memory_order_relaxed)) {
+			job* continuations = counter->continuations;
+			counter->continuations = nullptr;
+			unlock(counter);
+			start_continuations(continuations);
+			return;
+		}
+		// something was added meanwhile
+		unlock(counter);
+	}
+}
+
+static void run_range(const range_function body, void* context, int begin, int end, const int grain, job_counter* counter) {
+	thread_state& state = *states[thread_index];
+	while (end - begin > grain) {
+		if (state.deque.empty()) {
+			// nothing of ours left for thieves, hand them the upper half
+			const int middle = begin + (end - begin) / 2;
+			counter->pending.fetch_add(1, memory_order_relaxed);
+			job* item = allocate(state);
+			item->range = body;
+			item->function = nullptr;
+			item->context = context;
+			item->begin = middle;
+			item->end = end;
+			item->grain = grain;
+			item->counter = counter;
+			push(state, item);
+			end = middle;
+		}
+		else {
+			body(context, begin, begin + grain);
+			begin += grain;
+		}
+	}
+	body(context, begin, end);
+}
+
+static void execute(job* item) {
+	// copied out first so the ring slot can be reused while the job runs
+	const job_function function = item->function;
+	const range_function range = item->range;
+	void* context = item->context;
+	const int begin = item->begin, end = item->end, grain = item->grain;
+	job_counter* counter = item->counter;
+	item->in_use.store(false, memory_order_release);
+
+	if (range != nullptr) {
+		run_range(range, context, begin, end, grain, counter);
+	}
+	else {
+		function(context);
+	}
+	if (counter != nullptr) {
+		finish(counter);
+	}
+}
+
+static void worker_main(const int index) {
+	thread_index = index;
+	thread_state& state = *states[index];
+	while (!stopping.load()) {
+		if (run_one(state)) {
+			continue;
+		}
+		bool found = false;
+		for (int spin = 0; spin < idle_spins && !found; spin++) {
+			this_thread::yield();
+			found = queued.load() > 0;
+		}
+		if (found) {
+			continue;
+		}
+		unique_lock<mutex> guard(sleep_mutex);
+		sleeping.fetch_add(1);
+		wake.wait(guard, [] { return queued.load() > 0 || stopping.load(); });
+		sleeping.fetch_sub(1);
+	}
+}
+
+void job_system_init(const int threads) {
+	job_system_shutdown();
+	const int total = threads > 0 ? threads : max(1, static_cast<int>(thread::hardware_concurrency()));
+	// the attach slots are in place from the start, so workers never see the vector change
+	for (int i = 0; i < total + attach_slots; i++) {
+		states.emplace_back(new thread_state);
+		states.back()->random = 0x9e3779b9u * (i + 1);
+	}
+	thread_count = total;
+	thread_index = 0;
+	stopping = false;
+	for (int i = 1; i < total; i++) {
+		workers.emplace_back(worker_main, i);
+	}
+}
+
+void job_system_shutdown() {
+	{
+		lock_guard<mutex> guard(sleep_mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	states.clear();
+	thread_count = 0;
+	queued = 0;
+	thread_index = -1;
+}
+
+bool job_system_attach_thread() {
+	if (thread_index >= 0) {
+		return true;
+	}
+	for (int i = thread_count; i < static_cast<int>(states.size()); i++) {
+		bool expected = false;
+		if (states[i]->attached.compare_exchange_strong(expected, true)) {
+			thread_index = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void job_system_detach_thread() {
+	if (thread_index < thread_count) {
+		return;
+	}
+	// whatever thieves haven't taken yet runs here, the slot may go to another thread next
+	thread_state& state = *states[thread_index];
+	while (job* item = state.deque.pop()) {
+		queued.fetch_sub(1);
+		execute(item);
+	}
+	thread_index = -1;
+	state.attached.store(false);
+}
+
+int job_system_threads() {
+	return max(1, thread_count);
+}
+
+void job_run(const job_function function, void* context, job_counter* counter) {
+	if (thread_index < 0) {
+		function(context);
+		return;
+	}
+	if (counter != nullptr) {
+		counter->pending.fetch_add(1, memory_order_relaxed);
+	}
+	thread_state& state = *states[thread_index];
+	job* item = allocate(state);
+	item->function = function;
+	item->range = nullptr;
+	item->context = context;
+	item->counter = counter;
+	push(state, item);
+}
+
+void job_run_after(job_counter* dependency, const job_function function, void* context, job_counter* counter) {
+	if (thread_index < 0) {
+		job_wait(dependency);
+		function(context);
+		return;
+	}
+	if (counter != nullptr) {
+		counter->pending.fetch_add(1, memory_order_relaxed);
+	}
+	thread_state& state = *states[thread_index];
+	job* item = allocate(state);
+	item->function = function;
+	item->range = nullptr;
+	item->context = context;
+	item->counter = counter;
+
+	lock(dependency);
+	if (dependency->pending.load(memory_order_acquire) == 0) {
+		unlock(dependency);
+		push(state, item);
+		return;
+	}
+	item->next = dependency->continuations;
+	dependency->continuations = item;
+	unlock(dependency);
+}
+
+void job_wait(job_counter* counter) {
+	while (counter->pending.load(memory_order_acquire) > 0) {
+		if (thread_index < 0 || !run_one(*states[thread_index])) {
+			this_thread::yield();
+		}
+	}
+	// the last finish() may still hold the lock
+	lock(counter);
+	unlock(counter);
+}
+
+void parallel_for(const int begin, const int end, int grain, const range_function body, void* context) {
+	const int count = end - begin;
+	if (count <= 0) {
+		return;
+	}
+	if (grain <= 0) {
+		grain = max(1, count / (job_system_threads() * pieces_per_thread));
+	}
+	if (thread_index < 0 || count <= grain) {
+		body(context, begin, end);
+		return;
+	}
+	job_counter counter;
+	run_range(body, context, begin, end, grain, &counter);
+	job_wait(&counter);
+}
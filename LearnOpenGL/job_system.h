@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+
+// work stealing job system: every thread owns a Chase-Lev deque it pushes to and pops from at the
+// bottom, idle threads steal from the top of the others. jobs are a function pointer and a context
+// taken from a per thread ring, so submitting allocates nothing; a job_counter tracks a group of
+// jobs, can be waited on (the waiting thread runs jobs meanwhile) and can hold jobs that start once
+// it drops to zero
+typedef void (*job_function)(void* context);
+typedef void (*range_function)(void* context, int begin, int end);
+
+struct job;
+
+struct job_counter {
+	job_counter() = default;
+	job_counter(const job_counter&) = delete;
+	job_counter& operator=(const job_counter&) = delete;
+
+	// jobs submitted against the counter and not finished yet
+	std::atomic<int> pending{ 0 };
+	// guards the continuations and the final decrement
+	std::atomic<bool> locked{ false };
+	job* continuations = nullptr;
+};
+
+// threads counts the caller, which becomes thread 0 and runs jobs only while it waits; 0 - one per
+// hardware thread
+void job_system_init(int threads);
+void job_system_shutdown();
+int job_system_threads();
+
+// gives a thread started outside the system (a render thread, say) a deque of its own, so its
+// jobs go to the workers and its waits run jobs like thread 0's. false when every slot is taken;
+// detach before the thread ends and before shutdown
+bool job_system_attach_thread();
+void job_system_detach_thread();
+
+// counter may be null. threads outside the system (not the one that called init, not a worker and
+// not attached) run the job right away
+void job_run(job_function function, void* context, job_counter* counter);
+// starts the job once dependency is at zero; counter counts it from now on
+void job_run_after(job_counter* dependency, job_function function, void* context, job_counter* counter);
+// runs other jobs until the counter is at zero, so the counter can go away when this returns
+void job_wait(job_counter* counter);
+
+// body gets [begin, end) in pieces of up to grain items (0 - picked from the count and the
+// threads). a range is split in half only while the thread running it has nothing else queued, so
+// it costs few jobs while every thread is busy and spreads quickly when some are starving
+void parallel_for(int begin, int end, int grain, range_function body, void* context);
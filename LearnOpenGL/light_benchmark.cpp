@@ -0,0 +1,197 @@
+#include "light_benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_stats.h"
+#include "city_scene.h"
+#include "clustered_lights.h"
+#include "job_system.h"
+#include "log.h"
+#include "profiler.h"
+
+using namespace std;
+
+static const int warmup_frames = 3;
+static const int default_objects = 10000;
+
+struct light_times {
+	vector<double> bin_ms;
+	vector<double> bin_scalar_ms;
+	vector<double> bin_one_thread_ms;
+	vector<double> upload_ms;
+	vector<double> gpu_ms;
+	// upload and draw until glFinish returns
+	vector<double> draw_ms;
+	size_t visible_lights = 0;
+	size_t light_refs = 0;
+	size_t max_per_cluster = 0;
+	size_t busy_clusters = 0;
+};
+
+// the camera a bit further down the path every frame
+static double frame_seconds(const int frame) {
+	return 2.0 + frame * 0.37;
+}
+
+static bool same_grid(const light_grid& a, const light_grid& b) {
+	return a.light_count == b.light_count && a.clusters == b.clusters && a.indices == b.indices && a.lights == b.lights;
+}
+
+static void run_frames(GLFWwindow* window, const int frames, const int width, const int height, const bool bin_variants,
+	light_times& times) {
+	const mat4 projection = city_projection(static_cast<float>(width) / height);
+	vector<uint32_t> visible(city_objects().size());
+	light_grid grid, variant;
+	GLuint query = 0;
+	glGenQueries(1, &query);
+	for (int frame = 0; frame < warmup_frames + frames; frame++) {
+		glfwPollEvents();
+		const double seconds = frame_seconds(frame);
+		const mat4 view = city_view(seconds);
+		const mat4 view_projection = projection * view;
+		const size_t visible_count = city_cull_frustum(view_projection, false, visible.data());
+
+		city_bin_lights(seconds, view, projection, grid);
+		const double bin_ms = grid.bin_ms;
+		double bin_scalar_ms = 0.0, bin_one_thread_ms = 0.0;
+		if (bin_variants) {
+			clustered_lights_use_simd(false);
+			city_bin_lights(seconds, view, projection, variant);
+			clustered_lights_use_simd(true);
+			bin_scalar_ms = variant.bin_ms;
+			const int threads = job_system_threads();
+			job_system_init(1);
+			city_bin_lights(seconds, view, projection, variant);
+			job_system_init(threads);
+			bin_one_thread_ms = variant.bin_ms;
+		}
+
+		const double upload_start = profiler_now_ms();
+		clustered_lights_upload(grid);
+		const double upload_ms = profiler_now_ms() - upload_start;
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		city_draw(view_projection, visible.data(), visible_count);
+		glEndQuery(GL_TIME_ELAPSED);
+		glFinish();
+		const double draw_ms = profiler_now_ms() - upload_start;
+		GLuint64 gpu_ns = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpu_ns);
+
+		if (frame >= warmup_frames) {
+			times.bin_ms.push_back(bin_ms);
+			times.bin_scalar_ms.push_back(bin_scalar_ms);
+			times.bin_one_thread_ms.push_back(bin_one_thread_ms);
+			times.upload_ms.push_back(upload_ms);
+			times.gpu_ms.push_back(gpu_ns / 1e6);
+			times.draw_ms.push_back(draw_ms);
+			times.visible_lights += grid.light_count;
+			times.light_refs += grid.indices.size();
+			times.max_per_cluster = max(times.max_per_cluster, grid.max_per_cluster);
+			for (int cluster = 0; cluster < cluster_count; cluster++) {
+				times.busy_clusters += grid.clusters[cluster * 2 + 1] > 0 ? 1 : 0;
+			}
+		}
+		glfwSwapBuffers(window);
+	}
+	glDeleteQueries(1, &query);
+}
+
+int run_light_benchmark(const app_options& options, GLFWwindow* window, const int width, const int height) {
+	vector<size_t> counts;
+	for (const char* cursor = options.light_bench_counts.c_str(); *cursor != '\0';) {
+		char* end = nullptr;
+		const unsigned long long count = strtoull(cursor, &end, 10);
+		if (end == cursor) {
+			log("Malformed --light-bench, expected a comma separated list of light counts");
+			return 1;
+		}
+		counts.push_back(static_cast<size_t>(count));
+		cursor = *end == ',' ? end + 1 : end;
+	}
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 20;
+
+	city_generate(options.city_objects > 0 ? options.city_objects : default_objects, 1234);
+	job_system_init(0);
+	if (!city_init_gl() || !city_init_lights(width, height)) {
+		log("Failed to set up the light benchmark");
+		city_release_gl();
+		job_system_shutdown();
+		return 1;
+	}
+	glViewport(0, 0, width, height);
+
+	// the same frames without a single light, for what the lights add to the shading
+	city_generate_lights(0, 4321);
+	light_times unlit;
+	run_frames(window, frames, width, height, false, unlit);
+	const double unlit_gpu_ms = compute_stats(unlit.gpu_ms).median;
+	const double unlit_draw_ms = compute_stats(unlit.draw_ms).median;
+
+	bool mismatch = false;
+	char line[320];
+	string json = "{\n";
+	json += "  \"objects\": " + to_string(city_objects().size()) + ",\n";
+	json += "  \"clusters\": [" + to_string(cluster_tiles_x) + ", " + to_string(cluster_tiles_y) + ", " + to_string(cluster_slices) + "],\n";
+	json += "  \"threads\": " + to_string(job_system_threads()) + ",\n";
+	json += "  \"renderer\": \"" + string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) + "\",\n";
+	json += "  \"unlit_gpu_ms\": " + stats_json(compute_stats(unlit.gpu_ms)) + ",\n";
+	json += "  \"unlit_draw_ms\": " + stats_json(compute_stats(unlit.draw_ms)) + ",\n";
+	json += "  \"runs\": [\n";
+	for (size_t run = 0; run < counts.size(); run++) {
+		city_generate_lights(static_cast<int>(counts[run]), 4321);
+
+		// AVX2 and scalar binning have to agree exactly
+		const mat4 projection = city_projection(static_cast<float>(width) / height);
+		const mat4 view = city_view(frame_seconds(0));
+		light_grid simd_grid, scalar_grid;
+		city_bin_lights(frame_seconds(0), view, projection, simd_grid);
+		clustered_lights_use_simd(false);
+		city_bin_lights(frame_seconds(0), view, projection, scalar_grid);
+		clustered_lights_use_simd(true);
+		const bool same = same_grid(simd_grid, scalar_grid);
+		mismatch = mismatch || !same;
+
+		light_times times;
+		run_frames(window, frames, width, height, true, times);
+		const bench_stats bin = compute_stats(times.bin_ms);
+		const bench_stats bin_scalar = compute_stats(times.bin_scalar_ms);
+		const bench_stats bin_one_thread = compute_stats(times.bin_one_thread_ms);
+		const bench_stats gpu = compute_stats(times.gpu_ms);
+		const bench_stats draw = compute_stats(times.draw_ms);
+		const double visible = static_cast<double>(times.visible_lights) / frames;
+		const double refs = static_cast<double>(times.light_refs) / frames;
+		const double per_busy_cluster = static_cast<double>(times.light_refs) / max<size_t>(1, times.busy_clusters);
+
+		snprintf(line, sizeof(line), "Lights: %zu lights, %.0f in view, %.0f froxel entries (%.1f per lit froxel, max %zu)%s",
+			counts[run], visible, refs, per_busy_cluster, times.max_per_cluster, same ? "" : ", SIMD and scalar grids DIFFER");
+		log(line);
+		snprintf(line, sizeof(line), "Lights: binning %.3f ms (scalar %.3f ms, one thread %.3f ms), upload %.3f ms, "
+			"GPU %.2f ms (%+.2f ms over no lights), draw to finish %.2f ms (%+.2f ms)", bin.median, bin_scalar.median,
+			bin_one_thread.median, compute_stats(times.upload_ms).median, gpu.median, gpu.median - unlit_gpu_ms, draw.median,
+			draw.median - unlit_draw_ms);
+		log(line);
+
+		snprintf(line, sizeof(line), "    {\"lights\": %zu, \"visible_lights\": %.1f, \"froxel_entries\": %.1f, \"per_lit_froxel\": %.2f, "
+			"\"max_per_froxel\": %zu, \"grids_match\": %s, ", counts[run], visible, refs, per_busy_cluster, times.max_per_cluster,
+			same ? "true" : "false");
+		json += line;
+		json += "\"bin_ms\": " + stats_json(bin) + ", \"bin_scalar_ms\": " + stats_json(bin_scalar);
+		json += ", \"bin_one_thread_ms\": " + stats_json(bin_one_thread);
+		json += ", \"upload_ms\": " + stats_json(compute_stats(times.upload_ms)) + ", \"gpu_ms\": " + stats_json(gpu);
+		json += ", \"draw_ms\": " + stats_json(draw);
+		json += run + 1 == counts.size() ? "}\n" : "},\n";
+	}
+	json += "  ]\n}\n";
+
+	city_release_lights();
+	city_release_gl();
+	job_system_shutdown();
+
+	if (!write_bench_json(options.bench_output_path, "light_bench.json", json, "Light benchmark")) {
+		return 1;
+	}
+	return mismatch ? 1 : 0;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "app_options.h"
+#include "gl_api.h"
+
+// the city with each count of options.light_bench_counts moving point lights: binning time with and
+// without AVX2 and on one or every thread, and the GPU time of the clustered shading against the
+// city drawn without lights; checks both binning paths give the same grid and writes JSON
+int run_light_benchmark(const app_options& options, GLFWwindow* window, int width, int height);
@@ -0,0 +1,11 @@
+#include "log.h"
+
+#include <iostream>
+
+using namespace std;
+
+void log(const string& message) {
+	#if _DEBUG
+	cout << message << endl;
+	#endif
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <string>
+
+void log(const std::string& message);
@@ -1,99 +1,101 @@
-﻿#define GLEW_STATIC
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
-
+﻿#include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 #include <Windows.h>
 
+#include "alloc_tracker.h"
+#include "app_options.h"
+#include "bench_stats.h"
+#include "bvh_benchmark.h"
+#include "city_scene.h"
+#include "command_list_benchmark.h"
+#include "damage.h"
+#include "deferred_benchmark.h"
+#include "exposure_benchmark.h"
+#include "frame_arena.h"
+#include "frame_pacer.h"
+#include "frustum_cull_benchmark.h"
+#include "gl_api.h"
+#include "gl_recorder.h"
+#include "glew_baseline.h"
+#include "gpu_resources.h"
+#include "job_benchmark.h"
+#include "light_benchmark.h"
+#include "job_system.h"
+#include "log.h"
+#include "occlusion.h"
+#include "occlusion_benchmark.h"
+#include "post_benchmark.h"
+#include "post_process.h"
+#include "profiler.h"
+#include "render_graph.h"
+#include "render_stats.h"
+#include "render_thread.h"
+#include "shader.h"
+#include "soft_raster.h"
+#include "soft_raster_benchmark.h"
+#include "sdf_text.h"
+#include "shadow_benchmark.h"
+#include "sprite_benchmark.h"
+#include "startup_benchmark.h"
+#include "text_benchmark.h"
+#include "text_overlay.h"
+
 using namespace std;
 
 // EBO - element buffer objects
 
-const char* read_file(const char* path) {
-	// file read based on example in cplusplus.com tutorial
-	ifstream file (path, ios::in|ios::binary|ios::ate);
-	if (file.is_open())	{
-		const auto size = file.tellg();
-		//fSize = (GLuint) size;
-		auto* const memblock = new char [1 + size];
-		file.seekg (0, ios::beg);
-		file.read (memblock, size);
-		file.close();
-		memblock[size] = '\0';
-		string text;
-		text.assign(memblock);
-
-		return memblock;
-	}
-	else {
-		return nullptr;
-	}
-}
-
-static void log(const string& message) {
-	#if _DEBUG
-	cout << message << endl;
-	#endif
-}
+static bool overlay_visible = true;
+// --gpu-cull and the context has what it needs
+static bool gpu_culling = false;
+// frame times kept for the summary at exit, the rest are not recorded
+static const size_t max_recorded_frames = 1 << 16;
+// --on-demand: frames are drawn only when something damaged the screen
+static bool on_demand = false;
+static damage_rect overlay_area;
+// the stats overlay's numbers are brought up to date this often when nothing else redraws
+static const double overlay_refresh_seconds = 1.0;
+
+// the scene, shared by the GL path and the software rasterizer
+static const GLfloat vertices[] = {
+	0.5f,  0.5f, 0.0f,  // top right
+	0.5f, -0.5f, 0.0f,  // bottom right
+	-0.5f, -0.5f, 0.0f,  // bottom left
+	-0.5f,  0.5f, 0.0f   // top left
+};
+static const GLuint indices[] = {  // start from 0
+	0, 1, 3,   // first triangle
+	1, 2, 3    // second triangle
+};
+static const float clear_color[] = { 0.2f, 0.3f, 0.3f, 1.0f };
+// vertexColor in shader1.vert
+static const float quad_color[] = { 0.5f, 0.0f, 0.0f, 1.0f };
 
 void key_callback(GLFWwindow* window, const int key, int scancode, const int action, int mode) {
     if(key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
 		log("Complete");
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
-}
-
-GLuint create_shader(const char* shader_source_code, const int shader_type) {
-	GLint success = 0;
-
-	const GLuint shader = glCreateShader(shader_type);	
-	glShaderSource(shader, 1, &shader_source_code, nullptr);
-	glCompileShader(shader);	
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-
-	string message;
-
-	if(!success) {
-		const int log_size = 512;
-		GLchar info_log[log_size];
-
-		glGetShaderInfoLog(shader, log_size, nullptr, info_log);
-
-		message = "Shader compilation - failed\n";
-		message += info_log;
-		log(message);
-	}
-	else {
-		message = "Shader compilation - success";
-		log(message);
+	if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
+		overlay_visible = !overlay_visible;
+		if (on_demand) {
+			damage_add(overlay_area);
+		}
 	}
-
-	return shader;
 }
 
-GLuint create_shader_program(GLuint shaders[], const int array_size) {
-	GLint success = 0;
-	GLchar info_log[512];
-	const GLuint shader_program = glCreateProgram();
-	
-	for (int i = 0; i < array_size; i++)	{
-		glAttachShader(shader_program, shaders[i]);
+// the window was uncovered, what is on screen can't be trusted
+void refresh_callback(GLFWwindow* window) {
+	if (on_demand) {
+		damage_add_full();
 	}
-
-	glLinkProgram(shader_program);
-
-	glGetProgramiv(shader_program, GL_LINK_STATUS, &success);
-	if (!success) {
-		glGetProgramInfoLog(shader_program, 512, nullptr, info_log);
-		log("Shader program compilation - failed");
-	}
-
-	return shader_program;
 }
 
 GLuint shaders() {
+	profile_scope zone("shaders");
 	log("Commencing shader program compile");
 
 	const char* vertex_shader_source = read_file("shader1.vert");
@@ -118,7 +120,7 @@ GLuint shaders() {
 }
 
 void draw(const GLuint vao, const GLuint shader_program) {
-	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+	glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
 	glClear(GL_COLOR_BUFFER_BIT);
 
 	glUseProgram(shader_program); 
@@ -131,21 +133,312 @@ void draw(const GLuint vao, const GLuint shader_program) {
 	glBindVertexArray(0);
 }
 
-int main()
+// what draw() submits, on the CPU
+static void draw_software() {
+	soft_raster_begin_frame(clear_color, 1.0f);
+
+	soft_draw quad;
+	quad.positions = vertices;
+	quad.vertex_count = 4;
+	quad.indices = indices;
+	quad.index_count = 6;
+	copy(quad_color, quad_color + 4, quad.color);
+	soft_raster_draw(quad);
+
+	soft_raster_end_frame();
+}
+
+// no window, no GL: render the frames on the CPU and save the last one
+static int run_software(const app_options& options) {
+	job_system_init(0);
+	if (!soft_raster_init(800, 600)) {
+		job_system_shutdown();
+		return -1;
+	}
+	const int frames = max(1, options.frame_limit);
+	for (int frame = 0; frame < frames; frame++) {
+		draw_software();
+	}
+
+	const bool written = soft_raster_write_ppm(options.software_output_path);
+	soft_raster_shutdown();
+	job_system_shutdown();
+	if (!written) {
+		log("Failed to write " + options.software_output_path);
+		return -1;
+	}
+	return 0;
+}
+
+// the GL back buffer right after draw() against the software rasterizer's image of the same scene
+static void compare_with_software(const int width, const int height) {
+	vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+	if (!soft_raster_init(width, height)) {
+		return;
+	}
+	draw_software();
+	const soft_raster_difference difference = soft_raster_compare(pixels.data(), 1);
+	log("Software rasterizer vs GL: " + to_string(difference.mismatched_pixels) + " of " + to_string(width * height)
+		+ " pixels differ, max channel difference " + to_string(difference.max_channel_difference));
+	soft_raster_shutdown();
+}
+
+// seconds glfwWaitEventsTimeout() may sleep for before something is due without input (negative - until input)
+static double idle_timeout(const double now_ms, const double next_overlay_ms, const double deadline_ms) {
+	double until_ms = -1.0;
+	if (next_overlay_ms > 0.0) {
+		until_ms = next_overlay_ms;
+	}
+	if (deadline_ms > 0.0 && (until_ms < 0.0 || deadline_ms < until_ms)) {
+		until_ms = deadline_ms;
+	}
+	return until_ms < 0.0 ? -1.0 : max(0.0, until_ms - now_ms) / 1000.0;
+}
+
+// the main thread's half of a frame. --city: the camera follows the path at wall clock speed;
+// frustum culled (through the BVH with --bvh), and with --occlusion the survivors are tested
+// against the nearest buildings too
+static void build_frame(const app_options& options, const int width, const int height, const uint64_t frame,
+	frame_packet& packet) {
+	packet.frame = frame;
+	packet.first = frame == 0;
+	packet.seconds = glfwGetTime();
+	packet.overlay = overlay_visible;
+	packet.visible_count = 0;
+	packet.list_count = 0;
+	if (options.city_objects <= 0) {
+		return;
+	}
+
+	const mat4 projection = city_projection(static_cast<float>(width) / height);
+	const mat4 view = city_view(packet.seconds);
+	packet.view_projection = projection * view;
+	if (options.city_lights > 0 || options.deferred || options.shadow_map_size > 0) {
+		profile_scope zone("bin_lights");
+		city_bin_lights(packet.seconds, view, projection, packet.lights);
+	}
+	if (options.shadow_map_size > 0) {
+		profile_scope zone("fit_shadows");
+		city_fit_shadows(view, projection, packet.shadows);
+	}
+	if (gpu_culling) {
+		return;
+	}
+	{
+		profile_scope zone("frustum_cull");
+		packet.visible_count = city_cull_frustum(packet.view_projection, options.city_bvh, packet.visible.data());
+	}
+	if (options.occluders > 0) {
+		profile_scope zone("occlusion_cull");
+		packet.visible_count = city_cull_occluded(packet.view_projection, city_eye(packet.seconds), options.occluders,
+			packet.visible.data(), packet.visible_count, packet.visible.data());
+	}
+	if (options.command_lists > 0) {
+		// a few lists per thread, so a slow one doesn't hold up the others
+		profile_scope zone("record_commands");
+		packet.list_count = min(max_frame_lists, static_cast<size_t>(job_system_threads()) * 4);
+		city_record(packet.view_projection, packet.visible.data(), packet.visible_count, packet.lists, packet.list_count);
+	}
+}
+
+// what the GL half of a frame needs besides the packet
+struct frame_renderer {
+	GLFWwindow* window;
+	GLuint vao;
+	GLuint shader_program;
+	int width;
+	int height;
+	bool city;
+	// --lights, --deferred or --shadows, the packet's light grid is uploaded before the scene is drawn
+	bool lights;
+	// --shadows, the packet's cascades are drawn before the scene
+	bool shadows;
+	bool sort_commands;
+	bool software_compare;
+	bool collect_stats;
+	bool track_gpu_memory;
+	bool paced;
+	// --on-demand frames redraw only their damage into the canvas
+	bool partial_redraw;
+	// --render-graph, the scene goes through it with post-processing
+	render_graph* graph;
+	// --font, a title and the frame number drawn as SDF text
+	bool text;
+};
+
+static void draw_scene(const frame_renderer& renderer, const frame_packet& packet) {
+	if (!renderer.city) {
+		draw(renderer.vao, renderer.shader_program);
+	}
+	else if (gpu_culling) {
+		city_draw_gpu_culled(packet.view_projection);
+	}
+	else if (packet.list_count > 0) {
+		city_draw_lists(packet.view_projection, packet.lists, packet.list_count, renderer.sort_commands);
+	}
+	else {
+		city_draw(packet.view_projection, packet.visible.data(), packet.visible_count);
+	}
+}
+
+struct scene_pass_context {
+	const frame_renderer* renderer;
+	const frame_packet* packet;
+};
+
+static void scene_pass(const render_graph& graph, void* context) {
+	const scene_pass_context& scene = *static_cast<const scene_pass_context*>(context);
+	draw_scene(*scene.renderer, *scene.packet);
+}
+
+// the GL half of a frame, on the main thread or on the render thread with --render-thread
+static void render_frame(const frame_packet& packet, void* context) {
+	const frame_renderer& renderer = *static_cast<const frame_renderer*>(context);
+	{
+		profile_scope zone("draw");
+		if (renderer.lights) {
+			clustered_lights_upload(packet.lights);
+		}
+		if (renderer.shadows) {
+			city_render_shadows(packet.shadows);
+		}
+		if (renderer.partial_redraw) {
+			// the canvas still holds the last frame, only the damage is drawn over it
+			damage_canvas_bind();
+			glEnable(GL_SCISSOR_TEST);
+			for (size_t i = 0; i < packet.damage_count; i++) {
+				const damage_rect& rect = packet.damage[i];
+				glScissor(rect.x, rect.y, rect.width, rect.height);
+				draw_scene(renderer, packet);
+			}
+		}
+		else if (renderer.graph != nullptr) {
+			// declared every frame, the compile comes from the cache unless the overlay was toggled
+			scene_pass_context scene = { &renderer, &packet };
+			render_graph& graph = *renderer.graph;
+			post_process_set_time(packet.seconds);
+			graph.begin();
+			post_process_declare(graph, renderer.width, renderer.height, scene_pass, &scene, packet.overlay);
+			if (graph.compile()) {
+				graph.execute(0, renderer.width, renderer.height);
+			}
+		}
+		else {
+			draw_scene(renderer, packet);
+		}
+	}
+	if (renderer.text) {
+		profile_scope zone("text");
+		char line[64];
+		snprintf(line, sizeof(line), "frame %llu, %.1f s", static_cast<unsigned long long>(packet.frame), packet.seconds);
+		const float title_height = sdf_text_print(16.0f, 12.0f, 36.0f, 0xffffffff, "LearnOpenGL", 0.0f);
+		sdf_text_print(18.0f, 12.0f + title_height, 14.0f, 0xc0e0e0e0, line, 0.0f);
+		sdf_text_draw(renderer.width, renderer.height);
+	}
+	if (renderer.software_compare && packet.first) {
+		compare_with_software(renderer.width, renderer.height);
+	}
+	if (renderer.collect_stats) {
+		profile_scope zone("render_stats");
+		render_stats_frame();
+		if (packet.overlay && (!renderer.partial_redraw || packet.overlay_damaged)) {
+			// blended, so it may only go where the scene under it was just redrawn
+			if (renderer.partial_redraw) {
+				glScissor(overlay_area.x, overlay_area.y, overlay_area.width, overlay_area.height);
+			}
+			render_stats_overlay(renderer.width, renderer.height);
+		}
+	}
+	if (renderer.partial_redraw) {
+		glDisable(GL_SCISSOR_TEST);
+		damage_canvas_present();
+	}
+	{
+		profile_scope zone("swap");
+		const double swap_start_ms = profiler_now_ms();
+		glfwSwapBuffers(renderer.window);
+		if (renderer.paced) {
+			frame_pacer_presented(packet.input_ms, swap_start_ms);
+		}
+	}
+	gl_recorder_frame();
+	if (renderer.track_gpu_memory) {
+		gpu_resources_frame();
+	}
+	if (packet.first) {
+		// wait for the driver so the startup report covers the frame being on screen, not just queued
+		glFinish();
+	}
+}
+
+// writes the allocation report; false if something allocated after the warmup frames
+static bool finish_alloc_check(const app_options& options) {
+	const string report = alloc_tracker_report(10);
+	log(report);
+
+	const string path = !options.bench_output_path.empty() ? options.bench_output_path : "alloc_report.txt";
+	ofstream file(path);
+	file << report;
+	if (!file) {
+		log("Failed to write allocation report");
+	}
+
+	if (alloc_tracker_counts().steady_allocations > 0) {
+		log("Allocation check FAILED: the steady state frames allocated");
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
 {
+	profiler_init();
+	const app_options options = parse_options(argc, argv);
+
+	if (options.startup_bench_runs > 0) {
+		return run_startup_benchmark(options);
+	}
+	if (options.software_bench_triangles > 0) {
+		return run_soft_raster_benchmark(options);
+	}
+	if (!options.software_output_path.empty()) {
+		return run_software(options);
+	}
+	if (options.frustum_bench_objects > 0) {
+		return run_frustum_cull_benchmark(options);
+	}
+	if (!options.bvh_bench_counts.empty()) {
+		return run_bvh_benchmark(options);
+	}
+	if (options.job_bench_threads > 0) {
+		return run_job_benchmark(options);
+	}
+
+	const bool check_allocations = options.alloc_check_warmup >= 0 && alloc_tracker_enable(options.alloc_check_warmup);
+
 	try
 	{	
+		profiler_begin("glfw_init");
 		glfwInit();
-		//min OpenGL version - 3.3 - major.minor
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		profiler_end();
+		//min OpenGL version - 3.3 - major.minor, compute shaders for the GPU culling and auto-exposure need 4.3
+		const bool compute_shaders = options.gpu_cull > 0 || options.auto_exposure || options.exposure_bench;
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, compute_shaders ? 4 : 3);
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 		glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+		#if _DEBUG
+		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+		#endif
 		
 		#if !_DEBUG
 		FreeConsole();
 		#endif
 
+		profiler_begin("create_window");
 		GLFWwindow* window = glfwCreateWindow(800, 600, "OpenGL", nullptr, nullptr);
 		if (window == nullptr) {	
 			log("Failed to create GLFW window");
@@ -154,31 +447,118 @@ int main()
 			return -1;
 		}
 		glfwMakeContextCurrent(window);
+		profiler_end();
 
 		glfwSetKeyCallback(window, key_callback);  
+		glfwSetWindowRefreshCallback(window, refresh_callback);
 
-		glewExperimental = GL_TRUE;
-		if (glewInit() != GLEW_OK) 	{
-			log("Failed to initialize GLEW");
-			
+		if (!gl_api_init()) {
+			glfwTerminate();
 			return -1;
 		}
+		if (options.glew_baseline) {
+			glew_baseline_init();
+		}
+		#if _DEBUG
+		gl_api_enable_debug_output();
+		#endif
+
+		const bool track_gpu_memory = options.gpu_memory_report_seconds >= 0.0 && gpu_resources_enable();
+		if (track_gpu_memory) {
+			gpu_resources_report_interval(options.gpu_memory_report_seconds);
+			// nothing in the sample can be dropped yet, so going over budget is only reported
+			const auto over_budget = [](const gpu_category category, const uint64_t over_bytes) {
+				log(string(gpu_category_name(category)) + " is " + to_string(over_bytes) + " bytes over budget");
+			};
+			if (!gpu_resources_set_budgets(options.gpu_budget, over_budget)) {
+				log("Malformed --gpu-budget, expected category:megabytes[,...]");
+			}
+		}
+
+		const bool collect_stats = !options.render_stats_path.empty() && render_stats_enable();
+		if (collect_stats) {
+			text_overlay_init();
+		}
 
 		int width = 0, height = 0;
 		glfwGetFramebufferSize(window, &width, &height);  
+		if (!options.record_path.empty()) {
+			gl_recorder_start(options.record_path, width, height);
+		}
 		glViewport(0, 0, width, height);
-			
-		GLfloat vertices[] = {
-			0.5f,  0.5f, 0.0f,  // top right
-			0.5f, -0.5f, 0.0f,  // bottom right
-			-0.5f, -0.5f, 0.0f,  // bottom left
-			-0.5f,  0.5f, 0.0f   // top left
-		};
-		GLuint indices[] = {  // start from 0
-			0, 1, 3,   // first triangle
-			1, 2, 3    // second triangle
+
+		// the benchmarks draw their own frames, a recording of one is checked like the main loop's
+		const auto finish_benchmark = [](const int result) {
+			const bool recorded = gl_recorder_stop();
+			glfwTerminate();
+			return recorded ? result : 1;
 		};
-		
+		if (options.occlusion_bench) {
+			return finish_benchmark(run_occlusion_benchmark(options, window, width, height));
+		}
+		if (options.command_bench_commands > 0) {
+			return finish_benchmark(run_command_list_benchmark(options, window, width, height));
+		}
+		if (options.sprite_bench_sprites > 0) {
+			return finish_benchmark(run_sprite_benchmark(options, window, width, height));
+		}
+		if (!options.light_bench_counts.empty()) {
+			return finish_benchmark(run_light_benchmark(options, window, width, height));
+		}
+		if (options.text_bench_glyphs > 0) {
+			return finish_benchmark(run_text_benchmark(options, window, width, height));
+		}
+		if (options.deferred_bench_lights > 0) {
+			return finish_benchmark(run_deferred_benchmark(options, window, width, height));
+		}
+		if (options.shadow_bench) {
+			return finish_benchmark(run_shadow_benchmark(options, window, width, height));
+		}
+		if (options.post_bench) {
+			return finish_benchmark(run_post_benchmark(options, window, width, height));
+		}
+		if (options.exposure_bench) {
+			return finish_benchmark(run_exposure_benchmark(options, window, width, height));
+		}
+		const bool city = options.city_objects > 0;
+		// deferred shading lights the G-buffer with the clustered lights' grid, even an empty one, and
+		// only the lit programs sample the shadows
+		const bool shadows = city && options.shadow_map_size > 0;
+		const bool lights = city && (options.city_lights > 0 || options.deferred || shadows);
+		// the city is culled and its command lists recorded, glyphs generated and the software
+		// comparison rasterized on the job system
+		const bool jobs = city || !options.font_path.empty() || options.software_compare;
+		if (jobs) {
+			job_system_init(0);
+		}
+		if (city) {
+			city_generate(options.city_objects, 1234);
+			if (options.city_lights > 0) {
+				city_generate_lights(options.city_lights, 4321);
+			}
+			if (!city_init_gl() || (shadows && !city_init_shadows(options.shadow_map_size))
+				|| (lights && !city_init_lights(width, height))
+				|| (options.occluders > 0 && !occlusion_init(width / 4, height / 4))) {
+				glfwTerminate();
+				return -1;
+			}
+			gpu_culling = options.gpu_cull > 0 && city_init_gpu_cull(width, height, options.gpu_cull == 2);
+			if (options.gpu_cull > 0 && !gpu_culling) {
+				log("GPU culling unavailable, culling on the CPU");
+			}
+			if (options.deferred && gpu_culling) {
+				log("Deferred shading doesn't take the GPU culled draws, shading forward");
+			}
+			else if (options.deferred && !city_init_deferred()) {
+				log("Deferred shading unavailable, shading forward");
+			}
+			else if (options.deferred) {
+				city_use_deferred(true);
+			}
+		}
+			
+		profiler_begin("buffers");
+
 		//Vertex Buffer Objects
 		GLuint vbo = 0;
 		glGenBuffers(1, &vbo);
@@ -191,8 +571,6 @@ int main()
 		GLuint vao = 0;
 		glGenVertexArrays(1, &vao);
 
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
 		// 1. bind VAO
 		glBindVertexArray(vao);
 		// 2. copy vertex array into OpenGL buffer
@@ -207,6 +585,8 @@ int main()
 		// 5. unbind VAO
 		glBindVertexArray(0);
 
+		profiler_end();
+
 		const GLuint shader_program = shaders();
 
 		//wireframe mode
@@ -217,15 +597,255 @@ int main()
 
 		log("Commencing");
 
-		while(!glfwWindowShouldClose(window)) {
-			glfwPollEvents();
-			draw(vao, shader_program);
-			glfwSwapBuffers(window);
+		on_demand = options.on_demand;
+		if (on_demand) {
+			damage_init(width, height);
+			overlay_area = render_stats_overlay_rect(height);
+		}
+		render_graph frame_graph;
+		const bool use_graph = options.render_graph > 0 && post_process_init(!options.post_unfused);
+		if (use_graph) {
+			frame_graph.set_aliasing(options.render_graph == 1);
+			if (options.auto_exposure && !post_process_use_auto_exposure()) {
+				log("Auto-exposure is not available, the exposure stays fixed");
+			}
+			if (city && !options.deferred) {
+				// the quad's depth buffer is never cleared, and deferred shading keeps its depth in the
+				// G-buffer, so only the forward shaded city gets ambient occlusion
+				post_process_set_camera(city_projection(static_cast<float>(width) / height));
+			}
+		}
+		const bool text = !options.font_path.empty() && sdf_text_init(options.font_path.c_str(), 1024);
+		if (text) {
+			// every character the frame line can show, so new digits don't allocate mid run
+			sdf_text_preload("LearnOpenGL frame 0123456789,.s");
+		}
+		// the city's camera moves every frame, there is never anything to keep; bloom spreads light
+		// past the damage, and the text is drawn once over everything
+		const bool partial_redraw = on_demand && !city && !use_graph && !text && damage_canvas_init(width, height);
+
+		frame_renderer renderer = { window, vao, shader_program, width, height, city, lights, shadows,
+			options.command_lists == 2, options.software_compare, collect_stats, track_gpu_memory, options.pacing > 0,
+			partial_redraw, use_graph ? &frame_graph : nullptr, text };
+		if (options.pacing > 0) {
+			frame_pacer_init(static_cast<pacing_mode>(options.pacing - 1), options.pacing_fps);
 		}
+		const size_t max_visible = city ? city_objects().size() : 0;
+		frame_packet serial_packet;
+		if (options.render_thread) {
+			render_thread_start(window, render_frame, &renderer, max_visible);
+		}
+		else {
+			serial_packet.visible.resize(max_visible);
+		}
+
+		// the first marker separates the setup from the frames in a GL trace
+		gl_recorder_frame();
+		profiler_begin("first_frame");
+		int frame = 0;
+		// arena blocks taken from the heap once the first frame is out - should stay 0
+		uint64_t steady_arena_allocations = 0;
+		vector<double> frame_ms;
+		frame_ms.reserve(max_recorded_frames);
+		double frame_start_ms = profiler_now_ms();
+		const double deadline_ms = options.run_seconds > 0.0 ? frame_start_ms + options.run_seconds * 1000.0 : 0.0;
+		// CPU use of the frames, from the end of the first one
+		double loop_start_ms = frame_start_ms;
+		double loop_start_cpu_ms = profiler_process_cpu_ms();
+		double next_overlay_ms = 0.0;
+		uint64_t idle_wakeups = 0;
 
+		while(!glfwWindowShouldClose(window)) {
+			double input_ms = 0.0;
+			{
+				profile_scope zone("frame_pacing");
+				input_ms = options.pacing > 0 ? frame_pacer_wait() : profiler_now_ms();
+			}
+			if (on_demand && city) {
+				// animated, the camera moves every frame
+				damage_add_full();
+			}
+			{
+				profile_scope zone("poll_events");
+				if (on_demand && !damage_pending()) {
+					// nothing to draw: sleep until input comes or the overlay or the run is due
+					const double overlay_due_ms = overlay_visible && collect_stats ? next_overlay_ms : 0.0;
+					const double timeout = idle_timeout(profiler_now_ms(), overlay_due_ms, deadline_ms);
+					if (timeout < 0.0) {
+						glfwWaitEvents();
+					}
+					else {
+						glfwWaitEventsTimeout(timeout);
+					}
+					input_ms = frame_start_ms = profiler_now_ms();
+				}
+				else {
+					glfwPollEvents();
+				}
+			}
+			if (deadline_ms > 0.0 && profiler_now_ms() >= deadline_ms) {
+				glfwSetWindowShouldClose(window, GL_TRUE);
+			}
+			if (on_demand) {
+				if (overlay_visible && collect_stats && profiler_now_ms() >= next_overlay_ms) {
+					damage_add(overlay_area);
+					next_overlay_ms = profiler_now_ms() + overlay_refresh_seconds * 1000.0;
+				}
+				if (!damage_pending()) {
+					idle_wakeups++;
+					continue;
+				}
+			}
+			frame_packet& packet = options.render_thread ? render_thread_packet() : serial_packet;
+			packet.input_ms = input_ms;
+			if (on_demand) {
+				packet.overlay_damaged = damage_intersects(overlay_area);
+				if (packet.overlay_damaged) {
+					// the overlay is drawn whole, so the scene under all of it has to be redrawn too
+					damage_add(overlay_area);
+				}
+				packet.damage_count = damage_take(packet.damage);
+			}
+			{
+				profile_scope zone("build_frame");
+				build_frame(options, width, height, frame, packet);
+			}
+			if (options.render_thread) {
+				// frame - 1 is drawn now, this one gets drawn while the main thread builds the next
+				profile_scope zone("wait_render_thread");
+				render_thread_wait();
+			}
+			else {
+				render_frame(packet, &renderer);
+			}
+
+			// the render thread is idle until the submit, nothing allocates from the arenas
+			frame_arena_reset();
+			alloc_tracker_frame();
+			if (startup_complete()) {
+				steady_arena_allocations += frame_arena_last().frame_heap_allocations;
+			}
+			if (options.render_thread) {
+				render_thread_submit();
+			}
+
+			const double frame_end_ms = profiler_now_ms();
+			if (startup_complete() && frame_ms.size() < frame_ms.capacity()) {
+				frame_ms.push_back(frame_end_ms - frame_start_ms);
+			}
+			frame_start_ms = frame_end_ms;
+
+			if (options.frame_limit > 0 && ++frame >= options.frame_limit) {
+				glfwSetWindowShouldClose(window, GL_TRUE);
+			}
+
+			if (!startup_complete()) {
+				if (options.render_thread) {
+					// drawing the first frame is startup too, its arena blocks shouldn't count as steady state
+					render_thread_wait();
+					frame_arena_reset();
+				}
+				if (options.pacing > 0) {
+					frame_pacer_reset_stats();
+				}
+				profiler_end();
+				startup_first_frame_presented();
+				log_startup_report();
+
+				if (!options.startup_report_path.empty() && !write_startup_report(options.startup_report_path)) {
+					log("Failed to write startup report");
+				}
+				if (options.exit_after_first_frame) {
+					glfwSetWindowShouldClose(window, GL_TRUE);
+				}
+				frame_start_ms = loop_start_ms = profiler_now_ms();
+				loop_start_cpu_ms = profiler_process_cpu_ms();
+			}
+		}
+		const double loop_ms = profiler_now_ms() - loop_start_ms;
+		const double loop_cpu_ms = profiler_process_cpu_ms() - loop_start_cpu_ms;
+		render_thread_stop();
+		// shutdown allocations are not part of the steady state
+		alloc_tracker_disable();
+
+		// false when the run drew with calls the trace format doesn't have
+		const bool recorded = gl_recorder_stop();
+		log("Frame arena peak " + to_string(frame_arena_last().high_water) + " bytes, "
+			+ to_string(steady_arena_allocations) + " heap allocations after the first frame");
+		if (!frame_ms.empty()) {
+			const bench_stats stats = compute_stats(frame_ms);
+			char line[160];
+			snprintf(line, sizeof(line), "Frame time %.2f ms median, %.2f ms p95 over %d frames (%s)", stats.median,
+				stats.p95, static_cast<int>(frame_ms.size()), options.render_thread ? "render thread" : "single thread");
+			log(line);
+		}
+		if (loop_start_cpu_ms >= 0.0 && loop_ms > 0.0) {
+			char line[160];
+			snprintf(line, sizeof(line), "CPU %.1f%% of a core over %.1f s of frames", 100.0 * loop_cpu_ms / loop_ms,
+				loop_ms / 1000.0);
+			log(line);
+		}
+		if (on_demand) {
+			log(damage_report() + ", " + to_string(idle_wakeups) + " wakeups without damage");
+		}
+		if (options.pacing > 0) {
+			log(frame_pacer_report());
+			frame_pacer_shutdown();
+		}
+		if (track_gpu_memory) {
+			log(gpu_resources_report());
+		}
+		if (partial_redraw) {
+			damage_canvas_release();
+		}
+		if (use_graph) {
+			const render_graph_stats& stats = frame_graph.stats();
+			char line[256];
+			snprintf(line, sizeof(line), "Render graph: %zu passes, %zu culled, %zu transient targets in %zu textures, "
+				"%.2f MB with aliasing, %.2f MB without; %llu compiles, %llu from cache", stats.passes, stats.culled_passes,
+				stats.transient_resources, stats.physical_resources, stats.aliased_bytes / 1048576.0,
+				stats.unaliased_bytes / 1048576.0, static_cast<unsigned long long>(stats.compiles),
+				static_cast<unsigned long long>(stats.cached_compiles));
+			log(line);
+			const post_chain_stats chain = post_process_chain_stats();
+			snprintf(line, sizeof(line), "Post-processing: %d per-pixel effects in %d fullscreen passes", chain.effects,
+				chain.passes);
+			log(line);
+			frame_graph.release();
+			post_process_release();
+		}
+		if (city) {
+			city_release_gpu_cull();
+			if (lights) {
+				city_release_lights();
+			}
+			if (shadows) {
+				const shadow_stats& stats = shadow_maps_stats();
+				char line[256];
+				snprintf(line, sizeof(line), "Shadows: %llu cascades drawn, %llu from the cache; %llu draws for %llu casters",
+					static_cast<unsigned long long>(stats.cascades_drawn), static_cast<unsigned long long>(stats.cascades_cached),
+					static_cast<unsigned long long>(stats.draws), static_cast<unsigned long long>(stats.casters));
+				log(line);
+				city_release_shadows();
+			}
+			city_release_gl();
+			occlusion_shutdown();
+		}
+		if (text) {
+			sdf_text_release();
+		}
+		if (jobs) {
+			job_system_shutdown();
+		}
+		if (collect_stats && !write_render_stats(options.render_stats_path)) {
+			log("Failed to write render statistics");
+		}
 		glfwTerminate();
 
-		return 0;
+		if (check_allocations && !finish_alloc_check(options)) {
+			return 1;
+		}
+		return recorded ? 0 : 1;
 	}
 	catch (...)
 	{
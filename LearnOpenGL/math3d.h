@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cmath>
+
+// just enough vector math for the scenes and the CPU side culling; matrices are column major
+// like the GL uniforms, so mat4::m goes to glUniformMatrix4fv as is
+
+struct vec3 {
+	float x, y, z;
+};
+
+struct vec4 {
+	float x, y, z, w;
+};
+
+struct mat4 {
+	float m[16];
+};
+
+inline vec3 operator+(const vec3& a, const vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline vec3 operator-(const vec3& a, const vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline vec3 operator*(const vec3& a, const float s) { return { a.x * s, a.y * s, a.z * s }; }
+
+inline float dot(const vec3& a, const vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline vec3 cross(const vec3& a, const vec3& b) {
+	return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+inline float length(const vec3& a) { return std::sqrt(dot(a, a)); }
+inline vec3 normalize(const vec3& a) { return a * (1.0f / length(a)); }
+
+inline mat4 mat4_identity() {
+	return { { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } };
+}
+
+inline mat4 operator*(const mat4& a, const mat4& b) {
+	mat4 result;
+	for (int column = 0; column < 4; column++) {
+		for (int row = 0; row < 4; row++) {
+			float sum = 0.0f;
+			for (int k = 0; k < 4; k++) {
+				sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+			}
+			result.m[column * 4 + row] = sum;
+		}
+	}
+	return result;
+}
+
+// cofactors over the determinant; a must be invertible
+inline mat4 inverse(const mat4& a) {
+	const float* m = a.m;
+	mat4 result;
+	float* r = result.m;
+	r[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+	r[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+	r[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+	r[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+	r[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+	r[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+	r[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+	r[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+	r[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+	r[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+	r[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+	r[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+	r[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+	r[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+	r[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+	r[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+	const float inv_determinant = 1.0f / (m[0] * r[0] + m[1] * r[4] + m[2] * r[8] + m[3] * r[12]);
+	for (float& value : result.m) {
+		value *= inv_determinant;
+	}
+	return result;
+}
+
+inline vec4 transform(const mat4& a, const vec3& p) {
+	return {
+		a.m[0] * p.x + a.m[4] * p.y + a.m[8] * p.z + a.m[12],
+		a.m[1] * p.x + a.m[5] * p.y + a.m[9] * p.z + a.m[13],
+		a.m[2] * p.x + a.m[6] * p.y + a.m[10] * p.z + a.m[14],
+		a.m[3] * p.x + a.m[7] * p.y + a.m[11] * p.z + a.m[15]
+	};
+}
+
+// GL style: right handed view space, depth -1..1 after the divide
+inline mat4 perspective(const float fovy_radians, const float aspect, const float near_plane, const float far_plane) {
+	const float f = 1.0f / std::tan(fovy_radians * 0.5f);
+	mat4 result = {};
+	result.m[0] = f / aspect;
+	result.m[5] = f;
+	result.m[10] = (far_plane + near_plane) / (near_plane - far_plane);
+	result.m[11] = -1.0f;
+	result.m[14] = 2.0f * far_plane * near_plane / (near_plane - far_plane);
+	return result;
+}
+
+inline mat4 orthographic(const float left, const float right, const float bottom, const float top,
+	const float near_plane, const float far_plane) {
+	mat4 result = mat4_identity();
+	result.m[0] = 2.0f / (right - left);
+	result.m[5] = 2.0f / (top - bottom);
+	result.m[10] = -2.0f / (far_plane - near_plane);
+	result.m[12] = -(right + left) / (right - left);
+	result.m[13] = -(top + bottom) / (top - bottom);
+	result.m[14] = -(far_plane + near_plane) / (far_plane - near_plane);
+	return result;
+}
+
+inline mat4 look_at(const vec3& eye, const vec3& target, const vec3& up) {
+	const vec3 forward = normalize(target - eye);
+	const vec3 side = normalize(cross(forward, up));
+	const vec3 true_up = cross(side, forward);
+	mat4 result = mat4_identity();
+	result.m[0] = side.x;
+	result.m[4] = side.y;
+	result.m[8] = side.z;
+	result.m[1] = true_up.x;
+	result.m[5] = true_up.y;
+	result.m[9] = true_up.z;
+	result.m[2] = -forward.x;
+	result.m[6] = -forward.y;
+	result.m[10] = -forward.z;
+	result.m[12] = -dot(side, eye);
+	result.m[13] = -dot(true_up, eye);
+	result.m[14] = dot(forward, eye);
+	return result;
+}
+
+// unit cube around the origin to a box with this center and half size
+inline mat4 box_transform(const vec3& center, const vec3& half_size) {
+	mat4 result = mat4_identity();
+	result.m[0] = half_size.x;
+	result.m[5] = half_size.y;
+	result.m[10] = half_size.z;
+	result.m[12] = center.x;
+	result.m[13] = center.y;
+	result.m[14] = center.z;
+	return result;
+}
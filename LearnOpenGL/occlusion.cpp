@@ -0,0 +1,355 @@
+#include "occlusion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <immintrin.h>
+
+#include "cpu_features.h"
+
+using namespace std;
+
+static const int tile_size = 8;
+// tiles per side of a coarse cell
+static const int coarse_size = 4;
+static const uint64_t full_mask = ~0ull;
+// a box this close to the stored depth counts as in front of it: an occluder tested against its own
+// rasterized depth ties, give or take the rounding of its interpolation, and must not cull itself
+static const float depth_tolerance = 1.0e-5f;
+
+struct mask_tile {
+	// bit row * 8 + column; pixels of the working layer
+	uint64_t mask;
+	float z0;
+	float z1;
+};
+
+struct screen_vertex {
+	float x, y, z;
+};
+
+static int width = 0;
+static int height = 0;
+static int tiles_x = 0;
+static int tiles_y = 0;
+static int coarse_x = 0;
+static int coarse_y = 0;
+static bool use_avx2 = false;
+
+static vector<mask_tile> tiles;
+// farthest z0 of the cell's tiles, rebuilt by the first test after occluders were added
+static vector<float> coarse_z0;
+static bool coarse_dirty = true;
+static mat4 view_projection = {};
+// grows to the largest mesh once, then reused
+static vector<vec4> clip_positions;
+static occlusion_stats stats;
+
+bool occlusion_init(const int buffer_width, const int buffer_height) {
+	if (buffer_width <= 0 || buffer_height <= 0) {
+		return false;
+	}
+	tiles_x = (buffer_width + tile_size - 1) / tile_size;
+	tiles_y = (buffer_height + tile_size - 1) / tile_size;
+	width = tiles_x * tile_size;
+	height = tiles_y * tile_size;
+	coarse_x = (tiles_x + coarse_size - 1) / coarse_size;
+	coarse_y = (tiles_y + coarse_size - 1) / coarse_size;
+	use_avx2 = cpu_has_avx2();
+
+	tiles.assign(static_cast<size_t>(tiles_x) * tiles_y, mask_tile());
+	coarse_z0.assign(static_cast<size_t>(coarse_x) * coarse_y, 1.0f);
+	occlusion_begin(mat4_identity());
+	return true;
+}
+
+void occlusion_shutdown() {
+	tiles = vector<mask_tile>();
+	coarse_z0 = vector<float>();
+	clip_positions = vector<vec4>();
+	width = height = tiles_x = tiles_y = coarse_x = coarse_y = 0;
+}
+
+void occlusion_begin(const mat4& frame_view_projection) {
+	view_projection = frame_view_projection;
+	for (mask_tile& tile : tiles) {
+		tile.mask = 0;
+		tile.z0 = 1.0f;
+		tile.z1 = 0.0f;
+	}
+	coarse_dirty = true;
+	stats = occlusion_stats();
+}
+
+// 8 rows of 8 pixel centers against the three edges; e - edge values at the tile's first pixel
+static uint64_t coverage_scalar(const float a[3], const float b[3], const float e[3]) {
+	uint64_t mask = 0;
+	for (int row = 0; row < tile_size; row++) {
+		for (int column = 0; column < tile_size; column++) {
+			bool inside = true;
+			for (int i = 0; i < 3; i++) {
+				inside = inside && e[i] + a[i] * column + b[i] * row >= 0.0f;
+			}
+			mask |= static_cast<uint64_t>(inside ? 1 : 0) << (row * tile_size + column);
+		}
+	}
+	return mask;
+}
+
+static uint64_t coverage_avx2(const float a[3], const float b[3], const float e[3]) {
+	const __m256 columns = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	__m256 edge[3], step[3];
+	for (int i = 0; i < 3; i++) {
+		edge[i] = _mm256_add_ps(_mm256_set1_ps(e[i]), _mm256_mul_ps(_mm256_set1_ps(a[i]), columns));
+		step[i] = _mm256_set1_ps(b[i]);
+	}
+
+	uint64_t mask = 0;
+	for (int row = 0; row < tile_size; row++) {
+		const __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(edge[0], zero, _CMP_GE_OQ),
+			_mm256_cmp_ps(edge[1], zero, _CMP_GE_OQ)), _mm256_cmp_ps(edge[2], zero, _CMP_GE_OQ));
+		mask |= static_cast<uint64_t>(_mm256_movemask_ps(inside)) << (row * tile_size);
+		for (int i = 0; i < 3; i++) {
+			edge[i] = _mm256_add_ps(edge[i], step[i]);
+		}
+	}
+	return mask;
+}
+
+static void merge(mask_tile& tile, const uint64_t coverage, const float max_depth) {
+	if (coverage == full_mask) {
+		// covers the tile on its own: a nearer full layer, and the working layer may be behind it now
+		tile.z0 = min(tile.z0, max_depth);
+		if (tile.z1 >= tile.z0) {
+			tile.mask = 0;
+			tile.z1 = 0.0f;
+		}
+		return;
+	}
+	tile.mask |= coverage;
+	tile.z1 = max(tile.z1, max_depth);
+	if (tile.mask == full_mask) {
+		tile.z0 = tile.z1;
+		tile.mask = 0;
+		tile.z1 = 0.0f;
+	}
+}
+
+static void rasterize(const screen_vertex v[3]) {
+	const float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+	if (!(area > 0.0f)) {
+		stats.skipped_triangles++;
+		return;
+	}
+
+	// pixels whose centers fall inside the bounds
+	const float min_x = min(v[0].x, min(v[1].x, v[2].x));
+	const float max_x = max(v[0].x, max(v[1].x, v[2].x));
+	const float min_y = min(v[0].y, min(v[1].y, v[2].y));
+	const float max_y = max(v[0].y, max(v[1].y, v[2].y));
+	const int x0 = max(0, static_cast<int>(ceil(min_x - 0.5f)));
+	const int x1 = min(width - 1, static_cast<int>(floor(max_x - 0.5f)));
+	const int y0 = max(0, static_cast<int>(ceil(min_y - 0.5f)));
+	const int y1 = min(height - 1, static_cast<int>(floor(max_y - 0.5f)));
+	if (x0 > x1 || y0 > y1) {
+		stats.skipped_triangles++;
+		return;
+	}
+	stats.occluder_triangles++;
+
+	// edge i faces vertex i and is positive inside; divided by the area it is that vertex's weight
+	float a[3], b[3], c[3];
+	for (int i = 0; i < 3; i++) {
+		const screen_vertex& p = v[(i + 1) % 3];
+		const screen_vertex& q = v[(i + 2) % 3];
+		a[i] = p.y - q.y;
+		b[i] = q.x - p.x;
+		c[i] = p.x * q.y - p.y * q.x;
+	}
+	const float dz_dx = (v[0].z * a[0] + v[1].z * a[1] + v[2].z * a[2]) / area;
+	const float dz_dy = (v[0].z * b[0] + v[1].z * b[1] + v[2].z * b[2]) / area;
+	const float z_origin = (v[0].z * c[0] + v[1].z * c[1] + v[2].z * c[2]) / area;
+	const float vertex_max_depth = max(v[0].z, max(v[1].z, v[2].z));
+
+	for (int ty = y0 / tile_size; ty <= y1 / tile_size; ty++) {
+		const float first_y = ty * tile_size + 0.5f;
+		const float last_y = first_y + tile_size - 1;
+		for (int tx = x0 / tile_size; tx <= x1 / tile_size; tx++) {
+			mask_tile& tile = tiles[ty * tiles_x + tx];
+			const float first_x = tx * tile_size + 0.5f;
+			const float last_x = first_x + tile_size - 1;
+
+			// the plane is linear, so its farthest point over the tile's pixel centers is at a corner
+			const float plane_max_depth = z_origin + max(dz_dx * first_x, dz_dx * last_x) + max(dz_dy * first_y, dz_dy * last_y);
+			const float max_depth = min(vertex_max_depth, plane_max_depth);
+			if (max_depth >= tile.z0) {
+				continue;
+			}
+
+			float e[3];
+			bool outside = false;
+			bool covers_tile = true;
+			for (int i = 0; i < 3; i++) {
+				e[i] = a[i] * first_x + b[i] * first_y + c[i];
+				const float dx = a[i] * (tile_size - 1);
+				const float dy = b[i] * (tile_size - 1);
+				const float highest = e[i] + max(dx, 0.0f) + max(dy, 0.0f);
+				const float lowest = e[i] + min(dx, 0.0f) + min(dy, 0.0f);
+				outside = outside || highest < 0.0f;
+				covers_tile = covers_tile && lowest >= 0.0f;
+			}
+			if (outside) {
+				continue;
+			}
+
+			const uint64_t coverage = covers_tile ? full_mask : use_avx2 ? coverage_avx2(a, b, e) : coverage_scalar(a, b, e);
+			if (coverage != 0) {
+				merge(tile, coverage, max_depth);
+			}
+		}
+	}
+	coarse_dirty = true;
+}
+
+static screen_vertex to_screen(const vec4& p) {
+	const float inv_w = 1.0f / p.w;
+	return {
+		(p.x * inv_w * 0.5f + 0.5f) * width,
+		(p.y * inv_w * 0.5f + 0.5f) * height,
+		p.z * inv_w * 0.5f + 0.5f
+	};
+}
+
+static float near_distance(const vec4& p) {
+	return p.z + p.w;
+}
+
+static vec4 lerp(const vec4& p, const vec4& q, const float t) {
+	return { p.x + (q.x - p.x) * t, p.y + (q.y - p.y) * t, p.z + (q.z - p.z) * t, p.w + (q.w - p.w) * t };
+}
+
+// cuts the part in front of the near plane off and rasterizes the rest as a fan
+static void rasterize_clipped(const vec4 triangle[3]) {
+	vec4 polygon[4];
+	int count = 0;
+	for (int i = 0; i < 3; i++) {
+		const vec4& p = triangle[i];
+		const vec4& q = triangle[(i + 1) % 3];
+		const float dp = near_distance(p);
+		const float dq = near_distance(q);
+		if (dp >= 0.0f) {
+			polygon[count++] = p;
+		}
+		if ((dp >= 0.0f) != (dq >= 0.0f)) {
+			polygon[count++] = lerp(p, q, dp / (dp - dq));
+		}
+	}
+	if (count < 3) {
+		stats.skipped_triangles++;
+		return;
+	}
+
+	const screen_vertex first = to_screen(polygon[0]);
+	for (int i = 1; i + 1 < count; i++) {
+		const screen_vertex fan[3] = { first, to_screen(polygon[i]), to_screen(polygon[i + 1]) };
+		rasterize(fan);
+	}
+}
+
+void occlusion_add_mesh(const float* positions, const int vertex_count, const uint32_t* indices, const int index_count,
+	const mat4& model) {
+	const mat4 transform_to_clip = view_projection * model;
+	clip_positions.resize(vertex_count);
+	for (int i = 0; i < vertex_count; i++) {
+		const float* p = positions + i * 3;
+		clip_positions[i] = transform(transform_to_clip, { p[0], p[1], p[2] });
+	}
+
+	for (int i = 0; i + 2 < index_count; i += 3) {
+		const vec4 triangle[3] = { clip_positions[indices[i]], clip_positions[indices[i + 1]], clip_positions[indices[i + 2]] };
+		if (near_distance(triangle[0]) > 0.0f && near_distance(triangle[1]) > 0.0f && near_distance(triangle[2]) > 0.0f) {
+			const screen_vertex screen[3] = { to_screen(triangle[0]), to_screen(triangle[1]), to_screen(triangle[2]) };
+			rasterize(screen);
+		}
+		else {
+			rasterize_clipped(triangle);
+		}
+	}
+}
+
+static void rebuild_coarse() {
+	fill(coarse_z0.begin(), coarse_z0.end(), 0.0f);
+	for (int ty = 0; ty < tiles_y; ty++) {
+		for (int tx = 0; tx < tiles_x; tx++) {
+			float& cell = coarse_z0[(ty / coarse_size) * coarse_x + tx / coarse_size];
+			cell = max(cell, tiles[ty * tiles_x + tx].z0);
+		}
+	}
+	coarse_dirty = false;
+}
+
+bool occlusion_box_visible(const vec3& center, const vec3& half_size) {
+	stats.tested_boxes++;
+
+	float min_x = static_cast<float>(width), max_x = 0.0f;
+	float min_y = static_cast<float>(height), max_y = 0.0f;
+	float min_depth = 1.0f;
+	for (int corner = 0; corner < 8; corner++) {
+		const vec3 p = {
+			center.x + (corner & 1 ? half_size.x : -half_size.x),
+			center.y + (corner & 2 ? half_size.y : -half_size.y),
+			center.z + (corner & 4 ? half_size.z : -half_size.z)
+		};
+		const vec4 clip = transform(view_projection, p);
+		if (near_distance(clip) <= 0.0f) {
+			// reaches past the near plane, the camera may be inside it
+			return true;
+		}
+		const screen_vertex screen = to_screen(clip);
+		min_x = min(min_x, screen.x);
+		max_x = max(max_x, screen.x);
+		min_y = min(min_y, screen.y);
+		max_y = max(max_y, screen.y);
+		min_depth = min(min_depth, screen.z);
+	}
+
+	// half a pixel wider: an occluder edge can pass between the last pixel center it covers and the
+	// tile border, and things seen through that sliver must not be culled
+	const int x0 = max(0, static_cast<int>(floor(min_x - 0.5f)));
+	const int x1 = min(width - 1, static_cast<int>(floor(max_x + 0.5f)));
+	const int y0 = max(0, static_cast<int>(floor(min_y - 0.5f)));
+	const int y1 = min(height - 1, static_cast<int>(floor(max_y + 0.5f)));
+	if (x0 > x1 || y0 > y1) {
+		stats.culled_boxes++;
+		return false;
+	}
+
+	if (coarse_dirty) {
+		rebuild_coarse();
+	}
+	const int tx0 = x0 / tile_size, tx1 = x1 / tile_size;
+	const int ty0 = y0 / tile_size, ty1 = y1 / tile_size;
+	for (int cy = ty0 / coarse_size; cy <= ty1 / coarse_size; cy++) {
+		for (int cx = tx0 / coarse_size; cx <= tx1 / coarse_size; cx++) {
+			if (min_depth > coarse_z0[cy * coarse_x + cx] + depth_tolerance) {
+				continue;
+			}
+			const int row_end = min(ty1, cy * coarse_size + coarse_size - 1);
+			const int column_end = min(tx1, cx * coarse_size + coarse_size - 1);
+			for (int ty = max(ty0, cy * coarse_size); ty <= row_end; ty++) {
+				for (int tx = max(tx0, cx * coarse_size); tx <= column_end; tx++) {
+					if (min_depth <= tiles[ty * tiles_x + tx].z0 + depth_tolerance) {
+						return true;
+					}
+				}
+			}
+		}
+	}
+	stats.culled_boxes++;
+	return false;
+}
+
+const occlusion_stats& occlusion_last_stats() {
+	return stats;
+}
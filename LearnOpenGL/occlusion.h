@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "math3d.h"
+
+// masked software occlusion culling. a few big occluders are rasterized on the CPU into a small
+// depth buffer made of 8x8 pixel tiles; instead of a depth per pixel each tile keeps a coverage
+// mask and two depths: z0 - farthest depth of a layer covering the whole tile, z1 - farthest depth
+// of the triangles merged into the partially covered mask. when the mask fills up it becomes the
+// new z0. boxes are then tested against z0 with a coarse 4x4 tile level in front of it
+
+struct occlusion_stats {
+	int occluder_triangles = 0;
+	// behind the camera, back facing or too small to cover a pixel center
+	int skipped_triangles = 0;
+	int tested_boxes = 0;
+	int culled_boxes = 0;
+};
+
+// width and height are rounded up to multiples of 8
+bool occlusion_init(int width, int height);
+void occlusion_shutdown();
+
+void occlusion_begin(const mat4& view_projection);
+// triangle list of counter-clockwise, outward facing triangles, positions xyz and model
+// transformed; the mesh only hides things where it covers pixel centers
+void occlusion_add_mesh(const float* positions, int vertex_count, const uint32_t* indices, int index_count,
+	const mat4& model);
+// false if the box is hidden behind what was added since occlusion_begin(), or off screen
+bool occlusion_box_visible(const vec3& center, const vec3& half_size);
+
+const occlusion_stats& occlusion_last_stats();
@@ -0,0 +1,106 @@
+#include "occlusion_benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "bench_stats.h"
+#include "city_scene.h"
+#include "cpu_features.h"
+#include "log.h"
+#include "occlusion.h"
+
+using namespace std;
+
+// frames of the path rendered both ways and read back before the timed runs
+static const int verify_frames = 8;
+
+int run_occlusion_benchmark(const app_options& options, GLFWwindow* window, const int width, const int height) {
+	const int object_count = options.city_objects > 0 ? options.city_objects : 10000;
+	const int occluder_count = options.occluders > 0 ? options.occluders : 48;
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 120;
+	const int buffer_width = width / 4;
+	const int buffer_height = height / 4;
+
+	city_generate(object_count, 1234);
+	if (!city_init_gl() || !occlusion_init(buffer_width, buffer_height)) {
+		log("Failed to set up the occlusion benchmark");
+		return 1;
+	}
+	const mat4 projection = city_projection(static_cast<float>(width) / height);
+	vector<uint32_t> visible(object_count);
+
+	// a culled object must not have been visible: the frames have to match with and without culling
+	vector<uint8_t> reference, culled;
+	int differing = 0;
+	for (int frame = 0; frame < verify_frames; frame++) {
+		const double seconds = frame * city_loop_seconds / verify_frames;
+		const mat4 view_projection = projection * city_view(seconds);
+		city_draw(view_projection, nullptr, 0);
+		read_pixels(reference, width, height);
+		const size_t count = city_cull_occluded(view_projection, city_eye(seconds), occluder_count, nullptr, 0, visible.data());
+		city_draw(view_projection, visible.data(), count);
+		read_pixels(culled, width, height);
+		differing += differing_pixels(reference, culled);
+	}
+
+	vector<double> draw_all_ms, cull_ms, draw_visible_ms, culled_fraction;
+	for (int pass = 0; pass < 2; pass++) {
+		const bool cull = pass == 1;
+		for (int frame = 0; frame < frames; frame++) {
+			glfwPollEvents();
+			const double seconds = frame * city_loop_seconds / frames;
+			const mat4 view_projection = projection * city_view(seconds);
+
+			const bench_clock::time_point start = bench_clock::now();
+			size_t count = object_count;
+			if (cull) {
+				count = city_cull_occluded(view_projection, city_eye(seconds), occluder_count, nullptr, 0, visible.data());
+				cull_ms.push_back(elapsed_ms(start));
+				culled_fraction.push_back(1.0 - static_cast<double>(count) / object_count);
+			}
+
+			const bench_clock::time_point draw_start = bench_clock::now();
+			city_draw(view_projection, cull ? visible.data() : nullptr, count);
+			// the driver queues the draws, wait for them so the time is the frame's cost
+			glFinish();
+			(cull ? draw_visible_ms : draw_all_ms).push_back(elapsed_ms(draw_start));
+			glfwSwapBuffers(window);
+		}
+	}
+	city_release_gl();
+	occlusion_shutdown();
+
+	const bench_stats all_stats = compute_stats(draw_all_ms);
+	const bench_stats cull_stats = compute_stats(cull_ms);
+	const bench_stats visible_stats = compute_stats(draw_visible_ms);
+	const bench_stats culled_stats = compute_stats(culled_fraction);
+	const double saved_ms = all_stats.median - visible_stats.median;
+	const double saved_per_cull_ms = cull_stats.median > 0.0 ? saved_ms / cull_stats.median : 0.0;
+
+	char line[256];
+	snprintf(line, sizeof(line), "Occlusion culling: %.1f%% of %d objects culled, %.3f ms culling saves %.3f ms drawing "
+		"(%.3f -> %.3f ms), %d pixels differ", culled_stats.mean * 100.0, object_count, cull_stats.median, saved_ms,
+		all_stats.median, visible_stats.median, differing);
+	log(line);
+
+	string json = "{\n";
+	json += "  \"objects\": " + to_string(object_count) + ",\n";
+	json += "  \"occluders\": " + to_string(occluder_count) + ",\n";
+	json += "  \"buffer_width\": " + to_string(buffer_width) + ",\n";
+	json += "  \"buffer_height\": " + to_string(buffer_height) + ",\n";
+	json += "  \"frames\": " + to_string(frames) + ",\n";
+	json += string("  \"avx2\": ") + (cpu_has_avx2() ? "true" : "false") + ",\n";
+	json += "  \"renderer\": \"" + string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) + "\",\n";
+	json += "  \"draw_all_ms\": " + stats_json(all_stats) + ",\n";
+	json += "  \"cull_ms\": " + stats_json(cull_stats) + ",\n";
+	json += "  \"draw_visible_ms\": " + stats_json(visible_stats) + ",\n";
+	json += "  \"culled_fraction\": " + stats_json(culled_stats) + ",\n";
+	snprintf(line, sizeof(line), "  \"saved_ms\": %.4f,\n  \"saved_ms_per_cull_ms\": %.3f,\n", saved_ms, saved_per_cull_ms);
+	json += line;
+	json += "  \"verify_frames\": " + to_string(verify_frames) + ",\n";
+	json += "  \"differing_pixels\": " + to_string(differing) + "\n";
+	json += "}\n";
+
+	return write_bench_json(options.bench_output_path, "occlusion_bench.json", json, "Occlusion benchmark") ? 0 : 1;
+}
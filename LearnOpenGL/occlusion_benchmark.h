@@ -0,0 +1,9 @@
+#pragma once
+
+#include "app_options.h"
+#include "gl_api.h"
+
+// flies the city camera path twice in the open window, drawing every object and then only what
+// the software occlusion culling keeps, and writes per frame culling and draw times, the culled
+// fraction and the time saved per millisecond spent culling as JSON
+int run_occlusion_benchmark(const app_options& options, GLFWwindow* window, int width, int height);
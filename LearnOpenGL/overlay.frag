@@ -0,0 +1,11 @@
+#version 330 core
+
+in vec2 glyph_uv;
+out vec4 color;
+
+uniform sampler2D glyphs;
+
+void main() {
+	float coverage = texture(glyphs, glyph_uv).r;
+	color = mix(vec4(0.0, 0.0, 0.0, 0.6), vec4(1.0, 1.0, 0.6, 1.0), coverage);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 uv;
+
+uniform vec2 screen_size;
+
+out vec2 glyph_uv;
+
+void main() {
+	gl_Position = vec4(position / screen_size * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);
+	glyph_uv = uv;
+}
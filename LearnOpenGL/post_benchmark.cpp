@@ -0,0 +1,202 @@
+#include "post_benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bench_stats.h"
+#include "city_scene.h"
+#include "job_system.h"
+#include "log.h"
+#include "post_process.h"
+#include "profiler.h"
+#include "render_graph.h"
+
+using namespace std;
+
+static const int warmup_frames = 3;
+static const int default_objects = 10000;
+// channel difference the unfused chain's half float targets may account for
+static const int tolerance = 2;
+
+struct pass_samples {
+	const char* name;
+	vector<double> gpu_ms;
+};
+
+struct post_run {
+	vector<pass_samples> passes;
+	// every pass but the scene
+	vector<double> post_gpu_ms;
+	// declare, compile and execute until glFinish returns
+	vector<double> frame_ms;
+	post_chain_stats chain;
+	vector<uint8_t> pixels;
+};
+
+struct scene_frame {
+	mat4 view_projection;
+	vector<uint32_t> visible;
+	size_t visible_count;
+};
+
+// the camera a bit further down the path every frame
+static double frame_seconds(const int frame) {
+	return 2.0 + frame * 0.37;
+}
+
+static void scene_pass(const render_graph&, void* context) {
+	const scene_frame& scene = *static_cast<const scene_frame*>(context);
+	city_draw(scene.view_projection, scene.visible.data(), scene.visible_count);
+}
+
+static void add_sample(vector<pass_samples>& passes, const graph_pass_time& time) {
+	for (pass_samples& pass : passes) {
+		if (strcmp(pass.name, time.name) == 0) {
+			pass.gpu_ms.push_back(time.gpu_ms);
+			return;
+		}
+	}
+	passes.push_back({ time.name, vector<double>(1, time.gpu_ms) });
+}
+
+static void run_frames(GLFWwindow* window, const int frames, const int width, const int height, post_run& run) {
+	const mat4 projection = city_projection(static_cast<float>(width) / height);
+	render_graph graph;
+	graph.set_timing(true);
+	scene_frame scene;
+	scene.visible.resize(city_objects().size());
+	for (int frame = 0; frame < warmup_frames + frames; frame++) {
+		glfwPollEvents();
+		// the last frame is the first again, for the comparison
+		const double seconds = frame_seconds(frame < warmup_frames + frames - 1 ? frame : 0);
+		const double start = profiler_now_ms();
+		scene.view_projection = projection * city_view(seconds);
+		scene.visible_count = city_cull_frustum(scene.view_projection, false, scene.visible.data());
+		// the eye adapts at 60 Hz whatever the frames take
+		post_process_set_time(frame / 60.0);
+		graph.begin();
+		post_process_declare(graph, width, height, scene_pass, &scene, false);
+		if (graph.compile()) {
+			graph.execute(0, width, height);
+		}
+		glFinish();
+		const double frame_ms = profiler_now_ms() - start;
+		graph.collect_pass_times();
+		if (frame >= warmup_frames) {
+			double post_ms = 0.0;
+			for (const graph_pass_time& time : graph.pass_times()) {
+				add_sample(run.passes, time);
+				post_ms += strcmp(time.name, "scene") != 0 ? time.gpu_ms : 0.0;
+			}
+			run.post_gpu_ms.push_back(post_ms);
+			run.frame_ms.push_back(frame_ms);
+		}
+		if (frame == warmup_frames + frames - 1) {
+			read_pixels(run.pixels, width, height);
+		}
+		glfwSwapBuffers(window);
+	}
+	run.chain = post_process_chain_stats();
+	graph.release();
+}
+
+static string run_json(const char* name, const post_run& run) {
+	char line[256];
+	snprintf(line, sizeof(line), "  \"%s\": {\"effects\": %d, \"fullscreen_passes\": %d, ", name, run.chain.effects,
+		run.chain.passes);
+	string json = line;
+	json += "\"post_gpu_ms\": " + stats_json(compute_stats(run.post_gpu_ms));
+	json += ", \"frame_ms\": " + stats_json(compute_stats(run.frame_ms));
+	json += ", \"passes\": {";
+	for (size_t i = 0; i < run.passes.size(); i++) {
+		json += string(i > 0 ? ", " : "") + "\"" + run.passes[i].name + "\": " + stats_json(compute_stats(run.passes[i].gpu_ms));
+	}
+	json += "}}";
+	return json;
+}
+
+static void log_run(const char* name, const post_run& run) {
+	char line[256];
+	snprintf(line, sizeof(line), "Post-processing %s: %d effects in %d fullscreen passes, GPU %.3f ms, frame to finish %.2f ms",
+		name, run.chain.effects, run.chain.passes, compute_stats(run.post_gpu_ms).median,
+		compute_stats(run.frame_ms).median);
+	log(line);
+	for (const pass_samples& pass : run.passes) {
+		snprintf(line, sizeof(line), "  %-18s %.3f ms", pass.name, compute_stats(pass.gpu_ms).median);
+		log(line);
+	}
+}
+
+static bool run_chain(GLFWwindow* window, const bool fused, const bool auto_exposure, const int frames, const int width,
+	const int height, post_run& run) {
+	if (!post_process_init(fused) || (auto_exposure && !post_process_use_auto_exposure())) {
+		post_process_release();
+		return false;
+	}
+	post_process_set_camera(city_projection(static_cast<float>(width) / height));
+	run_frames(window, frames, width, height, run);
+	post_process_release();
+	return true;
+}
+
+int run_post_benchmark(const app_options& options, GLFWwindow* window, const int width, const int height) {
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 60;
+	city_generate(options.city_objects > 0 ? options.city_objects : default_objects, 1234);
+	job_system_init(0);
+	post_run fused, unfused;
+	if (!city_init_gl() || !run_chain(window, true, options.auto_exposure, frames, width, height, fused)
+		|| !run_chain(window, false, options.auto_exposure, frames, width, height, unfused)) {
+		log("Failed to set up the post-processing benchmark");
+		city_release_gl();
+		job_system_shutdown();
+		return 1;
+	}
+
+	size_t differing = 0;
+	int max_difference = 0;
+	for (size_t i = 0; i < fused.pixels.size(); i += 4) {
+		int pixel_difference = 0;
+		for (size_t channel = 0; channel < 3; channel++) {
+			pixel_difference = max(pixel_difference, abs(fused.pixels[i + channel] - unfused.pixels[i + channel]));
+		}
+		max_difference = max(max_difference, pixel_difference);
+		differing += pixel_difference > tolerance ? 1 : 0;
+	}
+	const bool match = differing * 1000 <= fused.pixels.size() / 4;
+
+	log_run("fused", fused);
+	log_run("unfused", unfused);
+	const int passes_saved = unfused.chain.passes - fused.chain.passes;
+	const double gpu_saved = compute_stats(unfused.post_gpu_ms).median - compute_stats(fused.post_gpu_ms).median;
+	char line[256];
+	snprintf(line, sizeof(line), "Post-processing: fusion saves %d fullscreen passes and %.3f ms GPU; %zu pixels differ by "
+		"more than %d (max %d)%s", passes_saved, gpu_saved, differing, tolerance, max_difference,
+		match ? "" : ", the images DIFFER");
+	log(line);
+
+	string json = "{\n";
+	json += "  \"objects\": " + to_string(city_objects().size()) + ",\n";
+	json += "  \"width\": " + to_string(width) + ",\n";
+	json += "  \"height\": " + to_string(height) + ",\n";
+	json += "  \"frames\": " + to_string(frames) + ",\n";
+	json += "  \"renderer\": \"" + string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) + "\",\n";
+	json += run_json("fused", fused) + ",\n";
+	json += run_json("unfused", unfused) + ",\n";
+	snprintf(line, sizeof(line), "  \"fullscreen_passes_saved\": %d,\n  \"gpu_ms_saved\": %.3f,\n", passes_saved, gpu_saved);
+	json += line;
+	json += "  \"differing_pixels\": " + to_string(differing) + ",\n";
+	json += "  \"max_channel_difference\": " + to_string(max_difference) + ",\n";
+	json += string("  \"images_match\": ") + (match ? "true" : "false") + "\n";
+	json += "}\n";
+
+	city_release_gl();
+	job_system_shutdown();
+
+	if (!write_bench_json(options.bench_output_path, "post_bench.json", json, "Post-processing benchmark")) {
+		return 1;
+	}
+	return match ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "app_options.h"
+#include "gl_api.h"
+
+// the city through the render graph's post-processing with the per-pixel effects fused into one
+// pass, then with a pass per effect: GPU time of every pass, the fullscreen passes fusion saves and
+// how far the two images are apart; --auto-exposure adds the histogram. writes JSON
+int run_post_benchmark(const app_options& options, GLFWwindow* window, int width, int height);
@@ -0,0 +1,579 @@
+#include "post_process.h"
+
+#include <algorithm>
+#include <string>
+
+#include "auto_exposure.h"
+#include "log.h"
+#include "shader.h"
+
+using namespace std;
+
+// scene colors above this start to glow, LDR scenes stay as they are
+static const float bloom_threshold = 1.0f;
+// horizontal and vertical blur pairs, each one widens the glow
+static const int blur_iterations = 2;
+// world units the occlusion looks around a pixel, and how dark it gets
+static const float occlusion_radius = 1.5f;
+static const float occlusion_strength = 1.0f;
+
+// the per-pixel effects in the order they apply; each is a snippet working on vec3 color at
+// screen_uv, so any run of them can share one fullscreen pass
+enum post_effect_id {
+	effect_ambient_occlusion,
+	effect_bloom,
+	effect_exposure,
+	effect_auto_exposure,
+	effect_tonemap,
+	effect_color_grade,
+	effect_vignette,
+	effect_dither,
+	effect_count
+};
+
+struct post_effect {
+	const char* name;
+	// uniforms and functions at file scope
+	const char* declarations;
+	// a block of its own in main()
+	const char* body;
+	// reads storage buffers, the chain needs GLSL 4.30
+	bool glsl_430;
+};
+
+static const post_effect effects[effect_count] = {
+	{ "ambient_occlusion", R"(
+uniform sampler2D ambient_occlusion;
+uniform sampler2D occlusion_depth;
+uniform sampler2D scene_depth;
+uniform vec2 depth_range;
+
+// the half resolution occlusion at a full resolution pixel: bilinear weights, scaled down for the
+// texels whose depth differs from the pixel's so the occlusion doesn't bleed across edges
+float upsampled_occlusion(ivec2 pixel) {
+	float near_plane = depth_range.x, far_plane = depth_range.y;
+	float depth = near_plane * far_plane / (far_plane - texelFetch(scene_depth, pixel, 0).r * (far_plane - near_plane));
+	vec2 position = (vec2(pixel) + 0.5) * 0.5 - 0.5;
+	ivec2 base = ivec2(floor(position));
+	vec2 fraction = position - vec2(base);
+	ivec2 limit = textureSize(ambient_occlusion, 0) - 1;
+	float sum = 0.0, weight_sum = 0.0;
+	for (int i = 0; i < 4; i++) {
+		ivec2 offset = ivec2(i & 1, i >> 1);
+		ivec2 texel = clamp(base + offset, ivec2(0), limit);
+		vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+		float difference = abs(texelFetch(occlusion_depth, texel, 0).r - depth) / depth;
+		float weight = (bilinear.x * bilinear.y + 0.001) / (difference * 100.0 + 0.001);
+		sum += texelFetch(ambient_occlusion, texel, 0).r * weight;
+		weight_sum += weight;
+	}
+	return sum / weight_sum;
+}
+)", R"(
+	color *= upsampled_occlusion(ivec2(gl_FragCoord.xy));
+)", false },
+	{ "bloom", R"(
+uniform sampler2D bloom;
+uniform float bloom_intensity;
+)", R"(
+	color += texture(bloom, screen_uv).rgb * bloom_intensity;
+)", false },
+	{ "exposure", R"(
+uniform float exposure;
+)", R"(
+	color *= exposure;
+)", false },
+	{ "auto_exposure", R"(
+// auto_exposure_binding, written by auto_exposure_adapt() this frame
+layout (std430, binding = 0) readonly buffer auto_exposure_result {
+	float average_luminance;
+	float exposure;
+};
+)", R"(
+	color *= exposure;
+)", true },
+	{ "tonemap", "", R"(
+	// ACES filmic curve, Narkowicz's fit
+	color = clamp(color * (2.51 * color + 0.03) / (color * (2.43 * color + 0.59) + 0.14), 0.0, 1.0);
+)", false },
+	{ "color_grade", R"(
+uniform float saturation;
+uniform float contrast;
+)", R"(
+	float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+	color = clamp((mix(vec3(luma), color, saturation) - 0.5) * contrast + 0.5, 0.0, 1.0);
+)", false },
+	{ "vignette", R"(
+uniform float vignette_strength;
+)", R"(
+	vec2 from_center = screen_uv - 0.5;
+	color *= 1.0 - vignette_strength * 2.0 * dot(from_center, from_center);
+)", false },
+	{ "dither", "", R"(
+	// half a step of an 8 bit target, so gradients don't band
+	float noise = fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+	color += (noise - 0.5) / 255.0;
+)", false },
+};
+
+// units of the chain's samplers, source is the scene or the previous pass
+static const char* const chain_samplers[] = { "source", "ambient_occlusion", "occlusion_depth", "scene_depth", "bloom" };
+enum chain_unit { source_unit, occlusion_unit, occlusion_depth_unit, scene_depth_unit, bloom_unit, chain_unit_count };
+
+struct chain_constant {
+	const char* name;
+	float value;
+};
+
+static const chain_constant chain_constants[] = {
+	{ "bloom_intensity", 0.6f },
+	{ "exposure", 1.0f },
+	{ "saturation", 1.1f },
+	{ "contrast", 1.05f },
+	{ "vignette_strength", 0.3f },
+};
+
+// a generated program for a set of effects, compiled the first time a chain needs it
+struct chain_program {
+	uint32_t effects;
+	GLuint id;
+	GLint depth_range_location;
+};
+
+// fused with and without occlusion and auto-exposure, and every effect on its own
+static const int max_chain_programs = effect_count + 4;
+
+struct chain_pass {
+	const chain_program* program;
+	graph_resource source;
+	bool last;
+};
+
+struct blur_pass {
+	graph_resource source;
+	float step_x;
+	float step_y;
+};
+
+static bool fuse = true;
+static bool has_camera = false;
+static bool auto_exposure = false;
+// since the frame before, for the eye adaptation
+static double last_seconds = -1.0;
+static float frame_seconds = 0.0f;
+static float near_plane = 0.0f;
+static float far_plane = 0.0f;
+static float tan_half_fov_x = 0.0f;
+static float tan_half_fov_y = 0.0f;
+
+static GLuint empty_vao = 0;
+static GLuint bright_program = 0;
+static GLuint blur_program = 0;
+static GLuint copy_program = 0;
+static GLuint occlusion_depth_program = 0;
+static GLuint occlusion_program = 0;
+static GLint threshold_location = -1;
+static GLint scene_texel_location = -1;
+static GLint texel_step_location = -1;
+static chain_program chain_programs[max_chain_programs];
+static int chain_program_count = 0;
+
+// what the passes need from the last declaration
+static graph_resource scene_color = invalid_graph_resource;
+static graph_resource scene_depth = invalid_graph_resource;
+static graph_resource occlusion_depth = invalid_graph_resource;
+static graph_resource occlusion = invalid_graph_resource;
+static graph_resource bloom = invalid_graph_resource;
+static graph_resource preview = invalid_graph_resource;
+static graph_resource histogram = invalid_graph_resource;
+static graph_resource exposure = invalid_graph_resource;
+static blur_pass blur_passes[blur_iterations * 2];
+static chain_pass chain_passes[effect_count];
+static post_chain_stats last_chain;
+static bool show_preview = false;
+
+static void draw_fullscreen(const GLuint program) {
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glUseProgram(program);
+	glBindVertexArray(empty_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+}
+
+static void bind_texture(const int unit, const GLuint texture) {
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+// sampler uniforms named in units order get units 0, 1 ...
+static void set_samplers(const GLuint program, const char* first, const char* second) {
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, first), 0);
+	if (second != nullptr) {
+		glUniform1i(glGetUniformLocation(program, second), 1);
+	}
+}
+
+static void set_camera_uniforms(const GLuint program) {
+	glUseProgram(program);
+	glUniform2f(glGetUniformLocation(program, "depth_range"), near_plane, far_plane);
+	glUniform2f(glGetUniformLocation(program, "tan_half_fov"), tan_half_fov_x, tan_half_fov_y);
+}
+
+static GLuint compile_chain(const uint32_t mask) {
+	bool glsl_430 = false;
+	for (int i = 0; i < effect_count; i++) {
+		glsl_430 = glsl_430 || ((mask & 1u << i) && effects[i].glsl_430);
+	}
+	string source = glsl_430 ? "#version 430 core\n" : "#version 330 core\n";
+	source += "\nin vec2 screen_uv;\nout vec4 frag_color;\n\nuniform sampler2D source;\n";
+	for (int i = 0; i < effect_count; i++) {
+		if (mask & 1u << i) {
+			source += effects[i].declarations;
+		}
+	}
+	source += "\nvoid main() {\n\tvec3 color = texelFetch(source, ivec2(gl_FragCoord.xy), 0).rgb;\n";
+	for (int i = 0; i < effect_count; i++) {
+		if (mask & 1u << i) {
+			source += string("\t// ") + effects[i].name + "\n\t{" + effects[i].body + "\t}\n";
+		}
+	}
+	source += "\tfrag_color = vec4(color, 1.0);\n}\n";
+
+	const char* vertex_source = read_file("fullscreen.vert");
+	if (vertex_source == nullptr) {
+		log("Failed to read fullscreen.vert");
+		return 0;
+	}
+	GLuint shaders[] = {
+		create_shader(vertex_source, GL_VERTEX_SHADER),
+		create_shader(source.c_str(), GL_FRAGMENT_SHADER)
+	};
+	const GLuint program = create_shader_program(shaders, 2);
+	glDeleteShader(shaders[0]);
+	glDeleteShader(shaders[1]);
+	delete[] vertex_source;
+
+	glUseProgram(program);
+	for (int unit = 0; unit < chain_unit_count; unit++) {
+		glUniform1i(glGetUniformLocation(program, chain_samplers[unit]), unit);
+	}
+	for (const chain_constant& constant : chain_constants) {
+		glUniform1f(glGetUniformLocation(program, constant.name), constant.value);
+	}
+	glUseProgram(0);
+	return program;
+}
+
+static const chain_program* chain_program_for(const uint32_t mask) {
+	for (int i = 0; i < chain_program_count; i++) {
+		if (chain_programs[i].effects == mask) {
+			return &chain_programs[i];
+		}
+	}
+	if (chain_program_count == max_chain_programs) {
+		log("Post-processing: too many effect chains");
+		return nullptr;
+	}
+	chain_program& program = chain_programs[chain_program_count++];
+	program.effects = mask;
+	program.id = compile_chain(mask);
+	program.depth_range_location = glGetUniformLocation(program.id, "depth_range");
+	if (program.depth_range_location >= 0) {
+		set_camera_uniforms(program.id);
+		glUseProgram(0);
+	}
+	return &program;
+}
+
+bool post_process_init(const bool fused) {
+	bright_program = load_program("fullscreen.vert", "bloom_bright.frag");
+	blur_program = load_program("fullscreen.vert", "bloom_blur.frag");
+	copy_program = load_program("fullscreen.vert", "copy.frag");
+	occlusion_depth_program = load_program("fullscreen.vert", "ssao_depth.frag");
+	occlusion_program = load_program("fullscreen.vert", "ssao.frag");
+	if (bright_program == 0 || blur_program == 0 || copy_program == 0 || occlusion_depth_program == 0
+		|| occlusion_program == 0) {
+		post_process_release();
+		return false;
+	}
+	fuse = fused;
+	set_samplers(bright_program, "scene", nullptr);
+	set_samplers(blur_program, "source", nullptr);
+	set_samplers(copy_program, "source", nullptr);
+	set_samplers(occlusion_depth_program, "scene_depth", nullptr);
+	set_samplers(occlusion_program, "linear_depth", nullptr);
+	glUniform1f(glGetUniformLocation(occlusion_program, "radius"), occlusion_radius);
+	glUniform1f(glGetUniformLocation(occlusion_program, "strength"), occlusion_strength);
+	set_camera_uniforms(occlusion_depth_program);
+	set_camera_uniforms(occlusion_program);
+	glUseProgram(0);
+	threshold_location = glGetUniformLocation(bright_program, "threshold");
+	scene_texel_location = glGetUniformLocation(bright_program, "scene_texel");
+	texel_step_location = glGetUniformLocation(blur_program, "texel_step");
+
+	// core profile draws need a vertex array, even without attributes
+	glGenVertexArrays(1, &empty_vao);
+	return true;
+}
+
+void post_process_release() {
+	glDeleteProgram(bright_program);
+	glDeleteProgram(blur_program);
+	glDeleteProgram(copy_program);
+	glDeleteProgram(occlusion_depth_program);
+	glDeleteProgram(occlusion_program);
+	if (auto_exposure) {
+		auto_exposure_release();
+		auto_exposure = false;
+	}
+	last_seconds = -1.0;
+	for (int i = 0; i < chain_program_count; i++) {
+		glDeleteProgram(chain_programs[i].id);
+	}
+	chain_program_count = 0;
+	glDeleteVertexArrays(1, &empty_vao);
+	bright_program = blur_program = copy_program = occlusion_depth_program = occlusion_program = empty_vao = 0;
+}
+
+void post_process_set_camera(const mat4& projection) {
+	// back out of perspective()
+	near_plane = projection.m[14] / (projection.m[10] - 1.0f);
+	far_plane = projection.m[14] / (projection.m[10] + 1.0f);
+	tan_half_fov_x = 1.0f / projection.m[0];
+	tan_half_fov_y = 1.0f / projection.m[5];
+	has_camera = true;
+	if (occlusion_program != 0) {
+		set_camera_uniforms(occlusion_depth_program);
+		set_camera_uniforms(occlusion_program);
+		for (int i = 0; i < chain_program_count; i++) {
+			if (chain_programs[i].depth_range_location >= 0) {
+				set_camera_uniforms(chain_programs[i].id);
+			}
+		}
+		glUseProgram(0);
+	}
+}
+
+bool post_process_use_auto_exposure() {
+	auto_exposure = auto_exposure || auto_exposure_init();
+	return auto_exposure;
+}
+
+void post_process_set_time(const double seconds) {
+	frame_seconds = last_seconds >= 0.0 ? static_cast<float>(seconds - last_seconds) : 0.0f;
+	last_seconds = seconds;
+}
+
+post_chain_stats post_process_chain_stats() {
+	return last_chain;
+}
+
+static void occlusion_depth_pass(const render_graph& graph, void*) {
+	bind_texture(0, graph.texture(scene_depth));
+	draw_fullscreen(occlusion_depth_program);
+	bind_texture(0, 0);
+}
+
+static void occlusion_pass(const render_graph& graph, void*) {
+	bind_texture(0, graph.texture(occlusion_depth));
+	draw_fullscreen(occlusion_program);
+	bind_texture(0, 0);
+}
+
+static void histogram_pass(const render_graph& graph, void*) {
+	const graph_texture_desc& desc = graph.texture_desc(scene_color);
+	auto_exposure_histogram(graph.texture(scene_color), desc.width, desc.height, graph.buffer(histogram));
+}
+
+static void adapt_pass(const render_graph& graph, void*) {
+	const graph_texture_desc& desc = graph.texture_desc(scene_color);
+	auto_exposure_adapt(graph.buffer(histogram), desc.width, desc.height, frame_seconds, graph.buffer(exposure));
+}
+
+static void bright_pass(const render_graph& graph, void*) {
+	const graph_texture_desc& desc = graph.texture_desc(scene_color);
+	bind_texture(0, graph.texture(scene_color));
+	glUseProgram(bright_program);
+	glUniform1f(threshold_location, bloom_threshold);
+	glUniform2f(scene_texel_location, 1.0f / desc.width, 1.0f / desc.height);
+	draw_fullscreen(bright_program);
+}
+
+static void blur(const render_graph& graph, void* context) {
+	const blur_pass& pass = *static_cast<const blur_pass*>(context);
+	bind_texture(0, graph.texture(pass.source));
+	glUseProgram(blur_program);
+	glUniform2f(texel_step_location, pass.step_x, pass.step_y);
+	draw_fullscreen(blur_program);
+}
+
+static void preview_pass(const render_graph& graph, void*) {
+	bind_texture(0, graph.texture(bloom));
+	draw_fullscreen(copy_program);
+}
+
+static void chain(const render_graph& graph, void* context) {
+	const chain_pass& pass = *static_cast<const chain_pass*>(context);
+	const uint32_t mask = pass.program->effects;
+	bind_texture(source_unit, graph.texture(pass.source));
+	if (mask & 1u << effect_ambient_occlusion) {
+		bind_texture(occlusion_unit, graph.texture(occlusion));
+		bind_texture(occlusion_depth_unit, graph.texture(occlusion_depth));
+		bind_texture(scene_depth_unit, graph.texture(scene_depth));
+	}
+	if (mask & 1u << effect_bloom) {
+		bind_texture(bloom_unit, graph.texture(bloom));
+	}
+	if (mask & 1u << effect_auto_exposure) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, auto_exposure_binding, graph.buffer(exposure));
+	}
+	draw_fullscreen(pass.program->id);
+
+	if (pass.last && show_preview) {
+		// top right corner, the overlay has the left
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		const graph_texture_desc& desc = graph.texture_desc(preview);
+		glViewport(viewport[2] - desc.width - 8, viewport[3] - desc.height - 8, desc.width, desc.height);
+		bind_texture(source_unit, graph.texture(preview));
+		draw_fullscreen(copy_program);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	}
+	for (int unit = chain_unit_count - 1; unit >= 0; unit--) {
+		bind_texture(unit, 0);
+	}
+}
+
+void post_process_declare(render_graph& graph, const int width, const int height, const graph_pass_function scene,
+	void* scene_context, const bool preview_bloom) {
+	graph_texture_desc full;
+	full.width = width;
+	full.height = height;
+	full.format = GL_RGBA16F;
+	graph_texture_desc depth = full;
+	depth.format = GL_DEPTH24_STENCIL8;
+	graph_texture_desc half = full;
+	half.width = max(1, width / 2);
+	half.height = max(1, height / 2);
+	graph_texture_desc quarter = full;
+	quarter.width = max(1, width / 4);
+	quarter.height = max(1, height / 4);
+	graph_texture_desc preview_desc = quarter;
+	preview_desc.format = GL_RGBA8;
+
+	scene_color = graph.create_texture("scene_color", full);
+	scene_depth = graph.create_texture("scene_depth", depth);
+	const int scene_pass = graph.add_pass("scene", scene, scene_context);
+	graph.write(scene_pass, scene_color);
+	graph.write(scene_pass, scene_depth);
+
+	uint32_t chain_effects = (1u << effect_count) - 1;
+	if (auto_exposure) {
+		chain_effects &= ~(1u << effect_exposure);
+		histogram = graph.create_buffer("luminance_histogram", auto_exposure_histogram_bytes);
+		const int histogram_index = graph.add_pass("luminance_histogram", histogram_pass, nullptr);
+		graph.read(histogram_index, scene_color);
+		graph.write(histogram_index, histogram);
+
+		exposure = graph.create_buffer("exposure", auto_exposure_result_bytes);
+		const int adapt_index = graph.add_pass("exposure_adapt", adapt_pass, nullptr);
+		graph.read(adapt_index, histogram);
+		graph.write(adapt_index, exposure);
+	}
+	else {
+		chain_effects &= ~(1u << effect_auto_exposure);
+	}
+	if (has_camera) {
+		half.format = GL_R32F;
+		occlusion_depth = graph.create_texture("ssao_depth", half);
+		const int depth_pass = graph.add_pass("ssao_depth", occlusion_depth_pass, nullptr);
+		graph.read(depth_pass, scene_depth);
+		graph.write(depth_pass, occlusion_depth);
+
+		half.format = GL_R8;
+		occlusion = graph.create_texture("ssao", half);
+		const int pass = graph.add_pass("ssao", occlusion_pass, nullptr);
+		graph.read(pass, occlusion_depth);
+		graph.write(pass, occlusion);
+	}
+	else {
+		chain_effects &= ~(1u << effect_ambient_occlusion);
+	}
+
+	const graph_resource bright = graph.create_texture("bloom_bright", quarter);
+	const int threshold_pass = graph.add_pass("bloom_bright", bright_pass, nullptr);
+	graph.read(threshold_pass, scene_color);
+	graph.write(threshold_pass, bright);
+
+	// ping-pong through a fresh resource per step; the graph aliases them back onto two textures
+	graph_resource source = bright;
+	for (int i = 0; i < blur_iterations * 2; i++) {
+		const bool horizontal = i % 2 == 0;
+		blur_pass& pass_context = blur_passes[i];
+		pass_context.source = source;
+		pass_context.step_x = horizontal ? 1.0f / quarter.width : 0.0f;
+		pass_context.step_y = horizontal ? 0.0f : 1.0f / quarter.height;
+
+		const graph_resource blurred = graph.create_texture(horizontal ? "bloom_blur_x" : "bloom_blur_y", quarter);
+		const int pass = graph.add_pass(horizontal ? "bloom_blur_x" : "bloom_blur_y", blur, &pass_context);
+		graph.read(pass, source);
+		graph.write(pass, blurred);
+		source = blurred;
+	}
+	bloom = source;
+
+	preview = graph.create_texture("bloom_preview", preview_desc);
+	const int preview_index = graph.add_pass("bloom_preview", preview_pass, nullptr);
+	graph.read(preview_index, bloom);
+	graph.write(preview_index, preview);
+	show_preview = preview_bloom;
+
+	// fused, one pass takes every effect; otherwise one pass per effect, through HDR targets the
+	// graph aliases onto two
+	last_chain.effects = 0;
+	last_chain.passes = 0;
+	for (int i = 0; i < effect_count; i++) {
+		last_chain.effects += chain_effects & 1u << i ? 1 : 0;
+	}
+	source = scene_color;
+	for (int i = 0; i < effect_count; i++) {
+		if (!(chain_effects & 1u << i)) {
+			continue;
+		}
+		const uint32_t remaining = chain_effects & ~((1u << i) - 1);
+		const uint32_t mask = fuse ? remaining : 1u << i;
+		const chain_program* program = chain_program_for(mask);
+		if (program == nullptr) {
+			return;
+		}
+		chain_pass& pass_context = chain_passes[last_chain.passes++];
+		pass_context.program = program;
+		pass_context.source = source;
+		pass_context.last = mask == remaining;
+
+		const int pass = graph.add_pass(fuse ? "post_chain" : effects[i].name, chain, &pass_context);
+		graph.read(pass, source);
+		if (mask & 1u << effect_ambient_occlusion) {
+			graph.read(pass, occlusion);
+			graph.read(pass, occlusion_depth);
+			graph.read(pass, scene_depth);
+		}
+		if (mask & 1u << effect_bloom) {
+			graph.read(pass, bloom);
+		}
+		if (mask & 1u << effect_auto_exposure) {
+			graph.read(pass, exposure);
+		}
+		if (pass_context.last) {
+			if (show_preview) {
+				graph.read(pass, preview);
+			}
+			graph.write(pass, graph.backbuffer());
+			break;
+		}
+		source = graph.create_texture("post_chain", full);
+		graph.write(pass, source);
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "math3d.h"
+#include "render_graph.h"
+
+// post-processing through the render graph: the scene goes into an HDR target, ambient occlusion is
+// taken at half resolution and bloom at quarter resolution, then the per-pixel effects - the
+// occlusion through a depth aware upsample, bloom, exposure, tonemapping, color grading, vignette
+// and dither - run as one fullscreen pass whose shader is generated from their snippets. unfused,
+// each effect gets a pass of its own through an HDR target, to compare against. preview also shows
+// the blurred bloom in a corner; without it the preview pass is still declared, and culled
+bool post_process_init(bool fused);
+void post_process_release();
+// ambient occlusion for a scene drawn with this projection, from perspective(); without a camera
+// the depth buffer isn't known to hold anything and the occlusion is left out
+void post_process_set_camera(const mat4& projection);
+// exposure from a GPU luminance histogram of the scene (auto_exposure.h) instead of a fixed one;
+// false without GL 4.3
+bool post_process_use_auto_exposure();
+// wall clock time of the frame about to be declared, the eye adapts by the time since the last
+void post_process_set_time(double seconds);
+// scene draws into the bound target, which has a depth buffer
+void post_process_declare(render_graph& graph, int width, int height, graph_pass_function scene, void* scene_context,
+	bool preview);
+
+struct post_chain_stats {
+	// per-pixel effects of the last declaration, and the fullscreen passes applying them
+	int effects = 0;
+	int passes = 0;
+};
+post_chain_stats post_process_chain_stats();
@@ -0,0 +1,177 @@
+#include "profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <Windows.h>
+
+#include "log.h"
+
+using namespace std;
+
+using profiler_clock = chrono::steady_clock;
+
+static profiler_clock::time_point origin;
+static double pre_main_ms = 0.0;
+static double first_frame_ms = -1.0;
+static thread::id recording_thread;
+
+static vector<profile_zone_record> zones;
+static vector<pair<const char*, double>> notes;
+static thread_local vector<const char*> zone_stack;
+static thread_local vector<size_t> open_records;
+static const size_t not_recorded = static_cast<size_t>(-1);
+
+// time between process creation and the call to profiler_init(): image loading, CRT and static init
+static double measure_pre_main_ms() {
+	FILETIME creation, exit, kernel, user, now;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+		return 0.0;
+	}
+	GetSystemTimePreciseAsFileTime(&now);
+
+	ULARGE_INTEGER created, current;
+	created.LowPart = creation.dwLowDateTime;
+	created.HighPart = creation.dwHighDateTime;
+	current.LowPart = now.dwLowDateTime;
+	current.HighPart = now.dwHighDateTime;
+
+	// FILETIME ticks are 100 ns
+	return current.QuadPart > created.QuadPart ? (current.QuadPart - created.QuadPart) / 10000.0 : 0.0;
+}
+
+double profiler_process_cpu_ms() {
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+		return -1.0;
+	}
+	ULARGE_INTEGER kernel_ticks, user_ticks;
+	kernel_ticks.LowPart = kernel.dwLowDateTime;
+	kernel_ticks.HighPart = kernel.dwHighDateTime;
+	user_ticks.LowPart = user.dwLowDateTime;
+	user_ticks.HighPart = user.dwHighDateTime;
+	// FILETIME ticks are 100 ns
+	return (kernel_ticks.QuadPart + user_ticks.QuadPart) / 10000.0;
+}
+
+void profiler_init() {
+	origin = profiler_clock::now();
+	pre_main_ms = measure_pre_main_ms();
+	recording_thread = this_thread::get_id();
+	zones.reserve(64);
+}
+
+double profiler_now_ms() {
+	return chrono::duration<double, milli>(profiler_clock::now() - origin).count();
+}
+
+static bool recording() {
+	return this_thread::get_id() == recording_thread && first_frame_ms < 0.0;
+}
+
+void profiler_begin(const char* name) {
+	if (recording()) {
+		open_records.push_back(zones.size());
+		zones.push_back({ name, static_cast<int>(zone_stack.size()), profiler_now_ms(), 0.0 });
+	}
+	else {
+		open_records.push_back(not_recorded);
+	}
+	zone_stack.push_back(name);
+}
+
+void profiler_end() {
+	if (zone_stack.empty()) {
+		return;
+	}
+	zone_stack.pop_back();
+
+	const size_t index = open_records.back();
+	open_records.pop_back();
+	if (index != not_recorded) {
+		zones[index].duration_ms = profiler_now_ms() - zones[index].start_ms;
+	}
+}
+
+const char* profiler_current_zone() {
+	return zone_stack.empty() ? nullptr : zone_stack.back();
+}
+
+void startup_note(const char* key, const double value) {
+	notes.emplace_back(key, value);
+}
+
+static double executable_bytes() {
+	char path[MAX_PATH];
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (GetModuleFileNameA(nullptr, path, MAX_PATH) == 0
+		|| !GetFileAttributesExA(path, GetFileExInfoStandard, &attributes)) {
+		return 0.0;
+	}
+	return static_cast<double>(attributes.nFileSizeLow) + attributes.nFileSizeHigh * 4294967296.0;
+}
+
+void startup_first_frame_presented() {
+	if (first_frame_ms < 0.0) {
+		first_frame_ms = profiler_now_ms();
+		startup_note("binary_bytes", executable_bytes());
+	}
+}
+
+bool startup_complete() {
+	return first_frame_ms >= 0.0;
+}
+
+static string format_ms(const double value) {
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.3f", value);
+	return buffer;
+}
+
+string startup_report_json() {
+	string json = "{\n";
+	json += "  \"pre_main_ms\": " + format_ms(pre_main_ms) + ",\n";
+	json += "  \"main_to_first_frame_ms\": " + format_ms(first_frame_ms) + ",\n";
+	json += "  \"total_ms\": " + format_ms(pre_main_ms + first_frame_ms) + ",\n";
+	json += "  \"notes\": {";
+	for (size_t i = 0; i < notes.size(); i++) {
+		json += string(i > 0 ? ", " : "") + "\"" + notes[i].first + "\": " + format_ms(notes[i].second);
+	}
+	json += "},\n";
+	json += "  \"phases\": [\n";
+
+	for (size_t i = 0; i < zones.size(); i++) {
+		const profile_zone_record& zone = zones[i];
+		json += "    {\"name\": \"";
+		json += zone.name;
+		json += "\", \"depth\": " + to_string(zone.depth);
+		json += ", \"start_ms\": " + format_ms(zone.start_ms);
+		json += ", \"duration_ms\": " + format_ms(zone.duration_ms) + "}";
+		json += i + 1 < zones.size() ? ",\n" : "\n";
+	}
+
+	json += "  ]\n}\n";
+	return json;
+}
+
+void log_startup_report() {
+	log("Startup breakdown (ms):");
+	log("  pre_main " + format_ms(pre_main_ms));
+	for (const profile_zone_record& zone : zones) {
+		log(string(2 + 2 * zone.depth, ' ') + zone.name + " " + format_ms(zone.duration_ms));
+	}
+	log("  first frame presented at " + format_ms(pre_main_ms + first_frame_ms));
+	for (const auto& note : notes) {
+		log(string("  ") + note.first + " " + format_ms(note.second));
+	}
+}
+
+bool write_startup_report(const string& path) {
+	ofstream file(path, ios::out | ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+	file << startup_report_json();
+	return file.good();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// wall clock zones; every zone opened before the first presented frame
+// ends up in the startup report
+struct profile_zone_record {
+	const char* name;
+	int depth;
+	double start_ms;
+	double duration_ms;
+};
+
+void profiler_init();
+// milliseconds since profiler_init()
+double profiler_now_ms();
+// user and kernel time of the whole process (negative - unavailable)
+double profiler_process_cpu_ms();
+
+void profiler_begin(const char* name);
+void profiler_end();
+// innermost open zone, or nullptr
+const char* profiler_current_zone();
+
+class profile_scope {
+public:
+	explicit profile_scope(const char* name) { profiler_begin(name); }
+	~profile_scope() { profiler_end(); }
+
+	profile_scope(const profile_scope&) = delete;
+	profile_scope& operator=(const profile_scope&) = delete;
+};
+
+// startup report - everything from process creation up to the first presented frame
+void startup_first_frame_presented();
+// extra numbers for the report, e.g. how many GL functions were loaded
+void startup_note(const char* key, double value);
+bool startup_complete();
+std::string startup_report_json();
+void log_startup_report();
+bool write_startup_report(const std::string& path);
@@ -0,0 +1,552 @@
+#include "render_graph.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "gpu_resources.h"
+#include "log.h"
+#include "profiler.h"
+
+using namespace std;
+
+struct texture_format {
+	GLenum internal_format;
+	GLenum format;
+	GLenum type;
+	int bytes_per_pixel;
+	bool depth;
+};
+
+static const texture_format texture_formats[] = {
+	{ GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false },
+	{ GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, false },
+	{ GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, false },
+	{ GL_RG16F, GL_RG, GL_HALF_FLOAT, 4, false },
+	{ GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, 4, false },
+	{ GL_R32F, GL_RED, GL_FLOAT, 4, false },
+	{ GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4, true },
+	{ GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4, true },
+};
+
+static const texture_format& format_of(const GLenum internal_format) {
+	for (const texture_format& format : texture_formats) {
+		if (format.internal_format == internal_format) {
+			return format;
+		}
+	}
+	log("Render graph: unsupported texture format, using GL_RGBA8");
+	return texture_formats[0];
+}
+
+static uint64_t hash_bytes(uint64_t hash, const void* data, const size_t size) {
+	// FNV-1a
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+template <typename T>
+static uint64_t hash_value(const uint64_t hash, const T& value) {
+	return hash_bytes(hash, &value, sizeof(value));
+}
+
+render_graph::~render_graph() {
+	release();
+}
+
+void render_graph::begin() {
+	resources.clear();
+	passes.clear();
+	backbuffer_resource = invalid_graph_resource;
+	declaration_error = false;
+}
+
+graph_resource render_graph::create_texture(const char* name, const graph_texture_desc& desc) {
+	resource_node resource = {};
+	resource.name = name;
+	resource.desc = desc;
+	resource.bytes = static_cast<size_t>(desc.width) * desc.height * format_of(desc.format).bytes_per_pixel;
+	resource.writer = -1;
+	resources.push_back(resource);
+	return static_cast<graph_resource>(resources.size() - 1);
+}
+
+graph_resource render_graph::create_buffer(const char* name, const size_t bytes) {
+	resource_node resource = {};
+	resource.name = name;
+	resource.is_buffer = true;
+	resource.bytes = bytes;
+	resource.writer = -1;
+	resources.push_back(resource);
+	return static_cast<graph_resource>(resources.size() - 1);
+}
+
+graph_resource render_graph::backbuffer() {
+	if (backbuffer_resource == invalid_graph_resource) {
+		resource_node resource = {};
+		resource.name = "backbuffer";
+		resource.is_backbuffer = true;
+		resource.writer = -1;
+		resources.push_back(resource);
+		backbuffer_resource = static_cast<graph_resource>(resources.size() - 1);
+	}
+	return backbuffer_resource;
+}
+
+int render_graph::add_pass(const char* name, const graph_pass_function execute, void* context) {
+	pass_node pass = {};
+	pass.name = name;
+	pass.execute = execute;
+	pass.context = context;
+	passes.push_back(pass);
+	return static_cast<int>(passes.size() - 1);
+}
+
+void render_graph::read(const int pass, const graph_resource resource) {
+	pass_node& node = passes[pass];
+	if (node.read_count == max_pass_reads || resources[resource].is_backbuffer) {
+		log(string("Render graph: pass ") + node.name + " can't read " + resources[resource].name);
+		declaration_error = true;
+		return;
+	}
+	node.reads[node.read_count++] = resource;
+}
+
+void render_graph::write(const int pass, const graph_resource resource) {
+	pass_node& node = passes[pass];
+	resource_node& written = resources[resource];
+	if (node.write_count == max_pass_writes || (!written.is_backbuffer && written.writer >= 0)) {
+		log(string("Render graph: pass ") + node.name + " can't write " + written.name);
+		declaration_error = true;
+		return;
+	}
+	node.writes[node.write_count++] = resource;
+	if (!written.is_backbuffer) {
+		written.writer = pass;
+	}
+}
+
+uint64_t render_graph::declaration_hash() const {
+	uint64_t hash = 14695981039346656037ull;
+	hash = hash_value(hash, aliasing);
+	for (const resource_node& resource : resources) {
+		hash = hash_value(hash, resource.name);
+		hash = hash_value(hash, resource.is_buffer);
+		hash = hash_value(hash, resource.is_backbuffer);
+		hash = hash_value(hash, resource.desc.width);
+		hash = hash_value(hash, resource.desc.height);
+		hash = hash_value(hash, resource.desc.format);
+		hash = hash_value(hash, resource.bytes);
+	}
+	for (const pass_node& pass : passes) {
+		hash = hash_value(hash, pass.name);
+		hash = hash_value(hash, pass.execute);
+		hash = hash_bytes(hash, pass.reads, pass.read_count * sizeof(graph_resource));
+		hash = hash_value(hash, pass.read_count);
+		hash = hash_bytes(hash, pass.writes, pass.write_count * sizeof(graph_resource));
+		hash = hash_value(hash, pass.write_count);
+	}
+	return hash;
+}
+
+bool render_graph::compile() {
+	if (declaration_error) {
+		compiled = false;
+		return false;
+	}
+	const uint64_t hash = declaration_hash();
+	if (compiled && hash == compiled_hash) {
+		for (size_t i = 0; i < resources.size(); i++) {
+			resources[i].physical = compiled_physical[i];
+		}
+		last_stats.cached_compiles++;
+		return true;
+	}
+	compiled = false;
+	last_stats.compiles++;
+
+	for (const pass_node& pass : passes) {
+		for (int i = 0; i < pass.read_count; i++) {
+			const resource_node& resource = resources[pass.reads[i]];
+			if (resource.writer < 0) {
+				log(string("Render graph: ") + resource.name + " is read by " + pass.name + " but never written");
+				return false;
+			}
+		}
+	}
+
+	// culling: whatever writes the backbuffer, and everything that feeds a pass already kept
+	stack.clear();
+	for (size_t p = 0; p < passes.size(); p++) {
+		pass_node& pass = passes[p];
+		pass.needed = false;
+		for (int i = 0; i < pass.write_count; i++) {
+			if (resources[pass.writes[i]].is_backbuffer) {
+				pass.needed = true;
+			}
+		}
+		if (pass.needed) {
+			stack.push_back(static_cast<int>(p));
+		}
+	}
+	while (!stack.empty()) {
+		const pass_node& pass = passes[stack.back()];
+		stack.pop_back();
+		for (int i = 0; i < pass.read_count; i++) {
+			pass_node& writer = passes[resources[pass.reads[i]].writer];
+			if (!writer.needed) {
+				writer.needed = true;
+				stack.push_back(resources[pass.reads[i]].writer);
+			}
+		}
+	}
+
+	// ordering: a pass waits for the writers of what it reads, and backbuffer writes stay in
+	// declaration order; of the passes ready to run the earliest declared goes first
+	indegree.assign(passes.size(), 0);
+	int previous_backbuffer_writer = -1;
+	size_t needed_count = 0;
+	for (size_t p = 0; p < passes.size(); p++) {
+		const pass_node& pass = passes[p];
+		if (!pass.needed) {
+			continue;
+		}
+		needed_count++;
+		for (int i = 0; i < pass.read_count; i++) {
+			indegree[p] += resources[pass.reads[i]].writer != static_cast<int>(p) ? 1 : 0;
+		}
+		for (int i = 0; i < pass.write_count; i++) {
+			if (resources[pass.writes[i]].is_backbuffer) {
+				indegree[p] += previous_backbuffer_writer >= 0 ? 1 : 0;
+				previous_backbuffer_writer = static_cast<int>(p);
+			}
+		}
+	}
+	order.clear();
+	emitted.assign(passes.size(), false);
+	while (order.size() < needed_count) {
+		int next = -1;
+		for (size_t p = 0; p < passes.size() && next < 0; p++) {
+			if (passes[p].needed && !emitted[p] && indegree[p] == 0) {
+				next = static_cast<int>(p);
+			}
+		}
+		if (next < 0) {
+			log("Render graph: the passes depend on each other in a cycle");
+			return false;
+		}
+		emitted[next] = true;
+		order.push_back(next);
+
+		bool writes_backbuffer = false;
+		for (int i = 0; i < passes[next].write_count; i++) {
+			writes_backbuffer = writes_backbuffer || resources[passes[next].writes[i]].is_backbuffer;
+		}
+		bool released_backbuffer_writer = false;
+		for (size_t p = 0; p < passes.size(); p++) {
+			const pass_node& pass = passes[p];
+			if (!pass.needed || emitted[p]) {
+				continue;
+			}
+			for (int i = 0; i < pass.read_count; i++) {
+				indegree[p] -= resources[pass.reads[i]].writer == next ? 1 : 0;
+			}
+			// the next backbuffer writer in declaration order
+			if (writes_backbuffer && !released_backbuffer_writer && static_cast<int>(p) > next) {
+				for (int i = 0; i < pass.write_count; i++) {
+					if (resources[pass.writes[i]].is_backbuffer && !released_backbuffer_writer) {
+						indegree[p]--;
+						released_backbuffer_writer = true;
+					}
+				}
+			}
+		}
+	}
+
+	// lifetimes in pass order
+	for (resource_node& resource : resources) {
+		resource.first_use = resource.last_use = -1;
+		resource.physical = -1;
+	}
+	for (size_t position = 0; position < order.size(); position++) {
+		const pass_node& pass = passes[order[position]];
+		const int at = static_cast<int>(position);
+		for (int i = 0; i < pass.read_count + pass.write_count; i++) {
+			resource_node& resource = resources[i < pass.read_count ? pass.reads[i] : pass.writes[i - pass.read_count]];
+			resource.first_use = resource.first_use < 0 ? at : resource.first_use;
+			resource.last_use = max(resource.last_use, at);
+		}
+	}
+
+	// physical resources, handed out in pass order: a slot is free again after its last user's
+	// last pass, and only goes to a resource of the same size and format
+	for (physical_resource& slot : physical) {
+		slot.used = false;
+		slot.busy_until = -1;
+	}
+	last_stats.unaliased_bytes = 0;
+	last_stats.transient_resources = 0;
+	for (size_t position = 0; position < order.size(); position++) {
+		for (resource_node& resource : resources) {
+			if (resource.first_use == static_cast<int>(position) && !resource.is_backbuffer) {
+				assign_physical(resource);
+				last_stats.unaliased_bytes += resource.bytes;
+				last_stats.transient_resources++;
+			}
+		}
+	}
+
+	last_stats.aliased_bytes = 0;
+	last_stats.physical_resources = 0;
+	for (physical_resource& slot : physical) {
+		if (!slot.used) {
+			// nothing needs it any more, e.g. after a resize
+			destroy_physical(slot);
+			slot.bytes = 0;
+			continue;
+		}
+		if (slot.name == 0) {
+			create_physical(slot);
+		}
+		last_stats.aliased_bytes += slot.bytes;
+		last_stats.physical_resources++;
+	}
+	last_stats.passes = passes.size();
+	last_stats.culled_passes = passes.size() - order.size();
+
+	compiled_physical.resize(resources.size());
+	for (size_t i = 0; i < resources.size(); i++) {
+		compiled_physical[i] = resources[i].physical;
+	}
+	compiled_hash = hash;
+	compiled = true;
+	return true;
+}
+
+void render_graph::assign_physical(resource_node& resource) {
+	int best = -1;
+	for (size_t i = 0; i < physical.size(); i++) {
+		const physical_resource& slot = physical[i];
+		const bool free = aliasing ? slot.busy_until < resource.first_use : !slot.used;
+		if (!free || slot.bytes == 0 || slot.is_buffer != resource.is_buffer) {
+			continue;
+		}
+		// buffers fit into anything big enough, textures need the same size and format
+		const bool fits = resource.is_buffer ? slot.bytes >= resource.bytes
+			: slot.desc.width == resource.desc.width && slot.desc.height == resource.desc.height
+				&& slot.desc.format == resource.desc.format;
+		if (fits && (best < 0 || slot.bytes < physical[best].bytes)) {
+			best = static_cast<int>(i);
+		}
+	}
+	if (best < 0) {
+		// an empty slot, its GL object is created at the end of the compile
+		for (size_t i = 0; i < physical.size() && best < 0; i++) {
+			if (physical[i].bytes == 0) {
+				best = static_cast<int>(i);
+			}
+		}
+		if (best < 0) {
+			physical.push_back(physical_resource());
+			best = static_cast<int>(physical.size() - 1);
+		}
+		physical_resource& slot = physical[best];
+		slot.is_buffer = resource.is_buffer;
+		slot.desc = resource.desc;
+		slot.bytes = resource.bytes;
+	}
+	physical_resource& slot = physical[best];
+	slot.used = true;
+	slot.busy_until = resource.last_use;
+	resource.physical = best;
+}
+
+void render_graph::create_physical(physical_resource& slot) {
+	if (slot.is_buffer) {
+		gpu_category_scope category(gpu_category::streaming);
+		glGenBuffers(1, &slot.name);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.name);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, slot.bytes, nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		return;
+	}
+
+	gpu_category_scope category(gpu_category::render_target);
+	const texture_format& format = format_of(slot.desc.format);
+	glGenTextures(1, &slot.name);
+	glBindTexture(GL_TEXTURE_2D, slot.name);
+	glTexImage2D(GL_TEXTURE_2D, 0, format.internal_format, slot.desc.width, slot.desc.height, 0, format.format,
+		format.type, nullptr);
+	const GLint filter = format.depth ? GL_NEAREST : GL_LINEAR;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void render_graph::destroy_physical(physical_resource& slot) {
+	if (slot.name == 0) {
+		return;
+	}
+	if (slot.is_buffer) {
+		glDeleteBuffers(1, &slot.name);
+	}
+	else {
+		// framebuffers with it attached go too
+		for (size_t i = 0; i < framebuffers.size();) {
+			const GLuint* attachments = framebuffers[i].attachments;
+			if (find(attachments, attachments + max_pass_writes, slot.name) != attachments + max_pass_writes) {
+				glDeleteFramebuffers(1, &framebuffers[i].framebuffer);
+				framebuffers[i] = framebuffers.back();
+				framebuffers.pop_back();
+			}
+			else {
+				i++;
+			}
+		}
+		glDeleteTextures(1, &slot.name);
+	}
+	slot.name = 0;
+}
+
+GLuint render_graph::framebuffer_for(const pass_node& pass, int* width, int* height) {
+	framebuffer_entry key = {};
+	int colors = 0;
+	bool stencil = false;
+	for (int i = 0; i < pass.write_count; i++) {
+		const resource_node& resource = resources[pass.writes[i]];
+		if (resource.is_backbuffer) {
+			return target_framebuffer;
+		}
+		if (resource.is_buffer) {
+			continue;
+		}
+		const GLuint name = physical[resource.physical].name;
+		if (format_of(resource.desc.format).depth) {
+			key.attachments[max_pass_writes - 1] = name;
+			stencil = resource.desc.format == GL_DEPTH24_STENCIL8;
+		}
+		else {
+			key.attachments[colors++] = name;
+		}
+		*width = resource.desc.width;
+		*height = resource.desc.height;
+	}
+	if (colors == 0 && key.attachments[max_pass_writes - 1] == 0) {
+		// only buffers written
+		return target_framebuffer;
+	}
+
+	for (const framebuffer_entry& entry : framebuffers) {
+		if (equal(entry.attachments, entry.attachments + max_pass_writes, key.attachments)) {
+			return entry.framebuffer;
+		}
+	}
+	glGenFramebuffers(1, &key.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, key.framebuffer);
+	GLenum draw_buffers[max_pass_writes];
+	for (int i = 0; i < colors; i++) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, key.attachments[i], 0);
+		draw_buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+	if (key.attachments[max_pass_writes - 1] != 0) {
+		const GLenum attachment = stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, key.attachments[max_pass_writes - 1], 0);
+	}
+	if (colors > 0) {
+		glDrawBuffers(colors, draw_buffers);
+	}
+	else {
+		glDrawBuffer(GL_NONE);
+	}
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		log(string("Render graph: framebuffer of pass ") + pass.name + " is incomplete");
+	}
+	framebuffers.push_back(key);
+	return key.framebuffer;
+}
+
+void render_graph::execute(const GLuint target, const int target_width, const int target_height) {
+	if (!compiled) {
+		return;
+	}
+	target_framebuffer = target;
+	collect_pass_times();
+	if (timing && timer_queries.size() < order.size()) {
+		const size_t first = timer_queries.size();
+		timer_queries.resize(order.size());
+		glGenQueries(static_cast<GLsizei>(order.size() - first), &timer_queries[first]);
+	}
+	for (const int index : order) {
+		const pass_node& pass = passes[index];
+		profile_scope zone(pass.name);
+		int width = target_width, height = target_height;
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_for(pass, &width, &height));
+		glViewport(0, 0, width, height);
+		if (timing) {
+			glBeginQuery(GL_TIME_ELAPSED, timer_queries[timed_passes.size()]);
+		}
+		pass.execute(*this, pass.context);
+		if (timing) {
+			glEndQuery(GL_TIME_ELAPSED);
+			timed_passes.push_back(pass.name);
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, target);
+	glViewport(0, 0, target_width, target_height);
+}
+
+void render_graph::release() {
+	for (physical_resource& slot : physical) {
+		destroy_physical(slot);
+	}
+	physical.clear();
+	for (const framebuffer_entry& entry : framebuffers) {
+		glDeleteFramebuffers(1, &entry.framebuffer);
+	}
+	framebuffers.clear();
+	if (!timer_queries.empty()) {
+		glDeleteQueries(static_cast<GLsizei>(timer_queries.size()), timer_queries.data());
+	}
+	timer_queries.clear();
+	timed_passes.clear();
+	compiled = false;
+}
+
+void render_graph::set_aliasing(const bool enabled) {
+	aliasing = enabled;
+}
+
+void render_graph::set_timing(const bool enabled) {
+	timing = enabled;
+}
+
+void render_graph::collect_pass_times() {
+	if (timed_passes.empty()) {
+		return;
+	}
+	last_pass_times.clear();
+	for (size_t i = 0; i < timed_passes.size(); i++) {
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(timer_queries[i], GL_QUERY_RESULT, &nanoseconds);
+		last_pass_times.push_back({ timed_passes[i], nanoseconds / 1e6 });
+	}
+	timed_passes.clear();
+}
+
+GLuint render_graph::texture(const graph_resource resource) const {
+	const int slot = resources[resource].physical;
+	return slot >= 0 && !resources[resource].is_buffer ? physical[slot].name : 0;
+}
+
+GLuint render_graph::buffer(const graph_resource resource) const {
+	const int slot = resources[resource].physical;
+	return slot >= 0 && resources[resource].is_buffer ? physical[slot].name : 0;
+}
+
+const graph_texture_desc& render_graph::texture_desc(const graph_resource resource) const {
+	return resources[resource].desc;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gl_api.h"
+
+// frame graph: every frame the passes are declared with the resources they read and write, then
+// compiled and executed. compiling culls the passes nothing on screen depends on, orders the rest
+// so every resource is written before it is read, and hands the transient resources GL objects
+// from a pool, where resources whose lifetimes don't overlap share one. a declaration identical to
+// the last compiled one skips the compile. once warm, declaring and executing don't allocate
+
+typedef uint32_t graph_resource;
+const graph_resource invalid_graph_resource = 0xffffffff;
+
+struct graph_texture_desc {
+	int width = 0;
+	int height = 0;
+	// sized internal format, GL_RGBA16F, GL_DEPTH24_STENCIL8 ...
+	GLenum format = GL_RGBA8;
+};
+
+class render_graph;
+typedef void (*graph_pass_function)(const render_graph& graph, void* context);
+
+struct render_graph_stats {
+	size_t passes = 0;
+	size_t culled_passes = 0;
+	size_t transient_resources = 0;
+	// GL objects backing them, and their bytes with and without sharing
+	size_t physical_resources = 0;
+	uint64_t aliased_bytes = 0;
+	uint64_t unaliased_bytes = 0;
+	uint64_t compiles = 0;
+	uint64_t cached_compiles = 0;
+};
+
+// GPU time of one executed pass, with set_timing()
+struct graph_pass_time {
+	const char* name;
+	double gpu_ms;
+};
+
+class render_graph {
+public:
+	render_graph() = default;
+	render_graph(const render_graph&) = delete;
+	render_graph& operator=(const render_graph&) = delete;
+	~render_graph();
+
+	// starts the next frame's declaration
+	void begin();
+	// transient: only lives within the frame, written by exactly one pass
+	graph_resource create_texture(const char* name, const graph_texture_desc& desc);
+	graph_resource create_buffer(const char* name, size_t bytes);
+	// the default framebuffer (or the one passed to execute()); passes writing it are never culled
+	graph_resource backbuffer();
+
+	// passes run in an order that satisfies their reads and writes, declaration order otherwise;
+	// execute is called with the pass's color and depth writes bound as the framebuffer
+	int add_pass(const char* name, graph_pass_function execute, void* context);
+	void read(int pass, graph_resource resource);
+	void write(int pass, graph_resource resource);
+
+	// false if a resource is written twice or the passes depend on each other in a cycle
+	bool compile();
+	// runs the compiled passes; target is the framebuffer backbuffer() stands for
+	void execute(GLuint target, int target_width, int target_height);
+	// every GL object, e.g. before the context goes away
+	void release();
+
+	// false - every transient resource gets GL objects of its own, to compare against
+	void set_aliasing(bool enabled);
+	// true - every executed pass is wrapped in a GL_TIME_ELAPSED query, so the passes can't start
+	// timer queries of their own
+	void set_timing(bool enabled);
+	// waits for the queries of the last execute() and moves them to pass_times(); execute() does it
+	// itself for the frame before, which has usually finished by then
+	void collect_pass_times();
+	// in execution order, from the last collected frame
+	const std::vector<graph_pass_time>& pass_times() const { return last_pass_times; }
+
+	// the GL object behind a resource, valid while a pass executes
+	GLuint texture(graph_resource resource) const;
+	GLuint buffer(graph_resource resource) const;
+	const graph_texture_desc& texture_desc(graph_resource resource) const;
+
+	const render_graph_stats& stats() const { return last_stats; }
+
+private:
+	static const int max_pass_reads = 8;
+	// color attachments plus depth
+	static const int max_pass_writes = 5;
+
+	struct resource_node {
+		const char* name;
+		bool is_buffer;
+		bool is_backbuffer;
+		graph_texture_desc desc;
+		size_t bytes;
+		int writer;
+		// compiled: first and last position in the pass order that uses it, its physical slot
+		int first_use;
+		int last_use;
+		int physical;
+	};
+	struct pass_node {
+		const char* name;
+		graph_pass_function execute;
+		void* context;
+		graph_resource reads[max_pass_reads];
+		int read_count;
+		graph_resource writes[max_pass_writes];
+		int write_count;
+		bool needed;
+	};
+	struct physical_resource {
+		bool is_buffer;
+		graph_texture_desc desc;
+		size_t bytes;
+		GLuint name;
+		// by the last compile, until this position in the pass order
+		bool used;
+		int busy_until;
+	};
+	struct framebuffer_entry {
+		// GL texture names of the color attachments then depth, 0 where there is none
+		GLuint attachments[max_pass_writes];
+		GLuint framebuffer;
+	};
+
+	uint64_t declaration_hash() const;
+	void assign_physical(resource_node& resource);
+	void create_physical(physical_resource& slot);
+	void destroy_physical(physical_resource& slot);
+	GLuint framebuffer_for(const pass_node& pass, int* width, int* height);
+
+	std::vector<resource_node> resources;
+	std::vector<pass_node> passes;
+	graph_resource backbuffer_resource = invalid_graph_resource;
+	bool declaration_error = false;
+	GLuint target_framebuffer = 0;
+
+	// compiled
+	std::vector<int> order;
+	std::vector<physical_resource> physical;
+	// slot of every resource, for a compile the cache answers
+	std::vector<int> compiled_physical;
+	std::vector<framebuffer_entry> framebuffers;
+	uint64_t compiled_hash = 0;
+	bool compiled = false;
+	bool aliasing = true;
+	render_graph_stats last_stats;
+
+	// one query per executed pass, and the passes of the frame they are still pending for
+	bool timing = false;
+	std::vector<GLuint> timer_queries;
+	std::vector<const char*> timed_passes;
+	std::vector<graph_pass_time> last_pass_times;
+
+	// compile scratch
+	std::vector<int> indegree;
+	std::vector<int> stack;
+	std::vector<bool> emitted;
+};
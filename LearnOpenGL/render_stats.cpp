@@ -0,0 +1,325 @@
+#include "render_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "frame_arena.h"
+#include "gl_api.h"
+#include "log.h"
+#include "text_overlay.h"
+
+using namespace std;
+
+// frames[current] is being counted, the other one is the last complete frame
+static render_stats frames[2];
+static int current = 0;
+static bool suspended = false;
+
+static uint64_t frame_count = 0;
+static render_stats totals;
+static render_stats peaks;
+
+void render_stats_frame() {
+	const render_stats& frame = frames[current];
+
+	totals.draw_calls += frame.draw_calls;
+	totals.triangles += frame.triangles;
+	totals.indirect_commands += frame.indirect_commands;
+	totals.compute_dispatches += frame.compute_dispatches;
+	totals.state_changes += frame.state_changes;
+	totals.program_binds += frame.program_binds;
+	totals.buffer_bytes_uploaded += frame.buffer_bytes_uploaded;
+	totals.texture_bytes_uploaded += frame.texture_bytes_uploaded;
+	totals.gpu_bytes_allocated += frame.gpu_bytes_allocated;
+
+	peaks.draw_calls = max(peaks.draw_calls, frame.draw_calls);
+	peaks.triangles = max(peaks.triangles, frame.triangles);
+	peaks.indirect_commands = max(peaks.indirect_commands, frame.indirect_commands);
+	peaks.compute_dispatches = max(peaks.compute_dispatches, frame.compute_dispatches);
+	peaks.state_changes = max(peaks.state_changes, frame.state_changes);
+	peaks.program_binds = max(peaks.program_binds, frame.program_binds);
+	peaks.buffer_bytes_uploaded = max(peaks.buffer_bytes_uploaded, frame.buffer_bytes_uploaded);
+	peaks.texture_bytes_uploaded = max(peaks.texture_bytes_uploaded, frame.texture_bytes_uploaded);
+	peaks.gpu_bytes_allocated = max(peaks.gpu_bytes_allocated, frame.gpu_bytes_allocated);
+
+	frame_count++;
+	current ^= 1;
+	frames[current] = render_stats();
+}
+
+const render_stats& render_stats_last() {
+	return frames[current ^ 1];
+}
+
+void render_stats_suspend(const bool suspend) {
+	suspended = suspend;
+}
+
+void render_stats_mapped_write(const uint64_t bytes) {
+	if (!suspended) {
+		frames[current].buffer_bytes_uploaded += bytes;
+	}
+}
+
+// text for the overlay lives in the frame arena, drawing it does not touch the heap
+static const char* format_bytes(const uint64_t bytes) {
+	if (bytes >= (1 << 20)) {
+		return frame_format("%.2f MB", bytes / 1048576.0);
+	}
+	if (bytes >= (1 << 10)) {
+		return frame_format("%.2f KB", bytes / 1024.0);
+	}
+	return frame_format("%u B", static_cast<unsigned>(bytes));
+}
+
+void render_stats_overlay(const int width, const int height) {
+	const render_stats& frame = render_stats_last();
+	const frame_arena_stats& arena = frame_arena_last();
+
+	text_overlay_print(1, 1, frame_format("DRAWS %llu  TRIS %llu",
+		static_cast<unsigned long long>(frame.draw_calls), static_cast<unsigned long long>(frame.triangles)));
+	text_overlay_print(1, 2, frame_format("INDIRECT %llu  DISPATCHES %llu",
+		static_cast<unsigned long long>(frame.indirect_commands), static_cast<unsigned long long>(frame.compute_dispatches)));
+	text_overlay_print(1, 3, frame_format("STATE %llu  PROGRAMS %llu",
+		static_cast<unsigned long long>(frame.state_changes), static_cast<unsigned long long>(frame.program_binds)));
+	text_overlay_print(1, 4, frame_format("BUFFER UP %s  TEXTURE UP %s",
+		format_bytes(frame.buffer_bytes_uploaded), format_bytes(frame.texture_bytes_uploaded)));
+	text_overlay_print(1, 5, frame_format("GPU ALLOC %s", format_bytes(frame.gpu_bytes_allocated)));
+	text_overlay_print(1, 6, frame_format("ARENA %s  HEAP BLOCKS %llu",
+		format_bytes(arena.bytes_used), static_cast<unsigned long long>(arena.frame_heap_allocations)));
+
+	render_stats_suspend(true);
+	text_overlay_draw(width, height);
+	render_stats_suspend(false);
+}
+
+damage_rect render_stats_overlay_rect(const int height) {
+	// the six lines above, wide enough for the longest with gigabyte sized numbers
+	return text_overlay_cells_rect(1, 1, 44, 6, height);
+}
+
+static string stats_object(const render_stats& stats, const double divisor) {
+	char buffer[640];
+	snprintf(buffer, sizeof(buffer),
+		"{\"draw_calls\": %.2f, \"triangles\": %.2f, \"indirect_commands\": %.2f, \"compute_dispatches\": %.2f, "
+		"\"state_changes\": %.2f, \"program_binds\": %.2f, "
+		"\"buffer_bytes_uploaded\": %.2f, \"texture_bytes_uploaded\": %.2f, \"gpu_bytes_allocated\": %.2f}",
+		stats.draw_calls / divisor, stats.triangles / divisor, stats.indirect_commands / divisor,
+		stats.compute_dispatches / divisor, stats.state_changes / divisor,
+		stats.program_binds / divisor, stats.buffer_bytes_uploaded / divisor,
+		stats.texture_bytes_uploaded / divisor, stats.gpu_bytes_allocated / divisor);
+	return buffer;
+}
+
+string render_stats_json() {
+	const double frames_counted = frame_count > 0 ? static_cast<double>(frame_count) : 1.0;
+	string json = "{\n";
+	json += "  \"frames\": " + to_string(frame_count) + ",\n";
+	json += "  \"total\": " + stats_object(totals, 1.0) + ",\n";
+	json += "  \"per_frame_mean\": " + stats_object(totals, frames_counted) + ",\n";
+	json += "  \"per_frame_max\": " + stats_object(peaks, 1.0) + ",\n";
+	json += "  \"last_frame\": " + stats_object(render_stats_last(), 1.0) + "\n";
+	json += "}\n";
+	return json;
+}
+
+bool write_render_stats(const string& path) {
+	ofstream file(path, ios::out | ios::trunc);
+	file << render_stats_json();
+	return file.good();
+}
+
+#if USE_GLEW
+
+bool render_stats_enable() {
+	log("Render statistics need the generated loader, rebuild without UseGlew");
+	return false;
+}
+
+#else
+
+static uint64_t primitive_triangles(const GLenum mode, const GLsizei count) {
+	switch (mode) {
+	case GL_TRIANGLES:
+		return count / 3;
+	case GL_TRIANGLE_STRIP:
+	case GL_TRIANGLE_FAN:
+		return count > 2 ? count - 2 : 0;
+	default:
+		return 0;
+	}
+}
+
+static uint64_t pixel_bytes(const GLenum format, const GLenum type) {
+	uint64_t channels = 4;
+	switch (format) {
+	case GL_RED: case GL_DEPTH_COMPONENT: channels = 1; break;
+	case GL_RG: case GL_DEPTH_STENCIL: channels = 2; break;
+	case GL_RGB: channels = 3; break;
+	default: break;
+	}
+	switch (type) {
+	case GL_UNSIGNED_BYTE: case GL_BYTE: return channels;
+	case GL_HALF_FLOAT: case GL_UNSIGNED_SHORT: case GL_SHORT: return channels * 2;
+	// packed formats store the whole pixel in one value
+	case GL_UNSIGNED_INT_24_8: case GL_UNSIGNED_INT_10F_11F_11F_REV: case GL_UNSIGNED_INT_2_10_10_10_REV: return 4;
+	default: return channels * 4;
+	}
+}
+
+static render_stats& counting() {
+	return frames[current];
+}
+
+// every hook counts, then calls the function the loader had before render_stats_enable()
+#define COUNT(name, params, args, body) \
+	static decltype(gl_loader_##name) real_##name = nullptr; \
+	static void GL_LOADER_APIENTRY count_##name params { \
+		if (!suspended) body \
+		real_##name args; \
+	}
+
+COUNT(glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count), {
+	counting().draw_calls++;
+	counting().triangles += primitive_triangles(mode, count);
+})
+COUNT(glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices), {
+	counting().draw_calls++;
+	counting().triangles += primitive_triangles(mode, count);
+})
+COUNT(glDrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei instances), (mode, first, count, instances), {
+	counting().draw_calls++;
+	counting().triangles += primitive_triangles(mode, count) * instances;
+})
+COUNT(glDrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances),
+	(mode, count, type, indices, instances), {
+	counting().draw_calls++;
+	counting().triangles += primitive_triangles(mode, count) * instances;
+})
+COUNT(glMultiDrawElementsIndirect, (GLenum mode, GLenum type, const void* indirect, GLsizei draws, GLsizei stride),
+	(mode, type, indirect, draws, stride), {
+	counting().draw_calls++;
+	counting().indirect_commands += draws;
+})
+COUNT(glMultiDrawElementsIndirectCount, (GLenum mode, GLenum type, const void* indirect, GLintptr draw_count,
+	GLsizei max_draws, GLsizei stride), (mode, type, indirect, draw_count, max_draws, stride), {
+	counting().draw_calls++;
+	counting().indirect_commands += max_draws;
+})
+COUNT(glDispatchCompute, (GLuint groups_x, GLuint groups_y, GLuint groups_z), (groups_x, groups_y, groups_z), {
+	counting().compute_dispatches++;
+})
+COUNT(glUseProgram, (GLuint program), (program), {
+	counting().program_binds++;
+})
+COUNT(glBindVertexArray, (GLuint array), (array), {
+	counting().state_changes++;
+})
+COUNT(glBindBuffer, (GLenum target, GLuint buffer), (target, buffer), {
+	counting().state_changes++;
+})
+COUNT(glBindTexture, (GLenum target, GLuint texture), (target, texture), {
+	counting().state_changes++;
+})
+COUNT(glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer), {
+	counting().state_changes++;
+})
+COUNT(glBindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size),
+	(target, index, buffer, offset, size), {
+	counting().state_changes++;
+})
+COUNT(glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer), {
+	counting().state_changes++;
+})
+COUNT(glActiveTexture, (GLenum unit), (unit), {
+	counting().state_changes++;
+})
+COUNT(glEnable, (GLenum cap), (cap), {
+	counting().state_changes++;
+})
+COUNT(glDisable, (GLenum cap), (cap), {
+	counting().state_changes++;
+})
+COUNT(glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), {
+	counting().state_changes++;
+})
+COUNT(glScissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), {
+	counting().state_changes++;
+})
+COUNT(glClearColor, (GLfloat r, GLfloat g, GLfloat b, GLfloat a), (r, g, b, a), {
+	counting().state_changes++;
+})
+COUNT(glBlendFunc, (GLenum source, GLenum destination), (source, destination), {
+	counting().state_changes++;
+})
+COUNT(glBufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage), {
+	counting().gpu_bytes_allocated += size;
+	if (data != nullptr) {
+		counting().buffer_bytes_uploaded += size;
+	}
+})
+COUNT(glBufferStorage, (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags), (target, size, data, flags), {
+	counting().gpu_bytes_allocated += size;
+	if (data != nullptr) {
+		counting().buffer_bytes_uploaded += size;
+	}
+})
+COUNT(glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data), {
+	counting().buffer_bytes_uploaded += size;
+})
+COUNT(glTexImage2D, (GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border,
+	GLenum format, GLenum type, const void* pixels), (target, level, internal_format, width, height, border, format, type, pixels), {
+	const uint64_t bytes = static_cast<uint64_t>(width) * height * pixel_bytes(format, type);
+	counting().gpu_bytes_allocated += bytes;
+	if (pixels != nullptr) {
+		counting().texture_bytes_uploaded += bytes;
+	}
+})
+COUNT(glTexSubImage2D, (GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+	GLenum format, GLenum type, const void* pixels), (target, level, x, y, width, height, format, type, pixels), {
+	counting().texture_bytes_uploaded += static_cast<uint64_t>(width) * height * pixel_bytes(format, type);
+})
+COUNT(glTexImage3D, (GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLsizei depth,
+	GLint border, GLenum format, GLenum type, const void* pixels),
+	(target, level, internal_format, width, height, depth, border, format, type, pixels), {
+	const uint64_t bytes = static_cast<uint64_t>(width) * height * depth * pixel_bytes(format, type);
+	counting().gpu_bytes_allocated += bytes;
+	if (pixels != nullptr) {
+		counting().texture_bytes_uploaded += bytes;
+	}
+})
+COUNT(glTexSubImage3D, (GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei width, GLsizei height,
+	GLsizei depth, GLenum format, GLenum type, const void* pixels),
+	(target, level, x, y, z, width, height, depth, format, type, pixels), {
+	counting().texture_bytes_uploaded += static_cast<uint64_t>(width) * height * depth * pixel_bytes(format, type);
+})
+
+#define HOOK(name) real_##name = gl_loader_##name; gl_loader_##name = count_##name
+
+bool render_stats_enable() {
+	HOOK(glDrawArrays); HOOK(glDrawElements); HOOK(glDrawArraysInstanced); HOOK(glDrawElementsInstanced);
+	HOOK(glUseProgram); HOOK(glBindVertexArray); HOOK(glBindBuffer); HOOK(glBindTexture);
+	HOOK(glBindBufferBase); HOOK(glBindBufferRange); HOOK(glBindFramebuffer); HOOK(glActiveTexture);
+	HOOK(glEnable); HOOK(glDisable); HOOK(glViewport); HOOK(glScissor); HOOK(glClearColor); HOOK(glBlendFunc);
+	HOOK(glBufferData); HOOK(glBufferSubData); HOOK(glTexImage2D); HOOK(glTexSubImage2D);
+	HOOK(glTexImage3D); HOOK(glTexSubImage3D);
+	// lazy: resolved first, or resolving one on its first call would put the driver's function back
+	const bool gl_4_3 = gl_api_has_version(4, 3);
+	if ((gl_4_3 || gl_api_has_extension("GL_ARB_compute_shader")) && gl_loader_load("glDispatchCompute")) {
+		HOOK(glDispatchCompute);
+	}
+	if ((gl_4_3 || gl_api_has_extension("GL_ARB_multi_draw_indirect")) && gl_loader_load("glMultiDrawElementsIndirect")) {
+		HOOK(glMultiDrawElementsIndirect);
+	}
+	if ((gl_api_has_version(4, 6) || gl_api_has_extension("GL_ARB_indirect_parameters"))
+		&& gl_loader_load("glMultiDrawElementsIndirectCount")) {
+		HOOK(glMultiDrawElementsIndirectCount);
+	}
+	if ((gl_api_has_version(4, 4) || gl_api_has_extension("GL_ARB_buffer_storage")) && gl_loader_load("glBufferStorage")) {
+		HOOK(glBufferStorage);
+	}
+	return true;
+}
+
+#endif
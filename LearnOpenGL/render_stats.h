@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "damage.h"
+
+// work done by one frame, counted by hooking the gl_loader functions. indirect draws count as
+// one call each, their commands (at most the maximum a count buffer allows) and triangles are
+// only known to the GPU
+struct render_stats {
+	uint32_t draw_calls = 0;
+	uint64_t triangles = 0;
+	uint64_t indirect_commands = 0;
+	uint32_t compute_dispatches = 0;
+	uint32_t state_changes = 0;
+	uint32_t program_binds = 0;
+	uint64_t buffer_bytes_uploaded = 0;
+	uint64_t texture_bytes_uploaded = 0;
+	uint64_t gpu_bytes_allocated = 0;
+};
+
+// installs the counting hooks; not available with USE_GLEW
+bool render_stats_enable();
+// frame boundary: the frame being counted becomes render_stats_last()
+void render_stats_frame();
+const render_stats& render_stats_last();
+// calls made while suspended (e.g. by the overlay itself) are not counted
+void render_stats_suspend(bool suspended);
+// bytes written through a mapped buffer, which no GL call shows; the writer counts them
+void render_stats_mapped_write(uint64_t bytes);
+
+// last frame's counters through text_overlay
+void render_stats_overlay(int width, int height);
+// where render_stats_overlay() can draw
+damage_rect render_stats_overlay_rect(int height);
+// totals, per frame mean and max over the whole run
+std::string render_stats_json();
+bool write_render_stats(const std::string& path);
@@ -0,0 +1,104 @@
+#include "render_thread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "gl_api.h"
+#include "job_system.h"
+
+using namespace std;
+
+// low bits of the shared slot word: a packet index; this bit: published and not taken yet
+static const unsigned fresh_bit = 4;
+static const unsigned index_mask = 3;
+
+static frame_packet packets[3];
+// owned by the main thread / the render thread / passed between them
+static unsigned filling = 0;
+static unsigned drawing = 1;
+static atomic<unsigned> latest{ 2 };
+
+static GLFWwindow* render_window = nullptr;
+static render_function render_callback = nullptr;
+static void* render_context = nullptr;
+static thread render_worker;
+
+static atomic<uint64_t> submitted{ 0 };
+static atomic<uint64_t> rendered{ 0 };
+static atomic<bool> stopping{ false };
+// only for parking the threads, the packets go through latest
+static mutex park_mutex;
+static condition_variable packet_ready;
+static condition_variable packet_done;
+
+static void wake(condition_variable& condition) {
+	lock_guard<mutex> lock(park_mutex);
+	condition.notify_one();
+}
+
+static void render_main() {
+	glfwMakeContextCurrent(render_window);
+	// glyph generation and the software comparison run here, their waits should help the workers
+	job_system_attach_thread();
+	for (;;) {
+		{
+			unique_lock<mutex> lock(park_mutex);
+			packet_ready.wait(lock, [] { return (latest.load() & fresh_bit) != 0 || stopping.load(); });
+		}
+		if ((latest.load() & fresh_bit) == 0) {
+			break;
+		}
+		drawing = latest.exchange(drawing) & index_mask;
+		render_callback(packets[drawing], render_context);
+		rendered.fetch_add(1);
+		wake(packet_done);
+	}
+	job_system_detach_thread();
+	glfwMakeContextCurrent(nullptr);
+}
+
+void render_thread_start(GLFWwindow* window, const render_function render, void* context, const size_t max_visible) {
+	for (frame_packet& packet : packets) {
+		packet.visible.resize(max_visible);
+	}
+	filling = 0;
+	drawing = 1;
+	latest = 2;
+	submitted = 0;
+	rendered = 0;
+	stopping = false;
+	render_window = window;
+	render_callback = render;
+	render_context = context;
+
+	glfwMakeContextCurrent(nullptr);
+	render_worker = thread(render_main);
+}
+
+void render_thread_stop() {
+	if (!render_worker.joinable()) {
+		return;
+	}
+	render_thread_wait();
+	stopping = true;
+	wake(packet_ready);
+	render_worker.join();
+	glfwMakeContextCurrent(render_window);
+}
+
+frame_packet& render_thread_packet() {
+	return packets[filling];
+}
+
+void render_thread_wait() {
+	unique_lock<mutex> lock(park_mutex);
+	packet_done.wait(lock, [] { return rendered.load() == submitted.load(); });
+}
+
+void render_thread_submit() {
+	submitted.fetch_add(1);
+	filling = latest.exchange(filling | fresh_bit) & index_mask;
+	wake(packet_ready);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "clustered_lights.h"
+#include "command_list.h"
+#include "damage.h"
+#include "math3d.h"
+#include "shadow_maps.h"
+
+struct GLFWwindow;
+
+// command lists a packet can carry
+const size_t max_frame_lists = 32;
+
+// everything the GL side needs for one frame. the main thread fills a packet and hands it over,
+// after that the packet belongs to the render thread until it comes back around
+struct frame_packet {
+	uint64_t frame = 0;
+	double seconds = 0.0;
+	// profiler_now_ms() when the frame's input was polled
+	double input_ms = 0.0;
+	mat4 view_projection = {};
+	// city objects to draw, room for every object is reserved up front
+	std::vector<uint32_t> visible;
+	size_t visible_count = 0;
+	// the draws of the visible objects when they were recorded ahead (--command-lists)
+	command_list lists[max_frame_lists];
+	size_t list_count = 0;
+	// --lights, binned on the main thread and uploaded on the GL side
+	light_grid lights;
+	// --shadows, fitted and culled on the main thread
+	shadow_frame shadows;
+	bool overlay = false;
+	// --on-demand: the parts of the screen to redraw and whether the overlay is among them
+	damage_rect damage[max_damage_rects];
+	size_t damage_count = 0;
+	bool overlay_damaged = false;
+	// the first frame gets compared with the software rasterizer if asked and waited on with glFinish
+	bool first = false;
+};
+
+typedef void (*render_function)(const frame_packet& packet, void* context);
+
+// three packets passed around through one atomic: the main thread fills one, the render thread
+// draws another, the third is the latest published one. render runs on the render thread for
+// every packet, swap buffers included. the window's context must be current on the caller, it
+// moves to the render thread
+void render_thread_start(GLFWwindow* window, render_function render, void* context, size_t max_visible);
+// after the last packet is drawn the context comes back to the calling thread
+void render_thread_stop();
+
+// the packet to fill for the next frame
+frame_packet& render_thread_packet();
+// waits until the render thread is done with everything submitted; it is idle until the next
+// submit then, so frame boundary work that must not race it can run
+void render_thread_wait();
+// publishes the filled packet; call render_thread_wait() first, so the main thread stays at most
+// one frame ahead
+void render_thread_submit();
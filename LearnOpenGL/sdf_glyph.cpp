@@ -0,0 +1,136 @@
+#include "sdf_glyph.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "job_system.h"
+
+using namespace std;
+
+// how far a flattened curve may stray from the real one, in pixels
+static const float flatness = 0.05f;
+static const int max_curve_pieces = 16;
+
+struct sdf_edge {
+	float x0, y0;
+	float x1, y1;
+};
+
+struct row_crossing {
+	float x;
+	int direction;
+};
+
+struct generate_context {
+	const ttf_font* font;
+	sdf_glyph* glyphs;
+};
+
+static float distance_squared(const sdf_edge& edge, const float x, const float y) {
+	const float dx = edge.x1 - edge.x0, dy = edge.y1 - edge.y0;
+	const float length = dx * dx + dy * dy;
+	const float t = length > 0.0f ? min(1.0f, max(0.0f, ((x - edge.x0) * dx + (y - edge.y0) * dy) / length)) : 0.0f;
+	const float px = edge.x0 + t * dx - x, py = edge.y0 + t * dy - y;
+	return px * px + py * py;
+}
+
+// curves in font units to edges in bitmap pixels, y down from the top row
+static void flatten(const vector<ttf_curve>& curves, const float scale, const sdf_glyph& glyph, vector<sdf_edge>& edges) {
+	edges.clear();
+	const auto to_x = [&](const float x) { return x * scale - glyph.left; };
+	const auto to_y = [&](const float y) { return glyph.top - y * scale; };
+	for (const ttf_curve& curve : curves) {
+		// the curve strays from its chord by a quarter of this at most
+		const float bend_x = (curve.x0 - 2.0f * curve.cx + curve.x1) * scale;
+		const float bend_y = (curve.y0 - 2.0f * curve.cy + curve.y1) * scale;
+		const float deviation = sqrt(bend_x * bend_x + bend_y * bend_y) * 0.25f;
+		const int pieces = min(max_curve_pieces, max(1, static_cast<int>(ceil(sqrt(deviation / flatness)))));
+		float x = to_x(curve.x0), y = to_y(curve.y0);
+		for (int piece = 1; piece <= pieces; piece++) {
+			const float t = static_cast<float>(piece) / pieces, u = 1.0f - t;
+			const float next_x = to_x(u * u * curve.x0 + 2.0f * u * t * curve.cx + t * t * curve.x1);
+			const float next_y = to_y(u * u * curve.y0 + 2.0f * u * t * curve.cy + t * t * curve.y1);
+			const sdf_edge edge = { x, y, next_x, next_y };
+			edges.push_back(edge);
+			x = next_x;
+			y = next_y;
+		}
+	}
+}
+
+static void generate_one(const ttf_font& font, sdf_glyph& glyph, vector<ttf_curve>& curves, vector<sdf_edge>& edges,
+	vector<row_crossing>& crossings) {
+	sdf_glyph_box(font, glyph.glyph, glyph);
+	glyph.pixels.assign(static_cast<size_t>(glyph.width) * glyph.height, 0);
+	if (glyph.width == 0) {
+		return;
+	}
+	curves.clear();
+	font.outline(glyph.glyph, curves);
+	flatten(curves, static_cast<float>(sdf_em_pixels) / font.units_per_em(), glyph, edges);
+
+	const float reach = static_cast<float>(sdf_spread);
+	for (int row = 0; row < glyph.height; row++) {
+		const float y = row + 0.5f;
+		// inside means a nonzero winding number, counted along a ray to the right
+		crossings.clear();
+		int winding = 0;
+		for (const sdf_edge& edge : edges) {
+			if ((edge.y0 <= y && y < edge.y1) || (edge.y1 <= y && y < edge.y0)) {
+				const row_crossing crossing = { edge.x0 + (y - edge.y0) * (edge.x1 - edge.x0) / (edge.y1 - edge.y0), edge.y1 > edge.y0 ? 1 : -1 };
+				crossings.push_back(crossing);
+				winding += crossing.direction;
+			}
+		}
+		sort(crossings.begin(), crossings.end(), [](const row_crossing& a, const row_crossing& b) { return a.x < b.x; });
+
+		size_t passed = 0;
+		uint8_t* pixels = &glyph.pixels[static_cast<size_t>(row) * glyph.width];
+		for (int column = 0; column < glyph.width; column++) {
+			const float x = column + 0.5f;
+			while (passed < crossings.size() && crossings[passed].x <= x) {
+				winding -= crossings[passed++].direction;
+			}
+			float nearest = reach * reach;
+			for (const sdf_edge& edge : edges) {
+				// edges whose bounds are out of reach can't be nearer
+				const float out_x = max(0.0f, max(min(edge.x0, edge.x1) - x, x - max(edge.x0, edge.x1)));
+				const float out_y = max(0.0f, max(min(edge.y0, edge.y1) - y, y - max(edge.y0, edge.y1)));
+				if (out_x * out_x + out_y * out_y < nearest) {
+					nearest = min(nearest, distance_squared(edge, x, y));
+				}
+			}
+			const float distance = winding != 0 ? sqrt(nearest) : -sqrt(nearest);
+			pixels[column] = static_cast<uint8_t>(min(255.0f, max(0.0f, (0.5f + distance / (2.0f * reach)) * 255.0f + 0.5f)));
+		}
+	}
+}
+
+static void generate_range(void* context, const int begin, const int end) {
+	const generate_context& work = *static_cast<const generate_context*>(context);
+	vector<ttf_curve> curves;
+	vector<sdf_edge> edges;
+	vector<row_crossing> crossings;
+	for (int i = begin; i < end; i++) {
+		generate_one(*work.font, work.glyphs[i], curves, edges, crossings);
+	}
+}
+
+void sdf_glyph_box(const ttf_font& font, const uint32_t glyph, sdf_glyph& box) {
+	const ttf_glyph_metrics& metrics = font.metrics(glyph);
+	if (metrics.x_max <= metrics.x_min || metrics.y_max <= metrics.y_min) {
+		box.width = box.height = box.left = box.top = 0;
+		return;
+	}
+	const float scale = static_cast<float>(sdf_em_pixels) / font.units_per_em();
+	box.left = static_cast<int>(floor(metrics.x_min * scale)) - sdf_spread;
+	box.top = static_cast<int>(ceil(metrics.y_max * scale)) + sdf_spread;
+	box.width = static_cast<int>(ceil(metrics.x_max * scale)) + sdf_spread - box.left;
+	box.height = box.top - (static_cast<int>(floor(metrics.y_min * scale)) - sdf_spread);
+}
+
+void sdf_generate(const ttf_font& font, sdf_glyph* glyphs, const size_t count) {
+	generate_context context = { &font, glyphs };
+	// a glyph is a fraction of a millisecond, the range is only split while threads are starving
+	parallel_for(0, static_cast<int>(count), 1, generate_range, &context);
+}
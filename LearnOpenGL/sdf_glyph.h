@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ttf_font.h"
+
+// signed distance fields of glyph outlines: a texel is 0.5 on the outline, more inside and less
+// outside, reaching 1 and 0 sdf_spread pixels away. thresholded at 0.5 when sampled, a glyph stays
+// sharp far above the size it was generated at
+
+// pixels per em the fields are generated at, and how far they reach each way
+const int sdf_em_pixels = 32;
+const int sdf_spread = 4;
+
+struct sdf_glyph {
+	uint32_t glyph = 0;
+	int width = 0;
+	int height = 0;
+	// the bitmap's top left corner from the pen position, y up, in pixels at sdf_em_pixels
+	int left = 0;
+	int top = 0;
+	// top row first
+	std::vector<uint8_t> pixels;
+};
+
+// fills in the size and placement only, 0 x 0 for glyphs without an outline
+void sdf_glyph_box(const ttf_font& font, uint32_t glyph, sdf_glyph& box);
+// the glyph of every entry is set by the caller; spread over the job system's threads when it runs
+void sdf_generate(const ttf_font& font, sdf_glyph* glyphs, size_t count);
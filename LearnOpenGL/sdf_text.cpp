@@ -0,0 +1,301 @@
+#include "sdf_text.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "gl_api.h"
+#include "glyph_atlas.h"
+#include "profiler.h"
+#include "sdf_glyph.h"
+#include "shader.h"
+#include "ttf_font.h"
+
+using namespace std;
+
+struct glyph_box {
+	int width;
+	int height;
+	int left;
+	int top;
+};
+
+struct glyph_instance {
+	// screen rectangle, then its atlas rectangle
+	float x, y, width, height;
+	float u0, v0, u1, v1;
+	uint32_t color;
+};
+
+static ttf_font font;
+static glyph_atlas atlas;
+static bool ready = false;
+
+static GLuint program = 0;
+static GLuint vao = 0;
+static GLuint vbo = 0;
+static GLint screen_size_location = -1;
+
+// size and placement of every glyph's field, known before the field is generated
+static vector<glyph_box> boxes;
+// the frame a missing glyph was queued in, so it is queued once
+static vector<uint64_t> queued_frame;
+static vector<sdf_glyph> missing;
+static vector<glyph_instance> instances;
+static vector<uint32_t> instance_glyphs;
+static uint64_t frame = 1;
+static sdf_text_stats stats;
+
+// the next character, U+FFFD for a malformed sequence
+static uint32_t next_codepoint(const char*& text) {
+	const uint8_t lead = static_cast<uint8_t>(*text++);
+	if (lead < 0x80) {
+		return lead;
+	}
+	const int continuation = lead >= 0xf0 ? 3 : lead >= 0xe0 ? 2 : lead >= 0xc0 ? 1 : -1;
+	if (continuation < 0) {
+		return 0xfffd;
+	}
+	uint32_t codepoint = lead & (0x3f >> continuation);
+	for (int i = 0; i < continuation; i++) {
+		if ((static_cast<uint8_t>(*text) & 0xc0) != 0x80) {
+			return 0xfffd;
+		}
+		codepoint = codepoint << 6 | (static_cast<uint8_t>(*text++) & 0x3f);
+	}
+	return codepoint;
+}
+
+bool sdf_text_init(const char* font_path, const int atlas_size) {
+	if (!font.load(font_path)) {
+		return false;
+	}
+	program = load_program("sdf_text.vert", "sdf_text.frag");
+	if (program == 0) {
+		return false;
+	}
+	screen_size_location = glGetUniformLocation(program, "screen_size");
+	atlas.init(atlas_size, font.glyph_count());
+
+	boxes.resize(font.glyph_count());
+	sdf_glyph box;
+	for (uint32_t glyph = 0; glyph < font.glyph_count(); glyph++) {
+		sdf_glyph_box(font, glyph, box);
+		const glyph_box placed = { box.width, box.height, box.left, box.top };
+		boxes[glyph] = placed;
+	}
+	queued_frame.assign(font.glyph_count(), 0);
+
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &vbo);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glyph_instance), reinterpret_cast<GLvoid*>(offsetof(glyph_instance, x)));
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glyph_instance), reinterpret_cast<GLvoid*>(offsetof(glyph_instance, u0)));
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(glyph_instance), reinterpret_cast<GLvoid*>(offsetof(glyph_instance, color)));
+	for (GLuint attribute = 0; attribute < 3; attribute++) {
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, 1);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	ready = true;
+	return true;
+}
+
+void sdf_text_release() {
+	atlas.release();
+	glDeleteBuffers(1, &vbo);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteProgram(program);
+	vbo = vao = program = 0;
+	instances.clear();
+	instance_glyphs.clear();
+	missing.clear();
+	ready = false;
+}
+
+static void queue_missing(const uint32_t glyph) {
+	if (atlas.find(glyph) < 0 && queued_frame[glyph] != frame) {
+		queued_frame[glyph] = frame;
+		missing.emplace_back();
+		missing.back().glyph = glyph;
+	}
+}
+
+static void generate_missing() {
+	if (missing.empty()) {
+		return;
+	}
+	const double start = profiler_now_ms();
+	sdf_generate(font, missing.data(), missing.size());
+	const uint64_t evicted_before = atlas.stats().evicted;
+	for (const sdf_glyph& generated : missing) {
+		atlas.insert(generated.glyph, generated.width, generated.height, generated.pixels.data());
+	}
+	stats.generated += missing.size();
+	stats.evicted += atlas.stats().evicted - evicted_before;
+	stats.generate_ms += profiler_now_ms() - start;
+	missing.clear();
+}
+
+float sdf_text_print(const float x, const float y, const float pixel_size, const uint32_t color, const char* text,
+	const float max_width) {
+	if (!ready) {
+		return 0.0f;
+	}
+	const float scale = pixel_size / font.units_per_em();
+	const float field_scale = pixel_size / sdf_em_pixels;
+	const float line_height = (font.ascent() - font.descent() + font.line_gap()) * scale;
+	float pen_x = x;
+	float baseline = y + font.ascent() * scale;
+	int lines = 1;
+	uint32_t previous = 0;
+	// the word being laid out: its first quad and where the pen was before it
+	size_t word_start = instances.size();
+	float word_x = x;
+
+	while (*text != '\0') {
+		const uint32_t codepoint = next_codepoint(text);
+		if (codepoint == '\n') {
+			pen_x = word_x = x;
+			baseline += line_height;
+			lines++;
+			previous = 0;
+			word_start = instances.size();
+			continue;
+		}
+		const uint32_t glyph = font.glyph_index(codepoint);
+		if (previous != 0) {
+			pen_x += font.kerning(previous, glyph) * scale;
+		}
+		const float advance = font.metrics(glyph).advance * scale;
+
+		// a word running past the width moves to the next line, unless it starts its line already
+		if (max_width > 0.0f && codepoint != ' ' && pen_x + advance > x + max_width && word_x > x) {
+			const float dx = x - word_x;
+			for (size_t i = word_start; i < instances.size(); i++) {
+				instances[i].x += dx;
+				instances[i].y += line_height;
+			}
+			pen_x += dx;
+			word_x = x;
+			baseline += line_height;
+			lines++;
+		}
+
+		const glyph_box& box = boxes[glyph];
+		if (box.width > 0) {
+			glyph_instance quad;
+			quad.x = pen_x + box.left * field_scale;
+			quad.y = baseline - box.top * field_scale;
+			quad.width = box.width * field_scale;
+			quad.height = box.height * field_scale;
+			quad.u0 = quad.v0 = quad.u1 = quad.v1 = 0.0f;
+			quad.color = color;
+			instances.push_back(quad);
+			instance_glyphs.push_back(glyph);
+			queue_missing(glyph);
+		}
+		pen_x += advance;
+		previous = glyph;
+		if (codepoint == ' ') {
+			word_start = instances.size();
+			word_x = pen_x;
+		}
+	}
+	return lines * line_height;
+}
+
+float sdf_text_measure(const float pixel_size, const char* text) {
+	if (!ready) {
+		return 0.0f;
+	}
+	const float scale = pixel_size / font.units_per_em();
+	float widest = 0.0f, width = 0.0f;
+	uint32_t previous = 0;
+	while (*text != '\0') {
+		const uint32_t codepoint = next_codepoint(text);
+		if (codepoint == '\n') {
+			widest = max(widest, width);
+			width = 0.0f;
+			previous = 0;
+			continue;
+		}
+		const uint32_t glyph = font.glyph_index(codepoint);
+		width += ((previous != 0 ? font.kerning(previous, glyph) : 0) + font.metrics(glyph).advance) * scale;
+		previous = glyph;
+	}
+	return max(widest, width);
+}
+
+void sdf_text_preload(const char* text) {
+	if (!ready) {
+		return;
+	}
+	while (*text != '\0') {
+		const uint32_t glyph = font.glyph_index(next_codepoint(text));
+		if (boxes[glyph].width > 0) {
+			queue_missing(glyph);
+		}
+	}
+	generate_missing();
+}
+
+void sdf_text_draw(const int width, const int height) {
+	if (!ready) {
+		return;
+	}
+	generate_missing();
+
+	// atlas rectangles are only final now, glyphs that found no room are left out
+	const float texel = 1.0f / atlas.size();
+	size_t kept = 0;
+	for (size_t i = 0; i < instances.size(); i++) {
+		const int slot = atlas.find(instance_glyphs[i]);
+		if (slot < 0) {
+			stats.dropped++;
+			continue;
+		}
+		const atlas_rect& rect = atlas.rect(slot);
+		glyph_instance& quad = instances[kept++];
+		quad = instances[i];
+		quad.u0 = rect.x * texel;
+		quad.v0 = rect.y * texel;
+		quad.u1 = (rect.x + rect.width) * texel;
+		quad.v1 = (rect.y + rect.height) * texel;
+	}
+
+	if (kept > 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, kept * sizeof(glyph_instance), instances.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glUseProgram(program);
+		glUniform2f(screen_size_location, static_cast<GLfloat>(width), static_cast<GLfloat>(height));
+		glBindTexture(GL_TEXTURE_2D, atlas.texture());
+		glBindVertexArray(vao);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(kept));
+		glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glDisable(GL_BLEND);
+		stats.draws++;
+		stats.glyphs += kept;
+	}
+
+	instances.clear();
+	instance_glyphs.clear();
+	atlas.next_frame();
+	frame++;
+}
+
+const sdf_text_stats& sdf_text_get_stats() {
+	return stats;
+}
+
+void sdf_text_reset_stats() {
+	stats = sdf_text_stats();
+}
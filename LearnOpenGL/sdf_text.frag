@@ -0,0 +1,15 @@
+#version 330 core
+
+in vec2 atlas_uv;
+in vec4 glyph_tint;
+out vec4 color;
+
+uniform sampler2D atlas;
+
+void main() {
+	// the outline is at 0.5; the screen space rate of change keeps the edge about a pixel wide at any size
+	float distance = texture(atlas, atlas_uv).r;
+	float edge = max(0.7 * fwidth(distance), 1e-4);
+	float coverage = smoothstep(0.5 - edge, 0.5 + edge, distance);
+	color = vec4(glyph_tint.rgb, glyph_tint.a * coverage);
+}
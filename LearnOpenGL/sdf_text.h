@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// text in a TrueType font drawn from signed distance fields, so labels stay sharp at any size:
+// glyphs are generated when first printed, in parallel on the job system, into a glyph atlas that
+// evicts the least recently used ones, and everything printed in a frame is a single draw
+
+struct sdf_text_stats {
+	uint64_t glyphs = 0;
+	uint64_t draws = 0;
+	uint64_t generated = 0;
+	uint64_t evicted = 0;
+	// glyphs left out because the atlas had no room for them
+	uint64_t dropped = 0;
+	double generate_ms = 0.0;
+};
+
+bool sdf_text_init(const char* font_path, int atlas_size);
+void sdf_text_release();
+
+// text is UTF-8, x and y the top left corner of the first line in pixels from the top left of the
+// screen; lines break at '\n' and, when max_width > 0, between words that would go past it.
+// returns the height of the lines laid out
+float sdf_text_print(float x, float y, float pixel_size, uint32_t color, const char* text, float max_width);
+// width of the widest line, nothing is printed
+float sdf_text_measure(float pixel_size, const char* text);
+// generates the glyphs of text now rather than when they are first drawn
+void sdf_text_preload(const char* text);
+// generates the glyphs missing from the atlas and draws everything printed since the last call
+void sdf_text_draw(int width, int height);
+
+const sdf_text_stats& sdf_text_get_stats();
+void sdf_text_reset_stats();
@@ -0,0 +1,134 @@
+#include "shader.h"
+
+#include <fstream>
+#include <string>
+
+#include "log.h"
+#include "profiler.h"
+
+using namespace std;
+
+const char* read_file(const char* path) {
+	profile_scope zone("read_file");
+	// file read based on example in cplusplus.com tutorial
+	ifstream file (path, ios::in|ios::binary|ios::ate);
+	if (file.is_open())	{
+		const auto size = file.tellg();
+		//fSize = (GLuint) size;
+		auto* const memblock = new char [1 + size];
+		file.seekg (0, ios::beg);
+		file.read (memblock, size);
+		file.close();
+		memblock[size] = '\0';
+		string text;
+		text.assign(memblock);
+
+		return memblock;
+	}
+	else {
+		return nullptr;
+	}
+}
+
+GLuint create_shader(const char* shader_source_code, const int shader_type) {
+	profile_scope zone("create_shader");
+	GLint success = 0;
+
+	const GLuint shader = glCreateShader(shader_type);	
+	glShaderSource(shader, 1, &shader_source_code, nullptr);
+	glCompileShader(shader);	
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+	string message;
+
+	if(!success) {
+		const int log_size = 512;
+		GLchar info_log[log_size];
+
+		glGetShaderInfoLog(shader, log_size, nullptr, info_log);
+
+		message = "Shader compilation - failed\n";
+		message += info_log;
+		log(message);
+	}
+	else {
+		message = "Shader compilation - success";
+		log(message);
+	}
+
+	return shader;
+}
+
+GLuint create_shader_program(GLuint shaders[], const int array_size) {
+	profile_scope zone("link_program");
+	GLint success = 0;
+	GLchar info_log[512];
+	const GLuint shader_program = glCreateProgram();
+	
+	for (int i = 0; i < array_size; i++)	{
+		glAttachShader(shader_program, shaders[i]);
+	}
+
+	glLinkProgram(shader_program);
+
+	glGetProgramiv(shader_program, GL_LINK_STATUS, &success);
+	if (!success) {
+		glGetProgramInfoLog(shader_program, 512, nullptr, info_log);
+		log("Shader program compilation - failed");
+	}
+
+	return shader_program;
+}
+
+GLuint load_program(const char* vertex_path, const char* fragment_path) {
+	return load_program_with(vertex_path, fragment_path, nullptr);
+}
+
+GLuint load_program_with(const char* vertex_path, const char* fragment_path, const char* snippet_path) {
+	const char* vertex_source = read_file(vertex_path);
+	const char* fragment_source = read_file(fragment_path);
+	const char* snippet_source = snippet_path != nullptr ? read_file(snippet_path) : nullptr;
+	if (vertex_source == nullptr || fragment_source == nullptr || (snippet_path != nullptr && snippet_source == nullptr)) {
+		log(string("Failed to read ") + (vertex_source == nullptr ? vertex_path : fragment_source == nullptr ? fragment_path : snippet_path));
+		delete[] vertex_source;
+		delete[] fragment_source;
+		delete[] snippet_source;
+		return 0;
+	}
+
+	string fragment = fragment_source;
+	if (snippet_source != nullptr) {
+		// #version has to stay the first line
+		const size_t version_end = fragment.find('\n');
+		fragment.insert(version_end != string::npos ? version_end + 1 : fragment.size(), string("\n") + snippet_source + "\n");
+	}
+	GLuint shaders[] = {
+		create_shader(vertex_source, GL_VERTEX_SHADER),
+		create_shader(fragment.c_str(), GL_FRAGMENT_SHADER)
+	};
+	const GLuint program = create_shader_program(shaders, 2);
+
+	glDeleteShader(shaders[0]);
+	glDeleteShader(shaders[1]);
+	delete[] vertex_source;
+	delete[] fragment_source;
+	delete[] snippet_source;
+
+	return program;
+}
+
+GLuint load_compute_program(const char* path) {
+	const char* source = read_file(path);
+	if (source == nullptr) {
+		log(string("Failed to read ") + path);
+		return 0;
+	}
+
+	GLuint shader = create_shader(source, GL_COMPUTE_SHADER);
+	const GLuint program = create_shader_program(&shader, 1);
+
+	glDeleteShader(shader);
+	delete[] source;
+
+	return program;
+}
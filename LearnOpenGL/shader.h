@@ -0,0 +1,16 @@
+#pragma once
+
+#include "gl_api.h"
+
+// whole file as a null terminated string allocated with new[], nullptr if it cannot be read
+const char* read_file(const char* path);
+
+GLuint create_shader(const char* shader_source_code, int shader_type);
+GLuint create_shader_program(GLuint shaders[], int array_size);
+// vertex + fragment program from two files, 0 if a file is missing
+GLuint load_program(const char* vertex_path, const char* fragment_path);
+// load_program with the GLSL of snippet_path spliced into the fragment shader after its #version
+// line, for code more than one program shares; snippet_path may be null
+GLuint load_program_with(const char* vertex_path, const char* fragment_path, const char* snippet_path);
+// compute program from one file, 0 if the file is missing
+GLuint load_compute_program(const char* path);
@@ -0,0 +1,154 @@
+#include "shadow_benchmark.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "bench_stats.h"
+#include "city_scene.h"
+#include "job_system.h"
+#include "log.h"
+#include "profiler.h"
+#include "shadow_maps.h"
+
+using namespace std;
+
+static const int warmup_frames = 3;
+static const int default_objects = 10000;
+static const int default_size = 1024;
+
+struct shadow_times {
+	vector<double> fit_ms;
+	vector<double> submit_ms;
+	vector<double> gpu_ms;
+	// the shadow pass and the city until glFinish returns
+	vector<double> frame_ms;
+	uint64_t cascades = 0;
+	uint64_t draws = 0;
+	uint64_t casters = 0;
+};
+
+// the camera a bit further down the path every frame, about what it moves at 60 Hz
+static double frame_seconds(const int frame) {
+	return 2.0 + frame / 60.0;
+}
+
+static void run_frames(GLFWwindow* window, const int frames, const int width, const int height, shadow_times& times) {
+	const mat4 projection = city_projection(static_cast<float>(width) / height);
+	vector<uint32_t> visible(city_objects().size());
+	shadow_frame shadows;
+	light_grid grid;
+	GLuint query = 0;
+	glGenQueries(1, &query);
+	for (int frame = 0; frame < warmup_frames + frames; frame++) {
+		glfwPollEvents();
+		const double seconds = frame_seconds(frame);
+		const mat4 view = city_view(seconds);
+		const mat4 view_projection = projection * view;
+		const double start = profiler_now_ms();
+		city_fit_shadows(view, projection, shadows);
+		const double fit_ms = profiler_now_ms() - start;
+		const shadow_stats before = shadow_maps_stats();
+
+		const double submit_start = profiler_now_ms();
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		city_render_shadows(shadows);
+		glEndQuery(GL_TIME_ELAPSED);
+		const double submit_ms = profiler_now_ms() - submit_start;
+		const shadow_stats& after = shadow_maps_stats();
+
+		city_bin_lights(seconds, view, projection, grid);
+		clustered_lights_upload(grid);
+		city_draw(view_projection, visible.data(), city_cull_frustum(view_projection, false, visible.data()));
+		glFinish();
+		const double frame_ms = profiler_now_ms() - start;
+		GLuint64 gpu_ns = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpu_ns);
+
+		if (frame >= warmup_frames) {
+			times.fit_ms.push_back(fit_ms);
+			times.submit_ms.push_back(submit_ms);
+			times.gpu_ms.push_back(gpu_ns / 1e6);
+			times.frame_ms.push_back(frame_ms);
+			times.cascades += after.cascades_drawn - before.cascades_drawn;
+			times.draws += after.draws - before.draws;
+			times.casters += after.casters - before.casters;
+		}
+		glfwSwapBuffers(window);
+	}
+	glDeleteQueries(1, &query);
+}
+
+static string run_json(const char* name, const shadow_times& times, const int frames) {
+	char line[256];
+	snprintf(line, sizeof(line), "  \"%s\": {\"cascades_per_frame\": %.2f, \"draws_per_frame\": %.1f, \"casters_per_frame\": %.1f, ",
+		name, static_cast<double>(times.cascades) / frames, static_cast<double>(times.draws) / frames,
+		static_cast<double>(times.casters) / frames);
+	string json = line;
+	json += "\"fit_ms\": " + stats_json(compute_stats(times.fit_ms));
+	json += ", \"submit_ms\": " + stats_json(compute_stats(times.submit_ms));
+	json += ", \"gpu_ms\": " + stats_json(compute_stats(times.gpu_ms));
+	json += ", \"frame_ms\": " + stats_json(compute_stats(times.frame_ms)) + "}";
+	return json;
+}
+
+static void log_run(const char* name, const shadow_times& times, const int frames) {
+	char line[320];
+	snprintf(line, sizeof(line), "Shadows %s: %.2f cascades, %.1f draws (%.1f casters) per frame; fit and cull %.3f ms, "
+		"submit %.3f ms, GPU %.2f ms, frame to finish %.2f ms", name, static_cast<double>(times.cascades) / frames,
+		static_cast<double>(times.draws) / frames, static_cast<double>(times.casters) / frames,
+		compute_stats(times.fit_ms).median, compute_stats(times.submit_ms).median, compute_stats(times.gpu_ms).median,
+		compute_stats(times.frame_ms).median);
+	log(line);
+}
+
+int run_shadow_benchmark(const app_options& options, GLFWwindow* window, const int width, const int height) {
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 60;
+	const int size = options.shadow_map_size > 0 ? options.shadow_map_size : default_size;
+	city_generate(options.city_objects > 0 ? options.city_objects : default_objects, 1234);
+	city_generate_lights(0, 4321);
+	job_system_init(0);
+	if (!city_init_gl() || !city_init_shadows(size) || !city_init_lights(width, height)) {
+		log("Failed to set up the shadow benchmark");
+		city_release_shadows();
+		city_release_gl();
+		job_system_shutdown();
+		return 1;
+	}
+	glViewport(0, 0, width, height);
+
+	shadow_times uncached, cached;
+	shadow_maps_use_cache(false);
+	run_frames(window, frames, width, height, uncached);
+	shadow_maps_use_cache(true);
+	run_frames(window, frames, width, height, cached);
+	log_run("every frame", uncached, frames);
+	log_run("cached", cached, frames);
+
+	const double gpu_saved = compute_stats(uncached.gpu_ms).median - compute_stats(cached.gpu_ms).median;
+	const double frame_saved = compute_stats(uncached.frame_ms).median - compute_stats(cached.frame_ms).median;
+	char line[256];
+	snprintf(line, sizeof(line), "Shadows: caching saves %.1f draws per frame (%.0f%%), %.2f ms GPU, %.2f ms frame to finish",
+		static_cast<double>(uncached.draws - cached.draws) / frames,
+		uncached.draws > 0 ? 100.0 * (uncached.draws - cached.draws) / uncached.draws : 0.0, gpu_saved, frame_saved);
+	log(line);
+
+	string json = "{\n";
+	json += "  \"objects\": " + to_string(city_objects().size()) + ",\n";
+	json += "  \"cascades\": " + to_string(shadow_cascades) + ",\n";
+	json += "  \"map_size\": " + to_string(size) + ",\n";
+	json += "  \"frames\": " + to_string(frames) + ",\n";
+	json += "  \"renderer\": \"" + string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) + "\",\n";
+	json += run_json("every_frame", uncached, frames) + ",\n";
+	json += run_json("cached", cached, frames) + ",\n";
+	snprintf(line, sizeof(line), "  \"draws_saved_per_frame\": %.2f,\n  \"gpu_ms_saved\": %.3f,\n  \"frame_ms_saved\": %.3f\n",
+		static_cast<double>(uncached.draws - cached.draws) / frames, gpu_saved, frame_saved);
+	json += line;
+	json += "}\n";
+
+	city_release_lights();
+	city_release_shadows();
+	city_release_gl();
+	job_system_shutdown();
+
+	return write_bench_json(options.bench_output_path, "shadow_bench.json", json, "Shadow benchmark") ? 0 : 1;
+}
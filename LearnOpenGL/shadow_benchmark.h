@@ -0,0 +1,9 @@
+#pragma once
+
+#include "app_options.h"
+#include "gl_api.h"
+
+// the shadow pass along the city's camera path with every cascade drawn every frame, then with the
+// far cascades cached: cascades and draws per frame, casters a draw per object would take, CPU time
+// of the fit and culling, GPU time of the pass; writes JSON
+int run_shadow_benchmark(const app_options& options, GLFWwindow* window, int width, int height);
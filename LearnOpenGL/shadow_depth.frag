@@ -0,0 +1,6 @@
+#version 330 core
+
+// depth only, the shadow map framebuffer has no color attachment
+
+void main() {
+}
@@ -0,0 +1,283 @@
+#include "shadow_maps.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gpu_resources.h"
+#include "log.h"
+#include "profiler.h"
+#include "shader.h"
+
+using namespace std;
+
+// units 1 to 3 are clustered_lights', 4 and 5 deferred_shading's
+static const GLint shadow_unit = 6;
+static const GLuint cascade_block_binding = 0;
+// shadows end here, or at the far plane if it is nearer
+static const float shadow_distance = 300.0f;
+// between uniform (0) and logarithmic (1) splits
+static const float split_blend = 0.8f;
+// a cached cascade covers this much more than its part of the frustum, so the camera can move a
+// while before it has to be drawn again
+static const float cache_margin = 0.3f;
+
+// what a cached cascade was last drawn with
+struct cached_cascade {
+	bool valid = false;
+	// snapped center in light space and the half size it was drawn with
+	float x = 0.0f, y = 0.0f;
+	float half_size = 0.0f;
+	mat4 light_view_projection = {};
+	float texel_size = 0.0f;
+};
+
+static GLuint depth_array = 0;
+static GLuint framebuffer = 0;
+static GLuint uniform_buffer = 0;
+static GLuint depth_program = 0;
+static GLint light_view_projection_location = -1;
+static int map_size = 0;
+static int first_cached = shadow_cascades;
+static int refresh_interval = 0;
+static bool use_cache = true;
+static vec3 light_direction = normalize(vec3{ 0.4f, 1.0f, 0.3f });
+static cached_cascade cache[shadow_cascades];
+static uint64_t fit_frames = 0;
+static shadow_stats stats;
+
+bool shadow_maps_init(const int size, const int cached_cascades, const int refresh_frames) {
+	depth_program = load_program("shadow_depth.vert", "shadow_depth.frag");
+	if (depth_program == 0) {
+		return false;
+	}
+	light_view_projection_location = glGetUniformLocation(depth_program, "light_view_projection");
+	map_size = size;
+	first_cached = shadow_cascades - min(max(cached_cascades, 0), shadow_cascades - 1);
+	refresh_interval = max(refresh_frames, 0);
+
+	gpu_category_scope category(gpu_category::render_target);
+	glGenTextures(1, &depth_array);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, depth_array);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, size, size, shadow_cascades, 0, GL_DEPTH_COMPONENT,
+		GL_FLOAT, nullptr);
+	// the comparison with linear filtering averages four texels' results
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depth_array, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// std140: the matrices, then the cascade ends and texel sizes as two vec4
+	glGenBuffers(1, &uniform_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, uniform_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, (shadow_cascades * 16 + 8) * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	if (!complete) {
+		log("Shadow map framebuffer is incomplete");
+		shadow_maps_release();
+		return false;
+	}
+	shadow_maps_invalidate();
+	stats = shadow_stats();
+	return true;
+}
+
+void shadow_maps_release() {
+	glDeleteProgram(depth_program);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &depth_array);
+	glDeleteBuffers(1, &uniform_buffer);
+	depth_program = framebuffer = depth_array = uniform_buffer = 0;
+}
+
+void shadow_maps_set_light(const vec3& direction) {
+	if (direction.x != light_direction.x || direction.y != light_direction.y || direction.z != light_direction.z) {
+		light_direction = direction;
+		shadow_maps_invalidate();
+	}
+}
+
+void shadow_maps_invalidate() {
+	for (cached_cascade& cascade : cache) {
+		cascade.valid = false;
+	}
+}
+
+void shadow_maps_use_cache(const bool cache_far) {
+	use_cache = cache_far;
+	shadow_maps_invalidate();
+}
+
+// the light looks down its direction from the origin, the cascades differ only in their box
+static mat4 light_view() {
+	const vec3 up = fabs(light_direction.y) > 0.99f ? vec3{ 1.0f, 0.0f, 0.0f } : vec3{ 0.0f, 1.0f, 0.0f };
+	return look_at({ 0.0f, 0.0f, 0.0f }, light_direction * -1.0f, up);
+}
+
+void shadow_maps_fit(const mat4& view, const mat4& projection, const vec3& scene_min, const vec3& scene_max,
+	shadow_frame& frame) {
+	const double start = profiler_now_ms();
+	const float near_plane = projection.m[14] / (projection.m[10] - 1.0f);
+	const float far_plane = projection.m[14] / (projection.m[10] + 1.0f);
+	const float tan_x = 1.0f / projection.m[0];
+	const float tan_y = 1.0f / projection.m[5];
+	const float distance = min(far_plane, shadow_distance);
+	const mat4 camera_to_world = inverse(view);
+	const mat4 to_light = light_view();
+
+	// the whole scene's depth range along the light, so no caster in front of a cascade is clipped
+	float scene_near = 1e30f, scene_far = -1e30f;
+	for (int corner = 0; corner < 8; corner++) {
+		const vec3 p = { corner & 1 ? scene_max.x : scene_min.x, corner & 2 ? scene_max.y : scene_min.y,
+			corner & 4 ? scene_max.z : scene_min.z };
+		const float depth = -transform(to_light, p).z;
+		scene_near = min(scene_near, depth);
+		scene_far = max(scene_far, depth);
+	}
+
+	// one cached cascade redrawn in turn every refresh_interval frames
+	const int cached_count = shadow_cascades - first_cached;
+	const int refresh = use_cache && cached_count > 0 && refresh_interval > 0 && fit_frames % refresh_interval == 0
+		? first_cached + static_cast<int>(fit_frames / refresh_interval % cached_count) : -1;
+	fit_frames++;
+
+	float split_near = near_plane;
+	for (int i = 0; i < shadow_cascades; i++) {
+		const float fraction = static_cast<float>(i + 1) / shadow_cascades;
+		const float split_far = split_blend * near_plane * pow(distance / near_plane, fraction)
+			+ (1.0f - split_blend) * (near_plane + (distance - near_plane) * fraction);
+
+		// bounding sphere of the slice; its radius doesn't depend on where the camera looks
+		vec3 corners[8];
+		vec3 center = { 0.0f, 0.0f, 0.0f };
+		for (int corner = 0; corner < 8; corner++) {
+			const float depth = corner & 4 ? split_far : split_near;
+			const vec3 p = { (corner & 1 ? 1.0f : -1.0f) * depth * tan_x, (corner & 2 ? 1.0f : -1.0f) * depth * tan_y, -depth };
+			const vec4 world = transform(camera_to_world, p);
+			corners[corner] = { world.x, world.y, world.z };
+			center = center + corners[corner] * 0.125f;
+		}
+		float radius = 0.0f;
+		for (const vec3& corner : corners) {
+			radius = max(radius, length(corner - center));
+		}
+		radius = ceil(radius);
+		const vec4 light_center = transform(to_light, center);
+
+		cached_cascade& cascade = cache[i];
+		const bool cached = use_cache && i >= first_cached;
+		// still inside what the cascade was drawn with
+		const bool covered = cascade.valid && fabs(light_center.x - cascade.x) + radius <= cascade.half_size
+			&& fabs(light_center.y - cascade.y) + radius <= cascade.half_size;
+		frame.render[i] = !cached || !covered || i == refresh;
+		if (frame.render[i]) {
+			const float half_size = cached ? ceil(radius * (1.0f + cache_margin)) : radius;
+			const float texel = 2.0f * half_size / map_size;
+			cascade.valid = cached;
+			cascade.x = floor(light_center.x / texel) * texel;
+			cascade.y = floor(light_center.y / texel) * texel;
+			cascade.half_size = half_size;
+			cascade.texel_size = texel;
+			cascade.light_view_projection = orthographic(cascade.x - half_size, cascade.x + half_size,
+				cascade.y - half_size, cascade.y + half_size, scene_near - 1.0f, scene_far + 1.0f) * to_light;
+		}
+		frame.light_view_projection[i] = cascade.light_view_projection;
+		frame.texel_size[i] = cascade.texel_size;
+		frame.cascade_far[i] = split_far;
+		frame.ranges[i].clear();
+		frame.casters[i] = 0;
+		split_near = split_far;
+	}
+	frame.fit_ms = profiler_now_ms() - start;
+}
+
+size_t shadow_maps_render(const shadow_frame& frame, const GLuint vertex_array) {
+	GLint target = 0;
+	GLint viewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, map_size, map_size);
+	glEnable(GL_DEPTH_TEST);
+	// slope scaled bias against acne, the shading adds a normal offset on top
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+	glUseProgram(depth_program);
+	glBindVertexArray(vertex_array);
+
+	size_t draws = 0;
+	for (int i = 0; i < shadow_cascades; i++) {
+		if (!frame.render[i]) {
+			stats.cascades_cached++;
+			continue;
+		}
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depth_array, 0, i);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glUniformMatrix4fv(light_view_projection_location, 1, GL_FALSE, frame.light_view_projection[i].m);
+		const vector<uint32_t>& ranges = frame.ranges[i];
+		for (size_t range = 0; range < ranges.size(); range += 2) {
+			glDrawElements(GL_TRIANGLES, ranges[range + 1], GL_UNSIGNED_INT,
+				reinterpret_cast<GLvoid*>(static_cast<uintptr_t>(ranges[range]) * sizeof(GLuint)));
+		}
+		draws += ranges.size() / 2;
+		stats.cascades_drawn++;
+		stats.casters += frame.casters[i];
+	}
+	stats.draws += draws;
+	stats.frames++;
+
+	glBindVertexArray(0);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_DEPTH_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, target);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+	// clip space to texture space for the sampling
+	float block[shadow_cascades * 16 + 8];
+	for (int i = 0; i < shadow_cascades; i++) {
+		mat4 bias = mat4_identity();
+		bias.m[0] = bias.m[5] = bias.m[10] = 0.5f;
+		bias.m[12] = bias.m[13] = bias.m[14] = 0.5f;
+		const mat4 sampled = bias * frame.light_view_projection[i];
+		copy(sampled.m, sampled.m + 16, block + i * 16);
+		block[shadow_cascades * 16 + i] = frame.cascade_far[i];
+		block[shadow_cascades * 16 + 4 + i] = frame.texel_size[i];
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, uniform_buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	return draws;
+}
+
+void shadow_maps_setup_program(const GLuint program) {
+	glUseProgram(program);
+	// a unit of its own even without shadows, two sampler types may not share one
+	glUniform1i(glGetUniformLocation(program, "shadow_map"), shadow_unit);
+	glUniform1i(glGetUniformLocation(program, "shadowed"), depth_array != 0 ? 1 : 0);
+	const GLuint block = glGetUniformBlockIndex(program, "shadow_cascades");
+	if (block != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, block, cascade_block_binding);
+	}
+}
+
+void shadow_maps_bind() {
+	glActiveTexture(GL_TEXTURE0 + shadow_unit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, depth_array);
+	glActiveTexture(GL_TEXTURE0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, cascade_block_binding, uniform_buffer);
+}
+
+const shadow_stats& shadow_maps_stats() {
+	return stats;
+}
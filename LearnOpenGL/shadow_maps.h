@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gl_api.h"
+#include "math3d.h"
+
+// cascaded shadow maps for a directional light: the view frustum up to the shadow distance is cut
+// into cascades, each fitted with a sphere so its size doesn't change as the camera turns, and its
+// position snapped to whole shadow map texels so the edges don't crawl as the camera moves. the far
+// cascades are cached: rendered with some margin around them, then kept while the camera stays
+// inside, the light and the casters don't change, and only refreshed one at a time every few frames.
+// casters are drawn depth only from a position only vertex stream as ranges of its index buffer
+
+const int shadow_cascades = 4;
+
+// what the fit decided for one frame, filled on the main thread and drawn on the GL side
+struct shadow_frame {
+	// world to clip space of each cascade's light camera
+	mat4 light_view_projection[shadow_cascades] = {};
+	// view depth where each cascade ends, and the world size of one of its texels
+	float cascade_far[shadow_cascades] = {};
+	float texel_size[shadow_cascades] = {};
+	// whether the cascade is drawn this frame; the others keep what is in the shadow map
+	bool render[shadow_cascades] = {};
+	// casters of the cascades to draw, as first index and index count pairs in the caster stream
+	std::vector<uint32_t> ranges[shadow_cascades];
+	// objects in each drawn cascade, what drawing them one by one would take
+	size_t casters[shadow_cascades] = {};
+	double fit_ms = 0.0;
+};
+
+// totals over every frame since shadow_maps_init()
+struct shadow_stats {
+	uint64_t frames = 0;
+	uint64_t cascades_drawn = 0;
+	// drawn from the cache instead
+	uint64_t cascades_cached = 0;
+	uint64_t draws = 0;
+	uint64_t casters = 0;
+};
+
+// size x size texels per cascade; the last cached_cascades are cached and one of them refreshed
+// every refresh_frames frames (0 - only when they have to be)
+bool shadow_maps_init(int size, int cached_cascades, int refresh_frames);
+void shadow_maps_release();
+// points at the light, normalized; a new direction redraws every cascade
+void shadow_maps_set_light(const vec3& direction);
+// the casters moved, were added or removed: the cached cascades are drawn again
+void shadow_maps_invalidate();
+// false - every cascade is fitted tight and drawn every frame, for comparisons
+void shadow_maps_use_cache(bool cache);
+
+// cascades for a camera; projection comes from perspective(), scene_min and scene_max bound every
+// caster. leaves the ranges empty, they are the caller's to fill for the cascades to render
+void shadow_maps_fit(const mat4& view, const mat4& projection, const vec3& scene_min, const vec3& scene_max,
+	shadow_frame& frame);
+// draws the cascades the frame marks from vertex_array, whose index buffer holds 32 bit indices,
+// then updates what the programs sample; returns the draw count
+size_t shadow_maps_render(const shadow_frame& frame, GLuint vertex_array);
+// sampler unit and uniform block of a program with sun_shadow() (city_clustered.frag), which only
+// shadows after shadow_maps_init(); leaves the program bound
+void shadow_maps_setup_program(GLuint program);
+// binds the shadow map and the cascade uniforms for the programs
+void shadow_maps_bind();
+const shadow_stats& shadow_maps_stats();
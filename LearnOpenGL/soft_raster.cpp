@@ -0,0 +1,544 @@
+#include "soft_raster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <immintrin.h>
+
+#include "cpu_features.h"
+#include "job_system.h"
+
+using namespace std;
+
+static const int tile_size = 64;
+// tiles merge the binners with a fixed size cursor array
+static const int max_threads = 64;
+
+struct clip_vertex {
+	float x, y, z, w;
+	float color[4];
+};
+
+struct setup_triangle {
+	// normalized edge functions: a * x + b * y + c is the barycentric weight of vertex i
+	float a[3], b[3], c[3];
+	// pixels exactly on the edge belong to the triangle (top-left fill rule, as GL rasterizers do)
+	bool top_left[3];
+	float z0, dz1, dz2;
+	float inv_w[3];
+	// divided by w, so interpolating and dividing by the interpolated 1/w is perspective correct
+	float color[3][4];
+	uint32_t flat_pixel;
+	bool flat;
+	bool depth_test;
+	int min_x, min_y, max_x, max_y;
+};
+
+struct bin_entry {
+	// submission order, tiles merge the binners by it
+	uint32_t sequence;
+	uint32_t triangle;
+};
+
+// one per binning chunk, so submission needs no locks
+struct binner {
+	vector<setup_triangle> triangles;
+	vector<vector<bin_entry>> bins;
+};
+
+static int width = 0;
+static int height = 0;
+static int tiles_x = 0;
+static int tiles_y = 0;
+static int thread_count = 1;
+static bool use_avx2 = false;
+
+static vector<uint32_t> color_buffer;
+static uint32_t clear_pixel = 0;
+static float clear_depth_value = 1.0f;
+static vector<clip_vertex> vertices;
+static vector<binner> binners;
+static uint32_t sequence_base = 0;
+
+static thread_local float tile_depth[tile_size * tile_size];
+
+static uint32_t pack_color(const float* color) {
+	uint32_t pixel = 0;
+	for (int channel = 0; channel < 4; channel++) {
+		const float value = min(max(color[channel], 0.0f), 1.0f);
+		pixel |= static_cast<uint32_t>(value * 255.0f + 0.5f) << (channel * 8);
+	}
+	return pixel;
+}
+
+bool soft_raster_init(const int frame_width, const int frame_height) {
+	soft_raster_shutdown();
+	if (frame_width <= 0 || frame_height <= 0) {
+		return false;
+	}
+
+	width = frame_width;
+	height = frame_height;
+	tiles_x = (width + tile_size - 1) / tile_size;
+	tiles_y = (height + tile_size - 1) / tile_size;
+	thread_count = min(max_threads, job_system_threads());
+	use_avx2 = cpu_has_avx2();
+
+	color_buffer.assign(static_cast<size_t>(width) * height, 0);
+	binners.resize(thread_count);
+	for (binner& bins : binners) {
+		bins.bins.resize(tiles_x * tiles_y);
+	}
+	return true;
+}
+
+void soft_raster_shutdown() {
+	binners.clear();
+}
+
+int soft_raster_threads() {
+	return thread_count;
+}
+
+void soft_raster_begin_frame(const float clear_color[4], const float clear_depth) {
+	clear_pixel = pack_color(clear_color);
+	clear_depth_value = clear_depth;
+	sequence_base = 0;
+	// clear() keeps the capacity, a steady scene stops allocating after a few frames
+	for (binner& bins : binners) {
+		bins.triangles.clear();
+		for (vector<bin_entry>& bin : bins.bins) {
+			bin.clear();
+		}
+	}
+}
+
+// vertex processing
+
+struct draw_context {
+	const soft_draw* draw;
+	int triangle_count;
+};
+
+static int chunk_begin(const int count, const int index) {
+	return static_cast<int>(static_cast<int64_t>(count) * index / thread_count);
+}
+
+static void transform_vertices(void* context, const int index) {
+	const soft_draw& draw = *static_cast<draw_context*>(context)->draw;
+	const float* m = draw.transform;
+	const int end = chunk_begin(draw.vertex_count, index + 1);
+
+	for (int i = chunk_begin(draw.vertex_count, index); i < end; i++) {
+		const float* p = draw.positions + static_cast<size_t>(i) * draw.position_stride;
+		clip_vertex& v = vertices[i];
+		if (m != nullptr) {
+			v.x = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+			v.y = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+			v.z = m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14];
+			v.w = m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15];
+		}
+		else {
+			v.x = p[0];
+			v.y = p[1];
+			v.z = p[2];
+			v.w = 1.0f;
+		}
+		const float* color = draw.colors != nullptr ? draw.colors + static_cast<size_t>(i) * 4 : draw.color;
+		copy(color, color + 4, v.color);
+	}
+}
+
+// clipping, setup and binning
+
+static clip_vertex lerp(const clip_vertex& from, const clip_vertex& to, const float t) {
+	clip_vertex v;
+	v.x = from.x + (to.x - from.x) * t;
+	v.y = from.y + (to.y - from.y) * t;
+	v.z = from.z + (to.z - from.z) * t;
+	v.w = from.w + (to.w - from.w) * t;
+	for (int channel = 0; channel < 4; channel++) {
+		v.color[channel] = from.color[channel] + (to.color[channel] - from.color[channel]) * t;
+	}
+	return v;
+}
+
+// distance to the near (z = -w) or far (z = w) plane, inside when >= 0
+static float plane_distance(const clip_vertex& v, const int plane) {
+	return plane == 0 ? v.z + v.w : v.w - v.z;
+}
+
+static int clip_polygon(const clip_vertex* in, const int count, clip_vertex* out, const int plane) {
+	int written = 0;
+	for (int i = 0; i < count; i++) {
+		const clip_vertex& current = in[i];
+		const clip_vertex& next = in[(i + 1) % count];
+		const float d0 = plane_distance(current, plane);
+		const float d1 = plane_distance(next, plane);
+		if (d0 >= 0.0f) {
+			out[written++] = current;
+		}
+		if ((d0 >= 0.0f) != (d1 >= 0.0f)) {
+			out[written++] = lerp(current, next, d0 / (d0 - d1));
+		}
+	}
+	return written;
+}
+
+static bool setup(const clip_vertex* v0, const clip_vertex* v1, const clip_vertex* v2, const soft_draw& draw,
+	setup_triangle* triangle) {
+	const clip_vertex* v[3] = { v0, v1, v2 };
+	float sx[3], sy[3], sz[3];
+	for (int i = 0; i < 3; i++) {
+		triangle->inv_w[i] = 1.0f / v[i]->w;
+		sx[i] = (v[i]->x * triangle->inv_w[i] * 0.5f + 0.5f) * width;
+		sy[i] = (v[i]->y * triangle->inv_w[i] * 0.5f + 0.5f) * height;
+		sz[i] = v[i]->z * triangle->inv_w[i] * 0.5f + 0.5f;
+	}
+
+	const float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sy[1] - sy[0]) * (sx[2] - sx[0]);
+	if (!(fabs(area) > 1e-12f)) {
+		return false;
+	}
+
+	// pixel centers sit at +0.5
+	triangle->min_x = max(0, static_cast<int>(ceil(min({ sx[0], sx[1], sx[2] }) - 0.5f)));
+	triangle->min_y = max(0, static_cast<int>(ceil(min({ sy[0], sy[1], sy[2] }) - 0.5f)));
+	triangle->max_x = min(width - 1, static_cast<int>(floor(max({ sx[0], sx[1], sx[2] }) - 0.5f)));
+	triangle->max_y = min(height - 1, static_cast<int>(floor(max({ sy[0], sy[1], sy[2] }) - 0.5f)));
+	if (triangle->min_x > triangle->max_x || triangle->min_y > triangle->max_y) {
+		return false;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		const int j = (i + 1) % 3, k = (i + 2) % 3;
+		triangle->a[i] = (sy[j] - sy[k]) / area;
+		triangle->b[i] = (sx[k] - sx[j]) / area;
+		triangle->c[i] = (sx[j] * sy[k] - sx[k] * sy[j]) / area;
+		triangle->top_left[i] = triangle->a[i] > 0.0f || (triangle->a[i] == 0.0f && triangle->b[i] < 0.0f);
+	}
+
+	triangle->z0 = sz[0];
+	triangle->dz1 = sz[1] - sz[0];
+	triangle->dz2 = sz[2] - sz[0];
+	triangle->depth_test = draw.depth_test;
+	triangle->flat = draw.colors == nullptr;
+	triangle->flat_pixel = pack_color(draw.color);
+	if (!triangle->flat) {
+		for (int i = 0; i < 3; i++) {
+			for (int channel = 0; channel < 4; channel++) {
+				triangle->color[i][channel] = v[i]->color[channel] * triangle->inv_w[i];
+			}
+		}
+	}
+	return true;
+}
+
+static void bin(binner& bins, const setup_triangle& triangle, const uint32_t sequence) {
+	const uint32_t index = static_cast<uint32_t>(bins.triangles.size());
+	bins.triangles.push_back(triangle);
+
+	for (int ty = triangle.min_y / tile_size; ty <= triangle.max_y / tile_size; ty++) {
+		for (int tx = triangle.min_x / tile_size; tx <= triangle.max_x / tile_size; tx++) {
+			// skip tiles the bounding box touches but the triangle misses: some edge is negative
+			// at the tile's pixel center that is furthest inside it
+			const float x0 = max(tx * tile_size, triangle.min_x) + 0.5f;
+			const float y0 = max(ty * tile_size, triangle.min_y) + 0.5f;
+			const float x1 = min(tx * tile_size + tile_size - 1, triangle.max_x) + 0.5f;
+			const float y1 = min(ty * tile_size + tile_size - 1, triangle.max_y) + 0.5f;
+			bool covered = true;
+			for (int i = 0; i < 3 && covered; i++) {
+				const float x = triangle.a[i] > 0.0f ? x1 : x0;
+				const float y = triangle.b[i] > 0.0f ? y1 : y0;
+				covered = triangle.a[i] * x + triangle.b[i] * y + triangle.c[i] >= 0.0f;
+			}
+			if (covered) {
+				bins.bins[ty * tiles_x + tx].push_back({ sequence, index });
+			}
+		}
+	}
+}
+
+static bool outside_same_plane(const clip_vertex* v[3]) {
+	const auto all = [&v](float (*distance)(const clip_vertex&)) {
+		return distance(*v[0]) < 0.0f && distance(*v[1]) < 0.0f && distance(*v[2]) < 0.0f;
+	};
+	return all([](const clip_vertex& p) { return p.w - p.x; }) || all([](const clip_vertex& p) { return p.w + p.x; })
+		|| all([](const clip_vertex& p) { return p.w - p.y; }) || all([](const clip_vertex& p) { return p.w + p.y; })
+		|| all([](const clip_vertex& p) { return p.w - p.z; }) || all([](const clip_vertex& p) { return p.w + p.z; });
+}
+
+static void process_triangles(void* context, const int index) {
+	const draw_context& draw_info = *static_cast<draw_context*>(context);
+	const soft_draw& draw = *draw_info.draw;
+	binner& bins = binners[index];
+	const int end = chunk_begin(draw_info.triangle_count, index + 1);
+
+	for (int t = chunk_begin(draw_info.triangle_count, index); t < end; t++) {
+		const clip_vertex* v[3];
+		bool valid = true;
+		for (int corner = 0; corner < 3; corner++) {
+			const uint32_t vertex = draw.indices != nullptr ? draw.indices[t * 3 + corner] : t * 3 + corner;
+			valid = valid && vertex < static_cast<uint32_t>(draw.vertex_count);
+			v[corner] = valid ? &vertices[vertex] : nullptr;
+		}
+		if (!valid || outside_same_plane(v)) {
+			continue;
+		}
+
+		const uint32_t sequence = sequence_base + t;
+		setup_triangle triangle;
+		const bool needs_clip = plane_distance(*v[0], 0) < 0.0f || plane_distance(*v[1], 0) < 0.0f
+			|| plane_distance(*v[2], 0) < 0.0f || plane_distance(*v[0], 1) < 0.0f
+			|| plane_distance(*v[1], 1) < 0.0f || plane_distance(*v[2], 1) < 0.0f;
+		if (!needs_clip) {
+			if (setup(v[0], v[1], v[2], draw, &triangle)) {
+				bin(bins, triangle, sequence);
+			}
+			continue;
+		}
+
+		// near and far planes; x and y are left to the bounding box clamp, the edge functions are float
+		clip_vertex polygon[8] = { *v[0], *v[1], *v[2] };
+		clip_vertex clipped[8];
+		int count = clip_polygon(polygon, 3, clipped, 0);
+		count = clip_polygon(clipped, count, polygon, 1);
+		for (int i = 1; i + 1 < count; i++) {
+			if (setup(&polygon[0], &polygon[i], &polygon[i + 1], draw, &triangle)) {
+				bin(bins, triangle, sequence);
+			}
+		}
+	}
+}
+
+// a task per chunk index, the job system hands out ranges of them
+template <void (*task)(void* context, int index)>
+static void run_chunks(void* context, const int begin, const int end) {
+	for (int index = begin; index < end; index++) {
+		task(context, index);
+	}
+}
+
+void soft_raster_draw(const soft_draw& draw) {
+	if (draw.positions == nullptr || draw.vertex_count <= 0) {
+		return;
+	}
+	draw_context context = { &draw, (draw.indices != nullptr ? draw.index_count : draw.vertex_count) / 3 };
+
+	vertices.resize(draw.vertex_count);
+	parallel_for(0, thread_count, 1, run_chunks<transform_vertices>, &context);
+	parallel_for(0, thread_count, 1, run_chunks<process_triangles>, &context);
+	sequence_base += context.triangle_count;
+}
+
+// tile shading
+
+static void raster_scalar(const setup_triangle& t, const int x0, const int y0, const int x1, const int y1,
+	const int tile_x0, const int tile_y0) {
+	for (int y = y0; y <= y1; y++) {
+		const float py = y + 0.5f;
+		uint32_t* row = &color_buffer[static_cast<size_t>(y) * width];
+		float* depth_row = tile_depth + (y - tile_y0) * tile_size;
+
+		for (int x = x0; x <= x1; x++) {
+			const float px = x + 0.5f;
+			float e[3];
+			bool inside = true;
+			for (int i = 0; i < 3; i++) {
+				e[i] = t.a[i] * px + t.b[i] * py + t.c[i];
+				inside = inside && (e[i] > 0.0f || (e[i] == 0.0f && t.top_left[i]));
+			}
+			if (!inside) {
+				continue;
+			}
+
+			if (t.depth_test) {
+				const float z = t.z0 + e[1] * t.dz1 + e[2] * t.dz2;
+				if (!(z < depth_row[x - tile_x0])) {
+					continue;
+				}
+				depth_row[x - tile_x0] = z;
+			}
+
+			if (t.flat) {
+				row[x] = t.flat_pixel;
+				continue;
+			}
+			const float w = 1.0f / (e[0] * t.inv_w[0] + e[1] * t.inv_w[1] + e[2] * t.inv_w[2]);
+			float color[4];
+			for (int channel = 0; channel < 4; channel++) {
+				color[channel] = (e[0] * t.color[0][channel] + e[1] * t.color[1][channel] + e[2] * t.color[2][channel]) * w;
+			}
+			row[x] = pack_color(color);
+		}
+	}
+}
+
+// 8 pixels of a row per iteration
+static void raster_avx2(const setup_triangle& t, const int x0, const int y0, const int x1, const int y1,
+	const int tile_x0, const int tile_y0) {
+	const __m256 lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 scale = _mm256_set1_ps(255.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 last = _mm256_set1_ps(x1 + 0.5f);
+	const __m256 first = _mm256_set1_ps(x0 + 0.5f);
+
+	__m256 a[3], top_left[3];
+	for (int i = 0; i < 3; i++) {
+		a[i] = _mm256_set1_ps(t.a[i]);
+		top_left[i] = _mm256_castsi256_ps(_mm256_set1_epi32(t.top_left[i] ? -1 : 0));
+	}
+	const __m256 z0 = _mm256_set1_ps(t.z0);
+	const __m256 dz1 = _mm256_set1_ps(t.dz1);
+	const __m256 dz2 = _mm256_set1_ps(t.dz2);
+	const __m256i flat_pixel = _mm256_set1_epi32(static_cast<int>(t.flat_pixel));
+
+	// spans start on the tile's 8 pixel grid so the depth loads stay inside the tile row
+	const int start_x = tile_x0 + ((x0 - tile_x0) & ~7);
+
+	for (int y = y0; y <= y1; y++) {
+		const float py = y + 0.5f;
+		__m256 row_c[3];
+		for (int i = 0; i < 3; i++) {
+			row_c[i] = _mm256_set1_ps(t.b[i] * py + t.c[i]);
+		}
+		uint32_t* row = &color_buffer[static_cast<size_t>(y) * width];
+		float* depth_row = tile_depth + (y - tile_y0) * tile_size;
+
+		for (int x = start_x; x <= x1; x += 8) {
+			const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lanes);
+			__m256 e[3];
+			__m256 mask = _mm256_and_ps(_mm256_cmp_ps(px, first, _CMP_GE_OQ), _mm256_cmp_ps(px, last, _CMP_LE_OQ));
+			for (int i = 0; i < 3; i++) {
+				e[i] = _mm256_add_ps(_mm256_mul_ps(a[i], px), row_c[i]);
+				const __m256 inside = _mm256_or_ps(_mm256_cmp_ps(e[i], zero, _CMP_GT_OQ),
+					_mm256_and_ps(_mm256_cmp_ps(e[i], zero, _CMP_EQ_OQ), top_left[i]));
+				mask = _mm256_and_ps(mask, inside);
+			}
+			if (_mm256_movemask_ps(mask) == 0) {
+				continue;
+			}
+
+			if (t.depth_test) {
+				const __m256 z = _mm256_add_ps(z0, _mm256_add_ps(_mm256_mul_ps(e[1], dz1), _mm256_mul_ps(e[2], dz2)));
+				const __m256 depth = _mm256_loadu_ps(depth_row + x - tile_x0);
+				mask = _mm256_and_ps(mask, _mm256_cmp_ps(z, depth, _CMP_LT_OQ));
+				if (_mm256_movemask_ps(mask) == 0) {
+					continue;
+				}
+				_mm256_storeu_ps(depth_row + x - tile_x0, _mm256_blendv_ps(depth, z, mask));
+			}
+
+			__m256i pixels = flat_pixel;
+			if (!t.flat) {
+				const __m256 w = _mm256_div_ps(one, _mm256_add_ps(_mm256_mul_ps(e[0], _mm256_set1_ps(t.inv_w[0])),
+					_mm256_add_ps(_mm256_mul_ps(e[1], _mm256_set1_ps(t.inv_w[1])), _mm256_mul_ps(e[2], _mm256_set1_ps(t.inv_w[2])))));
+				pixels = _mm256_setzero_si256();
+				for (int channel = 0; channel < 4; channel++) {
+					__m256 value = _mm256_mul_ps(e[0], _mm256_set1_ps(t.color[0][channel]));
+					value = _mm256_add_ps(value, _mm256_mul_ps(e[1], _mm256_set1_ps(t.color[1][channel])));
+					value = _mm256_add_ps(value, _mm256_mul_ps(e[2], _mm256_set1_ps(t.color[2][channel])));
+					value = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(value, w), zero), one);
+					const __m256i bytes = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, scale), half));
+					pixels = _mm256_or_si256(pixels, _mm256_slli_epi32(bytes, channel * 8));
+				}
+			}
+			_mm256_maskstore_epi32(reinterpret_cast<int*>(row + x), _mm256_castps_si256(mask), pixels);
+		}
+	}
+}
+
+static void shade_tile(void*, const int index) {
+	const int tile_x0 = (index % tiles_x) * tile_size;
+	const int tile_y0 = (index / tiles_x) * tile_size;
+	const int tile_x1 = min(tile_x0 + tile_size, width) - 1;
+	const int tile_y1 = min(tile_y0 + tile_size, height) - 1;
+
+	for (int y = tile_y0; y <= tile_y1; y++) {
+		fill_n(&color_buffer[static_cast<size_t>(y) * width + tile_x0], tile_x1 - tile_x0 + 1, clear_pixel);
+	}
+	fill_n(tile_depth, tile_size * tile_size, clear_depth_value);
+
+	// the binners each hold their bin in submission order; merge them so triangles land in that order
+	size_t cursors[max_threads] = {};
+	const int binner_count = static_cast<int>(binners.size());
+	for (;;) {
+		int next = -1;
+		uint32_t next_sequence = 0;
+		for (int b = 0; b < binner_count; b++) {
+			const vector<bin_entry>& bin = binners[b].bins[index];
+			if (cursors[b] < bin.size() && (next < 0 || bin[cursors[b]].sequence < next_sequence)) {
+				next = b;
+				next_sequence = bin[cursors[b]].sequence;
+			}
+		}
+		if (next < 0) {
+			break;
+		}
+
+		const bin_entry& entry = binners[next].bins[index][cursors[next]++];
+		const setup_triangle& triangle = binners[next].triangles[entry.triangle];
+		const int x0 = max(triangle.min_x, tile_x0), x1 = min(triangle.max_x, tile_x1);
+		const int y0 = max(triangle.min_y, tile_y0), y1 = min(triangle.max_y, tile_y1);
+		if (use_avx2) {
+			raster_avx2(triangle, x0, y0, x1, y1, tile_x0, tile_y0);
+		}
+		else {
+			raster_scalar(triangle, x0, y0, x1, y1, tile_x0, tile_y0);
+		}
+	}
+}
+
+void soft_raster_end_frame() {
+	parallel_for(0, tiles_x * tiles_y, 1, run_chunks<shade_tile>, nullptr);
+}
+
+const uint32_t* soft_raster_pixels() {
+	return color_buffer.data();
+}
+
+int soft_raster_width() {
+	return width;
+}
+
+int soft_raster_height() {
+	return height;
+}
+
+bool soft_raster_write_ppm(const string& path) {
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == nullptr) {
+		return false;
+	}
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+	vector<unsigned char> row(static_cast<size_t>(width) * 3);
+	// PPM goes top down
+	for (int y = height - 1; y >= 0; y--) {
+		for (int x = 0; x < width; x++) {
+			const uint32_t pixel = color_buffer[static_cast<size_t>(y) * width + x];
+			row[x * 3] = pixel & 0xff;
+			row[x * 3 + 1] = (pixel >> 8) & 0xff;
+			row[x * 3 + 2] = (pixel >> 16) & 0xff;
+		}
+		fwrite(row.data(), 1, row.size(), file);
+	}
+	return fclose(file) == 0;
+}
+
+soft_raster_difference soft_raster_compare(const uint8_t* rgba, const int tolerance) {
+	soft_raster_difference difference;
+	const uint8_t* ours = reinterpret_cast<const uint8_t*>(color_buffer.data());
+	for (size_t pixel = 0; pixel < color_buffer.size(); pixel++) {
+		int largest = 0;
+		for (int channel = 0; channel < 4; channel++) {
+			largest = max(largest, abs(ours[pixel * 4 + channel] - rgba[pixel * 4 + channel]));
+		}
+		difference.max_channel_difference = max(difference.max_channel_difference, largest);
+		difference.mismatched_pixels += largest > tolerance ? 1 : 0;
+	}
+	return difference;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// CPU rendering backend for machines without a usable GL driver. draws are transformed, clipped
+// and binned into 64x64 screen tiles as they are submitted; soft_raster_end_frame() then shades
+// the tiles in parallel, each one against its own depth buffer, with AVX2 edge functions when the
+// CPU has them. the result is an RGBA8 image laid out the way glReadPixels returns it
+
+struct soft_draw {
+	// xyz per vertex, position_stride floats apart
+	const float* positions = nullptr;
+	int position_stride = 3;
+	int vertex_count = 0;
+	// triangle list; nullptr - vertices taken in order
+	const uint32_t* indices = nullptr;
+	int index_count = 0;
+	// column major model-view-projection; nullptr - positions are already in clip space
+	const float* transform = nullptr;
+	// rgba per vertex, interpolated perspective correct; nullptr - every pixel gets color
+	const float* colors = nullptr;
+	float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	// GL_LESS against the frame's depth, off like the GL default
+	bool depth_test = false;
+};
+
+// work is split over the job system's threads as it is at init (job_system.h), without it
+// everything runs on the calling thread
+bool soft_raster_init(int width, int height);
+void soft_raster_shutdown();
+int soft_raster_threads();
+
+void soft_raster_begin_frame(const float clear_color[4], float clear_depth);
+void soft_raster_draw(const soft_draw& draw);
+void soft_raster_end_frame();
+
+// bottom row first, R G B A bytes per pixel
+const uint32_t* soft_raster_pixels();
+int soft_raster_width();
+int soft_raster_height();
+bool soft_raster_write_ppm(const std::string& path);
+
+struct soft_raster_difference {
+	// pixels with any channel further apart than the tolerance
+	int mismatched_pixels = 0;
+	int max_channel_difference = 0;
+};
+
+// rgba - width * height pixels in the soft_raster_pixels() layout, e.g. from glReadPixels
+soft_raster_difference soft_raster_compare(const uint8_t* rgba, int tolerance);
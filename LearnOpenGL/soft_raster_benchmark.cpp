@@ -0,0 +1,119 @@
+#include "soft_raster_benchmark.h"
+
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bench_stats.h"
+#include "cpu_features.h"
+#include "job_system.h"
+#include "log.h"
+#include "soft_raster.h"
+
+using namespace std;
+
+static const int bench_width = 1280;
+static const int bench_height = 720;
+static const int warmup_frames = 2;
+
+int run_soft_raster_benchmark(const app_options& options) {
+	const int triangle_count = options.software_bench_triangles;
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 20;
+
+	// small triangles scattered over the screen at random depths, a few pixels to a few dozen wide
+	mt19937 random(1234);
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	vector<float> positions(static_cast<size_t>(triangle_count) * 9);
+	vector<float> colors(static_cast<size_t>(triangle_count) * 12);
+	for (int t = 0; t < triangle_count; t++) {
+		const float center_x = unit(random) * 2.0f - 1.0f;
+		const float center_y = unit(random) * 2.0f - 1.0f;
+		const float size = 0.005f + unit(random) * 0.03f;
+		const float depth = unit(random) * 2.0f - 1.0f;
+		for (int corner = 0; corner < 3; corner++) {
+			float* p = &positions[(t * 3 + corner) * 3];
+			p[0] = center_x + (unit(random) - 0.5f) * size * 2.0f;
+			p[1] = center_y + (unit(random) - 0.5f) * size * 2.0f;
+			p[2] = depth;
+			float* c = &colors[(t * 3 + corner) * 4];
+			c[0] = unit(random);
+			c[1] = unit(random);
+			c[2] = unit(random);
+			c[3] = 1.0f;
+		}
+	}
+
+	soft_draw draw;
+	draw.positions = positions.data();
+	draw.vertex_count = triangle_count * 3;
+	draw.colors = colors.data();
+	draw.depth_test = true;
+	const float clear_color[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	const int hardware_threads = max(1, static_cast<int>(thread::hardware_concurrency()));
+	vector<int> thread_counts;
+	for (int threads = 1; threads < hardware_threads; threads *= 2) {
+		thread_counts.push_back(threads);
+	}
+	thread_counts.push_back(hardware_threads);
+
+	string json = "{\n";
+	json += "  \"triangles\": " + to_string(triangle_count) + ",\n";
+	json += "  \"width\": " + to_string(bench_width) + ",\n";
+	json += "  \"height\": " + to_string(bench_height) + ",\n";
+	json += "  \"frames\": " + to_string(frames) + ",\n";
+	json += string("  \"avx2\": ") + (cpu_has_avx2() ? "true" : "false") + ",\n";
+	json += "  \"runs\": [\n";
+
+	double single_thread_ms = 0.0;
+	for (size_t run = 0; run < thread_counts.size(); run++) {
+		job_system_init(thread_counts[run]);
+		if (!soft_raster_init(bench_width, bench_height)) {
+			log("Failed to initialize the software rasterizer");
+			job_system_shutdown();
+			return 1;
+		}
+
+		vector<double> frame_ms, bin_ms, shade_ms;
+		for (int frame = 0; frame < warmup_frames + frames; frame++) {
+			const bench_clock::time_point start = bench_clock::now();
+			soft_raster_begin_frame(clear_color, 1.0f);
+			soft_raster_draw(draw);
+			const double binned = elapsed_ms(start);
+			soft_raster_end_frame();
+			const double total = elapsed_ms(start);
+
+			if (frame >= warmup_frames) {
+				frame_ms.push_back(total);
+				bin_ms.push_back(binned);
+				shade_ms.push_back(total - binned);
+			}
+		}
+
+		const bench_stats frame_stats = compute_stats(frame_ms);
+		if (run == 0) {
+			single_thread_ms = frame_stats.median;
+		}
+		const double triangles_per_second = triangle_count / (frame_stats.median / 1000.0);
+		const double speedup = single_thread_ms / frame_stats.median;
+
+		char line[160];
+		snprintf(line, sizeof(line), "%2d threads: %8.3f ms/frame, %6.2f Mtri/s, speedup %.2f",
+			thread_counts[run], frame_stats.median, triangles_per_second / 1e6, speedup);
+		log(line);
+
+		json += "    {\"threads\": " + to_string(thread_counts[run]);
+		json += ", \"frame_ms\": " + stats_json(frame_stats);
+		json += ", \"bin_ms\": " + stats_json(compute_stats(bin_ms));
+		json += ", \"shade_ms\": " + stats_json(compute_stats(shade_ms));
+		snprintf(line, sizeof(line), ", \"triangles_per_second\": %.0f, \"speedup\": %.3f}", triangles_per_second, speedup);
+		json += line;
+		json += run + 1 < thread_counts.size() ? ",\n" : "\n";
+		soft_raster_shutdown();
+		job_system_shutdown();
+	}
+	json += "  ]\n}\n";
+
+	return write_bench_json(options.bench_output_path, "software_bench.json", json, "Software rasterizer benchmark") ? 0 : 1;
+}
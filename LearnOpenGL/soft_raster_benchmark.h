@@ -0,0 +1,7 @@
+#pragma once
+
+#include "app_options.h"
+
+// renders options.software_bench_triangles random triangles with the software rasterizer at
+// 1, 2, 4 ... hardware threads and writes frame times, triangles per second and speedup as JSON
+int run_soft_raster_benchmark(const app_options& options);
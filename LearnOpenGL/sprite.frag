@@ -0,0 +1,11 @@
+#version 330 core
+
+in vec3 image_uv;
+in vec4 sprite_tint;
+out vec4 color;
+
+uniform sampler2DArray images;
+
+void main() {
+	color = texture(images, image_uv) * sprite_tint;
+}
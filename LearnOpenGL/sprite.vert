@@ -0,0 +1,19 @@
+#version 330 core
+
+// one instance per sprite, the corners of the 4 vertex strip come from gl_VertexID
+layout (location = 0) in vec4 rect;
+layout (location = 1) in vec4 tint;
+layout (location = 2) in uint layer;
+
+uniform vec2 screen_size;
+
+out vec3 image_uv;
+out vec4 sprite_tint;
+
+void main() {
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 position = rect.xy + corner * rect.zw;
+	gl_Position = vec4(position / screen_size * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);
+	image_uv = vec3(corner, float(layer));
+	sprite_tint = tint;
+}
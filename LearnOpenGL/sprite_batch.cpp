@@ -0,0 +1,250 @@
+#include "sprite_batch.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "gl_api.h"
+#include "gpu_resources.h"
+#include "log.h"
+#include "render_stats.h"
+#include "shader.h"
+
+using namespace std;
+
+// the ring: a region is fenced when it fills up and waited on the next time around
+static const size_t region_count = 4;
+static const size_t region_sprites = 1 << 18;
+static const size_t ring_sprites = region_count * region_sprites;
+// how long a single fence wait lasts before it is retried
+static const GLuint64 fence_timeout_ns = 1000000000;
+
+static GLuint program = 0;
+static GLuint vao = 0;
+static GLuint buffer = 0;
+static GLuint texture = 0;
+static GLint screen_size_location = -1;
+
+static int image_width = 0;
+static int image_height = 0;
+static int max_layers = 0;
+static int layers = 0;
+static bool mipmaps_dirty = false;
+
+// persistent - the whole ring stays mapped (GL 4.4 / ARB_buffer_storage), otherwise the rest of the
+// current region is mapped unsynchronized until the next draw
+static bool persistent = false;
+static sprite* mapped = nullptr;
+static GLsync fences[region_count] = {};
+
+// slot of the next sprite in the ring, and of the first one not drawn yet
+static size_t cursor = 0;
+static size_t batch_start = 0;
+// where the slot at cursor is mapped (nullptr - nowhere) and the end of its region
+static sprite* writable = nullptr;
+static size_t writable_end = 0;
+
+static size_t max_batch = 0;
+static sprite_batch_stats stats;
+
+static void wait_region(const size_t region) {
+	if (fences[region] == nullptr) {
+		return;
+	}
+	if (glClientWaitSync(fences[region], 0, 0) == GL_TIMEOUT_EXPIRED) {
+		stats.fence_waits++;
+		GLenum result;
+		do {
+			result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, fence_timeout_ns);
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fences[region]);
+	fences[region] = nullptr;
+}
+
+static void open_writable() {
+	// a no-op unless cursor just came around to a region the GPU may still be reading
+	wait_region(cursor / region_sprites);
+	writable_end = (cursor / region_sprites + 1) * region_sprites;
+	if (persistent) {
+		writable = mapped + cursor;
+	}
+	else {
+		// the GPU only reads the slots before cursor, nothing has to wait for it
+		writable = static_cast<sprite*>(glMapBufferRange(GL_ARRAY_BUFFER, cursor * sizeof(sprite),
+			(writable_end - cursor) * sizeof(sprite), GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+	}
+}
+
+// GL 3.3 has no base instance, the attributes are pointed at the batch instead
+static void point_attributes(const size_t first) {
+	const char* base = reinterpret_cast<const char*>(first * sizeof(sprite));
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(sprite), base + offsetof(sprite, x));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(sprite), base + offsetof(sprite, color));
+	glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(sprite), base + offsetof(sprite, layer));
+}
+
+static void flush() {
+	if (!persistent && writable != nullptr) {
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		writable = nullptr;
+	}
+	if (cursor > batch_start) {
+		point_attributes(batch_start);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(cursor - batch_start));
+		stats.draws++;
+		batch_start = cursor;
+	}
+	if (writable_end > 0 && cursor == writable_end) {
+		fences[cursor / region_sprites - 1] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		cursor = batch_start = cursor % ring_sprites;
+		writable = nullptr;
+		writable_end = 0;
+	}
+}
+
+bool sprite_batch_init(const int width, const int height, const int images) {
+	program = load_program("sprite.vert", "sprite.frag");
+	if (program == 0) {
+		return false;
+	}
+	screen_size_location = glGetUniformLocation(program, "screen_size");
+
+	image_width = width;
+	image_height = height;
+	max_layers = images;
+	layers = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, images, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	const GLsizeiptr bytes = ring_sprites * sizeof(sprite);
+	const GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &buffer);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	{
+		gpu_category_scope category(gpu_category::streaming);
+		persistent = gl_api_has_version(4, 4) || gl_api_has_extension("GL_ARB_buffer_storage");
+		if (persistent) {
+			glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, map_flags);
+			mapped = static_cast<sprite*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, map_flags));
+		}
+		else {
+			glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+		}
+	}
+	for (GLuint attribute = 0; attribute < 3; attribute++) {
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, 1);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (persistent && mapped == nullptr) {
+		log("Failed to map the sprite buffer");
+		sprite_batch_release();
+		return false;
+	}
+	cursor = batch_start = 0;
+	log(string("Sprite batch ready, streaming through ") + (persistent ? "a persistently mapped ring" : "unsynchronized maps"));
+	return true;
+}
+
+void sprite_batch_release() {
+	for (GLsync& fence : fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+	if (mapped != nullptr) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		mapped = nullptr;
+	}
+	glDeleteBuffers(1, &buffer);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteTextures(1, &texture);
+	glDeleteProgram(program);
+	buffer = vao = texture = program = 0;
+	writable = nullptr;
+	writable_end = 0;
+}
+
+int sprite_batch_add_image(const uint8_t* rgba) {
+	if (layers >= max_layers) {
+		return -1;
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layers, image_width, image_height, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	mipmaps_dirty = true;
+	return layers++;
+}
+
+void sprite_batch_begin(const int width, const int height) {
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	if (mipmaps_dirty) {
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		mipmaps_dirty = false;
+	}
+	glUseProgram(program);
+	glUniform2f(screen_size_location, static_cast<GLfloat>(width), static_cast<GLfloat>(height));
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void sprite_batch_draw(const sprite* sprites, size_t count) {
+	while (count > 0) {
+		if (writable == nullptr) {
+			open_writable();
+			if (writable == nullptr) {
+				return;
+			}
+		}
+		size_t written = min(count, writable_end - cursor);
+		if (max_batch > 0) {
+			written = min(written, batch_start + max_batch - cursor);
+		}
+		memcpy(writable, sprites, written * sizeof(sprite));
+		render_stats_mapped_write(written * sizeof(sprite));
+		writable += written;
+		cursor += written;
+		sprites += written;
+		count -= written;
+		stats.sprites += written;
+		if (cursor == writable_end || (max_batch > 0 && cursor - batch_start >= max_batch)) {
+			flush();
+		}
+	}
+}
+
+void sprite_batch_end() {
+	flush();
+	glDisable(GL_BLEND);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void sprite_batch_set_max_batch(const size_t sprites) {
+	max_batch = sprites;
+}
+
+const sprite_batch_stats& sprite_batch_get_stats() {
+	return stats;
+}
+
+void sprite_batch_reset_stats() {
+	stats = sprite_batch_stats();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 2D sprites drawn with as few draw calls as possible: every image is a layer of one texture array,
+// so switching images never breaks a batch, and the sprites are written straight into a ring of
+// streaming buffer regions that are drawn instanced, one draw per region filled
+
+// a quad in pixels from the top left corner of the screen, like the text overlay
+struct sprite {
+	float x = 0.0f;
+	float y = 0.0f;
+	float width = 0.0f;
+	float height = 0.0f;
+	// multiplies the image, r g b a bytes from the lowest
+	uint32_t color = 0xffffffff;
+	// from sprite_batch_add_image()
+	uint32_t layer = 0;
+};
+
+struct sprite_batch_stats {
+	uint64_t sprites = 0;
+	uint64_t draws = 0;
+	// region reuses that had to wait for the GPU to finish reading the region
+	uint64_t fence_waits = 0;
+};
+
+// every image is image_width x image_height RGBA8, at most max_images of them
+bool sprite_batch_init(int image_width, int image_height, int max_images);
+void sprite_batch_release();
+// the image's layer, -1 when the array is full
+int sprite_batch_add_image(const uint8_t* rgba);
+
+// sprites are drawn in the order they are added, alpha blended, with nothing bound when end returns
+void sprite_batch_begin(int width, int height);
+void sprite_batch_draw(const sprite* sprites, size_t count);
+void sprite_batch_end();
+
+// at most this many sprites per draw (0 - a whole region), 1 draws every sprite on its own
+void sprite_batch_set_max_batch(size_t sprites);
+const sprite_batch_stats& sprite_batch_get_stats();
+void sprite_batch_reset_stats();
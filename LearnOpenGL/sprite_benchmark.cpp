@@ -0,0 +1,222 @@
+#include "sprite_benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench_stats.h"
+#include "log.h"
+#include "sprite_batch.h"
+
+using namespace std;
+
+static const int warmup_frames = 3;
+static const int image_size = 32;
+static const int image_count = 16;
+// the one draw per sprite run only draws this many, it would take seconds per frame otherwise
+static const size_t max_unbatched_sprites = 20000;
+
+struct frame_times {
+	vector<double> update_ms;
+	vector<double> submit_ms;
+	vector<double> gpu_ms;
+	vector<double> frame_ms;
+};
+
+// disc, ring, square and diamond in four colors, with a soft edge
+static vector<uint8_t> make_image(const int index) {
+	static const uint8_t colors[4][3] = { { 255, 90, 80 }, { 80, 200, 255 }, { 120, 255, 120 }, { 255, 220, 80 } };
+	const uint8_t* color = colors[index / 4];
+	vector<uint8_t> image(image_size * image_size * 4);
+	for (int y = 0; y < image_size; y++) {
+		for (int x = 0; x < image_size; x++) {
+			const float u = (x + 0.5f) / image_size * 2.0f - 1.0f;
+			const float v = (y + 0.5f) / image_size * 2.0f - 1.0f;
+			float distance = 0.0f;
+			switch (index % 4) {
+			case 0: distance = sqrt(u * u + v * v) - 0.9f; break;
+			case 1: distance = abs(sqrt(u * u + v * v) - 0.65f) - 0.25f; break;
+			case 2: distance = max(abs(u), abs(v)) - 0.8f; break;
+			default: distance = abs(u) + abs(v) - 0.95f; break;
+			}
+			uint8_t* pixel = &image[(y * image_size + x) * 4];
+			pixel[0] = color[0];
+			pixel[1] = color[1];
+			pixel[2] = color[2];
+			pixel[3] = static_cast<uint8_t>(255.0f * min(1.0f, max(0.0f, -distance * image_size * 0.5f)));
+		}
+	}
+	return image;
+}
+
+// velocities in pixels per frame, sprites leaving one edge come back at the other
+static void move_sprites(vector<sprite>& sprites, const size_t count, const vector<float>& velocities,
+	const float width, const float height) {
+	for (size_t i = 0; i < count; i++) {
+		sprite& moved = sprites[i];
+		moved.x += velocities[i * 2];
+		moved.y += velocities[i * 2 + 1];
+		if (moved.x < -moved.width) {
+			moved.x += width + moved.width;
+		}
+		else if (moved.x > width) {
+			moved.x -= width + moved.width;
+		}
+		if (moved.y < -moved.height) {
+			moved.y += height + moved.height;
+		}
+		else if (moved.y > height) {
+			moved.y -= height + moved.height;
+		}
+	}
+}
+
+static void draw_sprites(const vector<sprite>& sprites, const size_t count, const int width, const int height) {
+	glClear(GL_COLOR_BUFFER_BIT);
+	sprite_batch_begin(width, height);
+	sprite_batch_draw(sprites.data(), count);
+	sprite_batch_end();
+}
+
+static void run_frames(GLFWwindow* window, const int frames, vector<sprite>& sprites, const size_t count,
+	const vector<float>& velocities, const int width, const int height, frame_times& times) {
+	GLuint query = 0;
+	glGenQueries(1, &query);
+	for (int frame = 0; frame < warmup_frames + frames; frame++) {
+		glfwPollEvents();
+		const bench_clock::time_point start = bench_clock::now();
+		move_sprites(sprites, count, velocities, static_cast<float>(width), static_cast<float>(height));
+		const double updated = elapsed_ms(start);
+
+		glClear(GL_COLOR_BUFFER_BIT);
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		const bench_clock::time_point submit_start = bench_clock::now();
+		sprite_batch_begin(width, height);
+		sprite_batch_draw(sprites.data(), count);
+		sprite_batch_end();
+		const double submitted = elapsed_ms(submit_start);
+		glEndQuery(GL_TIME_ELAPSED);
+		// wait for the draws so the frame time is their cost
+		glFinish();
+		GLuint64 gpu_ns = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpu_ns);
+
+		if (frame >= warmup_frames) {
+			times.update_ms.push_back(updated);
+			times.submit_ms.push_back(submitted);
+			times.gpu_ms.push_back(gpu_ns / 1e6);
+			times.frame_ms.push_back(elapsed_ms(start));
+		}
+		glfwSwapBuffers(window);
+	}
+	glDeleteQueries(1, &query);
+}
+
+static string times_json(const frame_times& times) {
+	string json = "\"update_ms\": " + stats_json(compute_stats(times.update_ms));
+	json += ", \"submit_ms\": " + stats_json(compute_stats(times.submit_ms));
+	json += ", \"gpu_ms\": " + stats_json(compute_stats(times.gpu_ms));
+	json += ", \"frame_ms\": " + stats_json(compute_stats(times.frame_ms));
+	return json;
+}
+
+int run_sprite_benchmark(const app_options& options, GLFWwindow* window, const int width, const int height) {
+	const size_t count = static_cast<size_t>(options.sprite_bench_sprites);
+	const size_t unbatched_count = min(count, max_unbatched_sprites);
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 20;
+
+	if (!sprite_batch_init(image_size, image_size, image_count)) {
+		log("Failed to set up the sprite benchmark");
+		return 1;
+	}
+	for (int image = 0; image < image_count; image++) {
+		sprite_batch_add_image(make_image(image).data());
+	}
+
+	mt19937 random(1234);
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	vector<sprite> sprites(count);
+	vector<float> velocities(count * 2);
+	for (size_t i = 0; i < count; i++) {
+		sprite& created = sprites[i];
+		created.width = created.height = 4.0f + 12.0f * unit(random);
+		created.x = unit(random) * width;
+		created.y = unit(random) * height;
+		created.color = 0x00ffffff | static_cast<uint32_t>(128 + 127 * unit(random)) << 24;
+		created.layer = static_cast<uint32_t>(unit(random) * image_count) % image_count;
+		velocities[i * 2] = unit(random) * 2.0f - 1.0f;
+		velocities[i * 2 + 1] = unit(random) * 2.0f - 1.0f;
+	}
+	// the images in submission order are random, a texture per image would end a batch on nearly every sprite
+	size_t texture_switches = 0;
+	for (size_t i = 1; i < count; i++) {
+		texture_switches += sprites[i].layer != sprites[i - 1].layer ? 1 : 0;
+	}
+
+	glClearColor(0.05f, 0.05f, 0.08f, 1.0f);
+	glViewport(0, 0, width, height);
+
+	// batching must not change the image: both draw in the same order
+	vector<uint8_t> batched_pixels, unbatched_pixels;
+	draw_sprites(sprites, unbatched_count, width, height);
+	read_pixels(batched_pixels, width, height);
+	sprite_batch_set_max_batch(1);
+	draw_sprites(sprites, unbatched_count, width, height);
+	read_pixels(unbatched_pixels, width, height);
+	const int difference = differing_pixels(batched_pixels, unbatched_pixels);
+
+	frame_times unbatched;
+	sprite_batch_reset_stats();
+	run_frames(window, frames, sprites, unbatched_count, velocities, width, height, unbatched);
+	const double unbatched_draws = static_cast<double>(sprite_batch_get_stats().draws) / (warmup_frames + frames);
+
+	frame_times batched;
+	sprite_batch_set_max_batch(0);
+	sprite_batch_reset_stats();
+	run_frames(window, frames, sprites, count, velocities, width, height, batched);
+	const sprite_batch_stats batch_stats = sprite_batch_get_stats();
+	const double batched_draws = static_cast<double>(batch_stats.draws) / (warmup_frames + frames);
+	sprite_batch_release();
+
+	const bench_stats batched_submit = compute_stats(batched.submit_ms);
+	const bench_stats unbatched_submit = compute_stats(unbatched.submit_ms);
+	const double batched_ns = batched_submit.median * 1e6 / max<size_t>(1, count);
+	const double unbatched_ns = unbatched_submit.median * 1e6 / max<size_t>(1, unbatched_count);
+
+	char line[256];
+	snprintf(line, sizeof(line), "Sprites: %zu sprites in %d images, %.0f draws per frame (%zu with a texture per image)",
+		count, image_count, batched_draws, texture_switches + 1);
+	log(line);
+	snprintf(line, sizeof(line), "Sprites: batched     update %.2f ms, submit %.2f ms (%.2f ns per sprite), GPU %.2f ms, frame %.2f ms, %llu fence waits",
+		compute_stats(batched.update_ms).median, batched_submit.median, batched_ns, compute_stats(batched.gpu_ms).median,
+		compute_stats(batched.frame_ms).median, static_cast<unsigned long long>(batch_stats.fence_waits));
+	log(line);
+	snprintf(line, sizeof(line), "Sprites: one draw per sprite, %zu sprites: submit %.2f ms (%.1f ns per sprite, %.0f ms for all %zu), GPU %.2f ms",
+		unbatched_count, unbatched_submit.median, unbatched_ns, unbatched_ns * count / 1e6, count,
+		compute_stats(unbatched.gpu_ms).median);
+	log(line);
+	snprintf(line, sizeof(line), "Sprites: %d pixels differ between batched and one draw per sprite", difference);
+	log(line);
+
+	string json = "{\n";
+	json += "  \"sprites\": " + to_string(count) + ",\n";
+	json += "  \"images\": " + to_string(image_count) + ",\n";
+	json += "  \"frames\": " + to_string(frames) + ",\n";
+	json += "  \"renderer\": \"" + string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) + "\",\n";
+	snprintf(line, sizeof(line), "  \"batched\": {\"draws_per_frame\": %.1f, \"submit_ns_per_sprite\": %.3f, \"fence_waits\": %llu, ",
+		batched_draws, batched_ns, static_cast<unsigned long long>(batch_stats.fence_waits));
+	json += line + times_json(batched) + "},\n";
+	snprintf(line, sizeof(line), "  \"one_draw_per_sprite\": {\"sprites\": %zu, \"draws_per_frame\": %.1f, \"submit_ns_per_sprite\": %.3f, ",
+		unbatched_count, unbatched_draws, unbatched_ns);
+	json += line + times_json(unbatched) + "},\n";
+	json += "  \"draws_with_a_texture_per_image\": " + to_string(texture_switches + 1) + ",\n";
+	json += "  \"differing_pixels\": " + to_string(difference) + "\n";
+	json += "}\n";
+
+	if (!write_bench_json(options.bench_output_path, "sprite_bench.json", json, "Sprite benchmark")) {
+		return 1;
+	}
+	return difference == 0 ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "app_options.h"
+#include "gl_api.h"
+
+// options.sprite_bench_sprites moving sprites in 16 images drawn through the sprite batch every
+// frame, then a slice of them with one draw per sprite; checks both give the same image and writes
+// CPU and GPU times of both as JSON
+int run_sprite_benchmark(const app_options& options, GLFWwindow* window, int width, int height);
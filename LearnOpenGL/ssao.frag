@@ -0,0 +1,59 @@
+#version 330 core
+
+out vec4 color;
+
+// distance from the eye, from ssao_depth.frag
+uniform sampler2D linear_depth;
+uniform vec2 depth_range;
+// tangent of half the field of view, horizontal and vertical
+uniform vec2 tan_half_fov;
+// world distance the occluders are looked for within, and how dark they make it
+uniform float radius;
+uniform float strength;
+
+const int sample_count = 12;
+// in texels of this target, so close surfaces don't thrash the texture cache
+const float max_screen_radius = 32.0;
+
+vec3 view_position(ivec2 texel) {
+	vec2 size = vec2(textureSize(linear_depth, 0));
+	texel = clamp(texel, ivec2(0), ivec2(size) - 1);
+	float depth = texelFetch(linear_depth, texel, 0).r;
+	vec2 ndc = (vec2(texel) + 0.5) / size * 2.0 - 1.0;
+	return vec3(ndc * tan_half_fov * depth, -depth);
+}
+
+void main() {
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	vec3 position = view_position(texel);
+	float depth = -position.z;
+	float screen_radius = min(radius / (depth * tan_half_fov.y) * 0.5 * float(textureSize(linear_depth, 0).y),
+		max_screen_radius);
+	if (depth >= depth_range.y * 0.999 || screen_radius < 1.0) {
+		// sky, or too far for the samples to leave the texel
+		color = vec4(1.0);
+		return;
+	}
+
+	// the normal from the neighbours with the smaller depth step, so it doesn't bend around edges
+	vec3 right = view_position(texel + ivec2(1, 0)) - position;
+	vec3 left = position - view_position(texel - ivec2(1, 0));
+	vec3 up = view_position(texel + ivec2(0, 1)) - position;
+	vec3 down = position - view_position(texel - ivec2(0, 1));
+	vec3 normal = normalize(cross(abs(right.z) < abs(left.z) ? right : left, abs(up.z) < abs(down.z) ? up : down));
+
+	// a spiral of samples, turned per pixel by interleaved gradient noise; the bilateral upsample
+	// of the result smooths the noise out
+	float angle = 6.2831853 * fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+	float occlusion = 0.0;
+	for (int i = 0; i < sample_count; i++) {
+		float t = (float(i) + 0.5) / float(sample_count);
+		float sample_angle = angle + float(i) * 2.3999632;
+		vec2 offset = vec2(cos(sample_angle), sin(sample_angle)) * t * screen_radius;
+		vec3 to_sample = view_position(texel + ivec2(offset)) - position;
+		float distance_squared = dot(to_sample, to_sample);
+		float in_range = max(1.0 - distance_squared / (radius * radius), 0.0);
+		occlusion += max(dot(to_sample, normal) - 0.01 * depth, 0.0) / (distance_squared + 0.01) * in_range;
+	}
+	color = vec4(max(1.0 - 2.0 * strength * occlusion / float(sample_count), 0.0), 0.0, 0.0, 1.0);
+}
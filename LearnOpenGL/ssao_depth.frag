@@ -0,0 +1,19 @@
+#version 330 core
+
+out vec4 color;
+
+uniform sampler2D scene_depth;
+// near and far plane of the projection
+uniform vec2 depth_range;
+
+void main() {
+	// the nearest of the 2x2 full resolution depths, as distance from the eye
+	ivec2 texel = ivec2(gl_FragCoord.xy) * 2;
+	ivec2 limit = textureSize(scene_depth, 0) - 1;
+	float depth = 1.0;
+	for (int i = 0; i < 4; i++) {
+		depth = min(depth, texelFetch(scene_depth, min(texel + ivec2(i & 1, i >> 1), limit), 0).r);
+	}
+	float near_plane = depth_range.x, far_plane = depth_range.y;
+	color = vec4(near_plane * far_plane / (far_plane - depth * (far_plane - near_plane)), 0.0, 0.0, 1.0);
+}
@@ -0,0 +1,214 @@
+#include "startup_benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <Windows.h>
+
+#include "bench_stats.h"
+#include "log.h"
+
+using namespace std;
+
+using samples = map<string, vector<double>>;
+
+static string read_text(const string& path) {
+	ifstream file(path, ios::in | ios::binary);
+	stringstream text;
+	text << file.rdbuf();
+	return text.str();
+}
+
+static bool read_number(const string& text, const string& key, size_t from, double* value, size_t* end = nullptr) {
+	const size_t at = text.find("\"" + key + "\": ", from);
+	if (at == string::npos) {
+		return false;
+	}
+	const char* begin = text.c_str() + at + key.size() + 4;
+	char* stop = nullptr;
+	*value = strtod(begin, &stop);
+	if (end != nullptr) {
+		*end = stop - text.c_str();
+	}
+	return stop != begin;
+}
+
+// the report is written by startup_report_json(), so a flat scan is enough;
+// zones opened more than once (read_file, create_shader) are summed up
+static bool parse_report(const string& text, samples& out) {
+	double value = 0.0;
+	for (const char* key : { "pre_main_ms", "main_to_first_frame_ms", "total_ms" }) {
+		if (!read_number(text, key, 0, &value)) {
+			return false;
+		}
+		out[key].push_back(value);
+	}
+
+	const size_t notes_begin = text.find("\"notes\": {");
+	const size_t notes_end = text.find('}', notes_begin);
+	size_t at = notes_begin + 10;
+	while ((at = text.find('"', at)) != string::npos && at < notes_end) {
+		const size_t key_end = text.find('"', at + 1);
+		const string key = text.substr(at + 1, key_end - at - 1);
+		if (!read_number(text, key, at, &value, &at)) {
+			return false;
+		}
+		out["note." + key].push_back(value);
+	}
+
+	map<string, double> phases;
+	at = text.find("\"phases\"");
+	while ((at = text.find("{\"name\": \"", at)) != string::npos) {
+		at += 10;
+		const size_t name_end = text.find('"', at);
+		const string name = text.substr(at, name_end - at);
+		if (!read_number(text, "duration_ms", name_end, &value, &at)) {
+			return false;
+		}
+		phases[name] += value;
+	}
+	for (const auto& phase : phases) {
+		out["phase." + phase.first].push_back(phase.second);
+	}
+	return true;
+}
+
+static bool enable_privilege(const char* name) {
+	HANDLE token = nullptr;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+		return false;
+	}
+	TOKEN_PRIVILEGES privileges = {};
+	privileges.PrivilegeCount = 1;
+	privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+	const bool ok = LookupPrivilegeValueA(nullptr, name, &privileges.Privileges[0].Luid)
+		&& AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+		&& GetLastError() == ERROR_SUCCESS;
+	CloseHandle(token);
+	return ok;
+}
+
+// drops the file cache (standby list) so the next launch has to hit the disk for the
+// executable, the DLLs and the shaders; needs an elevated prompt
+static bool purge_file_cache() {
+	typedef LONG (WINAPI *set_system_information)(INT, PVOID, ULONG);
+	static const auto nt_set_system_information = reinterpret_cast<set_system_information>(
+		GetProcAddress(GetModuleHandleA("ntdll.dll"), "NtSetSystemInformation"));
+
+	if (nt_set_system_information == nullptr || !enable_privilege(SE_PROF_SINGLE_PROCESS_NAME)) {
+		return false;
+	}
+
+	const INT system_memory_list_information = 80;
+	INT flush_modified_list = 3;
+	INT purge_standby_list = 4;
+	nt_set_system_information(system_memory_list_information, &flush_modified_list, sizeof(INT));
+	return nt_set_system_information(system_memory_list_information, &purge_standby_list, sizeof(INT)) >= 0;
+}
+
+static bool launch(const string& executable, const string& report_path, const char* arguments, double* wall_ms) {
+	string command_line = "\"" + executable + "\" --exit-after-first-frame --startup-report=\"" + report_path + "\" "
+		+ arguments;
+
+	STARTUPINFOA startup_info = {};
+	startup_info.cb = sizeof(startup_info);
+	PROCESS_INFORMATION process = {};
+
+	const bench_clock::time_point start = bench_clock::now();
+	if (!CreateProcessA(nullptr, &command_line[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup_info, &process)) {
+		return false;
+	}
+	WaitForSingleObject(process.hProcess, INFINITE);
+	*wall_ms = elapsed_ms(start);
+
+	DWORD exit_code = 1;
+	GetExitCodeProcess(process.hProcess, &exit_code);
+	CloseHandle(process.hThread);
+	CloseHandle(process.hProcess);
+	return exit_code == 0;
+}
+
+static string series_json(const char* mode, const int runs, const bool cache_purged, const samples& results) {
+	string json = string("  \"") + mode + "\": {\n";
+	json += "    \"runs\": " + to_string(runs) + ",\n";
+	json += string("    \"cache_purged\": ") + (cache_purged ? "true" : "false") + ",\n";
+
+	size_t index = 0;
+	for (const auto& series : results) {
+		json += "    \"" + series.first + "\": " + stats_json(compute_stats(series.second));
+		json += ++index < results.size() ? ",\n" : "\n";
+	}
+	json += "  }";
+	return json;
+}
+
+static bool run_series(const string& executable, const string& report_path, const char* arguments, const int runs,
+	const bool cold, samples& results, bool* cache_purged) {
+	*cache_purged = cold;
+
+	for (int i = 0; i < runs; i++) {
+		if (cold && !purge_file_cache()) {
+			*cache_purged = false;
+		}
+
+		double wall_ms = 0.0;
+		if (!launch(executable, report_path, arguments, &wall_ms) || !parse_report(read_text(report_path), results)) {
+			log("Startup benchmark: run " + to_string(i) + " failed");
+			return false;
+		}
+		results["launch_to_exit_ms"].push_back(wall_ms);
+	}
+	return true;
+}
+
+int run_startup_benchmark(const app_options& options) {
+	char executable[MAX_PATH];
+	GetModuleFileNameA(nullptr, executable, MAX_PATH);
+
+	char temp_directory[MAX_PATH];
+	GetTempPathA(MAX_PATH, temp_directory);
+	const string report_path = string(temp_directory) + "learnopengl_startup_" + to_string(GetCurrentProcessId()) + ".json";
+
+	const int runs = options.startup_bench_runs;
+	string json = "{\n";
+
+	if (options.startup_bench_cold) {
+		samples cold;
+		bool cache_purged = false;
+		if (!run_series(executable, report_path, "", runs, true, cold, &cache_purged)) {
+			return -1;
+		}
+		if (!cache_purged) {
+			log("Startup benchmark: could not purge the file cache (run elevated), cold numbers are not cold");
+		}
+		json += series_json("cold", runs, cache_purged, cold) + ",\n";
+	}
+
+	// one untimed launch so the warm series starts with everything cached
+	samples warm;
+	bool unused = false;
+	if (!run_series(executable, report_path, "", 1, false, warm, &unused)) {
+		return -1;
+	}
+	warm.clear();
+	if (!run_series(executable, report_path, "", runs, false, warm, &unused)) {
+		return -1;
+	}
+	json += series_json("warm", runs, false, warm) + ",\n";
+
+	// the same warm launches with glewInit() timed after the loader, phase.glew_init next to
+	// phase.gl_loader_init; kept apart so GLEW's time doesn't count in the series above
+	samples glew;
+	if (!run_series(executable, report_path, "--glew-baseline", runs, false, glew, &unused)) {
+		return -1;
+	}
+	json += series_json("warm_glew_baseline", runs, false, glew) + "\n}\n";
+
+	DeleteFileA(report_path.c_str());
+
+	return write_bench_json(options.bench_output_path, "startup_bench.json", json, "Startup benchmark") ? 0 : -1;
+}
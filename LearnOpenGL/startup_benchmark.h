@@ -0,0 +1,8 @@
+#pragma once
+
+#include "app_options.h"
+
+// relaunches the executable options.startup_bench_runs times (cold and/or warm, then warm with the
+// GLEW baseline), collects each child's startup report and writes min/mean/median/p95/max per phase
+// as JSON
+int run_startup_benchmark(const app_options& options);
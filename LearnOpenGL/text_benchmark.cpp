@@ -0,0 +1,243 @@
+#include "text_benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bench_stats.h"
+#include "job_system.h"
+#include "log.h"
+#include "sdf_glyph.h"
+#include "sdf_text.h"
+#include "ttf_font.h"
+
+using namespace std;
+
+static const int warmup_frames = 3;
+static const int generate_runs = 3;
+static const int atlas_size = 1024;
+// small enough that drawing every glyph of the font has to evict, big enough for a frame's glyphs
+static const int churn_atlas_size = 256;
+static const int churn_frames = 60;
+static const int churn_glyphs_per_frame = 12;
+static const char* const default_font = "C:/Windows/Fonts/arial.ttf";
+static const char* const sample_text = "Quick brown foxes jump over the lazy dog; 0123456789 AVAWAY fi fl (TTF + SDF)";
+
+static void append_utf8(string& text, const uint32_t codepoint) {
+	if (codepoint < 0x80) {
+		text += static_cast<char>(codepoint);
+	}
+	else if (codepoint < 0x800) {
+		text += static_cast<char>(0xc0 | codepoint >> 6);
+		text += static_cast<char>(0x80 | (codepoint & 0x3f));
+	}
+	else {
+		text += static_cast<char>(0xe0 | codepoint >> 12);
+		text += static_cast<char>(0x80 | (codepoint >> 6 & 0x3f));
+		text += static_cast<char>(0x80 | (codepoint & 0x3f));
+	}
+}
+
+// the same lines every time, to compare the image a churned atlas gives with a fresh one's; few
+// enough glyphs to fit the small atlas
+static void draw_sample(const int width, const int height) {
+	glClear(GL_COLOR_BUFFER_BIT);
+	sdf_text_print(10.0f, 10.0f, 40.0f, 0xffffffff, "SDF text 0123", 0.0f);
+	sdf_text_print(10.0f, 70.0f, 16.0f, 0xff80ffff, "AVAWAY fi fl", 0.0f);
+	sdf_text_draw(width, height);
+}
+
+int run_text_benchmark(const app_options& options, GLFWwindow* window, const int width, const int height) {
+	const string font_path = options.font_path.empty() ? default_font : options.font_path;
+	const int frames = options.frame_limit > 0 ? options.frame_limit : 20;
+	ttf_font font;
+	if (!font.load(font_path)) {
+		return 1;
+	}
+
+	// every glyph with an outline
+	vector<sdf_glyph> glyphs;
+	for (uint32_t glyph = 0; glyph < font.glyph_count(); glyph++) {
+		const ttf_glyph_metrics& metrics = font.metrics(glyph);
+		if (metrics.x_max > metrics.x_min && metrics.y_max > metrics.y_min) {
+			glyphs.emplace_back();
+			glyphs.back().glyph = glyph;
+		}
+	}
+
+	const int hardware_threads = max(1, static_cast<int>(thread::hardware_concurrency()));
+	vector<int> thread_counts;
+	for (int threads = 1; threads < hardware_threads; threads *= 2) {
+		thread_counts.push_back(threads);
+	}
+	thread_counts.push_back(hardware_threads);
+
+	string json = "{\n";
+	json += "  \"font_glyphs\": " + to_string(font.glyph_count()) + ",\n";
+	json += "  \"outline_glyphs\": " + to_string(glyphs.size()) + ",\n";
+	json += "  \"renderer\": \"" + string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) + "\",\n";
+	json += "  \"generate\": [\n";
+	char line[256];
+	for (size_t run = 0; run < thread_counts.size(); run++) {
+		job_system_init(thread_counts[run]);
+		vector<double> generate_ms;
+		for (int repeat = 0; repeat < generate_runs; repeat++) {
+			const bench_clock::time_point start = bench_clock::now();
+			sdf_generate(font, glyphs.data(), glyphs.size());
+			generate_ms.push_back(elapsed_ms(start));
+		}
+		job_system_shutdown();
+		const bench_stats stats = compute_stats(generate_ms);
+		snprintf(line, sizeof(line), "SDF text: %zu glyphs generated on %2d threads in %.1f ms, %.0f glyphs/s",
+			glyphs.size(), thread_counts[run], stats.median, glyphs.size() / stats.median * 1000.0);
+		log(line);
+		snprintf(line, sizeof(line), "    {\"threads\": %d, \"glyphs_per_second\": %.0f, \"ms\": ", thread_counts[run],
+			glyphs.size() / stats.median * 1000.0);
+		json += line + stats_json(stats) + (run + 1 == thread_counts.size() ? "}\n" : "},\n");
+	}
+	json += "  ],\n";
+
+	job_system_init(0);
+	if (!sdf_text_init(font_path.c_str(), atlas_size)) {
+		job_system_shutdown();
+		log("Failed to set up the text benchmark");
+		return 1;
+	}
+	glClearColor(0.08f, 0.08f, 0.1f, 1.0f);
+	glViewport(0, 0, width, height);
+
+	// dense annotations filling the screen row by row, a wrapped paragraph and a big title on top
+	vector<string> labels;
+	vector<float> label_x, label_y;
+	size_t label_glyphs = 0;
+	const float label_size = 11.0f, label_height = 13.0f;
+	for (int index = 0; label_glyphs < static_cast<size_t>(options.text_bench_glyphs); index++) {
+		snprintf(line, sizeof(line), "node %d: %.1f ms", index, (index * 37 % 1000) / 10.0);
+		const float label_width = sdf_text_measure(label_size, line) + 6.0f;
+		const int columns = max(1, static_cast<int>(width / label_width));
+		const int cell = index % (columns * static_cast<int>(height / label_height));
+		labels.push_back(line);
+		label_x.push_back((cell % columns) * label_width);
+		label_y.push_back((cell / columns) * label_height);
+		for (const char* character = line; *character != '\0'; character++) {
+			label_glyphs += *character != ' ' ? 1 : 0;
+		}
+	}
+
+	GLuint query = 0;
+	glGenQueries(1, &query);
+	vector<double> layout_ms, draw_ms, gpu_ms, frame_ms;
+	double cold_frame_ms = 0.0;
+	uint64_t glyphs_per_frame = 0;
+	sdf_text_reset_stats();
+	for (int frame = 0; frame < warmup_frames + frames; frame++) {
+		glfwPollEvents();
+		glClear(GL_COLOR_BUFFER_BIT);
+		const uint64_t glyphs_before = sdf_text_get_stats().glyphs;
+		const bench_clock::time_point start = bench_clock::now();
+		for (size_t i = 0; i < labels.size(); i++) {
+			sdf_text_print(label_x[i], label_y[i], label_size, 0xffd0d0d0, labels[i].c_str(), 0.0f);
+		}
+		sdf_text_print(40.0f, 40.0f, 18.0f, 0xff80ffff, sample_text, 360.0f);
+		sdf_text_print(40.0f, height - 140.0f, 96.0f, 0xe0ffffff, "LearnOpenGL", 0.0f);
+		const double laid_out = elapsed_ms(start);
+
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		const bench_clock::time_point draw_start = bench_clock::now();
+		sdf_text_draw(width, height);
+		const double drawn = elapsed_ms(draw_start);
+		glEndQuery(GL_TIME_ELAPSED);
+		glFinish();
+		GLuint64 gpu_ns = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpu_ns);
+
+		if (frame == 0) {
+			cold_frame_ms = elapsed_ms(start);
+		}
+		if (frame >= warmup_frames) {
+			layout_ms.push_back(laid_out);
+			draw_ms.push_back(drawn);
+			gpu_ms.push_back(gpu_ns / 1e6);
+			frame_ms.push_back(elapsed_ms(start));
+		}
+		glyphs_per_frame = sdf_text_get_stats().glyphs - glyphs_before;
+		glfwSwapBuffers(window);
+	}
+	glDeleteQueries(1, &query);
+	const sdf_text_stats frame_stats = sdf_text_get_stats();
+	const double draws_per_frame = static_cast<double>(frame_stats.draws) / (warmup_frames + frames);
+
+	const bench_stats layout_stats = compute_stats(layout_ms);
+	const bench_stats draw_stats = compute_stats(draw_ms);
+	const bench_stats gpu_stats = compute_stats(gpu_ms);
+	snprintf(line, sizeof(line), "SDF text: %llu glyphs in %.0f draws per frame, first frame %.1f ms generating %llu glyphs",
+		static_cast<unsigned long long>(glyphs_per_frame), draws_per_frame, cold_frame_ms,
+		static_cast<unsigned long long>(frame_stats.generated));
+	log(line);
+	snprintf(line, sizeof(line), "SDF text: layout %.2f ms (%.1f M glyphs/s), draw %.2f ms CPU (%.1f M glyphs/s), %.2f ms GPU (%.1f M glyphs/s)",
+		layout_stats.median, glyphs_per_frame / layout_stats.median / 1000.0, draw_stats.median,
+		glyphs_per_frame / draw_stats.median / 1000.0, gpu_stats.median, glyphs_per_frame / max(gpu_stats.median, 1e-6) / 1000.0);
+	log(line);
+
+	json += "  \"glyphs_per_frame\": " + to_string(glyphs_per_frame) + ",\n";
+	snprintf(line, sizeof(line), "  \"draws_per_frame\": %.1f,\n  \"cold_frame_ms\": %.3f,\n", draws_per_frame, cold_frame_ms);
+	json += line;
+	json += "  \"layout_ms\": " + stats_json(layout_stats) + ",\n";
+	json += "  \"draw_cpu_ms\": " + stats_json(draw_stats) + ",\n";
+	json += "  \"draw_gpu_ms\": " + stats_json(gpu_stats) + ",\n";
+	json += "  \"frame_ms\": " + stats_json(compute_stats(frame_ms)) + ",\n";
+	snprintf(line, sizeof(line), "  \"layout_glyphs_per_second\": %.0f,\n  \"draw_cpu_glyphs_per_second\": %.0f,\n"
+		"  \"draw_gpu_glyphs_per_second\": %.0f,\n", glyphs_per_frame / layout_stats.median * 1000.0,
+		glyphs_per_frame / draw_stats.median * 1000.0, glyphs_per_frame / max(gpu_stats.median, 1e-6) * 1000.0);
+	json += line;
+
+	// the reference image from the big atlas, then every glyph the font maps pushed through a small
+	// one a window at a time, so the least recently used ones have to go
+	vector<uint8_t> reference, churned;
+	draw_sample(width, height);
+	read_pixels(reference, width, height);
+	sdf_text_release();
+	sdf_text_init(font_path.c_str(), churn_atlas_size);
+	vector<uint32_t> codepoints;
+	for (uint32_t codepoint = 0x21; codepoint < 0x10000; codepoint++) {
+		const ttf_glyph_metrics& metrics = font.metrics(font.glyph_index(codepoint));
+		if (font.glyph_index(codepoint) != 0 && metrics.x_max > metrics.x_min) {
+			codepoints.push_back(codepoint);
+		}
+	}
+	sdf_text_reset_stats();
+	for (int frame = 0; frame < churn_frames && !codepoints.empty(); frame++) {
+		glfwPollEvents();
+		string window_text;
+		for (int i = 0; i < churn_glyphs_per_frame; i++) {
+			append_utf8(window_text, codepoints[(frame * churn_glyphs_per_frame + i) % codepoints.size()]);
+		}
+		glClear(GL_COLOR_BUFFER_BIT);
+		sdf_text_print(10.0f, 10.0f, 24.0f, 0xffffffff, window_text.c_str(), width - 20.0f);
+		sdf_text_draw(width, height);
+		glfwSwapBuffers(window);
+	}
+	const sdf_text_stats churn_stats = sdf_text_get_stats();
+	draw_sample(width, height);
+	read_pixels(churned, width, height);
+	const int difference = differing_pixels(reference, churned);
+	sdf_text_release();
+	job_system_shutdown();
+
+	snprintf(line, sizeof(line), "SDF text: %d px atlas over %zu glyphs: %llu generated, %llu evicted, %llu dropped; %d pixels differ from the big atlas",
+		churn_atlas_size, codepoints.size(), static_cast<unsigned long long>(churn_stats.generated),
+		static_cast<unsigned long long>(churn_stats.evicted), static_cast<unsigned long long>(churn_stats.dropped), difference);
+	log(line);
+	snprintf(line, sizeof(line), "  \"churn\": {\"atlas_size\": %d, \"frames\": %d, \"generated\": %llu, \"evicted\": %llu, \"dropped\": %llu},\n",
+		churn_atlas_size, churn_frames, static_cast<unsigned long long>(churn_stats.generated),
+		static_cast<unsigned long long>(churn_stats.evicted), static_cast<unsigned long long>(churn_stats.dropped));
+	json += line;
+	json += "  \"differing_pixels\": " + to_string(difference) + "\n";
+	json += "}\n";
+
+	if (!write_bench_json(options.bench_output_path, "text_bench.json", json, "Text benchmark")) {
+		return 1;
+	}
+	return difference == 0 && frame_stats.dropped == 0 && churn_stats.dropped == 0 ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "app_options.h"
+#include "gl_api.h"
+
+// SDF text: glyph generation throughput on 1, 2, 4 ... threads, then frames of
+// options.text_bench_glyphs glyphs of dense labels timing layout, drawing on the CPU and on the GPU,
+// then a small atlas churned through every glyph of the font to exercise eviction; writes JSON
+int run_text_benchmark(const app_options& options, GLFWwindow* window, int width, int height);
@@ -0,0 +1,177 @@
+#include "text_overlay.h"
+
+#include <cctype>
+#include <vector>
+
+#include "gl_api.h"
+#include "log.h"
+#include "shader.h"
+
+using namespace std;
+
+struct glyph {
+	char character;
+	const char* rows[7];
+};
+
+static const glyph font[] = {
+	{ ' ', { "     ", "     ", "     ", "     ", "     ", "     ", "     " } },
+	{ '0', { " ### ", "#   #", "#  ##", "# # #", "##  #", "#   #", " ### " } },
+	{ '1', { "  #  ", " ##  ", "  #  ", "  #  ", "  #  ", "  #  ", " ### " } },
+	{ '2', { " ### ", "#   #", "    #", "   # ", "  #  ", " #   ", "#####" } },
+	{ '3', { "#####", "   # ", "  #  ", "   # ", "    #", "#   #", " ### " } },
+	{ '4', { "   # ", "  ## ", " # # ", "#  # ", "#####", "   # ", "   # " } },
+	{ '5', { "#####", "#    ", "#### ", "    #", "    #", "#   #", " ### " } },
+	{ '6', { "  ## ", " #   ", "#    ", "#### ", "#   #", "#   #", " ### " } },
+	{ '7', { "#####", "    #", "   # ", "  #  ", " #   ", " #   ", " #   " } },
+	{ '8', { " ### ", "#   #", "#   #", " ### ", "#   #", "#   #", " ### " } },
+	{ '9', { " ### ", "#   #", "#   #", " ####", "    #", "   # ", " ##  " } },
+	{ 'A', { " ### ", "#   #", "#   #", "#####", "#   #", "#   #", "#   #" } },
+	{ 'B', { "#### ", "#   #", "#   #", "#### ", "#   #", "#   #", "#### " } },
+	{ 'C', { " ### ", "#   #", "#    ", "#    ", "#    ", "#   #", " ### " } },
+	{ 'D', { "#### ", "#   #", "#   #", "#   #", "#   #", "#   #", "#### " } },
+	{ 'E', { "#####", "#    ", "#    ", "#### ", "#    ", "#    ", "#####" } },
+	{ 'F', { "#####", "#    ", "#    ", "#### ", "#    ", "#    ", "#    " } },
+	{ 'G', { " ### ", "#   #", "#    ", "# ###", "#   #", "#   #", " ####" } },
+	{ 'H', { "#   #", "#   #", "#   #", "#####", "#   #", "#   #", "#   #" } },
+	{ 'I', { " ### ", "  #  ", "  #  ", "  #  ", "  #  ", "  #  ", " ### " } },
+	{ 'J', { "  ###", "   # ", "   # ", "   # ", "   # ", "#  # ", " ##  " } },
+	{ 'K', { "#   #", "#  # ", "# #  ", "##   ", "# #  ", "#  # ", "#   #" } },
+	{ 'L', { "#    ", "#    ", "#    ", "#    ", "#    ", "#    ", "#####" } },
+	{ 'M', { "#   #", "## ##", "# # #", "# # #", "#   #", "#   #", "#   #" } },
+	{ 'N', { "#   #", "#   #", "##  #", "# # #", "#  ##", "#   #", "#   #" } },
+	{ 'O', { " ### ", "#   #", "#   #", "#   #", "#   #", "#   #", " ### " } },
+	{ 'P', { "#### ", "#   #", "#   #", "#### ", "#    ", "#    ", "#    " } },
+	{ 'Q', { " ### ", "#   #", "#   #", "#   #", "# # #", "#  # ", " ## #" } },
+	{ 'R', { "#### ", "#   #", "#   #", "#### ", "# #  ", "#  # ", "#   #" } },
+	{ 'S', { " ####", "#    ", "#    ", " ### ", "    #", "    #", "#### " } },
+	{ 'T', { "#####", "  #  ", "  #  ", "  #  ", "  #  ", "  #  ", "  #  " } },
+	{ 'U', { "#   #", "#   #", "#   #", "#   #", "#   #", "#   #", " ### " } },
+	{ 'V', { "#   #", "#   #", "#   #", "#   #", "#   #", " # # ", "  #  " } },
+	{ 'W', { "#   #", "#   #", "#   #", "# # #", "# # #", "# # #", " # # " } },
+	{ 'X', { "#   #", "#   #", " # # ", "  #  ", " # # ", "#   #", "#   #" } },
+	{ 'Y', { "#   #", "#   #", " # # ", "  #  ", "  #  ", "  #  ", "  #  " } },
+	{ 'Z', { "#####", "    #", "   # ", "  #  ", " #   ", "#    ", "#####" } },
+	{ ':', { "     ", " ##  ", " ##  ", "     ", " ##  ", " ##  ", "     " } },
+	{ '.', { "     ", "     ", "     ", "     ", "     ", " ##  ", " ##  " } },
+	{ ',', { "     ", "     ", "     ", "     ", " ##  ", "  #  ", " #   " } },
+	{ '-', { "     ", "     ", "     ", "#####", "     ", "     ", "     " } },
+	{ '+', { "     ", "  #  ", "  #  ", "#####", "  #  ", "  #  ", "     " } },
+	{ '=', { "     ", "     ", "#####", "     ", "#####", "     ", "     " } },
+	{ '/', { "     ", "    #", "   # ", "  #  ", " #   ", "#    ", "     " } },
+	{ '%', { "##   ", "##  #", "   # ", "  #  ", " #   ", "#  ##", "   ##" } },
+	{ '(', { "   # ", "  #  ", " #   ", " #   ", " #   ", "  #  ", "   # " } },
+	{ ')', { " #   ", "  #  ", "   # ", "   # ", "   # ", "  #  ", " #   " } },
+	{ '_', { "     ", "     ", "     ", "     ", "     ", "     ", "#####" } },
+};
+
+// a glyph cell is the 5x7 glyph plus one pixel of spacing right and below
+const int cell_width = 6;
+const int cell_height = 8;
+const int glyph_count = sizeof(font) / sizeof(font[0]);
+const int pixel_scale = 2;
+
+static GLuint program = 0;
+static GLuint vao = 0;
+static GLuint vbo = 0;
+static GLuint texture = 0;
+static GLint screen_size_location = -1;
+static int glyph_index[128];
+static vector<GLfloat> vertices;
+
+bool text_overlay_init() {
+	program = load_program("overlay.vert", "overlay.frag");
+	if (program == 0) {
+		return false;
+	}
+	screen_size_location = glGetUniformLocation(program, "screen_size");
+
+	// atlas: all glyphs side by side in one row of cells
+	const int atlas_width = glyph_count * cell_width;
+	vector<unsigned char> atlas(atlas_width * cell_height, 0);
+	for (int& index : glyph_index) {
+		index = 0;
+	}
+	for (int i = 0; i < glyph_count; i++) {
+		glyph_index[static_cast<int>(font[i].character)] = i;
+		for (int y = 0; y < 7; y++) {
+			for (int x = 0; x < 5; x++) {
+				atlas[y * atlas_width + i * cell_width + x] = font[i].rows[y][x] == '#' ? 255 : 0;
+			}
+		}
+	}
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas_width, cell_height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &vbo);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), static_cast<GLvoid*>(nullptr));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), reinterpret_cast<GLvoid*>(2 * sizeof(GLfloat)));
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+
+	return true;
+}
+
+void text_overlay_print(const int column, const int row, const char* text) {
+	const float atlas_width = static_cast<float>(glyph_count * cell_width);
+	const float width = cell_width * pixel_scale;
+	const float height = cell_height * pixel_scale;
+
+	for (size_t i = 0; text[i] != '\0'; i++) {
+		const int character = toupper(static_cast<unsigned char>(text[i]));
+		const int index = character < 128 ? glyph_index[character] : 0;
+
+		const float x0 = (column + i) * width, y0 = row * height;
+		const float x1 = x0 + width, y1 = y0 + height;
+		const float u0 = index * cell_width / atlas_width, u1 = (index + 1) * cell_width / atlas_width;
+
+		const GLfloat quad[] = {
+			x0, y0, u0, 0.0f,   x1, y0, u1, 0.0f,   x1, y1, u1, 1.0f,
+			x0, y0, u0, 0.0f,   x1, y1, u1, 1.0f,   x0, y1, u0, 1.0f
+		};
+		vertices.insert(vertices.end(), quad, quad + 24);
+	}
+}
+
+void text_overlay_draw(const int width, const int height) {
+	if (vertices.empty() || program == 0) {
+		vertices.clear();
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STREAM_DRAW);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glUseProgram(program);
+	glUniform2f(screen_size_location, static_cast<GLfloat>(width), static_cast<GLfloat>(height));
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glBindVertexArray(vao);
+	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size() / 4));
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_BLEND);
+
+	vertices.clear();
+}
+
+damage_rect text_overlay_cells_rect(const int column, const int row, const int columns, const int rows,
+	const int screen_height) {
+	damage_rect rect;
+	rect.x = column * cell_width * pixel_scale;
+	rect.width = columns * cell_width * pixel_scale;
+	rect.height = rows * cell_height * pixel_scale;
+	rect.y = screen_height - row * cell_height * pixel_scale - rect.height;
+	return rect;
+}
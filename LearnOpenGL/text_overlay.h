@@ -0,0 +1,12 @@
+#pragma once
+
+#include "damage.h"
+
+// debug text drawn with a built-in 5x7 font; letters are shown in upper case
+bool text_overlay_init();
+// column/row in character cells from the top left corner
+void text_overlay_print(int column, int row, const char* text);
+// draws everything printed since the last call in one draw call
+void text_overlay_draw(int width, int height);
+// pixels covered by a block of cells on a screen this tall, bottom left origin like glScissor
+damage_rect text_overlay_cells_rect(int column, int row, int columns, int rows, int screen_height);
@@ -0,0 +1,482 @@
+#include "ttf_font.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "log.h"
+
+using namespace std;
+
+// composite glyphs nest at most this deep
+static const int max_composite_depth = 8;
+
+// simple glyph point flags
+static const uint8_t on_curve = 0x01;
+static const uint8_t x_short = 0x02;
+static const uint8_t y_short = 0x04;
+static const uint8_t repeat_flag = 0x08;
+static const uint8_t x_same_or_positive = 0x10;
+static const uint8_t y_same_or_positive = 0x20;
+
+// composite glyph component flags
+static const uint16_t args_are_words = 0x0001;
+static const uint16_t args_are_offsets = 0x0002;
+static const uint16_t have_scale = 0x0008;
+static const uint16_t more_components = 0x0020;
+static const uint16_t have_xy_scale = 0x0040;
+static const uint16_t have_two_by_two = 0x0080;
+
+static uint16_t read_u16(const uint8_t* bytes) {
+	return static_cast<uint16_t>(bytes[0] << 8 | bytes[1]);
+}
+
+static int16_t read_i16(const uint8_t* bytes) {
+	return static_cast<int16_t>(read_u16(bytes));
+}
+
+static uint32_t read_u32(const uint8_t* bytes) {
+	return static_cast<uint32_t>(bytes[0]) << 24 | static_cast<uint32_t>(bytes[1]) << 16 | bytes[2] << 8 | bytes[3];
+}
+
+static float read_f2dot14(const uint8_t* bytes) {
+	return read_i16(bytes) / 16384.0f;
+}
+
+static uint32_t table_tag(const char* name) {
+	return static_cast<uint32_t>(name[0]) << 24 | name[1] << 16 | name[2] << 8 | name[3];
+}
+
+// x' = a x + c y + e, y' = b x + d y + f as { a, b, c, d, e, f }
+static void transform_point(const float* transform, const float x, const float y, float* out_x, float* out_y) {
+	*out_x = transform[0] * x + transform[2] * y + transform[4];
+	*out_y = transform[1] * x + transform[3] * y + transform[5];
+}
+
+// contour points to curves, off-curve points in a row have an on-curve point implied halfway
+static void add_contour(const float* xs, const float* ys, const uint8_t* flags, const int first, const int last,
+	const float* transform, vector<ttf_curve>& curves) {
+	const int count = last - first + 1;
+	if (count < 2) {
+		return;
+	}
+	int start = -1;
+	for (int i = first; i <= last && start < 0; i++) {
+		start = flags[i] & on_curve ? i : -1;
+	}
+
+	float start_x, start_y;
+	int walked;
+	if (start >= 0) {
+		start_x = xs[start];
+		start_y = ys[start];
+		walked = 1;
+	}
+	else {
+		// nothing on the curve at all: start halfway between the last point and the first
+		start = first;
+		start_x = (xs[last] + xs[first]) * 0.5f;
+		start_y = (ys[last] + ys[first]) * 0.5f;
+		walked = 0;
+	}
+
+	float x = start_x, y = start_y;
+	float control_x = 0.0f, control_y = 0.0f;
+	bool has_control = false;
+	const auto emit = [&](const float cx, const float cy, const float to_x, const float to_y) {
+		ttf_curve curve;
+		transform_point(transform, x, y, &curve.x0, &curve.y0);
+		transform_point(transform, cx, cy, &curve.cx, &curve.cy);
+		transform_point(transform, to_x, to_y, &curve.x1, &curve.y1);
+		curves.push_back(curve);
+		x = to_x;
+		y = to_y;
+	};
+	for (; walked <= count; walked++) {
+		// past the last point the contour closes back at its start
+		const bool closing = walked == count;
+		const int index = first + (start - first + walked) % count;
+		const float next_x = closing ? start_x : xs[index];
+		const float next_y = closing ? start_y : ys[index];
+		if (closing || flags[index] & on_curve) {
+			if (has_control) {
+				emit(control_x, control_y, next_x, next_y);
+			}
+			else {
+				emit((x + next_x) * 0.5f, (y + next_y) * 0.5f, next_x, next_y);
+			}
+			has_control = false;
+		}
+		else {
+			if (has_control) {
+				emit(control_x, control_y, (control_x + next_x) * 0.5f, (control_y + next_y) * 0.5f);
+			}
+			control_x = next_x;
+			control_y = next_y;
+			has_control = true;
+		}
+	}
+}
+
+bool ttf_font::load(const string& path) {
+	ifstream file(path, ios::binary);
+	if (!file) {
+		log("Failed to open font " + path);
+		return false;
+	}
+	data.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	const size_t size = data.size();
+	// 0x00010000 or 'true' for TrueType outlines, 'OTTO' has CFF ones
+	if (size < 12 || (read_u32(&data[0]) != 0x00010000 && read_u32(&data[0]) != table_tag("true"))) {
+		log(path + " is not a TrueType font");
+		return false;
+	}
+
+	uint32_t head = 0, maxp = 0, hhea = 0, hmtx = 0, cmap = 0, kern = 0;
+	uint32_t head_length = 0, maxp_length = 0, hhea_length = 0, hmtx_length = 0, loca_length = 0, kern_length = 0;
+	loca = glyf = 0;
+	const uint16_t table_count = read_u16(&data[4]);
+	for (uint16_t i = 0; i < table_count && 12 + (i + 1) * 16u <= size; i++) {
+		const uint8_t* record = &data[12 + i * 16];
+		const uint32_t tag = read_u32(record);
+		const uint32_t offset = read_u32(record + 8);
+		const uint32_t length = read_u32(record + 12);
+		if (offset > size || length > size - offset) {
+			continue;
+		}
+		if (tag == table_tag("head")) { head = offset; head_length = length; }
+		else if (tag == table_tag("maxp")) { maxp = offset; maxp_length = length; }
+		else if (tag == table_tag("hhea")) { hhea = offset; hhea_length = length; }
+		else if (tag == table_tag("hmtx")) { hmtx = offset; hmtx_length = length; }
+		else if (tag == table_tag("loca")) { loca = offset; loca_length = length; }
+		else if (tag == table_tag("glyf")) { glyf = offset; }
+		else if (tag == table_tag("cmap")) { cmap = offset; }
+		else if (tag == table_tag("kern")) { kern = offset; kern_length = length; }
+	}
+	if (head == 0 || head_length < 54 || maxp == 0 || maxp_length < 6 || hhea == 0 || hhea_length < 36
+		|| hmtx == 0 || loca == 0 || glyf == 0 || cmap == 0) {
+		log(path + " lacks a table needed for TrueType outlines");
+		return false;
+	}
+
+	em_units = read_u16(&data[head + 18]);
+	long_offsets = read_i16(&data[head + 50]) != 0;
+	const uint32_t count = read_u16(&data[maxp + 4]);
+	ascender = read_i16(&data[hhea + 4]);
+	descender = read_i16(&data[hhea + 6]);
+	gap = read_i16(&data[hhea + 8]);
+	const uint32_t horizontal_metrics = read_u16(&data[hhea + 34]);
+	if (em_units == 0 || horizontal_metrics == 0 || horizontal_metrics * 4 > hmtx_length
+		|| (count + 1) * (long_offsets ? 4 : 2) > loca_length) {
+		log(path + " has malformed tables");
+		return false;
+	}
+
+	glyph_metrics.assign(count, ttf_glyph_metrics());
+	for (uint32_t glyph = 0; glyph < count; glyph++) {
+		ttf_glyph_metrics& metrics = glyph_metrics[glyph];
+		// glyphs past the last full entry keep its advance
+		metrics.advance = read_u16(&data[hmtx + min(glyph, horizontal_metrics - 1) * 4]);
+		uint32_t length = 0;
+		const uint32_t offset = glyph_offset(glyph, &length);
+		if (length >= 10) {
+			metrics.x_min = read_i16(&data[offset + 2]);
+			metrics.y_min = read_i16(&data[offset + 4]);
+			metrics.x_max = read_i16(&data[offset + 6]);
+			metrics.y_max = read_i16(&data[offset + 8]);
+		}
+	}
+	read_cmap(cmap);
+	kern_pairs.clear();
+	if (kern != 0) {
+		read_kern(kern, kern_length);
+	}
+	return true;
+}
+
+uint32_t ttf_font::glyph_offset(const uint32_t glyph, uint32_t* length) const {
+	const uint32_t start = long_offsets ? read_u32(&data[loca + glyph * 4]) : read_u16(&data[loca + glyph * 2]) * 2u;
+	const uint32_t end = long_offsets ? read_u32(&data[loca + glyph * 4 + 4]) : read_u16(&data[loca + glyph * 2 + 2]) * 2u;
+	if (end <= start || glyf + static_cast<size_t>(end) > data.size()) {
+		*length = 0;
+		return 0;
+	}
+	*length = end - start;
+	return glyf + start;
+}
+
+void ttf_font::read_cmap(const uint32_t offset) {
+	bmp_glyphs.assign(0x10000, 0);
+	groups.clear();
+	const size_t size = data.size();
+	if (offset + 4 > size) {
+		return;
+	}
+
+	uint32_t format4 = 0, format12 = 0;
+	const uint16_t count = read_u16(&data[offset + 2]);
+	for (uint16_t i = 0; i < count && offset + 4 + (i + 1) * 8u <= size; i++) {
+		const uint8_t* record = &data[offset + 4 + i * 8];
+		const uint16_t platform = read_u16(record);
+		const uint16_t encoding = read_u16(record + 2);
+		const uint32_t subtable = offset + read_u32(record + 4);
+		// unicode, or windows with the basic (1) or the full (10) unicode repertoire
+		if (subtable + 4 > size || !(platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10)))) {
+			continue;
+		}
+		const uint16_t format = read_u16(&data[subtable]);
+		if (format == 4 && format4 == 0) {
+			format4 = subtable;
+		}
+		else if (format == 12 && format12 == 0) {
+			format12 = subtable;
+		}
+	}
+
+	const uint32_t count_glyphs = glyph_count();
+	if (format12 != 0 && format12 + 16 <= size) {
+		const uint32_t group_count = read_u32(&data[format12 + 12]);
+		for (uint32_t i = 0; i < group_count && format12 + 16 + (i + 1) * 12 <= size; i++) {
+			const uint8_t* group = &data[format12 + 16 + i * 12];
+			const cmap_group mapped = { read_u32(group), read_u32(group + 4), read_u32(group + 8) };
+			if (mapped.last < mapped.first) {
+				continue;
+			}
+			groups.push_back(mapped);
+			for (uint32_t codepoint = mapped.first; codepoint <= mapped.last && codepoint < 0x10000; codepoint++) {
+				const uint32_t glyph = mapped.glyph + codepoint - mapped.first;
+				bmp_glyphs[codepoint] = static_cast<uint16_t>(glyph < count_glyphs ? glyph : 0);
+			}
+		}
+		sort(groups.begin(), groups.end(), [](const cmap_group& a, const cmap_group& b) { return a.first < b.first; });
+	}
+	else if (format4 != 0 && format4 + 14 <= size) {
+		const uint32_t segments = read_u16(&data[format4 + 6]) / 2;
+		const uint32_t ends = format4 + 14;
+		const uint32_t starts = ends + segments * 2 + 2;
+		const uint32_t deltas = starts + segments * 2;
+		const uint32_t range_offsets = deltas + segments * 2;
+		if (range_offsets + segments * 2 > size) {
+			return;
+		}
+		for (uint32_t segment = 0; segment < segments; segment++) {
+			const uint32_t last = read_u16(&data[ends + segment * 2]);
+			const uint32_t first = read_u16(&data[starts + segment * 2]);
+			const uint16_t delta = read_u16(&data[deltas + segment * 2]);
+			const uint16_t range_offset = read_u16(&data[range_offsets + segment * 2]);
+			for (uint32_t codepoint = first; codepoint <= last && codepoint < 0x10000; codepoint++) {
+				uint32_t glyph = 0;
+				if (range_offset == 0) {
+					glyph = (codepoint + delta) & 0xffff;
+				}
+				else {
+					// the offset is relative to where it is stored
+					const uint32_t address = range_offsets + segment * 2 + range_offset + (codepoint - first) * 2;
+					if (address + 2 > size) {
+						break;
+					}
+					glyph = read_u16(&data[address]);
+					glyph = glyph != 0 ? (glyph + delta) & 0xffff : 0;
+				}
+				bmp_glyphs[codepoint] = static_cast<uint16_t>(glyph < count_glyphs ? glyph : 0);
+			}
+		}
+	}
+}
+
+void ttf_font::read_kern(const uint32_t offset, const uint32_t length) {
+	const uint32_t end = offset + length;
+	// version 0 as in Windows fonts, Apple's version 1 isn't read
+	if (length < 4 || read_u16(&data[offset]) != 0) {
+		return;
+	}
+	const uint16_t tables = read_u16(&data[offset + 2]);
+	uint32_t subtable = offset + 4;
+	for (uint16_t table = 0; table < tables && subtable + 6 <= end; table++) {
+		const uint16_t subtable_length = read_u16(&data[subtable + 2]);
+		const uint16_t coverage = read_u16(&data[subtable + 4]);
+		// format 0 pairs of horizontal kerning values, not minimums and not cross stream
+		if (coverage >> 8 == 0 && (coverage & 0x7) == 1 && subtable + 14 <= end) {
+			const uint16_t pairs = read_u16(&data[subtable + 6]);
+			for (uint32_t pair = 0; pair < pairs && subtable + 14 + (pair + 1) * 6 <= end; pair++) {
+				const uint8_t* entry = &data[subtable + 14 + pair * 6];
+				const kern_pair kerned = { static_cast<uint32_t>(read_u16(entry)) << 16 | read_u16(entry + 2), read_i16(entry + 4) };
+				kern_pairs.push_back(kerned);
+			}
+		}
+		if (subtable_length == 0) {
+			break;
+		}
+		subtable += subtable_length;
+	}
+	sort(kern_pairs.begin(), kern_pairs.end(), [](const kern_pair& a, const kern_pair& b) { return a.glyphs < b.glyphs; });
+}
+
+uint32_t ttf_font::glyph_index(const uint32_t codepoint) const {
+	if (codepoint < 0x10000) {
+		return bmp_glyphs.empty() ? 0 : bmp_glyphs[codepoint];
+	}
+	const auto group = upper_bound(groups.begin(), groups.end(), codepoint,
+		[](const uint32_t value, const cmap_group& mapped) { return value < mapped.first; });
+	if (group == groups.begin() || codepoint > (group - 1)->last) {
+		return 0;
+	}
+	const uint32_t glyph = (group - 1)->glyph + codepoint - (group - 1)->first;
+	return glyph < glyph_count() ? glyph : 0;
+}
+
+const ttf_glyph_metrics& ttf_font::metrics(const uint32_t glyph) const {
+	return glyph_metrics[glyph < glyph_metrics.size() ? glyph : 0];
+}
+
+int ttf_font::kerning(const uint32_t left, const uint32_t right) const {
+	if (kern_pairs.empty()) {
+		return 0;
+	}
+	const uint32_t glyphs = left << 16 | right;
+	const auto found = lower_bound(kern_pairs.begin(), kern_pairs.end(), glyphs,
+		[](const kern_pair& pair, const uint32_t value) { return pair.glyphs < value; });
+	return found != kern_pairs.end() && found->glyphs == glyphs ? found->value : 0;
+}
+
+void ttf_font::outline(const uint32_t glyph, vector<ttf_curve>& curves) const {
+	static const float identity[6] = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+	append_outline(glyph, identity, 0, curves);
+}
+
+void ttf_font::append_outline(const uint32_t glyph, const float* transform, const int depth, vector<ttf_curve>& curves) const {
+	if (glyph >= glyph_count() || depth > max_composite_depth) {
+		return;
+	}
+	uint32_t length = 0;
+	const uint32_t offset = glyph_offset(glyph, &length);
+	if (length < 10) {
+		return;
+	}
+	const uint8_t* bytes = &data[offset];
+	const uint8_t* end = bytes + length;
+	const int contours = read_i16(bytes);
+
+	if (contours < 0) {
+		// composite: other glyphs, each moved, scaled or both
+		const uint8_t* component = bytes + 10;
+		uint16_t flags = 0;
+		do {
+			if (component + 4 > end) {
+				return;
+			}
+			flags = read_u16(component);
+			const uint16_t index = read_u16(component + 2);
+			component += 4;
+			const int arguments = flags & args_are_words ? 4 : 2;
+			const int scale_bytes = flags & have_scale ? 2 : flags & have_xy_scale ? 4 : flags & have_two_by_two ? 8 : 0;
+			if (component + arguments + scale_bytes > end) {
+				return;
+			}
+			float dx = flags & args_are_words ? read_i16(component) : static_cast<int8_t>(component[0]);
+			float dy = flags & args_are_words ? read_i16(component + 2) : static_cast<int8_t>(component[1]);
+			component += arguments;
+			// matching points instead of offsets isn't supported, such components stay where they are
+			if (!(flags & args_are_offsets)) {
+				dx = dy = 0.0f;
+			}
+			float a = 1.0f, b = 0.0f, c = 0.0f, d = 1.0f;
+			if (flags & have_scale) {
+				a = d = read_f2dot14(component);
+			}
+			else if (flags & have_xy_scale) {
+				a = read_f2dot14(component);
+				d = read_f2dot14(component + 2);
+			}
+			else if (flags & have_two_by_two) {
+				a = read_f2dot14(component);
+				b = read_f2dot14(component + 2);
+				c = read_f2dot14(component + 4);
+				d = read_f2dot14(component + 6);
+			}
+			component += scale_bytes;
+
+			// the component's transform, then the parent's
+			const float combined[6] = {
+				transform[0] * a + transform[2] * b, transform[1] * a + transform[3] * b,
+				transform[0] * c + transform[2] * d, transform[1] * c + transform[3] * d,
+				transform[0] * dx + transform[2] * dy + transform[4], transform[1] * dx + transform[3] * dy + transform[5]
+			};
+			append_outline(index, combined, depth + 1, curves);
+		} while (flags & more_components);
+		return;
+	}
+
+	const uint8_t* contour_ends = bytes + 10;
+	if (contour_ends + contours * 2 + 2 > end) {
+		return;
+	}
+	const int point_count = contours > 0 ? read_u16(contour_ends + (contours - 1) * 2) + 1 : 0;
+	const uint8_t* cursor = contour_ends + contours * 2 + 2 + read_u16(contour_ends + contours * 2);
+
+	// flags, then every x, then every y, each coordinate a delta from the previous point
+	vector<uint8_t> flags(point_count);
+	vector<float> xs(point_count), ys(point_count);
+	for (int point = 0; point < point_count;) {
+		if (cursor >= end) {
+			return;
+		}
+		const uint8_t flag = *cursor++;
+		int repeats = 0;
+		if (flag & repeat_flag) {
+			if (cursor >= end) {
+				return;
+			}
+			repeats = *cursor++;
+		}
+		for (int i = 0; i <= repeats && point < point_count; i++) {
+			flags[point++] = flag;
+		}
+	}
+	float coordinate = 0.0f;
+	for (int point = 0; point < point_count; point++) {
+		if (flags[point] & x_short) {
+			if (cursor >= end) {
+				return;
+			}
+			coordinate += flags[point] & x_same_or_positive ? *cursor : -*cursor;
+			cursor++;
+		}
+		else if (!(flags[point] & x_same_or_positive)) {
+			if (cursor + 2 > end) {
+				return;
+			}
+			coordinate += read_i16(cursor);
+			cursor += 2;
+		}
+		xs[point] = coordinate;
+	}
+	coordinate = 0.0f;
+	for (int point = 0; point < point_count; point++) {
+		if (flags[point] & y_short) {
+			if (cursor >= end) {
+				return;
+			}
+			coordinate += flags[point] & y_same_or_positive ? *cursor : -*cursor;
+			cursor++;
+		}
+		else if (!(flags[point] & y_same_or_positive)) {
+			if (cursor + 2 > end) {
+				return;
+			}
+			coordinate += read_i16(cursor);
+			cursor += 2;
+		}
+		ys[point] = coordinate;
+	}
+
+	int first = 0;
+	for (int contour = 0; contour < contours; contour++) {
+		const int last = read_u16(contour_ends + contour * 2);
+		if (last < first || last >= point_count) {
+			return;
+		}
+		add_contour(xs.data(), ys.data(), flags.data(), first, last, transform, curves);
+		first = last + 1;
+	}
+}
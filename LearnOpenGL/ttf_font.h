@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// TrueType fonts with glyf outlines: character map (formats 4 and 12), horizontal metrics, kern
+// table pairs and the outlines themselves; CFF (OpenType .otf) outlines and GPOS kerning aren't read
+
+// a quadratic piece of an outline in font units; straight pieces have the control point halfway
+struct ttf_curve {
+	float x0, y0;
+	float cx, cy;
+	float x1, y1;
+};
+
+struct ttf_glyph_metrics {
+	int advance = 0;
+	// bounding box, all zero for glyphs without an outline such as the space
+	int x_min = 0;
+	int y_min = 0;
+	int x_max = 0;
+	int y_max = 0;
+};
+
+class ttf_font {
+public:
+	bool load(const std::string& path);
+
+	// 0 (the missing glyph) for characters the font doesn't have
+	uint32_t glyph_index(uint32_t codepoint) const;
+	const ttf_glyph_metrics& metrics(uint32_t glyph) const;
+	// adds the outline's contours to curves, y up
+	void outline(uint32_t glyph, std::vector<ttf_curve>& curves) const;
+	// added to the advance between the two glyphs, in font units
+	int kerning(uint32_t left, uint32_t right) const;
+
+	uint32_t glyph_count() const { return static_cast<uint32_t>(glyph_metrics.size()); }
+	int units_per_em() const { return em_units; }
+	int ascent() const { return ascender; }
+	int descent() const { return descender; }
+	int line_gap() const { return gap; }
+
+private:
+	struct cmap_group {
+		uint32_t first;
+		uint32_t last;
+		uint32_t glyph;
+	};
+	struct kern_pair {
+		// left << 16 | right
+		uint32_t glyphs;
+		int16_t value;
+	};
+
+	uint32_t glyph_offset(uint32_t glyph, uint32_t* length) const;
+	void read_cmap(uint32_t offset);
+	void read_kern(uint32_t offset, uint32_t length);
+	void append_outline(uint32_t glyph, const float* transform, int depth, std::vector<ttf_curve>& curves) const;
+
+	std::vector<uint8_t> data;
+	uint32_t loca = 0;
+	uint32_t glyf = 0;
+	bool long_offsets = false;
+	int em_units = 0;
+	int ascender = 0;
+	int descender = 0;
+	int gap = 0;
+	std::vector<ttf_glyph_metrics> glyph_metrics;
+	// the basic multilingual plane looked up directly, anything above from the groups
+	std::vector<uint16_t> bmp_glyphs;
+	std::vector<cmap_group> groups;
+	// sorted by glyphs
+	std::vector<kern_pair> kern_pairs;
+};
@@ -0,0 +1,384 @@
+#!/usr/bin/env python3
+"""Generates LearnOpenGL/gl_loader.h and gl_loader.cpp - a GL function loader that only
+knows the entry points and constants the project references.
+
+The sources listed in the manifest are scanned (comments and string literals stripped)
+for gl* calls and GL_* constants; prototypes and values are taken from the vendored
+include/GL/glew.h. Functions named on a `lazy` line of the manifest are resolved on their
+first call, and only when the GL version or extension that provides them is present;
+everything else is resolved by gl_loader_init() and must exist.
+
+    python tools/gen_gl_loader.py            # regenerate after adding GL calls
+    python tools/gen_gl_loader.py --check    # fail if the checked-in loader is stale
+
+To compare against GLEW build both flavours (msbuild /p:UseGlew=1 for GLEW) and run
+`LearnOpenGL.exe --startup-bench=20` with each: the reports contain the gl_loader_init /
+glew_init phase and the executable size (binary_bytes).
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+GLEW_H = os.path.join(ROOT, 'include', 'GL', 'glew.h')
+MANIFEST = os.path.join(ROOT, 'LearnOpenGL', 'gl_loader.manifest')
+OUTPUT_DIR = os.path.join(ROOT, 'LearnOpenGL')
+GENERATED = ('gl_loader.h', 'gl_loader.cpp')
+
+# used by gl_loader_has_version() / gl_loader_has_extension() themselves
+LOADER_FUNCTIONS = ['glGetIntegerv', 'glGetStringi']
+LOADER_CONSTANTS = ['GL_EXTENSIONS', 'GL_MAJOR_VERSION', 'GL_MINOR_VERSION', 'GL_NUM_EXTENSIONS']
+
+BASIC_TYPES = '''typedef unsigned int GLenum;
+typedef unsigned int GLbitfield;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+typedef unsigned char GLboolean;
+typedef signed char GLbyte;
+typedef short GLshort;
+typedef unsigned char GLubyte;
+typedef unsigned short GLushort;
+typedef float GLfloat;
+typedef float GLclampf;
+typedef double GLdouble;
+typedef double GLclampd;
+typedef void GLvoid;
+typedef char GLchar;
+typedef unsigned short GLhalf;
+typedef int64_t GLint64;
+typedef uint64_t GLuint64;
+typedef ptrdiff_t GLintptr;
+typedef ptrdiff_t GLsizeiptr;
+typedef struct __GLsync* GLsync;'''
+
+
+class Function:
+    def __init__(self, name, ret, params, pfn):
+        self.name = name
+        self.ret = ret
+        self.params = params
+        self.pfn = pfn
+
+    def param_names(self):
+        if self.params.strip() in ('', 'void'):
+            return []
+        names = []
+        for param in self.params.split(','):
+            names.append(re.findall(r'\w+', param)[-1])
+        return names
+
+
+def parse_glew():
+    text = open(GLEW_H, encoding='latin-1').read()
+    functions = {}
+    constants = {}
+    callback_types = {}
+
+    for m in re.finditer(r'^GLAPI (.+?) GLAPIENTRY (gl\w+) \((.*?)\);', text, re.M):
+        ret, name, params = m.group(1).strip(), m.group(2), m.group(3).strip()
+        functions[name] = Function(name, ret, params, 'PFN%sPROC' % name.upper())
+
+    typedefs = {}
+    for m in re.finditer(r'^typedef (.+?) \(GLAPIENTRY \* (PFN\w+PROC)\) \((.*?)\);', text, re.M):
+        typedefs[m.group(2)] = (m.group(1).strip(), m.group(3).strip())
+    for m in re.finditer(r'^GLEW_FUN_EXPORT (PFN\w+PROC) __glew(\w+);', text, re.M):
+        pfn, name = m.group(1), 'gl' + m.group(2)
+        if pfn in typedefs and name not in functions:
+            ret, params = typedefs[pfn]
+            functions[name] = Function(name, ret, params, pfn)
+
+    for m in re.finditer(r'^#define (GL_\w+) (-?(?:0x[0-9A-Fa-f]+|\d+)(?:u|ull)?)\s*$', text, re.M):
+        constants.setdefault(m.group(1), m.group(2))
+    # core names glew defines through an older or extension name, e.g. GL_COMPARE_REF_TO_TEXTURE
+    for m in re.finditer(r'^#define (GL_\w+) (GL_\w+)\s*$', text, re.M):
+        if m.group(2) in constants:
+            constants.setdefault(m.group(1), constants[m.group(2)])
+
+    for m in re.finditer(r'^typedef (.+?) \(GLAPIENTRY \*(GL\w+PROC\w*)\)\((.*?)\);', text, re.M):
+        callback_types[m.group(2)] = 'typedef %s (GL_LOADER_APIENTRY* %s)(%s);' % (m.group(1), m.group(2), m.group(3))
+
+    return functions, constants, callback_types
+
+
+def parse_manifest():
+    sources, always, lazy = [], [], {}
+    for line in open(MANIFEST):
+        line = line.split('#', 1)[0].split()
+        if not line:
+            continue
+        if line[0] == 'sources':
+            sources += line[1:]
+        elif line[0] == 'function':
+            always += line[1:]
+        elif line[0] == 'lazy':
+            alternatives = [(line[2], line[1])]
+            for alternative in line[3:]:
+                requirement, name = alternative.split(':')
+                alternatives.append((requirement, name))
+            lazy[line[1]] = alternatives
+        else:
+            sys.exit('gl_loader.manifest: unknown directive ' + line[0])
+    return sources, always, lazy
+
+
+def strip_code(text):
+    pattern = r'//[^\n]*|/\*.*?\*/|"(?:\\.|[^"\\])*"|\'(?:\\.|[^\'\\])*\''
+    return re.sub(pattern, ' ', text, flags=re.S)
+
+
+def scan_sources(directories):
+    names, constants = set(), set()
+    for directory in directories:
+        path = os.path.join(ROOT, directory)
+        for file_name in sorted(os.listdir(path)):
+            if file_name in GENERATED or not file_name.endswith(('.cpp', '.h')):
+                continue
+            code = strip_code(open(os.path.join(path, file_name), encoding='utf-8-sig').read())
+            names.update(re.findall(r'\b(gl[A-Z]\w*)\s*\(', code))
+            names.update(re.findall(r'\b(gl[A-Z]\w*)\b', code))
+            names.update(re.findall(r'\bgl_loader_(gl[A-Z]\w*)\b', code))
+            constants.update(re.findall(r'\b(GL_[A-Z0-9_]+)\b', code))
+    return names, constants
+
+
+def generate(args):
+    functions, constant_values, callback_types = parse_glew()
+    sources, always, lazy = parse_manifest()
+    referenced, constants = scan_sources(sources)
+    always += LOADER_FUNCTIONS
+    constants.update(LOADER_CONSTANTS)
+
+    used = sorted(name for name in (referenced | set(always) | set(lazy)) if name in functions)
+    missing = [name for name in always + list(lazy) if name not in functions]
+    if missing:
+        sys.exit('gl_loader.manifest names unknown functions: ' + ', '.join(missing))
+    constants = sorted(name for name in constants if name in constant_values)
+
+    eager = [functions[name] for name in used if name not in lazy]
+    deferred = [functions[name] for name in used if name in lazy]
+
+    callbacks = sorted(name for name in callback_types
+                       if any(re.search(r'\b%s\b' % name, f.params) for f in eager + deferred))
+
+    header = []
+    emit = header.append
+    emit('// generated by tools/gen_gl_loader.py from gl_loader.manifest - do not edit')
+    emit('// %d functions (%d resolved on first use), %d constants' % (len(used), len(deferred), len(constants)))
+    emit('#pragma once')
+    emit('')
+    emit('#include <stddef.h>')
+    emit('#include <stdint.h>')
+    emit('')
+    emit('#if defined(__gl_h_) || defined(__GL_H__) || defined(__glew_h__)')
+    emit('#error gl_loader.h replaces gl.h and glew.h, include only one of them')
+    emit('#endif')
+    emit('#define __gl_h_')
+    emit('#define __GL_H__')
+    emit('')
+    emit('#ifdef _WIN32')
+    emit('#define GL_LOADER_APIENTRY __stdcall')
+    emit('#else')
+    emit('#define GL_LOADER_APIENTRY')
+    emit('#endif')
+    emit('')
+    emit(BASIC_TYPES)
+    for name in callbacks:
+        emit(callback_types[name])
+    emit('')
+    for name in constants:
+        emit('#define %s %s' % (name, constant_values[name]))
+    emit('')
+    for f in eager + deferred:
+        emit('typedef %s (GL_LOADER_APIENTRY* %s)(%s);' % (f.ret, f.pfn, f.params))
+    emit('')
+    for f in eager + deferred:
+        emit('extern %s gl_loader_%s;' % (f.pfn, f.name))
+    emit('')
+    for f in eager + deferred:
+        emit('#define %s gl_loader_%s' % (f.name, f.name))
+    emit('')
+    emit('// X(return type, name, (parameters), (arguments)) for every function, for code that wraps them all')
+    emit('#define GL_LOADER_FUNCTIONS(X) \\')
+    for i, f in enumerate(eager + deferred):
+        params = f.params if f.params.strip() else 'void'
+        emit('\tX(%s, %s, (%s), (%s))%s' % (f.ret, f.name, params, ', '.join(f.param_names()),
+                                         ' \\' if i < len(eager + deferred) - 1 else ''))
+    emit('')
+    emit('typedef void (*gl_loader_proc)();')
+    emit('typedef gl_loader_proc (*gl_loader_get_proc)(const char* name);')
+    emit('')
+    emit('// resolves every function that is not lazy; false if one of them is missing')
+    emit('bool gl_loader_init(gl_loader_get_proc get_proc);')
+    emit('int gl_loader_function_count();')
+    emit('// resolves a lazy function now; false if the driver does not provide it')
+    emit('bool gl_loader_load(const char* name);')
+    emit('bool gl_loader_has_version(int major, int minor);')
+    emit('bool gl_loader_has_extension(const char* name);')
+    emit('')
+
+    source = []
+    emit = source.append
+    emit('// generated by tools/gen_gl_loader.py from gl_loader.manifest - do not edit')
+    emit('#include "gl_loader.h"')
+    emit('')
+    emit('#include <cstdio>')
+    emit('#include <cstring>')
+    emit('#include <string>')
+    emit('')
+    emit('#include "log.h"')
+    emit('')
+    emit('using namespace std;')
+    emit('')
+    emit('static gl_loader_get_proc loader_get_proc = nullptr;')
+    emit('')
+    for f in eager:
+        emit('%s gl_loader_%s = nullptr;' % (f.pfn, f.name))
+    emit('')
+    emit('struct lazy_alternative {')
+    emit('\tconst char* requirement;')
+    emit('\tconst char* name;')
+    emit('};')
+    emit('')
+    emit('struct lazy_function {')
+    emit('\tconst char* name;')
+    emit('\tlazy_alternative alternatives[%d];' % max([len(a) for a in lazy.values()] + [1]))
+    emit('\tvoid (*assign)(gl_loader_proc proc);')
+    emit('\tint state; // 0 - not tried, 1 - resolved, -1 - unavailable')
+    emit('};')
+    emit('')
+    emit('static lazy_function lazy_functions[] = {')
+    for f in deferred:
+        alternatives = ', '.join('{ "%s", "%s" }' % a for a in lazy[f.name])
+        emit('\t{ "%s", { %s }, [](const gl_loader_proc proc) { gl_loader_%s = reinterpret_cast<%s>(proc); }, 0 },'
+             % (f.name, alternatives, f.name, f.pfn))
+    if not deferred:
+        emit('\t{ nullptr, {}, nullptr, -1 },')
+    emit('};')
+    emit('')
+    emit('static bool requirement_met(const char* requirement) {')
+    emit('\tint major = 0, minor = 0;')
+    emit('\tif (sscanf(requirement, "GL_VERSION_%d_%d", &major, &minor) == 2) {')
+    emit('\t\treturn gl_loader_has_version(major, minor);')
+    emit('\t}')
+    emit('\treturn gl_loader_has_extension(requirement);')
+    emit('}')
+    emit('')
+    emit('static bool resolve_lazy(const int index) {')
+    emit('\tlazy_function& function = lazy_functions[index];')
+    emit('\tif (function.state == 0) {')
+    emit('\t\tfunction.state = -1;')
+    emit('\t\tfor (const lazy_alternative& alternative : function.alternatives) {')
+    emit('\t\t\tif (alternative.name == nullptr || !requirement_met(alternative.requirement)) {')
+    emit('\t\t\t\tcontinue;')
+    emit('\t\t\t}')
+    emit('\t\t\tconst gl_loader_proc proc = loader_get_proc(alternative.name);')
+    emit('\t\t\tif (proc != nullptr) {')
+    emit('\t\t\t\tfunction.assign(proc);')
+    emit('\t\t\t\tfunction.state = 1;')
+    emit('\t\t\t\tbreak;')
+    emit('\t\t\t}')
+    emit('\t\t}')
+    emit('\t\tif (function.state < 0) {')
+    emit('\t\t\tlog(string("GL function not available: ") + function.name);')
+    emit('\t\t}')
+    emit('\t}')
+    emit('\treturn function.state > 0;')
+    emit('}')
+    emit('')
+    for index, f in enumerate(deferred):
+        names = f.param_names()
+        call = 'gl_loader_%s(%s)' % (f.name, ', '.join(names))
+        emit('static %s GL_LOADER_APIENTRY lazy_%s(%s) {' % (f.ret, f.name, f.params))
+        if f.ret == 'void':
+            emit('\tif (resolve_lazy(%d)) {' % index)
+            emit('\t\t%s;' % call)
+            emit('\t}')
+        else:
+            emit('\treturn resolve_lazy(%d) ? %s : static_cast<%s>(0);' % (index, call, f.ret))
+        emit('}')
+        emit('')
+    for f in deferred:
+        emit('%s gl_loader_%s = lazy_%s;' % (f.pfn, f.name, f.name))
+    if deferred:
+        emit('')
+    emit('bool gl_loader_init(const gl_loader_get_proc get_proc) {')
+    emit('\tloader_get_proc = get_proc;')
+    emit('\tint missing = 0;')
+    emit('')
+    emit('\tconst auto load = [&](const char* name) {')
+    emit('\t\tconst gl_loader_proc proc = get_proc(name);')
+    emit('\t\tif (proc == nullptr) {')
+    emit('\t\t\tlog(string("Failed to load ") + name);')
+    emit('\t\t\tmissing++;')
+    emit('\t\t}')
+    emit('\t\treturn proc;')
+    emit('\t};')
+    emit('')
+    for f in eager:
+        emit('\tgl_loader_%s = reinterpret_cast<%s>(load("%s"));' % (f.name, f.pfn, f.name))
+    emit('')
+    emit('\treturn missing == 0;')
+    emit('}')
+    emit('')
+    emit('int gl_loader_function_count() {')
+    emit('\treturn %d;' % len(used))
+    emit('}')
+    emit('')
+    emit('bool gl_loader_load(const char* name) {')
+    emit('\tfor (int i = 0; i < %d; i++) {' % len(deferred))
+    emit('\t\tif (strcmp(lazy_functions[i].name, name) == 0) {')
+    emit('\t\t\treturn resolve_lazy(i);')
+    emit('\t\t}')
+    emit('\t}')
+    emit('\treturn false;')
+    emit('}')
+    emit('')
+    emit('bool gl_loader_has_version(const int major, const int minor) {')
+    emit('\tstatic int version = -1;')
+    emit('\tif (version < 0) {')
+    emit('\t\tGLint context_major = 0, context_minor = 0;')
+    emit('\t\tglGetIntegerv(GL_MAJOR_VERSION, &context_major);')
+    emit('\t\tglGetIntegerv(GL_MINOR_VERSION, &context_minor);')
+    emit('\t\tversion = context_major * 10 + context_minor;')
+    emit('\t}')
+    emit('\treturn version >= major * 10 + minor;')
+    emit('}')
+    emit('')
+    emit('bool gl_loader_has_extension(const char* name) {')
+    emit('\tGLint count = 0;')
+    emit('\tglGetIntegerv(GL_NUM_EXTENSIONS, &count);')
+    emit('\tfor (GLint i = 0; i < count; i++) {')
+    emit('\t\tconst GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);')
+    emit('\t\tif (extension != nullptr && strcmp(reinterpret_cast<const char*>(extension), name) == 0) {')
+    emit('\t\t\treturn true;')
+    emit('\t\t}')
+    emit('\t}')
+    emit('\treturn false;')
+    emit('}')
+
+    outputs = {
+        'gl_loader.h': '\n'.join(header) + '\n',
+        'gl_loader.cpp': '\n'.join(source) + '\n',
+    }
+    stale = []
+    for name, text in outputs.items():
+        path = os.path.join(OUTPUT_DIR, name)
+        current = open(path).read() if os.path.exists(path) else None
+        if current == text:
+            continue
+        stale.append(name)
+        if not args.check:
+            with open(path, 'w', newline='\n') as output:
+                output.write(text)
+    if args.check and stale:
+        sys.exit('stale: ' + ', '.join(stale) + ' - run tools/gen_gl_loader.py')
+    print('gl_loader: %d functions (%d lazy), %d constants' % (len(used), len(deferred), len(constants)))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--check', action='store_true', help='only verify the generated files are up to date')
+    generate(parser.parse_args())